@@ -0,0 +1,82 @@
+# CMAKE generated file: DO NOT EDIT!
+# Generated by "Unix Makefiles" Generator, CMake Version 3.25
+
+# The generator used is:
+set(CMAKE_DEPENDS_GENERATOR "Unix Makefiles")
+
+# The top level Makefile was generated from the following files:
+set(CMAKE_MAKEFILE_DEPENDS
+  "CMakeCache.txt"
+  "/root/repo/CppNet/CMakeLists.txt"
+  "CMakeFiles/3.25.1/CMakeCCompiler.cmake"
+  "CMakeFiles/3.25.1/CMakeCXXCompiler.cmake"
+  "CMakeFiles/3.25.1/CMakeSystem.cmake"
+  "/root/repo/CppNet/test/CMakeLists.txt"
+  "/root/repo/CppNet/test/bench/CMakeLists.txt"
+  "/root/repo/CppNet/test/buffer/CMakeLists.txt"
+  "/root/repo/CppNet/test/echo/CMakeLists.txt"
+  "/root/repo/CppNet/test/http/CMakeLists.txt"
+  "/root/repo/CppNet/test/pingpong/CMakeLists.txt"
+  "/root/repo/CppNet/test/rpc/CMakeLists.txt"
+  "/root/repo/CppNet/test/sendfile/CMakeLists.txt"
+  "/root/repo/CppNet/test/simple/CMakeLists.txt"
+  "/usr/share/cmake-3.25/Modules/CMakeCInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCXXInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCommonLanguageInclude.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeGenericSystem.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeInitializeConfigs.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeLanguageInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeSystemSpecificInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeSystemSpecificInitialize.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/CMakeCommonCompilerMacros.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU-C.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU-CXX.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU-C.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU-CXX.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/UnixPaths.cmake"
+  )
+
+# The corresponding makefile is:
+set(CMAKE_MAKEFILE_OUTPUTS
+  "Makefile"
+  "CMakeFiles/cmake.check_cache"
+  )
+
+# Byproducts of CMake generate step:
+set(CMAKE_MAKEFILE_PRODUCTS
+  "CMakeFiles/CMakeDirectoryInformation.cmake"
+  "test/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "test/bench/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "test/buffer/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "test/echo/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "test/http/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "test/pingpong/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "test/rpc/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "test/sendfile/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "test/simple/CMakeFiles/CMakeDirectoryInformation.cmake"
+  )
+
+# Dependency information for all targets:
+set(CMAKE_DEPEND_INFO_FILES
+  "CMakeFiles/cppnet.dir/DependInfo.cmake"
+  "test/bench/CMakeFiles/memorypoolbench.dir/DependInfo.cmake"
+  "test/bench/CMakeFiles/connectionchurnbench.dir/DependInfo.cmake"
+  "test/bench/CMakeFiles/timerbench.dir/DependInfo.cmake"
+  "test/bench/CMakeFiles/bufferbench.dir/DependInfo.cmake"
+  "test/buffer/CMakeFiles/buffertest.dir/DependInfo.cmake"
+  "test/echo/CMakeFiles/echoclient.dir/DependInfo.cmake"
+  "test/echo/CMakeFiles/echoserver.dir/DependInfo.cmake"
+  "test/http/CMakeFiles/httpser.dir/DependInfo.cmake"
+  "test/pingpong/CMakeFiles/pingpongserver.dir/DependInfo.cmake"
+  "test/pingpong/CMakeFiles/pingpongclient.dir/DependInfo.cmake"
+  "test/pingpong/CMakeFiles/pingpongcrossthread.dir/DependInfo.cmake"
+  "test/rpc/CMakeFiles/serrpc.dir/DependInfo.cmake"
+  "test/rpc/CMakeFiles/clirpc.dir/DependInfo.cmake"
+  "test/sendfile/CMakeFiles/sendfileserver.dir/DependInfo.cmake"
+  "test/sendfile/CMakeFiles/sendfileclient.dir/DependInfo.cmake"
+  "test/simple/CMakeFiles/server.dir/DependInfo.cmake"
+  "test/simple/CMakeFiles/client.dir/DependInfo.cmake"
+  )
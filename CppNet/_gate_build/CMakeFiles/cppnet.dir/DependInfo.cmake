@@ -0,0 +1,37 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/CppNet/base/BlockMemoryPool.cpp" "CMakeFiles/cppnet.dir/base/BlockMemoryPool.cpp.o" "gcc" "CMakeFiles/cppnet.dir/base/BlockMemoryPool.cpp.o.d"
+  "/root/repo/CppNet/base/Buffer.cpp" "CMakeFiles/cppnet.dir/base/Buffer.cpp.o" "gcc" "CMakeFiles/cppnet.dir/base/Buffer.cpp.o.d"
+  "/root/repo/CppNet/base/Config.cpp" "CMakeFiles/cppnet.dir/base/Config.cpp.o" "gcc" "CMakeFiles/cppnet.dir/base/Config.cpp.o.d"
+  "/root/repo/CppNet/base/Log.cpp" "CMakeFiles/cppnet.dir/base/Log.cpp.o" "gcc" "CMakeFiles/cppnet.dir/base/Log.cpp.o.d"
+  "/root/repo/CppNet/base/LoopBuffer.cpp" "CMakeFiles/cppnet.dir/base/LoopBuffer.cpp.o" "gcc" "CMakeFiles/cppnet.dir/base/LoopBuffer.cpp.o.d"
+  "/root/repo/CppNet/base/MemoryPool.cpp" "CMakeFiles/cppnet.dir/base/MemoryPool.cpp.o" "gcc" "CMakeFiles/cppnet.dir/base/MemoryPool.cpp.o.d"
+  "/root/repo/CppNet/base/ThreadCache.cpp" "CMakeFiles/cppnet.dir/base/ThreadCache.cpp.o" "gcc" "CMakeFiles/cppnet.dir/base/ThreadCache.cpp.o.d"
+  "/root/repo/CppNet/base/TimeTool.cpp" "CMakeFiles/cppnet.dir/base/TimeTool.cpp.o" "gcc" "CMakeFiles/cppnet.dir/base/TimeTool.cpp.o.d"
+  "/root/repo/CppNet/net/CppNet.cpp" "CMakeFiles/cppnet.dir/net/CppNet.cpp.o" "gcc" "CMakeFiles/cppnet.dir/net/CppNet.cpp.o.d"
+  "/root/repo/CppNet/net/CppNetImpl.cpp" "CMakeFiles/cppnet.dir/net/CppNetImpl.cpp.o" "gcc" "CMakeFiles/cppnet.dir/net/CppNetImpl.cpp.o.d"
+  "/root/repo/CppNet/net/OSInfo.cpp" "CMakeFiles/cppnet.dir/net/OSInfo.cpp.o" "gcc" "CMakeFiles/cppnet.dir/net/OSInfo.cpp.o.d"
+  "/root/repo/CppNet/net/Socket.cpp" "CMakeFiles/cppnet.dir/net/Socket.cpp.o" "gcc" "CMakeFiles/cppnet.dir/net/Socket.cpp.o.d"
+  "/root/repo/CppNet/net/SocketRegistry.cpp" "CMakeFiles/cppnet.dir/net/SocketRegistry.cpp.o" "gcc" "CMakeFiles/cppnet.dir/net/SocketRegistry.cpp.o.d"
+  "/root/repo/CppNet/net/Timer.cpp" "CMakeFiles/cppnet.dir/net/Timer.cpp.o" "gcc" "CMakeFiles/cppnet.dir/net/Timer.cpp.o.d"
+  "/root/repo/CppNet/net/linux/AcceptSocket.cpp" "CMakeFiles/cppnet.dir/net/linux/AcceptSocket.cpp.o" "gcc" "CMakeFiles/cppnet.dir/net/linux/AcceptSocket.cpp.o.d"
+  "/root/repo/CppNet/net/linux/CEpoll.cpp" "CMakeFiles/cppnet.dir/net/linux/CEpoll.cpp.o" "gcc" "CMakeFiles/cppnet.dir/net/linux/CEpoll.cpp.o.d"
+  "/root/repo/CppNet/net/linux/LinuxFunc.cpp" "CMakeFiles/cppnet.dir/net/linux/LinuxFunc.cpp.o" "gcc" "CMakeFiles/cppnet.dir/net/linux/LinuxFunc.cpp.o.d"
+  "/root/repo/CppNet/net/linux/SocketBase.cpp" "CMakeFiles/cppnet.dir/net/linux/SocketBase.cpp.o" "gcc" "CMakeFiles/cppnet.dir/net/linux/SocketBase.cpp.o.d"
+  "/root/repo/CppNet/net/linux/SocketImpl.cpp" "CMakeFiles/cppnet.dir/net/linux/SocketImpl.cpp.o" "gcc" "CMakeFiles/cppnet.dir/net/linux/SocketImpl.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,47 @@
+file(REMOVE_RECURSE
+  "/root/repo/CppNet/build/libcppnet.a"
+  "/root/repo/CppNet/build/libcppnet.pdb"
+  "CMakeFiles/cppnet.dir/base/BlockMemoryPool.cpp.o"
+  "CMakeFiles/cppnet.dir/base/BlockMemoryPool.cpp.o.d"
+  "CMakeFiles/cppnet.dir/base/Buffer.cpp.o"
+  "CMakeFiles/cppnet.dir/base/Buffer.cpp.o.d"
+  "CMakeFiles/cppnet.dir/base/Config.cpp.o"
+  "CMakeFiles/cppnet.dir/base/Config.cpp.o.d"
+  "CMakeFiles/cppnet.dir/base/Log.cpp.o"
+  "CMakeFiles/cppnet.dir/base/Log.cpp.o.d"
+  "CMakeFiles/cppnet.dir/base/LoopBuffer.cpp.o"
+  "CMakeFiles/cppnet.dir/base/LoopBuffer.cpp.o.d"
+  "CMakeFiles/cppnet.dir/base/MemoryPool.cpp.o"
+  "CMakeFiles/cppnet.dir/base/MemoryPool.cpp.o.d"
+  "CMakeFiles/cppnet.dir/base/ThreadCache.cpp.o"
+  "CMakeFiles/cppnet.dir/base/ThreadCache.cpp.o.d"
+  "CMakeFiles/cppnet.dir/base/TimeTool.cpp.o"
+  "CMakeFiles/cppnet.dir/base/TimeTool.cpp.o.d"
+  "CMakeFiles/cppnet.dir/net/CppNet.cpp.o"
+  "CMakeFiles/cppnet.dir/net/CppNet.cpp.o.d"
+  "CMakeFiles/cppnet.dir/net/CppNetImpl.cpp.o"
+  "CMakeFiles/cppnet.dir/net/CppNetImpl.cpp.o.d"
+  "CMakeFiles/cppnet.dir/net/OSInfo.cpp.o"
+  "CMakeFiles/cppnet.dir/net/OSInfo.cpp.o.d"
+  "CMakeFiles/cppnet.dir/net/Socket.cpp.o"
+  "CMakeFiles/cppnet.dir/net/Socket.cpp.o.d"
+  "CMakeFiles/cppnet.dir/net/SocketRegistry.cpp.o"
+  "CMakeFiles/cppnet.dir/net/SocketRegistry.cpp.o.d"
+  "CMakeFiles/cppnet.dir/net/Timer.cpp.o"
+  "CMakeFiles/cppnet.dir/net/Timer.cpp.o.d"
+  "CMakeFiles/cppnet.dir/net/linux/AcceptSocket.cpp.o"
+  "CMakeFiles/cppnet.dir/net/linux/AcceptSocket.cpp.o.d"
+  "CMakeFiles/cppnet.dir/net/linux/CEpoll.cpp.o"
+  "CMakeFiles/cppnet.dir/net/linux/CEpoll.cpp.o.d"
+  "CMakeFiles/cppnet.dir/net/linux/LinuxFunc.cpp.o"
+  "CMakeFiles/cppnet.dir/net/linux/LinuxFunc.cpp.o.d"
+  "CMakeFiles/cppnet.dir/net/linux/SocketBase.cpp.o"
+  "CMakeFiles/cppnet.dir/net/linux/SocketBase.cpp.o.d"
+  "CMakeFiles/cppnet.dir/net/linux/SocketImpl.cpp.o"
+  "CMakeFiles/cppnet.dir/net/linux/SocketImpl.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/cppnet.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,14 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/CppNet/test
+# Build directory: /root/repo/CppNet/_gate_build/test
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+subdirs("bench")
+subdirs("buffer")
+subdirs("echo")
+subdirs("http")
+subdirs("pingpong")
+subdirs("rpc")
+subdirs("sendfile")
+subdirs("simple")
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/CppNet/build/bufferbench"
+  "/root/repo/CppNet/build/bufferbench.pdb"
+  "CMakeFiles/bufferbench.dir/BufferBench.cpp.o"
+  "CMakeFiles/bufferbench.dir/BufferBench.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bufferbench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/CppNet/build/connectionchurnbench"
+  "/root/repo/CppNet/build/connectionchurnbench.pdb"
+  "CMakeFiles/connectionchurnbench.dir/ConnectionChurnBench.cpp.o"
+  "CMakeFiles/connectionchurnbench.dir/ConnectionChurnBench.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/connectionchurnbench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
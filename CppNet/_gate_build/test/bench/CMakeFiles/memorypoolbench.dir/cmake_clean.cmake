@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/CppNet/build/memorypoolbench"
+  "/root/repo/CppNet/build/memorypoolbench.pdb"
+  "CMakeFiles/memorypoolbench.dir/MemoryPoolBench.cpp.o"
+  "CMakeFiles/memorypoolbench.dir/MemoryPoolBench.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/memorypoolbench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/CppNet/build/timerbench"
+  "/root/repo/CppNet/build/timerbench.pdb"
+  "CMakeFiles/timerbench.dir/TimerBench.cpp.o"
+  "CMakeFiles/timerbench.dir/TimerBench.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/timerbench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
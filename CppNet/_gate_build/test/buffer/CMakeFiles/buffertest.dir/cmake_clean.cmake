@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/CppNet/build/buffertest"
+  "/root/repo/CppNet/build/buffertest.pdb"
+  "CMakeFiles/buffertest.dir/BufferTest.cpp.o"
+  "CMakeFiles/buffertest.dir/BufferTest.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/buffertest.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,8 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/CppNet/test/buffer
+# Build directory: /root/repo/CppNet/_gate_build/test/buffer
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(buffertest "/root/repo/CppNet/build/buffertest")
+set_tests_properties(buffertest PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CppNet/test/buffer/CMakeLists.txt;11;add_test;/root/repo/CppNet/test/buffer/CMakeLists.txt;0;")
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/CppNet/build/echoclient"
+  "/root/repo/CppNet/build/echoclient.pdb"
+  "CMakeFiles/echoclient.dir/EchoClient.cpp.o"
+  "CMakeFiles/echoclient.dir/EchoClient.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/echoclient.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/CppNet/build/echoserver"
+  "/root/repo/CppNet/build/echoserver.pdb"
+  "CMakeFiles/echoserver.dir/EchoServer.cpp.o"
+  "CMakeFiles/echoserver.dir/EchoServer.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/echoserver.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
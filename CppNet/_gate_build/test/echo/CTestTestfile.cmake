@@ -0,0 +1,6 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/CppNet/test/echo
+# Build directory: /root/repo/CppNet/_gate_build/test/echo
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
@@ -0,0 +1,22 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/CppNet/test/http/HttpContext.cpp" "test/http/CMakeFiles/httpser.dir/HttpContext.cpp.o" "gcc" "test/http/CMakeFiles/httpser.dir/HttpContext.cpp.o.d"
+  "/root/repo/CppNet/test/http/HttpResponse.cpp" "test/http/CMakeFiles/httpser.dir/HttpResponse.cpp.o" "gcc" "test/http/CMakeFiles/httpser.dir/HttpResponse.cpp.o.d"
+  "/root/repo/CppNet/test/http/HttpServer.cpp" "test/http/CMakeFiles/httpser.dir/HttpServer.cpp.o" "gcc" "test/http/CMakeFiles/httpser.dir/HttpServer.cpp.o.d"
+  "/root/repo/CppNet/test/http/HttpServerTest.cpp" "test/http/CMakeFiles/httpser.dir/HttpServerTest.cpp.o" "gcc" "test/http/CMakeFiles/httpser.dir/HttpServerTest.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,17 @@
+file(REMOVE_RECURSE
+  "/root/repo/CppNet/build/httpser"
+  "/root/repo/CppNet/build/httpser.pdb"
+  "CMakeFiles/httpser.dir/HttpContext.cpp.o"
+  "CMakeFiles/httpser.dir/HttpContext.cpp.o.d"
+  "CMakeFiles/httpser.dir/HttpResponse.cpp.o"
+  "CMakeFiles/httpser.dir/HttpResponse.cpp.o.d"
+  "CMakeFiles/httpser.dir/HttpServer.cpp.o"
+  "CMakeFiles/httpser.dir/HttpServer.cpp.o.d"
+  "CMakeFiles/httpser.dir/HttpServerTest.cpp.o"
+  "CMakeFiles/httpser.dir/HttpServerTest.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/httpser.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/CppNet/build/pingpongclient"
+  "/root/repo/CppNet/build/pingpongclient.pdb"
+  "CMakeFiles/pingpongclient.dir/Client.cpp.o"
+  "CMakeFiles/pingpongclient.dir/Client.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/pingpongclient.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
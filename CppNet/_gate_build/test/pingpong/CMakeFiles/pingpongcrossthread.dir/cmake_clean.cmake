@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/CppNet/build/pingpongcrossthread"
+  "/root/repo/CppNet/build/pingpongcrossthread.pdb"
+  "CMakeFiles/pingpongcrossthread.dir/CrossThreadSend.cpp.o"
+  "CMakeFiles/pingpongcrossthread.dir/CrossThreadSend.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/pingpongcrossthread.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/CppNet/build/pingpongserver"
+  "/root/repo/CppNet/build/pingpongserver.pdb"
+  "CMakeFiles/pingpongserver.dir/Server.cpp.o"
+  "CMakeFiles/pingpongserver.dir/Server.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/pingpongserver.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,6 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/CppNet/test/pingpong
+# Build directory: /root/repo/CppNet/_gate_build/test/pingpong
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
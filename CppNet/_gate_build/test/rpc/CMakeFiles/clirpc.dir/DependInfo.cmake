@@ -0,0 +1,24 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/CppNet/test/rpc/FuncThread.cpp" "test/rpc/CMakeFiles/clirpc.dir/FuncThread.cpp.o" "gcc" "test/rpc/CMakeFiles/clirpc.dir/FuncThread.cpp.o.d"
+  "/root/repo/CppNet/test/rpc/InfoRouter.cpp" "test/rpc/CMakeFiles/clirpc.dir/InfoRouter.cpp.o" "gcc" "test/rpc/CMakeFiles/clirpc.dir/InfoRouter.cpp.o.d"
+  "/root/repo/CppNet/test/rpc/ParsePackage.cpp" "test/rpc/CMakeFiles/clirpc.dir/ParsePackage.cpp.o" "gcc" "test/rpc/CMakeFiles/clirpc.dir/ParsePackage.cpp.o.d"
+  "/root/repo/CppNet/test/rpc/RPCClient.cpp" "test/rpc/CMakeFiles/clirpc.dir/RPCClient.cpp.o" "gcc" "test/rpc/CMakeFiles/clirpc.dir/RPCClient.cpp.o.d"
+  "/root/repo/CppNet/test/rpc/RPCServer.cpp" "test/rpc/CMakeFiles/clirpc.dir/RPCServer.cpp.o" "gcc" "test/rpc/CMakeFiles/clirpc.dir/RPCServer.cpp.o.d"
+  "/root/repo/CppNet/test/rpc/TestClient.cpp" "test/rpc/CMakeFiles/clirpc.dir/TestClient.cpp.o" "gcc" "test/rpc/CMakeFiles/clirpc.dir/TestClient.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
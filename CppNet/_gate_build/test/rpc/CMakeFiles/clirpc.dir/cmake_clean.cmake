@@ -0,0 +1,21 @@
+file(REMOVE_RECURSE
+  "/root/repo/CppNet/build/clirpc"
+  "/root/repo/CppNet/build/clirpc.pdb"
+  "CMakeFiles/clirpc.dir/FuncThread.cpp.o"
+  "CMakeFiles/clirpc.dir/FuncThread.cpp.o.d"
+  "CMakeFiles/clirpc.dir/InfoRouter.cpp.o"
+  "CMakeFiles/clirpc.dir/InfoRouter.cpp.o.d"
+  "CMakeFiles/clirpc.dir/ParsePackage.cpp.o"
+  "CMakeFiles/clirpc.dir/ParsePackage.cpp.o.d"
+  "CMakeFiles/clirpc.dir/RPCClient.cpp.o"
+  "CMakeFiles/clirpc.dir/RPCClient.cpp.o.d"
+  "CMakeFiles/clirpc.dir/RPCServer.cpp.o"
+  "CMakeFiles/clirpc.dir/RPCServer.cpp.o.d"
+  "CMakeFiles/clirpc.dir/TestClient.cpp.o"
+  "CMakeFiles/clirpc.dir/TestClient.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/clirpc.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,21 @@
+file(REMOVE_RECURSE
+  "/root/repo/CppNet/build/serrpc"
+  "/root/repo/CppNet/build/serrpc.pdb"
+  "CMakeFiles/serrpc.dir/FuncThread.cpp.o"
+  "CMakeFiles/serrpc.dir/FuncThread.cpp.o.d"
+  "CMakeFiles/serrpc.dir/InfoRouter.cpp.o"
+  "CMakeFiles/serrpc.dir/InfoRouter.cpp.o.d"
+  "CMakeFiles/serrpc.dir/ParsePackage.cpp.o"
+  "CMakeFiles/serrpc.dir/ParsePackage.cpp.o.d"
+  "CMakeFiles/serrpc.dir/RPCClient.cpp.o"
+  "CMakeFiles/serrpc.dir/RPCClient.cpp.o.d"
+  "CMakeFiles/serrpc.dir/RPCServer.cpp.o"
+  "CMakeFiles/serrpc.dir/RPCServer.cpp.o.d"
+  "CMakeFiles/serrpc.dir/TestServer.cpp.o"
+  "CMakeFiles/serrpc.dir/TestServer.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/serrpc.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
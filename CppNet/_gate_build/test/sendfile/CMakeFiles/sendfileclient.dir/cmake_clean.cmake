@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "/root/repo/CppNet/build/sendfileclient"
+  "/root/repo/CppNet/build/sendfileclient.pdb"
+  "CMakeFiles/sendfileclient.dir/SendFileClient.cpp.o"
+  "CMakeFiles/sendfileclient.dir/SendFileClient.cpp.o.d"
+  "CMakeFiles/sendfileclient.dir/md5.cpp.o"
+  "CMakeFiles/sendfileclient.dir/md5.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/sendfileclient.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "/root/repo/CppNet/build/sendfileserver"
+  "/root/repo/CppNet/build/sendfileserver.pdb"
+  "CMakeFiles/sendfileserver.dir/SendFileServer.cpp.o"
+  "CMakeFiles/sendfileserver.dir/SendFileServer.cpp.o.d"
+  "CMakeFiles/sendfileserver.dir/md5.cpp.o"
+  "CMakeFiles/sendfileserver.dir/md5.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/sendfileserver.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
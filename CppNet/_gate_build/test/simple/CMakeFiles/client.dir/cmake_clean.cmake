@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/CppNet/build/client"
+  "/root/repo/CppNet/build/client.pdb"
+  "CMakeFiles/client.dir/CppNetClient.cpp.o"
+  "CMakeFiles/client.dir/CppNetClient.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/client.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/CppNet/build/server"
+  "/root/repo/CppNet/build/server.pdb"
+  "CMakeFiles/server.dir/CppNetServer.cpp.o"
+  "CMakeFiles/server.dir/CppNetServer.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/server.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -1,3 +1,4 @@
+#include "ThreadCache.h"
 #include "BlockMemoryPool.h"
 
 using namespace base;
@@ -9,32 +10,19 @@ CBlockMemoryPool::CBlockMemoryPool(const int large_sz, const int add_num) :
 }
 
 CBlockMemoryPool::~CBlockMemoryPool() {
-    // free all memory
-    std::unique_lock<std::mutex> lock(_large_mutex);
-    for (auto iter = _free_mem_vec.begin(); iter != _free_mem_vec.end(); ++iter) {
-        free(*iter);
-    }
+
 }
 
 void* CBlockMemoryPool::PoolLargeMalloc() {
-    std::unique_lock<std::mutex> lock(_large_mutex);
-    if (_free_mem_vec.empty()) {
-        Expansion();
-    }
-
-    void* ret = _free_mem_vec.back();
-    _free_mem_vec.pop_back();
-    return ret;
+    return CThreadCache::BlockMalloc(_large_size);
 }
 
 void CBlockMemoryPool::PoolLargeFree(void* &m) {
-    std::unique_lock<std::mutex> lock(_large_mutex);
-    _free_mem_vec.push_back(m);
+    CThreadCache::BlockFree(m, _large_size);
 }
 
 int CBlockMemoryPool::GetSize() {
-    std::unique_lock<std::mutex> lock(_large_mutex);
-    return (int)_free_mem_vec.size();
+    return CThreadCache::GetBlockNum(_large_size);
 }
 
 int CBlockMemoryPool::GetBlockLength() {
@@ -42,29 +30,12 @@ int CBlockMemoryPool::GetBlockLength() {
 }
 
 void CBlockMemoryPool::ReleaseHalf() {
-    std::unique_lock<std::mutex> lock(_large_mutex);
-    size_t size = _free_mem_vec.size();
-    size_t hale = size / 2;
-    for (auto iter = _free_mem_vec.begin(); iter != _free_mem_vec.end();) {
-        void* mem = *iter;
-        iter = _free_mem_vec.erase(iter);
-        free(mem);
-        
-        size--;
-        if (iter == _free_mem_vec.end() || size <= hale) {
-            break;
-        }
-    }
+    CThreadCache::ReleaseBlockHalf(_large_size);
 }
 
 void CBlockMemoryPool::Expansion(int num) {
     if (num == 0) {
         num = _number_large_add_nodes;
     }
-
-    for (int i = 0; i < num; ++i) {
-        void* mem = malloc(_large_size);
-        // not memset!
-        _free_mem_vec.push_back(mem);
-    }
+    CThreadCache::ExpansionBlock(_large_size, num);
 }
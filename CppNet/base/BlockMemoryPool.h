@@ -1,12 +1,10 @@
 #ifndef HEADER_BASE_BLOCKMMEMORYPOOL
 #define HEADER_BASE_BLOCKMMEMORYPOOL
 
-#include <mutex>
-#include <vector>
-
 namespace base {
 
-    // all memory must return memory pool before destory.
+    // blocks are cached by the thread which frees them, see CThreadCache.
+    // the size and release functions act on the calling thread's blocks.
     class CBlockMemoryPool {
     public:
         // bulk memory size. everytime add nodes num
@@ -28,10 +26,8 @@ namespace base {
         void Expansion(int num = 0);
 
     private:
-        std::mutex                _large_mutex;
         int                       _number_large_add_nodes; //every time add nodes num
         int                       _large_size;             //bulk memory size
-        std::vector<void*>        _free_mem_vec;           //free bulk memory list
     };
 }
 
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "Buffer.h"
 #include "MemoryPool.h"
 #include "LoopBuffer.h"
@@ -28,11 +30,10 @@ int CBuffer::ReadNotClear(char* res, int len) {
         return 0;
     }
 
-    std::unique_lock<std::mutex> lock(_mutex);
     CLoopBuffer* temp = _buffer_read;
     int cur_len = 0;
     while (temp && cur_len < len) {
-        cur_len += temp->ReadNotClear(res, len - cur_len);
+        cur_len += temp->ReadNotClear(res + cur_len, len - cur_len);
         if (temp == _buffer_write) {
             break;
         }
@@ -46,12 +47,11 @@ int CBuffer::Read(char* res, int len) {
         return 0;
     }
 
-    std::unique_lock<std::mutex> lock(_mutex);
     CLoopBuffer* temp = _buffer_read;
     CLoopBuffer* del_temp = nullptr;;
     int cur_len = 0;
     while (temp) {
-        cur_len += temp->Read(res, len - cur_len);
+        cur_len += temp->Read(res + cur_len, len - cur_len);
         if (cur_len >= len) {
             break;
         }
@@ -73,7 +73,6 @@ int CBuffer::Read(char* res, int len) {
 }
 
 int CBuffer::Write(const char* str, int len) {
-    std::unique_lock<std::mutex> lock(_mutex);
     CLoopBuffer* prv_temp = nullptr;
     CLoopBuffer* temp = _buffer_write;
     int cur_len = 0;
@@ -107,7 +106,6 @@ int CBuffer::Write(const char* str, int len) {
 
 void CBuffer::Clear(int len) {
     if (len == 0) {
-        std::unique_lock<std::mutex> lock(_mutex);
         CLoopBuffer* temp = _buffer_read;
         CLoopBuffer* cur = nullptr;
         while (temp) {
@@ -120,7 +118,6 @@ void CBuffer::Clear(int len) {
         return;
     }
     
-    std::unique_lock<std::mutex> lock(_mutex);
     CLoopBuffer* temp = _buffer_read;
     CLoopBuffer* del_temp = nullptr;
     int cur_len = 0;
@@ -146,7 +143,6 @@ void CBuffer::Clear(int len) {
 }
 
 int CBuffer::MoveWritePt(int len) {
-    std::unique_lock<std::mutex> lock(_mutex);
     CLoopBuffer* temp = _buffer_write;
     int cur_len = 0;
     while (temp) {
@@ -188,7 +184,6 @@ int CBuffer::GetFreeLength() {
         return 0;
     }
     
-    std::unique_lock<std::mutex> lock(_mutex);
     CLoopBuffer* temp = _buffer_write;
     int cur_len = 0;
     while (temp) {
@@ -206,7 +201,6 @@ int CBuffer::GetCanReadLength() {
         return 0;
     }
 
-    std::unique_lock<std::mutex> lock(_mutex);
     CLoopBuffer* temp = _buffer_read;
     int cur_len = 0;
     while (temp) {
@@ -229,7 +223,6 @@ int CBuffer::GetFreeMemoryBlock(std::vector<iovec>& block_vec, int size) {
     CLoopBuffer* prv_temp = nullptr;
     int cur_len = 0;
     if (size > 0) {
-        std::unique_lock<std::mutex> lock(_mutex);
         while (cur_len < size) {
             if (temp == nullptr) {
                 temp = _pool->PoolNew<CLoopBuffer>(_pool);
@@ -262,7 +255,6 @@ int CBuffer::GetFreeMemoryBlock(std::vector<iovec>& block_vec, int size) {
         _buffer_end = prv_temp;
 
     } else {
-        std::unique_lock<std::mutex> lock(_mutex);
         while (temp) {
             temp->GetFreeMemoryBlock(mem_1, mem_len_1, mem_2, mem_len_2);
             if (mem_len_1 > 0) {
@@ -288,7 +280,6 @@ int CBuffer::GetUseMemoryBlock(std::vector<iovec>& block_vec, int max_size) {
     int mem_len_1 = 0;
     int mem_len_2 = 0;
 
-    std::unique_lock<std::mutex> lock(_mutex);
     CLoopBuffer* temp = _buffer_read;
     int cur_len = 0;
     while (temp) {
@@ -335,6 +326,34 @@ int CBuffer::FindStr(const char* s, int s_len) const {
     return cur_len;
 }
 
+int CBuffer::Append(CBuffer& other) {
+    // take the blocks, nothing to copy
+    if (GetCanReadLength() == 0) {
+        Clear();
+        std::swap(_buff_count, other._buff_count);
+        std::swap(_buffer_read, other._buffer_read);
+        std::swap(_buffer_write, other._buffer_write);
+        std::swap(_buffer_end, other._buffer_end);
+        return GetCanReadLength();
+    }
+
+    std::vector<iovec> block_vec;
+    int cur_len = 0;
+    while (true) {
+        block_vec.clear();
+        int len = other.GetUseMemoryBlock(block_vec);
+        if (len == 0) {
+            break;
+        }
+        for (size_t i = 0; i < block_vec.size(); i++) {
+            Write((const char*)block_vec[i].iov_base, (int)block_vec[i].iov_len);
+        }
+        other.Clear(len);
+        cur_len += len;
+    }
+    return cur_len;
+}
+
 void CBuffer::_Reset() {
     _buffer_end = nullptr;
     _buffer_read = nullptr;
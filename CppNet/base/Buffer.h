@@ -1,7 +1,6 @@
 #ifndef HEADER_BASE_BUFFER
 #define HEADER_BASE_BUFFER
 
-#include <mutex>
 #include <memory>
 #include <vector>
 
@@ -15,6 +14,10 @@ namespace base {
 
     class CLoopBuffer;
     class CMemoryPool;
+    // a list of loop buffers growing as it's written.
+    // not thread safe, only the thread owning the buffer may use it.
+    // threads handing data to the owner lock around their own buffer and
+    // the owner takes it with Append.
     class CBuffer {
     public:
         CBuffer(std::shared_ptr<CMemoryPool>& pool);
@@ -62,6 +65,12 @@ namespace base {
         // return can read bytes
         int FindStr(const char* s, int s_len) const;
 
+        // move all data of other to the end of this buffer, other is empty
+        // after. the blocks of other are taken over when this one is empty.
+        // the two buffers must use the same pool.
+        // return bytes moved
+        int Append(CBuffer& other);
+
         friend std::ostream & operator<< (std::ostream &out, const CLoopBuffer &obj);
     
     private:
@@ -73,7 +82,6 @@ namespace base {
         CLoopBuffer* _buffer_write;
         CLoopBuffer* _buffer_end;
     
-        std::mutex   _mutex;
         std::shared_ptr<CMemoryPool>    _pool;
     };
 
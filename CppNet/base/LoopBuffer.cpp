@@ -43,13 +43,11 @@ int CLoopBuffer::Write(const char* str, int len) {
 
 int CLoopBuffer::Clear(int len) {
     if (len == 0) {
-        std::unique_lock<std::mutex> lock(_mutex);
         _write = _read = _buffer_start;
         _can_read = false;
         return 0;
     }
 
-    std::unique_lock<std::mutex> lock(_mutex);
     if (!_buffer_start) {
         return 0;
     }
@@ -124,7 +122,6 @@ int CLoopBuffer::ReadUntil(char* res, int len, const char* find, int find_len, i
 }
 
 int CLoopBuffer::GetFreeLength() {
-    std::unique_lock<std::mutex> lock(_mutex);
     if (_write > _read) {
         return (int)((_buffer_end - _write) + (_read - _buffer_start));
     
@@ -142,7 +139,6 @@ int CLoopBuffer::GetFreeLength() {
 }
 
 int CLoopBuffer::GetCanReadLength() {
-    std::unique_lock<std::mutex> lock(_mutex);
     if (_write > _read) {
         return (int)(_write - _read);
 
@@ -163,7 +159,6 @@ bool CLoopBuffer::GetFreeMemoryBlock(void*& res1, int& len1, void*& res2, int& l
     res1 = res2 = nullptr;
     len1 = len2 = 0;
 
-    std::unique_lock<std::mutex> lock(_mutex);
     if (_write >= _read) {
         if (_can_read && _write == _read) {
             return false;
@@ -188,7 +183,6 @@ bool CLoopBuffer::GetUseMemoryBlock(void*& res1, int& len1, void*& res2, int& le
     res1 = res2 = nullptr;
     len1 = len2 = 0;
 
-    std::unique_lock<std::mutex> lock(_mutex);
     if (_read >= _write) {
         if (!_can_read && _write == _read) {
             return false;
@@ -210,7 +204,6 @@ bool CLoopBuffer::GetUseMemoryBlock(void*& res1, int& len1, void*& res2, int& le
 }
 
 int CLoopBuffer::FindStr(const char* s, int s_len) {
-    std::unique_lock<std::mutex> lock(_mutex);
     if (_write > _read) {
         const char* find = _FindStrInMem(_read, s, _write - _read, s_len);
         if (find) {
@@ -248,12 +241,10 @@ int CLoopBuffer::FindStr(const char* s, int s_len) {
 }
 
 CLoopBuffer* CLoopBuffer::GetNext() {
-    std::unique_lock<std::mutex> lock(_mutex);
     return _next;
 }
 
 void CLoopBuffer::SetNext(CLoopBuffer* next) {
-    std::unique_lock<std::mutex> lock(_mutex);
     _next = next;
 }
 
@@ -283,7 +274,6 @@ const char* CLoopBuffer::_FindStrInMem(const char* buffer, const char* ch, int b
 }
 
 int CLoopBuffer::_Read(char* res, int len, bool clear) {
-    std::unique_lock<std::mutex> lock(_mutex);
     if (!_buffer_start) {
         return 0;
     }
@@ -348,7 +338,6 @@ int CLoopBuffer::_Read(char* res, int len, bool clear) {
 }
 
 int CLoopBuffer::_Write(const char* str, int len, bool write) {
-    std::unique_lock<std::mutex> lock(_mutex);
     if (_read < _write) {
         if (_write + len <= _buffer_end) {
             if (write) {
@@ -379,7 +368,7 @@ int CLoopBuffer::_Write(const char* str, int len, bool write) {
                 if (can_save > 0 && write) {
                     memcpy(_buffer_start, str + size_end, can_save);
                 }
-                _read = _write;
+                _write = _read;
                 _can_read = true;
                 return  (int)(can_save + size_end);
             }
@@ -1,12 +1,13 @@
 #ifndef HEADER_BASE_LOOPBUFFER
 #define HEADER_BASE_LOOPBUFFER
 
-#include <mutex>
 #include <memory>
 
 namespace base {
 
     class CMemoryPool;
+    // a ring buffer in a large block of the pool.
+    // not thread safe, only the thread owning the buffer may use it.
     class CLoopBuffer {
     public:
         CLoopBuffer(std::shared_ptr<CMemoryPool>& pool);
@@ -73,7 +74,6 @@ namespace base {
         char*    _buffer_start;
         char*    _buffer_end;
         bool     _can_read;         //when _read == _write? Is there any data can be read.
-        std::mutex   _mutex;
         CLoopBuffer* _next;         //point to next node
         std::shared_ptr<CMemoryPool>    _pool;
     };
@@ -0,0 +1,102 @@
+#ifndef HEADER_BASE_MPSCQUEUE
+#define HEADER_BASE_MPSCQUEUE
+
+#include <new>
+#include <atomic>
+#include <thread>
+#include <utility>
+
+#include "ThreadCache.h"
+
+namespace base {
+
+    // unbounded lock free queue, many threads push and one thread pops.
+    // a push is one atomic exchange, nodes come from the thread cache.
+    template<typename T>
+    class CMPSCQueue {
+    public:
+        CMPSCQueue() {
+            Node* stub = _NewNode();
+            _head.store(stub, std::memory_order_relaxed);
+            _tail = stub;
+        }
+
+        ~CMPSCQueue() {
+            T value;
+            while (Pop(value)) {}
+            _DeleteNode(_tail);
+        }
+
+        void Push(const T& element) {
+            Node* node = _NewNode();
+            node->_value = element;
+            _Push(node);
+        }
+
+        void Push(T&& element) {
+            Node* node = _NewNode();
+            node->_value = std::move(element);
+            _Push(node);
+        }
+
+        // only the consumer thread
+        bool Pop(T& value) {
+            Node* tail = _tail;
+            Node* next = tail->_next.load(std::memory_order_acquire);
+            if (!next) {
+                if (_head.load(std::memory_order_acquire) == tail) {
+                    return false;
+                }
+                // a producer swapped the head but didn't link the node yet
+                while (!(next = tail->_next.load(std::memory_order_acquire))) {
+                    std::this_thread::yield();
+                }
+            }
+            value = std::move(next->_value);
+            _tail = next;
+            _DeleteNode(tail);
+            return true;
+        }
+
+        // only the consumer thread
+        bool Empty() {
+            return _head.load(std::memory_order_acquire) == _tail;
+        }
+
+    private:
+        struct Node {
+            std::atomic<Node*>  _next;
+            T                   _value;
+        };
+
+        void _Push(Node* node) {
+            Node* prev = _head.exchange(node, std::memory_order_acq_rel);
+            prev->_next.store(node, std::memory_order_release);
+        }
+
+        Node* _NewNode() {
+            void* mem = sizeof(Node) <= __max_bytes ? CThreadCache::Malloc(sizeof(Node)) : ::operator new(sizeof(Node));
+            Node* node = new(mem) Node();
+            node->_next.store(nullptr, std::memory_order_relaxed);
+            return node;
+        }
+
+        void _DeleteNode(Node* node) {
+            node->~Node();
+            if (sizeof(Node) <= __max_bytes) {
+                CThreadCache::Free(node, sizeof(Node));
+
+            } else {
+                ::operator delete(node);
+            }
+        }
+
+    private:
+        std::atomic<Node*>   _head;
+        // consumer side, apart from the head pushed to by producers
+        char                 _pad[64 - sizeof(std::atomic<Node*>)];
+        Node*                _tail;
+    };
+}
+
+#endif
@@ -10,15 +10,13 @@
 #include <stdexcept>      //for logic_error
 #include <functional>
 
+#include "ThreadCache.h"
 #include "BlockMemoryPool.h"
 
 namespace base {
 
-    static const int __align = 8;
-    static const int __max_bytes = 256;
-    static const int __number_of_free_lists = __max_bytes / __align;
-    static const int __number_add_nodes = 20;
-
+    // small memory comes from the free lists of the calling thread,
+    // see CThreadCache. a pool may be used from any thread without locking.
     class CMemoryPool {
     public:
         // bulk memory size. 
@@ -58,30 +56,7 @@ namespace base {
         void ExpansionLarge(int num = 0);
     
     private:
-        int RoundUp(int size, int align = __align) {
-            return ((size + align - 1) & ~(align - 1));
-        }
-    
-        int FreeListIndex(int size, int align = __align) {
-            return (size + align - 1) / align - 1;
-        }
-    
-        void* ReFill(int size, int num = __number_add_nodes);
-        void* ChunkAlloc(int size, int& nums);
-        
-    private:
-        union MemNode {
-            MemNode*    _next;
-            char        _data[1];
-        };
-    
-        MemNode*     _free_list[__number_of_free_lists];    
-        char*        _pool_start;                    
-        char*        _pool_end;                
         std::thread::id            _create_thread_id;
-        std::vector<char*>         _malloc_vec;
-        std::recursive_mutex       _mutex;
-
         CBlockMemoryPool           _block_pool;
     };
     
@@ -93,17 +68,9 @@ namespace base {
             T* res = new(bytes) T(std::forward<Args>(args)...);
             return res;
         }
-    
-        std::unique_lock<std::recursive_mutex> lock(_mutex);
-        MemNode** my_free = &(_free_list[FreeListIndex(sz)]);
-        MemNode* result = *my_free;
-        if (result == nullptr) {
-            void* bytes = ReFill(RoundUp(sz));
-            T* res = new(bytes) T(std::forward<Args>(args)...);
-            return res;
-        }
-        *my_free = result->_next;
-        T* res = new(result) T(std::forward<Args>(args)...);
+
+        void* bytes = CThreadCache::Malloc(sz);
+        T* res = new(bytes) T(std::forward<Args>(args)...);
         return res;
     }
     
@@ -121,13 +88,8 @@ namespace base {
             return;
         }
     
-        MemNode* node = (MemNode*)c;
-        std::unique_lock<std::recursive_mutex> lock(_mutex);
-        MemNode** my_free = &(_free_list[FreeListIndex(sz)]);
-    
         c->~T();
-        node->_next = *my_free;
-        *my_free = node;
+        CThreadCache::Free(c, sz);
         c = nullptr;
     }
     
@@ -138,19 +100,10 @@ namespace base {
             memset(bytes, 0, sz);
             return (T*)bytes;
         }
-    
-        std::unique_lock<std::recursive_mutex> lock(_mutex);
-        MemNode** my_free = &(_free_list[FreeListIndex(sz)]);
-        MemNode* result = *my_free;
-        if (result == nullptr) {
-            void* bytes = ReFill(RoundUp(sz));
-            memset(bytes, 0, sz);
-            return (T*)bytes;
-        }
-    
-        *my_free = result->_next;
-        memset(result, 0, sz);
-        return (T*)result;
+
+        void* bytes = CThreadCache::Malloc(sz);
+        memset(bytes, 0, sz);
+        return (T*)bytes;
     }
     
     template<typename T>
@@ -165,12 +118,7 @@ namespace base {
             return;
         }
     
-        MemNode* node = (MemNode*)m;
-        std::unique_lock<std::recursive_mutex> lock(_mutex);
-        MemNode** my_free = &(_free_list[FreeListIndex(len)]);
-    
-        node->_next = *my_free;
-        *my_free = node;
+        CThreadCache::Free(m, len);
         m = nullptr;
     }
     
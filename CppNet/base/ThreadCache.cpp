@@ -0,0 +1,308 @@
+#include <mutex>
+#include <vector>
+#include <stdlib.h>
+
+#include "ThreadCache.h"
+#include "Log.h"
+
+using namespace base;
+
+namespace {
+
+    union MemNode {
+        MemNode*    _next;
+        char        _data[1];
+    };
+
+    struct Chain {
+        MemNode*    _head;
+        int         _num;
+    };
+
+    // chains of free nodes of one size class, or of bulk memory of one size
+    struct DepotList {
+        std::mutex            _mutex;
+        std::vector<Chain>    _chains;
+        int                   _num;    // nodes in all chains
+        int                   _block_size;
+    };
+
+    struct BlockList {
+        int         _block_size;
+        int         _num;
+        MemNode*    _head;
+        DepotList*  _depot;
+    };
+
+    // trivially destructible, so still usable while the thread's
+    // destructors run after its lists went back to the depot.
+    struct ThreadLists {
+        MemNode*    _free_list[__number_of_free_lists];
+        int         _free_num[__number_of_free_lists];
+        BlockList   _block_list[__number_of_block_lists];
+        bool        _registered;
+        bool        _released;
+    };
+
+    thread_local ThreadLists __thread_lists;
+
+    // never destroyed, threads and static objects may free to them at exit.
+    DepotList* GetDepot() {
+        static DepotList* depot = new DepotList[__number_of_free_lists]();
+        return depot;
+    }
+
+    DepotList* GetBlockDepot(int block_size) {
+        static std::mutex* mutex = new std::mutex;
+        static DepotList* depot = new DepotList[__number_of_block_lists]();
+        std::unique_lock<std::mutex> lock(*mutex);
+        for (int i = 0; i < __number_of_block_lists; i++) {
+            if (depot[i]._block_size == block_size) {
+                return &depot[i];
+            }
+            if (depot[i]._block_size == 0) {
+                depot[i]._block_size = block_size;
+                return &depot[i];
+            }
+        }
+        return nullptr;
+    }
+
+    void* MallocOrDie(int size) {
+        void* mem = malloc(size);
+        if (!mem) {
+            LOG_FATAL("malloc memory failed! size : %d", size);
+            abort();
+        }
+        return mem;
+    }
+
+    // carve a new chunk into a chain of __number_add_nodes nodes
+    MemNode* NewChain(int size) {
+        char* chunk = (char*)MallocOrDie(size * __number_add_nodes);
+        for (int i = 0; i < __number_add_nodes - 1; i++) {
+            ((MemNode*)(chunk + i * size))->_next = (MemNode*)(chunk + (i + 1) * size);
+        }
+        ((MemNode*)(chunk + (__number_add_nodes - 1) * size))->_next = nullptr;
+        return (MemNode*)chunk;
+    }
+
+    void PushChain(DepotList& depot, MemNode* head, int num) {
+        std::unique_lock<std::mutex> lock(depot._mutex);
+        depot._chains.push_back(Chain{head, num});
+        depot._num += num;
+    }
+
+    bool PopChain(DepotList& depot, Chain& chain) {
+        std::unique_lock<std::mutex> lock(depot._mutex);
+        if (depot._chains.empty()) {
+            return false;
+        }
+        chain = depot._chains.back();
+        depot._chains.pop_back();
+        depot._num -= chain._num;
+        return true;
+    }
+
+    // return a chain of small nodes from the depot, or a new one
+    Chain PopChain(int index) {
+        Chain chain;
+        if (!PopChain(GetDepot()[index], chain)) {
+            chain = Chain{NewChain((index + 1) * __align), __number_add_nodes};
+        }
+        return chain;
+    }
+
+    void FreeChain(MemNode* head) {
+        while (head) {
+            MemNode* next = head->_next;
+            free(head);
+            head = next;
+        }
+    }
+
+    // bulk memory over __max_thread_blocks a thread gives back to the depot,
+    // which keeps up to __max_depot_blocks blocks and frees the rest.
+    void PushBlockChain(DepotList* depot, MemNode* head, int num) {
+        if (depot) {
+            std::unique_lock<std::mutex> lock(depot->_mutex);
+            if (depot->_num + num <= __max_depot_blocks) {
+                depot->_chains.push_back(Chain{head, num});
+                depot->_num += num;
+                return;
+            }
+        }
+        FreeChain(head);
+    }
+
+    // take the first num nodes off a list
+    MemNode* SplitChain(MemNode*& head, int num) {
+        MemNode* chain = head;
+        MemNode* node = head;
+        for (int i = 1; i < num; i++) {
+            node = node->_next;
+        }
+        head = node->_next;
+        node->_next = nullptr;
+        return chain;
+    }
+
+    void ReleaseThreadLists();
+
+    class CThreadRelease {
+    public:
+        ~CThreadRelease() {
+            ReleaseThreadLists();
+        }
+    };
+
+    // lists are used since here, return them at thread exit
+    ThreadLists& GetThreadLists() {
+        ThreadLists& lists = __thread_lists;
+        if (!lists._registered) {
+            lists._registered = true;
+            static thread_local CThreadRelease release;
+            (void)release;
+        }
+        return lists;
+    }
+
+    void ReleaseThreadLists() {
+        ThreadLists& lists = __thread_lists;
+        for (int i = 0; i < __number_of_free_lists; i++) {
+            if (lists._free_list[i]) {
+                PushChain(GetDepot()[i], lists._free_list[i], lists._free_num[i]);
+                lists._free_list[i] = nullptr;
+                lists._free_num[i] = 0;
+            }
+        }
+        for (int i = 0; i < __number_of_block_lists; i++) {
+            BlockList& block = lists._block_list[i];
+            if (block._head) {
+                PushBlockChain(block._depot, block._head, block._num);
+                block._head = nullptr;
+                block._num = 0;
+            }
+        }
+        lists._released = true;
+    }
+
+    // return nullptr if this thread caches too many sizes already
+    BlockList* FindBlockList(ThreadLists& lists, int block_size) {
+        for (int i = 0; i < __number_of_block_lists; i++) {
+            BlockList& block = lists._block_list[i];
+            if (block._block_size == block_size) {
+                return &block;
+            }
+            if (block._block_size == 0) {
+                block._block_size = block_size;
+                block._depot = GetBlockDepot(block_size);
+                return &block;
+            }
+        }
+        return nullptr;
+    }
+}
+
+void* CThreadCache::Malloc(int size) {
+    int index = FreeListIndex(size);
+    ThreadLists& lists = GetThreadLists();
+    if (lists._released) {
+        // thread is exiting, go to the depot directly
+        Chain chain = PopChain(index);
+        if (chain._num > 1) {
+            PushChain(GetDepot()[index], chain._head->_next, chain._num - 1);
+        }
+        return chain._head;
+    }
+
+    MemNode* result = lists._free_list[index];
+    if (!result) {
+        Chain chain = PopChain(index);
+        result = chain._head;
+        lists._free_num[index] = chain._num;
+    }
+    lists._free_list[index] = result->_next;
+    lists._free_num[index]--;
+    return result;
+}
+
+void CThreadCache::Free(void* m, int size) {
+    int index = FreeListIndex(size);
+    MemNode* node = (MemNode*)m;
+    ThreadLists& lists = GetThreadLists();
+    if (lists._released) {
+        node->_next = nullptr;
+        PushChain(GetDepot()[index], node, 1);
+        return;
+    }
+
+    node->_next = lists._free_list[index];
+    lists._free_list[index] = node;
+    // keep up to two batches, so that a thread allocating and freeing
+    // around a batch boundary doesn't go to the depot every time.
+    if (++lists._free_num[index] >= 2 * __number_add_nodes) {
+        MemNode* chain = SplitChain(lists._free_list[index], __number_add_nodes);
+        lists._free_num[index] -= __number_add_nodes;
+        PushChain(GetDepot()[index], chain, __number_add_nodes);
+    }
+}
+
+void* CThreadCache::BlockMalloc(int block_size) {
+    ThreadLists& lists = GetThreadLists();
+    BlockList* block = lists._released ? nullptr : FindBlockList(lists, block_size);
+    if (!block) {
+        return MallocOrDie(block_size);
+    }
+    if (!block->_head) {
+        Chain chain;
+        if (!block->_depot || !PopChain(*block->_depot, chain)) {
+            // not memset!
+            return MallocOrDie(block_size);
+        }
+        block->_head = chain._head;
+        block->_num = chain._num;
+    }
+    MemNode* result = block->_head;
+    block->_head = result->_next;
+    block->_num--;
+    return result;
+}
+
+void CThreadCache::BlockFree(void* m, int block_size) {
+    ThreadLists& lists = GetThreadLists();
+    BlockList* block = lists._released ? nullptr : FindBlockList(lists, block_size);
+    if (!block) {
+        free(m);
+        return;
+    }
+    MemNode* node = (MemNode*)m;
+    node->_next = block->_head;
+    block->_head = node;
+    if (++block->_num >= __max_thread_blocks) {
+        MemNode* chain = SplitChain(block->_head, __number_add_nodes);
+        block->_num -= __number_add_nodes;
+        PushBlockChain(block->_depot, chain, __number_add_nodes);
+    }
+}
+
+int CThreadCache::GetBlockNum(int block_size) {
+    BlockList* block = FindBlockList(__thread_lists, block_size);
+    return block ? block->_num : 0;
+}
+
+void CThreadCache::ReleaseBlockHalf(int block_size) {
+    BlockList* block = FindBlockList(__thread_lists, block_size);
+    if (!block || block->_num == 0) {
+        return;
+    }
+    int half = block->_num / 2;
+    FreeChain(SplitChain(block->_head, block->_num - half));
+    block->_num = half;
+}
+
+void CThreadCache::ExpansionBlock(int block_size, int num) {
+    for (int i = 0; i < num; ++i) {
+        BlockFree(MallocOrDie(block_size), block_size);
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef HEADER_BASE_THREADCACHE
+#define HEADER_BASE_THREADCACHE
+
+namespace base {
+
+    static const int __align = 8;
+    static const int __max_bytes = 256;
+    static const int __number_of_free_lists = __max_bytes / __align;
+    // nodes moved between a thread and the depot at a time
+    static const int __number_add_nodes = 20;
+    // bulk memory sizes cached, and blocks of each kept at most
+    // by a thread and by the depot. the depot holds at most
+    // __max_depot_blocks * block_size bytes of each size.
+    static const int __number_of_block_lists = 4;
+    static const int __max_thread_blocks = 64;
+    static const int __max_depot_blocks = 1024;
+
+    // per thread free lists in front of a process wide depot.
+    // small nodes come from size class lists of the calling thread, which take
+    // and give back __number_add_nodes nodes at a time to the depot, so only
+    // one of that many allocations touches a lock. bulk memory blocks are cached
+    // per thread by size. memory freed on another thread than the one which
+    // allocated it goes to the lists of the freeing thread.
+    // all lists of a thread return to the depot when it exits.
+    // small nodes are carved from chunks of __number_add_nodes and never go
+    // back to the system, what is cached of a size class is bounded by the
+    // most nodes of it ever in use at once. bulk memory over the depot
+    // bound is freed.
+    class CThreadCache {
+    public:
+        // size must not be more than __max_bytes, 0 gets the smallest class
+        static void* Malloc(int size);
+        static void Free(void* m, int size);
+
+        // for bulk memory of block_size
+        static void* BlockMalloc(int block_size);
+        static void BlockFree(void* m, int block_size);
+
+        // return bulk memory num cached by this thread
+        static int GetBlockNum(int block_size);
+        // release half bulk memory cached by this thread
+        static void ReleaseBlockHalf(int block_size);
+        static void ExpansionBlock(int block_size, int num);
+
+        static int RoundUp(int size, int align = __align) {
+            return ((size + align - 1) & ~(align - 1));
+        }
+
+        static int FreeListIndex(int size, int align = __align) {
+            return size > 0 ? (size + align - 1) / align - 1 : 0;
+        }
+    };
+}
+
+#endif
@@ -15,6 +15,10 @@ static const uint16_t __mem_block_add_step = 5;
 
 // address buffer length in socket.
 static const uint16_t __addr_str_len       = 16;
+// handles below this number are found by index in socket registry, others by map.
+static const uint32_t __socket_slot_num     = 1024 * 1024;
+// slots in socket registry allocated at a time.
+static const uint32_t __socket_slot_segment = 1024;
 // log level. 
 static const base::LogLevel __log_level    = base::LOG_DEBUG_LEVEL;
 // log file name .
@@ -32,6 +36,8 @@ static const uint16_t __linux_read_buff_expand_len = 4096;
 static const uint32_t __linux_read_buff_expand_max = 65536;
 // max size of buffer will get from buffer. Be careful IOV_MAX.
 static const uint16_t __linux_write_buff_get       = 4096;
+// max posted tasks run by an io thread before it checks io again.
+static const uint32_t __max_task_batch             = 1024;
 
 #else
 
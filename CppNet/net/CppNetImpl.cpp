@@ -198,8 +198,7 @@ Handle CCppNetImpl::Connection(uint16_t port, std::string ip, const char* buf, u
     base::CMemSharePtr<CSocketImpl> sock = base::MakeNewSharedPtr<CSocketImpl>(&_pool, actions);
     sock->SyncConnection(ip, port, buf, buf_len);
 
-    std::unique_lock<std::mutex> lock(_mutex);
-    _socket_map[sock->GetSocket()] = sock;
+    _socket_map.Add(sock->GetSocket(), sock);
     return sock->GetSocket();
 }
 #endif
@@ -217,10 +216,7 @@ Handle CCppNetImpl::Connection(uint16_t port, std::string ip) {
     auto actions = _RandomGetActions();
     base::CMemSharePtr<CSocketImpl> sock = base::MakeNewSharedPtr<CSocketImpl>(&_pool, actions);
 #ifndef __linux__
-    {
-        std::unique_lock<std::mutex> lock(_mutex);
-        _socket_map[sock->GetSocket()] = sock;
-    }
+    _socket_map.Add(sock->GetSocket(), sock);
     sock->SyncConnection(ip, port, "", 0);
 #else
     //create socket
@@ -230,32 +226,18 @@ Handle CCppNetImpl::Connection(uint16_t port, std::string ip) {
         return 0;
     }
     sock->SetSocket(temp_socket);
-    {
-        std::unique_lock<std::mutex> lock(_mutex);
-        _socket_map[sock->GetSocket()] = sock;
-    }
+    _socket_map.Add(sock->GetSocket(), sock);
     sock->SyncConnection(ip, port);
 #endif
     return sock->GetSocket();
 }
 
 base::CMemSharePtr<CSocketImpl> CCppNetImpl::GetSocket(const Handle& handle) {
-    std::unique_lock<std::mutex> lock(_mutex);
-    auto iter = _socket_map.find(handle);
-    if (iter != _socket_map.end()) {
-        return iter->second;
-    }
-    return nullptr;
+    return _socket_map.Get(handle);
 }
 
 bool CCppNetImpl::RemoveSocket(const Handle& handle) {
-    std::unique_lock<std::mutex> lock(_mutex);
-    auto iter = _socket_map.find(handle);
-    if (iter != _socket_map.end()) {
-        _socket_map.erase(iter);
-        return true;
-    }
-    return false;
+    return _socket_map.Remove(handle);
 }
 
 uint32_t CCppNetImpl::GetThreadNum() {
@@ -269,12 +251,9 @@ void CCppNetImpl::_AcceptFunction(base::CMemSharePtr<CSocketImpl>& sock, uint32_
     }
     
     Handle handle = sock->GetSocket();
-    {
-        // add socket to map
-        std::unique_lock<std::mutex> lock(_mutex);
-        _socket_map[handle] = sock;
-        base::LOG_DEBUG("get client num : %d", int(_socket_map.size()));
-    }
+    // add socket to map
+    _socket_map.Add(handle, sock);
+    base::LOG_DEBUG("get client num : %d", int(_socket_map.Size()));
     err = CEC_SUCCESS;
     if (_accept_call_back) {
         _accept_call_back(handle, err);
@@ -306,16 +285,12 @@ void CCppNetImpl::_ReadFunction(base::CMemSharePtr<CEventHandler>& event, uint32
             socket_ptr->SyncRead();
             
         } else {
-            std::unique_lock<std::mutex> lock(_mutex);
-            _socket_map.erase(socket_ptr->GetSocket());
+            _socket_map.Remove(socket_ptr->GetSocket());
         }
 
     } else if (err & EVENT_DISCONNECT) {
         if (err & ERR_CONNECT_CLOSE) {
-            {
-                std::unique_lock<std::mutex> lock(_mutex);
-                _socket_map.erase(socket_ptr->GetSocket());
-            }
+            _socket_map.Remove(socket_ptr->GetSocket());
             err = CEC_SUCCESS;
             if (_disconnection_call_back) {
                 _disconnection_call_back(handle, err);
@@ -359,8 +334,7 @@ void CCppNetImpl::_ReadFunction(base::CMemSharePtr<CEventHandler>& event, uint32
     if (err == CEC_CLOSED 
         || err == CEC_CONNECT_BREAK 
         || err == CEC_CONNECT_REFUSE) {
-        std::unique_lock<std::mutex> lock(_mutex);
-        _socket_map.erase(socket_ptr->GetSocket());
+        _socket_map.Remove(socket_ptr->GetSocket());
     }
 #endif
 }
@@ -404,8 +378,7 @@ void CCppNetImpl::_WriteFunction(base::CMemSharePtr<CEventHandler>& event, uint3
 
     if (err == CEC_CLOSED
        || err == CEC_CONNECT_BREAK) {
-        std::unique_lock<std::mutex> lock(_mutex);
-        _socket_map.erase(socket_ptr->GetSocket());
+        _socket_map.Remove(socket_ptr->GetSocket());
 
     } else {
         if (socket_ptr->GetPoolSize() >= __max_block_num) {
@@ -12,6 +12,7 @@
 #include "MemoryPool.h"
 #include "EventHandler.h"
 #include "PoolSharedPtr.h"
+#include "SocketRegistry.h"
 
 namespace cppnet {
 
@@ -69,10 +70,9 @@ namespace cppnet {
         connection_call_back    _accept_call_back        = nullptr;
         
         base::CMemoryPool       _pool;
-        std::mutex              _mutex;
+        CSocketRegistry         _socket_map;
         std::vector<std::shared_ptr<std::thread>>                                _thread_vec;
         std::unordered_map<uint64_t, base::CMemSharePtr<CAcceptSocket>>          _accept_socket;
-        std::unordered_map<uint64_t, base::CMemSharePtr<CSocketImpl>>            _socket_map;
         std::unordered_map<std::thread::id, std::shared_ptr<CEventActions>>      _actions_map;
         std::unordered_map<uint64_t, std::weak_ptr<CEventActions>>               _timer_actions_map;
     };
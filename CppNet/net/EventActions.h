@@ -43,6 +43,8 @@ namespace cppnet {
         virtual void PostTask(std::function<void(void)>&) = 0;
         // weak up net io thread
         virtual void WakeUp() = 0;
+        // whether sockets of these actions can be handled right here
+        virtual bool InLoopThread() = 0;
 
         virtual CTimer& Timer() { return _timer; }
     protected:
@@ -43,6 +43,14 @@ namespace cppnet {
         void*                       _timer_param;
         std::function<void(void*)>  _timer_call_back;   // only timer event
         base::CMemWeakPtr<CEventHandler>  _event;
+
+        CTimerEvent() : _event_flag(0), _timer_id(0), _interval(0), _timer_param(nullptr) {}
+        // timeout events are returned by value in a vector
+        CTimerEvent(CTimerEvent&& other) : _event_flag(other._event_flag), _timer_id(other._timer_id),
+            _interval(other._interval), _timer_param(other._timer_param) {
+            _timer_call_back.swap(other._timer_call_back);
+            _event = other._event;
+        }
     };
 
     class CBuffer;
@@ -1,6 +1,7 @@
 #ifndef HEADER_NET_CSOCKETIMPL
 #define HEADER_NET_CSOCKETIMPL
 
+#include <mutex>
 #include <string>
 #include <memory>
 #include <atomic>
@@ -35,6 +36,11 @@ namespace cppnet {
         friend class CAcceptSocket;
         void Recv(base::CMemSharePtr<CEventHandler>& event);
         void Send(base::CMemSharePtr<CEventHandler>& event);
+#ifdef __linux__
+    private:
+        // move writes of other threads to the write buffer and send, on the io thread
+        void _FlushWrite();
+#endif
 
     public:
         base::CMemSharePtr<CEventHandler>        _read_event;
@@ -42,6 +48,18 @@ namespace cppnet {
 #ifndef __linux__
         //iocp use it save post event num;
         std::atomic<int16_t>                     _post_event_num;
+        // writes may come from any thread, the buffers don't lock
+        std::mutex                               _write_mutex;
+#else
+        // writes of other threads wait here for the io thread.
+        // the socket buffers are only used by the io thread
+        std::mutex                               _posted_mutex;
+        base::CMemSharePtr<base::CBuffer>        _posted_buffer;
+        // a flush of posted writes is queued to the io thread
+        std::atomic_bool                         _write_posted;
+        // without __per_handle_thread all io threads share one epoll and
+        // run tasks and events of any socket, so the write buffer locks
+        std::mutex                               _write_mutex;
 #endif
     };
 }
@@ -0,0 +1,167 @@
+#include <new>
+#include <thread>
+#include <stdint.h>
+
+#include "SocketImpl.h"
+#include "SocketRegistry.h"
+
+using namespace cppnet;
+
+static const uint32_t __socket_segment_num = __socket_slot_num / __socket_slot_segment;
+
+CSocketRegistry::CSlotLock::CSlotLock(Slot& slot) : _slot(slot) {
+    while (_slot._lock.test_and_set(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+CSocketRegistry::CSlotLock::~CSlotLock() {
+    _slot._lock.clear(std::memory_order_release);
+}
+
+CSocketRegistry::CSocketRegistry() : _size(0) {
+    for (uint32_t i = 0; i < __socket_segment_num; i++) {
+        _segments[i] = nullptr;
+    }
+}
+
+CSocketRegistry::~CSocketRegistry() {
+    Clear();
+    for (uint32_t i = 0; i < __socket_segment_num; i++) {
+        _DeleteSegment(_segments[i].load());
+    }
+}
+
+void CSocketRegistry::Add(const Handle& handle, const base::CMemSharePtr<CSocketImpl>& sock) {
+    Slot* slot = _GetSlot(handle, true);
+    if (!slot) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_socket_map.find(handle) == _socket_map.end()) {
+            _size++;
+        }
+        _socket_map[handle] = sock;
+        return;
+    }
+
+    // release the replaced one out of the slot lock
+    base::CMemSharePtr<CSocketImpl> old;
+    {
+        CSlotLock lock(*slot);
+        old = slot->_socket;
+        slot->_socket.Reset();
+        slot->_socket = sock;
+    }
+    if (!old) {
+        _size++;
+    }
+}
+
+base::CMemSharePtr<CSocketImpl> CSocketRegistry::Get(const Handle& handle) {
+    Slot* slot = _GetSlot(handle, false);
+    if (!slot) {
+        if (handle < __socket_slot_num) {
+            return nullptr;
+        }
+        std::unique_lock<std::mutex> lock(_mutex);
+        auto iter = _socket_map.find(handle);
+        if (iter != _socket_map.end()) {
+            return iter->second;
+        }
+        return nullptr;
+    }
+
+    CSlotLock lock(*slot);
+    return slot->_socket;
+}
+
+bool CSocketRegistry::Remove(const Handle& handle) {
+    Slot* slot = _GetSlot(handle, false);
+    if (!slot) {
+        if (handle < __socket_slot_num) {
+            return false;
+        }
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_socket_map.erase(handle) > 0) {
+            _size--;
+            return true;
+        }
+        return false;
+    }
+
+    base::CMemSharePtr<CSocketImpl> old;
+    {
+        CSlotLock lock(*slot);
+        old = slot->_socket;
+        slot->_socket.Reset();
+    }
+    if (old) {
+        _size--;
+        return true;
+    }
+    return false;
+}
+
+uint32_t CSocketRegistry::Size() {
+    return _size;
+}
+
+void CSocketRegistry::Clear() {
+    for (uint32_t i = 0; i < __socket_segment_num; i++) {
+        Slot* segment = _segments[i].load();
+        if (!segment) {
+            continue;
+        }
+        for (uint32_t j = 0; j < __socket_slot_segment; j++) {
+            Remove(i * __socket_slot_segment + j);
+        }
+    }
+    std::unique_lock<std::mutex> lock(_mutex);
+    _size -= (uint32_t)_socket_map.size();
+    _socket_map.clear();
+}
+
+CSocketRegistry::Slot* CSocketRegistry::_GetSlot(const Handle& handle, bool create) {
+    if (handle >= __socket_slot_num) {
+        return nullptr;
+    }
+    std::atomic<Slot*>& segment = _segments[handle / __socket_slot_segment];
+    Slot* slots = segment.load(std::memory_order_acquire);
+    if (!slots) {
+        if (!create) {
+            return nullptr;
+        }
+        Slot* new_slots = _NewSegment();
+        if (segment.compare_exchange_strong(slots, new_slots, std::memory_order_acq_rel)) {
+            slots = new_slots;
+
+        } else {
+            // another thread was first
+            _DeleteSegment(new_slots);
+        }
+    }
+    return &slots[handle % __socket_slot_segment];
+}
+
+CSocketRegistry::Slot* CSocketRegistry::_NewSegment() {
+    // the allocated address is kept right before the aligned slots
+    char* mem = new char[sizeof(Slot) * __socket_slot_segment + alignof(Slot) + sizeof(char*)];
+    uintptr_t start = (uintptr_t)(mem + sizeof(char*));
+    start = (start + alignof(Slot) - 1) & ~(uintptr_t)(alignof(Slot) - 1);
+    ((char**)start)[-1] = mem;
+
+    Slot* slots = (Slot*)start;
+    for (uint32_t i = 0; i < __socket_slot_segment; i++) {
+        new (&slots[i]) Slot();
+    }
+    return slots;
+}
+
+void CSocketRegistry::_DeleteSegment(Slot* slots) {
+    if (!slots) {
+        return;
+    }
+    for (uint32_t i = 0; i < __socket_slot_segment; i++) {
+        slots[i].~Slot();
+    }
+    delete[] ((char**)slots)[-1];
+}
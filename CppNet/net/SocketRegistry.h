@@ -0,0 +1,65 @@
+#ifndef HEADER_NET_CSOCKETREGISTRY
+#define HEADER_NET_CSOCKETREGISTRY
+
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+
+#include "CNConfig.h"
+#include "PoolSharedPtr.h"
+
+namespace cppnet {
+
+    class CSocketImpl;
+    // sockets by handle.
+    // handles below __socket_slot_num are kept in a flat array indexed by handle,
+    // every slot guarded by its own flag, so threads working on different sockets
+    // never share a lock. segments of the array are allocated on first use.
+    // the other handles, only seen on windows, go to a map behind a mutex.
+    class CSocketRegistry {
+    public:
+        CSocketRegistry();
+        ~CSocketRegistry();
+
+        // add or replace the socket of handle
+        void Add(const Handle& handle, const base::CMemSharePtr<CSocketImpl>& sock);
+        // return the socket of handle, or a null one
+        base::CMemSharePtr<CSocketImpl> Get(const Handle& handle);
+        // return false if there is no socket of handle
+        bool Remove(const Handle& handle);
+        // return number of sockets
+        uint32_t Size();
+        void Clear();
+
+    private:
+        // a cache line each, threads on neighbouring handles share none
+        struct alignas(64) Slot {
+            std::atomic_flag                   _lock = ATOMIC_FLAG_INIT;
+            base::CMemSharePtr<CSocketImpl>    _socket;
+        };
+
+        class CSlotLock {
+        public:
+            CSlotLock(Slot& slot);
+            ~CSlotLock();
+        private:
+            Slot&    _slot;
+        };
+
+        // return nullptr if handle is out of the array
+        Slot* _GetSlot(const Handle& handle, bool create);
+
+        // new[] doesn't align Slot before c++17
+        static Slot* _NewSegment();
+        static void _DeleteSegment(Slot* slots);
+
+    private:
+        std::atomic<Slot*>        _segments[__socket_slot_num / __socket_slot_segment];
+        std::atomic<uint32_t>     _size;
+
+        std::mutex                _mutex;
+        std::unordered_map<uint64_t, base::CMemSharePtr<CSocketImpl>>    _socket_map;
+    };
+
+}
+#endif
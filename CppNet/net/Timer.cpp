@@ -1,131 +1,364 @@
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <stdint.h>
+#include <string.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 #include "Log.h"
 #include "Timer.h"
 #include "EventHandler.h"
 
 using namespace cppnet;
 
-CTimer::CTimer() : _pool(new base::CMemoryPool(1024, 20)) {
+namespace cppnet {
+    struct CTimerNode {
+        CTimerEvent     _event;
+        uint64_t        _expire;
+        uint32_t        _slot;
+        CTimerNode*     _prev;
+        CTimerNode*     _next;
+    };
+}
+
+namespace {
+    int LowestBit(uint64_t bits) {
+#ifdef _MSC_VER
+        unsigned long index = 0;
+        _BitScanForward64(&index, bits);
+        return (int)index;
+#else
+        return __builtin_ctzll(bits);
+#endif
+    }
+
+    // first slot of a level in the slot array
+    uint32_t LevelFirst(uint32_t level) {
+        return level == 0 ? 0 : __wheel_size0 + (level - 1) * __wheel_size;
+    }
+
+    // ids are sequential, spread them over the table
+    size_t IdHash(uint64_t timer_id) {
+        return (size_t)((timer_id * 0x9E3779B97F4A7C15ull) >> 32);
+    }
 
+    // bits of the time a slot of a level stands for
+    uint32_t LevelShift(uint32_t level) {
+        return __wheel_bits0 + (level - 1) * __wheel_bits;
+    }
+}
+
+CTimer::CTimer() : _cur_tick(Now()), _free_list(nullptr), _timer_num(0) {
+    memset(_slots, 0, sizeof(_slots));
+    memset(_bitmap, 0, sizeof(_bitmap));
 }
 
 CTimer::~CTimer() {
+    for (size_t i = 0; i < _blocks.size(); i++) {
+        delete[] _blocks[i];
+    }
+}
+
+uint64_t CTimer::NewTimerId() {
+    static std::atomic<uint64_t> timer_id(0);
+    return ++timer_id;
+}
 
+uint64_t CTimer::Now() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
 uint64_t CTimer::AddTimer(uint32_t interval, const std::function<void(void*)>& call_back, void* param, bool always) {
-    base::CMemSharePtr<CTimerEvent> timer_event = base::MakeNewSharedPtr<CTimerEvent>(_pool.get());
-    timer_event->_timer_call_back = call_back;
-    timer_event->_interval        = interval;
-    timer_event->_event_flag      |= EVENT_TIMER;
-    timer_event->_timer_param     = param;
+    uint64_t timer_id = NewTimerId();
+    AddTimer(timer_id, interval, call_back, param, always);
+    return timer_id;
+}
+
+uint64_t CTimer::AddTimer(uint32_t interval, base::CMemSharePtr<CEventHandler>& event) {
+    CTimerNode* node = _NewNode(NewTimerId(), interval);
+    node->_event._event_flag |= EVENT_TIMER | event->_event_flag_set;
+    node->_event._event      = event;
+    _Insert(node);
+    return node->_event._timer_id;
+}
+
+void CTimer::AddTimer(uint64_t timer_id, uint32_t interval, const std::function<void(void*)>& call_back, void* param, bool always) {
+    CTimerNode* node = _NewNode(timer_id, interval);
+    node->_event._timer_call_back = call_back;
+    node->_event._event_flag      |= EVENT_TIMER;
+    node->_event._timer_param     = param;
 
     if (always) {
-        timer_event->_event_flag |= EVENT_TIMER_ALWAYS;
+        node->_event._event_flag |= EVENT_TIMER_ALWAYS;
     }
+    _Insert(node);
+}
 
-    _AddTimer(interval, timer_event, timer_event->_timer_id);
-
-    _fix_timer_id_map[timer_event->_timer_id] = timer_event;
+bool CTimer::DelTimer(uint64_t timerid) {
+    CTimerNode* node = _UnlinkId(timerid);
+    if (!node) {
+        return false;
+    }
+    _Remove(node);
+    _FreeNode(node);
+    return true;
+}
 
-    return timer_event->_timer_id;
+uint32_t CTimer::TimeoutCheck(std::vector<CTimerEvent>& res) {
+    return TimeoutCheck(Now(), res);
 }
 
-uint64_t CTimer::AddTimer(uint32_t interval, base::CMemSharePtr<CTimerEvent>& event) {
-    event->_interval = interval;
-    event->_event_flag |= EVENT_TIMER;
+uint32_t CTimer::TimeoutCheck(uint64_t nowtime, std::vector<CTimerEvent>& res) {
+    if (_timer_num == 0) {
+        _cur_tick = nowtime + 1;
+        return 0;
+    }
 
-    _AddTimer(interval, event, event->_timer_id);
+    while (_cur_tick <= nowtime) {
+        uint32_t index = _cur_tick & (__wheel_size0 - 1);
+        if (index == 0) {
+            for (uint32_t level = 1; level < __wheel_levels && _Cascade(level) == 0; level++) {}
+        }
 
-    _fix_timer_id_map[event->_timer_id] = event;
+        // slots before index are of the next round
+        int distance = _FindSlot(0, __wheel_size0, index);
+        if (distance < 0 || index + distance >= __wheel_size0) {
+            _cur_tick = std::min((_cur_tick | (__wheel_size0 - 1)) + 1, nowtime + 1);
+            continue;
+        }
+        if (_cur_tick + distance > nowtime) {
+            _cur_tick = nowtime + 1;
+            break;
+        }
+        _cur_tick += distance;
+        _Expire(index + distance, nowtime, res);
+        _cur_tick++;
+    }
+    return _RecentTimeout(nowtime);
+}
 
-    return event->_timer_id;
+uint32_t CTimer::GetTimerNum() {
+    return _timer_num;
 }
 
-uint64_t CTimer::AddTimer(uint32_t interval, base::CMemSharePtr<CEventHandler>& event) {
-    base::CMemSharePtr<CTimerEvent> timer_event = base::MakeNewSharedPtr<CTimerEvent>(_pool.get());
-    timer_event->_interval   = interval;
-    timer_event->_event_flag |= EVENT_TIMER | event->_event_flag_set;
-    timer_event->_event      = event;
+CTimerNode* CTimer::_NewNode(uint64_t timer_id, uint32_t interval) {
+    if (!_free_list) {
+        CTimerNode* block = new CTimerNode[__timer_block_num];
+        for (uint32_t i = 0; i < __timer_block_num - 1; i++) {
+            block[i]._next = &block[i + 1];
+        }
+        block[__timer_block_num - 1]._next = nullptr;
+        _free_list = block;
+        _blocks.push_back(block);
+    }
 
-    _AddTimer(interval, timer_event, timer_event->_timer_id);
+    uint64_t nowtime = Now();
+    // nothing to check since the last time, skip to now
+    if (_timer_num == 0) {
+        _cur_tick = nowtime;
+    }
 
-    _fix_timer_id_map[timer_event->_timer_id] = timer_event;
+    CTimerNode* node = _free_list;
+    _free_list = node->_next;
+    node->_event._timer_id = timer_id;
+    node->_event._interval = interval;
+    node->_expire = nowtime + interval;
+    _LinkId(node);
+    return node;
+}
 
-    return timer_event->_timer_id;
+void CTimer::_FreeNode(CTimerNode* node) {
+    node->_event._event_flag  = 0;
+    node->_event._timer_param = nullptr;
+    node->_event._timer_call_back = nullptr;
+    node->_event._event = base::CMemWeakPtr<CEventHandler>();
+    node->_next = _free_list;
+    _free_list = node;
 }
 
-bool CTimer::DelTimer(uint64_t timerid) {
-    std::unique_lock<std::recursive_mutex> lock(_mutex);
-    auto iter = _fix_timer_id_map.find(timerid);
-    if (iter == _fix_timer_id_map.end()) {
-        return false;
-    }
+void CTimer::_Insert(CTimerNode* node) {
+    // a passed time is checked next
+    uint64_t expire = std::max(node->_expire, _cur_tick);
+    uint64_t delta  = std::min(expire - _cur_tick, (uint64_t)__max_timer_interval);
+    expire = _cur_tick + delta;
+
+    uint32_t slot = 0;
+    if (delta < __wheel_size0) {
+        slot = expire & (__wheel_size0 - 1);
 
-    auto timer_event_ptr = iter->second.Lock();
-    if (timer_event_ptr) {
-        auto timer_iter = _timer_map.find(timer_event_ptr->_timer_id);
-        if (timer_iter != _timer_map.end()) {
-            _timer_map.erase(timer_iter);
-            return true;
+    } else {
+        uint32_t level = 1;
+        while (level < __wheel_levels - 1 && delta >= (1ull << (LevelShift(level) + __wheel_bits))) {
+            level++;
         }
+        slot = LevelFirst(level) + ((expire >> LevelShift(level)) & (__wheel_size - 1));
     }
 
-    return false;
+    node->_slot = slot;
+    node->_prev = nullptr;
+    node->_next = _slots[slot];
+    if (node->_next) {
+        node->_next->_prev = node;
+    }
+    _slots[slot] = node;
+    _bitmap[slot >> 6] |= 1ull << (slot & 63);
 }
 
-uint32_t CTimer::TimeoutCheck(std::vector<base::CMemSharePtr<CTimerEvent>>& res) {
-    _time.Now();
-    return TimeoutCheck(_time.GetMsec(), res);
+void CTimer::_Remove(CTimerNode* node) {
+    if (node->_prev) {
+        node->_prev->_next = node->_next;
+
+    } else {
+        _slots[node->_slot] = node->_next;
+        if (!node->_next) {
+            _bitmap[node->_slot >> 6] &= ~(1ull << (node->_slot & 63));
+        }
+    }
+    if (node->_next) {
+        node->_next->_prev = node->_prev;
+    }
 }
 
-uint32_t CTimer::TimeoutCheck(uint64_t nowtime, std::vector<base::CMemSharePtr<CTimerEvent>>& res) {
-    uint64_t recent_timeout = 0;
-    std::vector<base::CMemSharePtr<CTimerEvent>> always_timer;
-    std::unique_lock<std::recursive_mutex> lock(_mutex);
+uint32_t CTimer::_Cascade(uint32_t level) {
+    uint32_t index = (_cur_tick >> LevelShift(level)) & (__wheel_size - 1);
+    uint32_t slot  = LevelFirst(level) + index;
+    CTimerNode* node = _slots[slot];
+    _slots[slot] = nullptr;
+    _bitmap[slot >> 6] &= ~(1ull << (slot & 63));
+    while (node) {
+        CTimerNode* next = node->_next;
+        _Insert(node);
+        node = next;
+    }
+    return index;
+}
 
-    for (auto iter = _timer_map.begin(); iter != _timer_map.end();) {
-        if (iter->first <= nowtime) {
-            if (iter->second->_event_flag & EVENT_TIMER_ALWAYS) {
-                always_timer.push_back(iter->second);
-            }
-            res.push_back(iter->second);
-            iter = _timer_map.erase(iter);
+void CTimer::_Expire(uint32_t slot, uint64_t nowtime, std::vector<CTimerEvent>& res) {
+    CTimerNode* node = _slots[slot];
+    _slots[slot] = nullptr;
+    _bitmap[slot >> 6] &= ~(1ull << (slot & 63));
+    while (node) {
+        CTimerNode* next = node->_next;
+        // due beyond the span of the wheel, wait another round
+        if (node->_expire > nowtime) {
+            _Insert(node);
+            node = next;
+            continue;
+        }
+        res.emplace_back();
+        CTimerEvent& event = res.back();
+        event._event_flag  = node->_event._event_flag;
+        event._timer_id    = node->_event._timer_id;
+        event._interval    = node->_event._interval;
+        event._timer_param = node->_event._timer_param;
+        event._event       = node->_event._event;
+
+        if (node->_event._event_flag & EVENT_TIMER_ALWAYS) {
+            // add to timer again
+            event._timer_call_back = node->_event._timer_call_back;
+            node->_expire = nowtime + node->_event._interval;
+            _Insert(node);
 
         } else {
-            recent_timeout = iter->first - nowtime;
-            break;
+            event._timer_call_back.swap(node->_event._timer_call_back);
+            _UnlinkId(node->_event._timer_id);
+            _FreeNode(node);
         }
+        node = next;
     }
+}
 
-    // add to timer again
-    if (!always_timer.empty()) {
-        for (auto iter = always_timer.begin(); iter != always_timer.end(); ++iter) {
-            AddTimer((*iter)->_interval, (*iter));
+void CTimer::_LinkId(CTimerNode* node) {
+    // keep the table at most half full
+    if ((_timer_num + 1) * 2 > _id_slots.size()) {
+        std::vector<CIdSlot> slots;
+        slots.swap(_id_slots);
+        _id_slots.resize(std::max<size_t>(__timer_block_num * 2, slots.size() * 2), CIdSlot{0, nullptr});
+        _timer_num = 0;
+        for (size_t i = 0; i < slots.size(); i++) {
+            if (slots[i]._timer_id) {
+                _LinkId(slots[i]._node);
+            }
         }
     }
-    return recent_timeout;
+    size_t mask  = _id_slots.size() - 1;
+    size_t index = IdHash(node->_event._timer_id) & mask;
+    while (_id_slots[index]._timer_id) {
+        index = (index + 1) & mask;
+    }
+    _id_slots[index]._timer_id = node->_event._timer_id;
+    _id_slots[index]._node     = node;
+    _timer_num++;
 }
 
-uint32_t CTimer::GetTimerNum() {
-    std::unique_lock<std::recursive_mutex> lock(_mutex);
-    return _timer_map.size();
-}
+CTimerNode* CTimer::_UnlinkId(uint64_t timer_id) {
+    if (_id_slots.empty()) {
+        return nullptr;
+    }
+    size_t mask  = _id_slots.size() - 1;
+    size_t index = IdHash(timer_id) & mask;
+    while (_id_slots[index]._timer_id != timer_id) {
+        if (!_id_slots[index]._timer_id) {
+            return nullptr;
+        }
+        index = (index + 1) & mask;
+    }
+    CTimerNode* node = _id_slots[index]._node;
 
-void CTimer::_AddTimer(uint32_t interval, const base::CMemSharePtr<CTimerEvent>& t, uint64_t& id) {
-    _time.Now();
-    uint64_t nowtime = _time.GetMsec();
-    uint64_t key = nowtime + interval;
+    // move back the following ids which can't be found past the hole any more
+    size_t next = index;
+    while (true) {
+        next = (next + 1) & mask;
+        if (!_id_slots[next]._timer_id) {
+            break;
+        }
+        size_t home = IdHash(_id_slots[next]._timer_id) & mask;
+        if (((next - home) & mask) >= ((next - index) & mask)) {
+            _id_slots[index] = _id_slots[next];
+            index = next;
+        }
+    }
+    _id_slots[index]._timer_id = 0;
+    _timer_num--;
+    return node;
+}
 
-    std::unique_lock<std::recursive_mutex> lock(_mutex);
-    while (_timer_map.count(key)) {
-        key++;
+int CTimer::_FindSlot(uint32_t first, uint32_t size, uint32_t from) {
+    for (uint32_t distance = 0; distance < size;) {
+        uint32_t index = (from + distance) & (size - 1);
+        uint64_t bits  = _bitmap[(first + index) >> 6] >> (index & 63);
+        if (bits) {
+            return distance + LowestBit(bits);
+        }
+        distance += 64 - (index & 63);
     }
-    _timer_map[key] = t;
-    id = key;
+    return -1;
 }
 
-void CTimer::_AddTimer(uint32_t interval, base::CMemSharePtr<CTimerEvent>& event) {
-    event->_interval = interval;
-    event->_event_flag |= EVENT_TIMER;
-    _AddTimer(interval, event, event->_timer_id);
-}
\ No newline at end of file
+uint32_t CTimer::_RecentTimeout(uint64_t nowtime) {
+    if (_timer_num == 0) {
+        return 0;
+    }
+    // upper levels are not cascaded yet
+    if ((_cur_tick & (__wheel_size0 - 1)) == 0) {
+        return (uint32_t)(_cur_tick - nowtime);
+    }
+
+    uint64_t recent = UINT64_MAX;
+    int distance = _FindSlot(0, __wheel_size0, _cur_tick & (__wheel_size0 - 1));
+    if (distance >= 0) {
+        recent = _cur_tick + distance;
+    }
+    // timers of upper levels come down when their slot is cascaded
+    for (uint32_t level = 1; level < __wheel_levels; level++) {
+        uint64_t round = _cur_tick >> LevelShift(level);
+        distance = _FindSlot(LevelFirst(level), __wheel_size, (round + 1) & (__wheel_size - 1));
+        if (distance >= 0) {
+            recent = std::min(recent, (round + distance + 1) << LevelShift(level));
+        }
+    }
+    return (uint32_t)std::min(recent - nowtime, (uint64_t)__max_timer_interval);
+}
@@ -1,28 +1,51 @@
 #ifndef HEADER_NET_CTIMER
 #define HEADER_NET_CTIMER
 
-#include <map>
 #include <vector>
 
 #include "Buffer.h"
 #include "Single.h"
-#include "TimeTool.h"
 #include "EventHandler.h"
 #include "PoolSharedPtr.h"
 
 namespace cppnet {
 
+    // milliseconds in the first wheel level, and in a slot of each upper level
+    // multiplied by the slots of the level below.
+    static const uint32_t __wheel_bits0 = 8;
+    static const uint32_t __wheel_bits  = 6;
+    static const uint32_t __wheel_levels = 4;
+    static const uint32_t __wheel_size0 = 1 << __wheel_bits0;
+    static const uint32_t __wheel_size  = 1 << __wheel_bits;
+    static const uint32_t __wheel_slots = __wheel_size0 + (__wheel_levels - 1) * __wheel_size;
+    // longest time the wheel spans, about 18.6 hours. a timer due later is
+    // put at the end of the wheel and inserted again when that comes.
+    static const uint32_t __max_timer_interval = (1 << (__wheel_bits0 + (__wheel_levels - 1) * __wheel_bits)) - 1;
+    // timer events allocated at a time.
+    static const uint32_t __timer_block_num = 256;
+
     class CEventHandler;
     struct CTimerEvent;
+    struct CTimerNode;
+    // hierarchical timing wheel. adding and deleting a timer is O(1) and
+    // timer events are reused from a free list.
+    // not thread safe, the event actions call it from their io thread.
     class CTimer {
     public:
         CTimer();
         ~CTimer();
 
+        // return a new timer id, unique in the process. so an id can be
+        // handed out before the io thread adds the timer.
+        static uint64_t NewTimerId();
+        // milliseconds of a steady clock, the time timers are checked with
+        static uint64_t Now();
+
         //add a timer. return the timer id
         uint64_t AddTimer(uint32_t interval, const std::function<void(void*)>& call_back, void* param, bool always = false);
-        uint64_t AddTimer(uint32_t interval, base::CMemSharePtr<CTimerEvent>& event);
         uint64_t AddTimer(uint32_t interval, base::CMemSharePtr<CEventHandler>& event);
+        //add a timer with an id from NewTimerId
+        void AddTimer(uint64_t timer_id, uint32_t interval, const std::function<void(void*)>& call_back, void* param, bool always = false);
 
         //delete a timer
         bool DelTimer(uint64_t timerid);
@@ -30,22 +53,43 @@ namespace cppnet {
         //check timer whether or not to go out of time. if timeout.
         //res return all timeout timer.
         //return the recent timeout time. if there is no one, return 0
-        uint32_t TimeoutCheck(std::vector<base::CMemSharePtr<CTimerEvent>>& res);
-        uint32_t TimeoutCheck(uint64_t nowtime, std::vector<base::CMemSharePtr<CTimerEvent>>& res);
+        uint32_t TimeoutCheck(std::vector<CTimerEvent>& res);
+        uint32_t TimeoutCheck(uint64_t nowtime, std::vector<CTimerEvent>& res);
 
         // return number of event in timer
         uint32_t GetTimerNum();
     private:
-        // add timer event to event actions
-        void _AddTimer(uint32_t interval, const base::CMemSharePtr<CTimerEvent>& t, uint64_t& id);
-        void _AddTimer(uint32_t interval, base::CMemSharePtr<CTimerEvent>& event);
+        CTimerNode* _NewNode(uint64_t timer_id, uint32_t interval);
+        void _FreeNode(CTimerNode* node);
+        // link to the slot of its expire time, or unlink from its slot
+        void _Insert(CTimerNode* node);
+        void _Remove(CTimerNode* node);
+        // move timers of the current slot of a level to lower levels.
+        // return the index of the slot
+        uint32_t _Cascade(uint32_t level);
+        // return all timers of a slot of the first level
+        void _Expire(uint32_t slot, uint64_t nowtime, std::vector<CTimerEvent>& res);
+        // timers by id in an open addressing table
+        void _LinkId(CTimerNode* node);
+        CTimerNode* _UnlinkId(uint64_t timer_id);
+        // return distance from slot 'from' to the next used slot of a level, or -1
+        int _FindSlot(uint32_t first, uint32_t size, uint32_t from);
+        uint32_t _RecentTimeout(uint64_t nowtime);
     private:
-        std::shared_ptr<base::CMemoryPool>         _pool;
-        std::recursive_mutex                       _mutex;
-        base::CTimeTool                            _time;
-        std::map<uint64_t, base::CMemSharePtr<CTimerEvent>>    _timer_map;
-        std::map<uint64_t, base::CMemWeakPtr<CTimerEvent>>     _fix_timer_id_map;
+        struct CIdSlot {
+            uint64_t    _timer_id;    // 0 if empty
+            CTimerNode* _node;
+        };
+        // next millisecond to check
+        uint64_t                                    _cur_tick;
+        CTimerNode*                                 _slots[__wheel_slots];
+        // a bit for every slot with timers
+        uint64_t                                    _bitmap[__wheel_slots / 64];
+        CTimerNode*                                 _free_list;
+        std::vector<CTimerNode*>                    _blocks;
+        std::vector<CIdSlot>                        _id_slots;
+        uint32_t                                    _timer_num;
     };
 
 }
-#endif
\ No newline at end of file
+#endif
@@ -3,6 +3,7 @@
 #include <signal.h>
 #include <sys/poll.h>
 #include <arpa/inet.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 
 #include "Log.h"
@@ -43,7 +44,10 @@ enum EPOLL_CODE {
     WEAK_EPOLL = 0
 };
 
-CEpoll::CEpoll(bool per_epoll) : _run(true), _per_epoll(per_epoll) {
+// epoll of the io thread running here
+static thread_local CEpoll* __loop_epoll = nullptr;
+
+CEpoll::CEpoll(bool per_epoll) : _run(true), _per_epoll(per_epoll), _wake_pending(false) {
 
 }
 
@@ -63,18 +67,17 @@ bool CEpoll::Init(uint32_t) {
         base::LOG_FATAL("epoll init failed! error : %d", errno);
         return false;
     }
-    if (pipe((int*)_pipe) == -1) {
-        base::LOG_FATAL("pipe init failed! error : %d", errno);
+    _wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_wake_fd == -1) {
+        base::LOG_FATAL("eventfd init failed! error : %d", errno);
         return false;
     }
 
-    SetSocketNoblocking(_pipe[1]);
-    SetSocketNoblocking(_pipe[0]);
-    _pipe_content.events = EPOLLIN;
-    _pipe_content.data.fd = _pipe[0];
-    int res = epoll_ctl(_epoll_handler, EPOLL_CTL_ADD, _pipe[0], &_pipe_content);
+    _wake_content.events = EPOLLIN;
+    _wake_content.data.fd = _wake_fd;
+    int res = epoll_ctl(_epoll_handler, EPOLL_CTL_ADD, _wake_fd, &_wake_content);
     if (res == -1) {
-        base::LOG_ERROR("add pipe handle to epoll faild! error :%d", errno);
+        base::LOG_ERROR("add eventfd to epoll faild! error :%d", errno);
         return false;
     }
     return true;
@@ -87,15 +90,35 @@ bool CEpoll::Dealloc() {
 }
 
 uint64_t CEpoll::AddTimerEvent(uint32_t interval, const timer_call_back& call_back, void* param, bool always) {
-    return _timer.AddTimer(interval, call_back, param, always);
+    uint64_t timer_id = CTimer::NewTimerId();
+    if (InLoopThread()) {
+        _AddTimer(timer_id, interval, call_back, param, always);
+
+    } else {
+        std::function<void(void)> task = std::bind(&CEpoll::_AddTimer, this, timer_id, interval, call_back, param, always);
+        PostTask(task);
+    }
+    return timer_id;
 }
 
 bool CEpoll::RemoveTimerEvent(uint64_t timer_id) {
-    return _timer.DelTimer(timer_id);
+    if (InLoopThread()) {
+        return _RemoveTimer(timer_id);
+    }
+    // posted to the io thread, whether the timer was there is not known yet
+    std::function<void(void)> task = std::bind(&CEpoll::_RemoveTimer, this, timer_id);
+    PostTask(task);
+    return true;
 }
 
 bool CEpoll::AddTimerEvent(uint32_t interval, base::CMemSharePtr<CEventHandler>& event) {
-    _timer.AddTimer(interval, event);
+    if (InLoopThread()) {
+        _AddEventTimer(interval, event);
+
+    } else {
+        std::function<void(void)> task = std::bind(&CEpoll::_AddEventTimer, this, interval, event);
+        PostTask(task);
+    }
     base::LOG_DEBUG("add a timer event, %d", interval);
     return true;
 }
@@ -242,11 +265,18 @@ bool CEpoll::DelEvent(const uint64_t& sock) {
 
 void CEpoll::ProcessEvent() {
     uint32_t        wait_time = 0;
-    std::vector<base::CMemSharePtr<CTimerEvent>> timer_vec;;
+    std::vector<CTimerEvent> timer_vec;
     std::vector<epoll_event> event_vec;
     event_vec.resize(1000);
+    __loop_epoll = this;
     while (_run) {
-        wait_time = _timer.TimeoutCheck(timer_vec);
+        {
+            std::unique_lock<std::mutex> lock(_timer_mutex, std::defer_lock);
+            if (!_per_epoll) {
+                lock.lock();
+            }
+            wait_time = _timer.TimeoutCheck(timer_vec);
+        }
         //if there is no timer event. wait until recv something
         if (wait_time == 0 && timer_vec.empty()) {
             wait_time = -1;
@@ -260,43 +290,41 @@ void CEpoll::ProcessEvent() {
 
         if (res > 0) {
             base::LOG_DEBUG("epoll_wait get events! num :%d, TheadId : %lld", res, std::this_thread::get_id());
-
             _DoEvent(event_vec, res);
-            _DoTaskList();
-            if (!timer_vec.empty()) {
-                _DoTimeoutEvent(timer_vec);
-            }
-
-        } else {
-            if (!timer_vec.empty()) {
-                _DoTimeoutEvent(timer_vec);
-            }
-            _DoTaskList();
         }
+        if (!timer_vec.empty()) {
+            _DoTimeoutEvent(timer_vec);
+        }
+        // last, so tasks posted by the events above run before waiting again
+        _DoTaskList();
     }
+    __loop_epoll = nullptr;
 
     if (close(_epoll_handler) == -1) {
         base::LOG_ERROR("epoll close failed! error : %d", errno);
     }
-    if (close(_pipe[0]) == -1) {
-        base::LOG_ERROR("_pipe[0] close failed! error : %d", errno);
-    }
-    if (close(_pipe[1]) == -1) {
-        base::LOG_ERROR("_pipe[1] close failed! error : %d", errno);
+    if (close(_wake_fd) == -1) {
+        base::LOG_ERROR("eventfd close failed! error : %d", errno);
     }
     base::LOG_INFO("return the net io thread");
 }
 
 void CEpoll::PostTask(std::function<void(void)>& task) {
-    {
-        std::unique_lock<std::mutex> lock(_mutex);
-        _task_list.push_back(task);
+    _task_queue.Push(task);
+    // the io thread runs its tasks before waiting. otherwise wake it,
+    // unless a wake up is already on the way
+    if (__loop_epoll != this && !_wake_pending.exchange(true)) {
+        WakeUp();
     }
-    WakeUp();
 }
 
 void CEpoll::WakeUp() {
-    write(_pipe[1], "1", 1);
+    uint64_t one = 1;
+    write(_wake_fd, &one, sizeof(one));
+}
+
+bool CEpoll::InLoopThread() {
+    return !_per_epoll || __loop_epoll == this;
 }
 
 bool CEpoll::_AddEvent(base::CMemSharePtr<CEventHandler>& event, int32_t event_flag, uint64_t sock) {
@@ -371,28 +399,51 @@ bool CEpoll::_ReserOneShot(base::CMemSharePtr<CEventHandler>& event, int32_t eve
     return true;
 }
 
-void CEpoll::_DoTimeoutEvent(std::vector<base::CMemSharePtr<CTimerEvent>>& timer_vec) {
+void CEpoll::_AddTimer(uint64_t timer_id, uint32_t interval, const timer_call_back& call_back, void* param, bool always) {
+    std::unique_lock<std::mutex> lock(_timer_mutex, std::defer_lock);
+    if (!_per_epoll) {
+        lock.lock();
+    }
+    _timer.AddTimer(timer_id, interval, call_back, param, always);
+}
+
+void CEpoll::_AddEventTimer(uint32_t interval, base::CMemSharePtr<CEventHandler>& event) {
+    std::unique_lock<std::mutex> lock(_timer_mutex, std::defer_lock);
+    if (!_per_epoll) {
+        lock.lock();
+    }
+    _timer.AddTimer(interval, event);
+}
+
+bool CEpoll::_RemoveTimer(uint64_t timer_id) {
+    std::unique_lock<std::mutex> lock(_timer_mutex, std::defer_lock);
+    if (!_per_epoll) {
+        lock.lock();
+    }
+    return _timer.DelTimer(timer_id);
+}
+
+void CEpoll::_DoTimeoutEvent(std::vector<CTimerEvent>& timer_vec) {
     for (auto iter = timer_vec.begin(); iter != timer_vec.end(); ++iter) {
-        if ((*iter)->_event_flag & EVENT_READ) {
-            base::CMemSharePtr<CEventHandler> event_ptr = (*iter)->_event.Lock();
+        if (iter->_event_flag & EVENT_READ) {
+            base::CMemSharePtr<CEventHandler> event_ptr = iter->_event.Lock();
             base::CMemSharePtr<CSocketImpl> socket_ptr = event_ptr->_client_socket.Lock();
             if (socket_ptr) {
                 event_ptr->_event_flag_set |= EVENT_TIMER;
                 socket_ptr->Recv(event_ptr);
             }
 
-        } else if ((*iter)->_event_flag & EVENT_WRITE) {
-            base::CMemSharePtr<CEventHandler> event_ptr = (*iter)->_event.Lock();
+        } else if (iter->_event_flag & EVENT_WRITE) {
+            base::CMemSharePtr<CEventHandler> event_ptr = iter->_event.Lock();
             base::CMemSharePtr<CSocketImpl> socket_ptr = event_ptr->_client_socket.Lock();
             if (socket_ptr) {
                 event_ptr->_event_flag_set |= EVENT_TIMER;
                 socket_ptr->Send(event_ptr);
             }
 
-        } else if ((*iter)->_event_flag & EVENT_TIMER) {
-            auto func = (*iter)->_timer_call_back;
-            if (func) {
-                func((*iter)->_timer_param);
+        } else if (iter->_event_flag & EVENT_TIMER) {
+            if (iter->_timer_call_back) {
+                iter->_timer_call_back(iter->_timer_param);
             }
         }
     }
@@ -404,10 +455,10 @@ void CEpoll::_DoEvent(std::vector<epoll_event>& event_vec, int num) {
     base::CMemSharePtr<CAcceptSocket>* accept_sock = nullptr;
     void* sock = nullptr;
     for (int i = 0; i < num; i++) {
-        if (event_vec[i].data.fd == _pipe[0]) {
-            base::LOG_WARN("weak up the io thread, index : %d", i);
-            char buf[4];
-            read(_pipe[0], buf, 1);
+        if (event_vec[i].data.fd == _wake_fd) {
+            base::LOG_DEBUG("weak up the io thread, index : %d", i);
+            uint64_t num = 0;
+            read(_wake_fd, &num, sizeof(num));
             continue;
         }
 
@@ -446,14 +497,19 @@ void CEpoll::_DoEvent(std::vector<epoll_event>& event_vec, int num) {
 }
 
 void CEpoll::_DoTaskList() {
-    std::vector<std::function<void(void)>> func_vec;
-    {
-        std::unique_lock<std::mutex> lock(_mutex);
-        func_vec.swap(_task_list);
+    std::unique_lock<std::mutex> lock(_mutex, std::defer_lock);
+    if (!_per_epoll) {
+        lock.lock();
     }
-
-    for (size_t i = 0; i < func_vec.size(); ++i) {
-        func_vec[i]();
+    // tasks posted from now on need a new wake up
+    _wake_pending.store(false);
+    std::function<void(void)> task;
+    for (uint32_t i = 0; i < __max_task_batch && _task_queue.Pop(task); ++i) {
+        task();
+    }
+    // leave the rest for the next loop, without sleeping
+    if (!_task_queue.Empty() && !_wake_pending.exchange(true)) {
+        WakeUp();
     }
 }
 #endif // __linux__
@@ -4,6 +4,7 @@
 #define HEADER_NET_LINUX_CEPOOL
 
 #include <sys/epoll.h>
+#include "MPSCQueue.h"
 #include "EventActions.h"
 
 namespace cppnet {
@@ -36,6 +37,7 @@ namespace cppnet {
 
         virtual void PostTask(std::function<void(void)>& task);
         virtual void WakeUp();
+        virtual bool InLoopThread();
 
     private:
         bool _AddEvent(base::CMemSharePtr<CEventHandler>& event, int32_t event_flag, uint64_t sock);
@@ -43,7 +45,13 @@ namespace cppnet {
         bool _ModifyEvent(base::CMemSharePtr<CEventHandler>& event, int32_t event_flag, uint64_t sock);
         bool _ReserOneShot(base::CMemSharePtr<CEventHandler>& event, int32_t event_flag, uint64_t sock);
 
-        void _DoTimeoutEvent(std::vector<base::CMemSharePtr<CTimerEvent>>& timer_vec);
+        // the timer belongs to the io thread. with one epoll shared by
+        // all threads it is locked instead
+        void _AddTimer(uint64_t timer_id, uint32_t interval, const timer_call_back& call_back, void* param, bool always);
+        void _AddEventTimer(uint32_t interval, base::CMemSharePtr<CEventHandler>& event);
+        bool _RemoveTimer(uint64_t timer_id);
+
+        void _DoTimeoutEvent(std::vector<CTimerEvent>& timer_vec);
         void _DoEvent(std::vector<epoll_event>& event_vec, int32_t num);
         void _DoTaskList();
     private:
@@ -51,11 +59,16 @@ namespace cppnet {
 
         bool                _per_epoll;
         int32_t             _epoll_handler;
-        uint32_t            _pipe[2];
-        epoll_event         _pipe_content;
+        int32_t             _wake_fd;
+        epoll_event         _wake_content;
 
+        // set from a wake up until the io thread takes the tasks
+        std::atomic_bool    _wake_pending;
+        base::CMPSCQueue<std::function<void(void)>> _task_queue;
+        // threads sharing one epoll take the tasks in turn
         std::mutex          _mutex;
-        std::vector<std::function<void(void)>> _task_list;
+
+        std::mutex          _timer_mutex;
     };
 }
 
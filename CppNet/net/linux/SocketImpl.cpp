@@ -17,7 +17,7 @@
 
 using namespace cppnet;
 
-CSocketImpl::CSocketImpl(std::shared_ptr<CEventActions>& event_actions) : CSocketBase(event_actions){
+CSocketImpl::CSocketImpl(std::shared_ptr<CEventActions>& event_actions) : CSocketBase(event_actions), _write_posted(false) {
     _read_event = base::MakeNewSharedPtr<CEventHandler>(_pool.get());
     _write_event = base::MakeNewSharedPtr<CEventHandler>(_pool.get());
 
@@ -28,6 +28,7 @@ CSocketImpl::CSocketImpl(std::shared_ptr<CEventActions>& event_actions) : CSocke
     _write_event->_data = _pool->PoolNew<epoll_event>();
     ((epoll_event*)_write_event->_data)->events = 0;
     _write_event->_buffer = base::MakeNewSharedPtr<base::CBuffer>(_pool.get(), _pool);
+    _posted_buffer = base::MakeNewSharedPtr<base::CBuffer>(_pool.get(), _pool);
 }
 
 CSocketImpl::~CSocketImpl() {
@@ -62,24 +63,45 @@ void CSocketImpl::SyncRead() {
 }
 
 void CSocketImpl::SyncWrite(const char* src, uint32_t len) {
+    // with an epoll per io thread only that thread touches the socket
+    // buffers, hand it the data
+    if (_event_actions && !_event_actions->InLoopThread()) {
+        {
+            std::unique_lock<std::mutex> lock(_posted_mutex);
+            _posted_buffer->Write(src, len);
+        }
+        // one send for all writes posted until the io thread gets to it
+        if (!_write_posted.exchange(true)) {
+            std::function<void(void)> task = std::bind(&CSocketImpl::_FlushWrite, memshared_from_this());
+            _event_actions->PostTask(task);
+        }
+        return;
+    }
+
     if (!_write_event->_client_socket) {
         _write_event->_client_socket = memshared_from_this();
     }
 
-    _write_event->_event_flag_set |= EVENT_WRITE;
-
-    //can't send now
-    if (_write_event->_buffer->GetCanReadLength() > 0) {
-        _write_event->_buffer->Write(src, len);
-        if (_event_actions) {
-            _event_actions->AddSendEvent(_write_event);
+    {
+        // with one epoll for all io threads, any thread writes right here
+        std::unique_lock<std::mutex> lock(_write_mutex, std::defer_lock);
+        if (!__per_handle_thread) {
+            lock.lock();
         }
+        _write_event->_event_flag_set |= EVENT_WRITE;
 
-    } else {
-        // try send now
+        //can't send now
+        if (_write_event->_buffer->GetCanReadLength() > 0) {
+            _write_event->_buffer->Write(src, len);
+            if (_event_actions) {
+                _event_actions->AddSendEvent(_write_event);
+            }
+            return;
+        }
         _write_event->_buffer->Write(src, len);
-        Send(_write_event);
     }
+    // try send now
+    Send(_write_event);
 }
 
 void CSocketImpl::SyncConnection(const std::string& ip, uint16_t port) {
@@ -115,6 +137,21 @@ void CSocketImpl::PostTask(std::function<void(void)>& func) {
     _event_actions->PostTask(func);
 }
 
+void CSocketImpl::_FlushWrite() {
+    // a write after this posts a new flush
+    _write_posted = false;
+    {
+        std::unique_lock<std::mutex> lock(_posted_mutex);
+        _write_event->_buffer->Append(*_posted_buffer);
+    }
+
+    if (!_write_event->_client_socket) {
+        _write_event->_client_socket = memshared_from_this();
+    }
+    _write_event->_event_flag_set |= EVENT_WRITE;
+    Send(_write_event);
+}
+
 void CSocketImpl::Recv(base::CMemSharePtr<CEventHandler>& event) {
     if (!event->_client_socket) {
         base::LOG_WARN("the event with out socket");
@@ -203,6 +240,10 @@ void CSocketImpl::Send(base::CMemSharePtr<CEventHandler>& event) {
         event->_event_flag_set &= ~EVENT_TIMER;
 
     } else {
+        std::unique_lock<std::mutex> lock(_write_mutex, std::defer_lock);
+        if (!__per_handle_thread) {
+            lock.lock();
+        }
         event->_off_set = 0;
         while(event->_buffer && event->_buffer->GetCanReadLength() > 0) {
             std::vector<base::iovec> io_vec;
@@ -218,6 +259,7 @@ void CSocketImpl::Send(base::CMemSharePtr<CEventHandler>& event) {
                     if (res < data_len) {
                         _event_actions->AddSendEvent(_write_event);
                     }
+                    break;
 
                 } else if (errno == EBADMSG) {
                     err |= ERR_CONNECT_BREAK;
@@ -231,6 +273,10 @@ void CSocketImpl::Send(base::CMemSharePtr<CEventHandler>& event) {
                 }
             }
         }
+        // the write callback may write again
+        if (lock.owns_lock()) {
+            lock.unlock();
+        }
         CCppNetImpl::Instance()._WriteFunction(event, err);
     }
 }
@@ -45,14 +45,17 @@ bool CIOCP::Dealloc() {
 }
 
 uint64_t CIOCP::AddTimerEvent(uint32_t interval, const std::function<void(void*)>& call_back, void* param, bool always) {
+    std::unique_lock<std::mutex> lock(_timer_mutex);
     return _timer.AddTimer(interval, call_back, param, always);
 }
 
 bool CIOCP::RemoveTimerEvent(uint64_t timer_id) {
+    std::unique_lock<std::mutex> lock(_timer_mutex);
     return _timer.DelTimer(timer_id);
 }
 
 bool CIOCP::AddTimerEvent(uint32_t interval, base::CMemSharePtr<CEventHandler>& event) {
+    std::unique_lock<std::mutex> lock(_timer_mutex);
     _timer.AddTimer(interval, event);
     return true;
 }
@@ -123,9 +126,12 @@ void CIOCP::ProcessEvent() {
     EventOverlapped     *socket_context  = nullptr;
     OVERLAPPED          *over_lapped     = nullptr;
     unsigned int        wait_time        = 0;
-    std::vector<base::CMemSharePtr<CTimerEvent>> timer_vec;
+    std::vector<CTimerEvent> timer_vec;
     while (_run) {
-        wait_time = _timer.TimeoutCheck(timer_vec);
+        {
+            std::unique_lock<std::mutex> lock(_timer_mutex);
+            wait_time = _timer.TimeoutCheck(timer_vec);
+        }
         //if there is no timer event. wait until recv something
         if (wait_time == 0 && timer_vec.empty()) {
             wait_time = INFINITE;
@@ -330,28 +336,27 @@ bool CIOCP::_PostDisconnection(base::CMemSharePtr<CEventHandler>& event) {
     return true;
 }
 
-void CIOCP::_DoTimeoutEvent(std::vector<base::CMemSharePtr<CTimerEvent>>& timer_vec) {
+void CIOCP::_DoTimeoutEvent(std::vector<CTimerEvent>& timer_vec) {
     for (auto iter = timer_vec.begin(); iter != timer_vec.end(); ++iter) {
-        if ((*iter)->_event_flag & EVENT_READ) {
-            base::CMemSharePtr<CEventHandler> event_ptr = (*iter)->_event.Lock();
+        if (iter->_event_flag & EVENT_READ) {
+            base::CMemSharePtr<CEventHandler> event_ptr = iter->_event.Lock();
             base::CMemSharePtr<CSocketImpl> socket_ptr = event_ptr->_client_socket.Lock();
             if (socket_ptr) {
                 event_ptr->_event_flag_set |= EVENT_TIMER;
                 socket_ptr->Recv(event_ptr);
             }
 
-        } else if ((*iter)->_event_flag & EVENT_WRITE) {
-            base::CMemSharePtr<CEventHandler> event_ptr = (*iter)->_event.Lock();
+        } else if (iter->_event_flag & EVENT_WRITE) {
+            base::CMemSharePtr<CEventHandler> event_ptr = iter->_event.Lock();
             base::CMemSharePtr<CSocketImpl> socket_ptr = event_ptr->_client_socket.Lock();
             if (socket_ptr) {
                 event_ptr->_event_flag_set |= EVENT_TIMER;
                 socket_ptr->Send(event_ptr);
             }
 
-        } else if ((*iter)->_event_flag & EVENT_TIMER) {
-            auto func = (*iter)->_timer_call_back;
-            if (func) {
-                func((*iter)->_timer_param);
+        } else if (iter->_event_flag & EVENT_TIMER) {
+            if (iter->_timer_call_back) {
+                iter->_timer_call_back(iter->_timer_param);
             }
         }
     }
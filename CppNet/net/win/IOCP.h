@@ -65,6 +65,8 @@ namespace cppnet {
         virtual void PostTask(std::function<void(void)>& task);
         // weak up net io thread
         virtual void WakeUp();
+        // all threads share the completion port
+        virtual bool InLoopThread() { return true; }
 
     private:
         bool _PostRecv(base::CMemSharePtr<CEventHandler>& event);
@@ -73,7 +75,7 @@ namespace cppnet {
         bool _PostConnection(base::CMemSharePtr<CEventHandler>& event, const std::string& ip, short port, const char* buf, uint32_t buf_len);
         bool _PostDisconnection(base::CMemSharePtr<CEventHandler>& event);
 
-        void _DoTimeoutEvent(std::vector<base::CMemSharePtr<CTimerEvent>>& timer_vec);
+        void _DoTimeoutEvent(std::vector<CTimerEvent>& timer_vec);
         void _DoEvent(EventOverlapped *socket_context, uint32_t bytes);
         void _DoTaskList();
 
@@ -84,6 +86,8 @@ namespace cppnet {
         std::mutex            _mutex;
         std::atomic_bool      _run;
         std::vector<std::function<void(void)>> _task_list;
+        // all threads check the one timer
+        std::mutex            _timer_mutex;
     };
 }
 #endif
@@ -55,6 +55,7 @@ void CSocketImpl::SyncRead() {
 }
 
 void CSocketImpl::SyncWrite(const char* src, uint32_t len) {
+    std::unique_lock<std::mutex> lock(_write_mutex);
     _write_event->_buffer->Write(src, len);
 
     if (!_write_event->_client_socket) {
@@ -69,6 +70,7 @@ void CSocketImpl::SyncWrite(const char* src, uint32_t len) {
 
         // something wrong
         } else {
+            lock.unlock();
             CCppNetImpl::Instance()._ReadFunction(_read_event, ERR_CONNECT_CLOSE | EVENT_DISCONNECT);
         }
     }
@@ -0,0 +1,159 @@
+// Benchmark of CBuffer on the paths a socket takes it through.
+//
+// write:   Write a message and Read it back, as a read callback taking
+//          what arrived.
+// recv:    GetFreeMemoryBlock, MoveWritePt by a message and Read it, as the
+//          io thread receiving into the read buffer.
+// send:    Write a message, GetUseMemoryBlock and Clear it, as the io thread
+//          sending from the write buffer.
+// handoff: threads Write messages to a buffer under a lock, the owner thread
+//          takes them with Append and sends them as above, as writes of
+//          application threads handed to the io thread.
+//
+// Reports ns and MiB per second per message.
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Buffer.h"
+#include "CNConfig.h"
+#include "MemoryPool.h"
+
+using namespace base;
+using namespace cppnet;
+
+// bytes received or sent at a time, as the linux io thread does
+static const int __io_len = 4096;
+
+static char __data[65536];
+static char __out[65536];
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Report(const char* name, int msg_size, long msgs, double seconds) {
+    printf("%-8s %6d bytes  %7.1f ns/op  %9.2f MiB/s\n",
+           name, msg_size, seconds * 1e9 / msgs, (double)msgs * msg_size / seconds / 1024 / 1024);
+}
+
+void Write(std::shared_ptr<CMemoryPool>& pool, int msg_size, long msgs) {
+    CBuffer buffer(pool);
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < msgs; ++i) {
+        buffer.Write(__data, msg_size);
+        buffer.Read(__out, msg_size);
+    }
+    Report("write", msg_size, msgs, Seconds(start));
+}
+
+void Recv(std::shared_ptr<CMemoryPool>& pool, int msg_size, long msgs) {
+    CBuffer buffer(pool);
+    std::vector<iovec> io_vec;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < msgs; ++i) {
+        for (int left = msg_size; left > 0;) {
+            io_vec.clear();
+            int expand = 0;
+            if (buffer.GetFreeLength() == 0) {
+                expand = __io_len;
+            }
+            int len = buffer.GetFreeMemoryBlock(io_vec, expand);
+            left -= buffer.MoveWritePt(len < left ? len : left);
+        }
+        buffer.Read(__out, msg_size);
+    }
+    Report("recv", msg_size, msgs, Seconds(start));
+}
+
+void Send(std::shared_ptr<CMemoryPool>& pool, int msg_size, long msgs) {
+    CBuffer buffer(pool);
+    std::vector<iovec> io_vec;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < msgs; ++i) {
+        buffer.Write(__data, msg_size);
+        while (buffer.GetCanReadLength() > 0) {
+            io_vec.clear();
+            int len = buffer.GetUseMemoryBlock(io_vec, __io_len);
+            buffer.Clear(len);
+        }
+    }
+    Report("send", msg_size, msgs, Seconds(start));
+}
+
+void Handoff(std::shared_ptr<CMemoryPool>& pool, int msg_size, long msgs, int threads) {
+    CBuffer posted(pool);
+    CBuffer buffer(pool);
+    std::mutex mutex;
+    std::atomic_long pending(0);
+    std::atomic_int done(0);
+
+    std::vector<std::thread> writers;
+    for (int i = 0; i < threads; ++i) {
+        writers.push_back(std::thread([&]() {
+            for (long j = 0; j < msgs / threads; ++j) {
+                // as a socket's send queue, don't run far ahead of the io thread
+                while (pending > 256 * 1024) {
+                    std::this_thread::yield();
+                }
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    posted.Write(__data, msg_size);
+                }
+                pending += msg_size;
+            }
+            done++;
+        }));
+    }
+
+    std::vector<iovec> io_vec;
+    long sent = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (done < threads || pending > 0) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            buffer.Append(posted);
+        }
+        if (buffer.GetCanReadLength() == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        while (buffer.GetCanReadLength() > 0) {
+            io_vec.clear();
+            int len = buffer.GetUseMemoryBlock(io_vec, __io_len);
+            buffer.Clear(len);
+            pending -= len;
+            sent += len;
+        }
+    }
+    double seconds = Seconds(start);
+    for (size_t i = 0; i < writers.size(); ++i) {
+        writers[i].join();
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "handoff%d", threads);
+    Report(name, msg_size, sent / msg_size, seconds);
+}
+
+int main(int argc, char* argv[]) {
+    long msgs   = argc > 1 ? atol(argv[1]) : 2000000;
+    int threads = argc > 2 ? atoi(argv[2]) : 4;
+
+    std::shared_ptr<CMemoryPool> pool(new CMemoryPool(__mem_block_size, __mem_block_add_step));
+    int sizes[] = {64, 1024, 16384};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        long count = sizes[i] > 1024 ? msgs / 16 : msgs;
+        Write(pool, sizes[i], count);
+        Recv(pool, sizes[i], count);
+        Send(pool, sizes[i], count);
+        Handoff(pool, sizes[i], count, 1);
+        Handoff(pool, sizes[i], count, threads);
+    }
+    return 0;
+}
@@ -0,0 +1,179 @@
+// Benchmark of connection churn against an echo server in the same process.
+//
+// Client threads connect, send a message, wait for the echo and close,
+// over and over, so every io thread adds and removes sockets all the time.
+// Meanwhile lookup threads call GetIpAddress on long lived connections,
+// which finds the socket by handle as Write and Close do.
+//
+// Reports connections and lookups per second.
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "CppNet.h"
+
+using namespace cppnet;
+
+static const int __msg_len = 32;
+static const int __live_num = 64;
+
+static std::atomic_bool  __stop(false);
+static std::atomic_long  __connections(0);
+static std::atomic_long  __lookups(0);
+static std::atomic_long  __disconnections(0);
+
+static std::mutex            __live_mutex;
+static std::vector<Handle>   __live;
+static bool                  __accept_live = true;
+
+void OnAccept(const Handle& handle, uint32_t) {
+    std::unique_lock<std::mutex> lock(__live_mutex);
+    if (__accept_live) {
+        __live.push_back(handle);
+    }
+}
+
+void OnRead(const Handle& handle, base::CBuffer* data, uint32_t, uint32_t error) {
+    if (error != CEC_SUCCESS) {
+        return;
+    }
+    char buf[1024];
+    while (data->GetCanReadLength()) {
+        int len = data->Read(buf, sizeof(buf));
+        Write(handle, buf, len);
+    }
+}
+
+void OnDisconnect(const Handle&, uint32_t) {
+    __disconnections++;
+}
+
+int Connect(int port) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    if (connect(sock, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+void Churn(int port) {
+    char msg[__msg_len] = {0};
+    char echo[__msg_len];
+    // reset on close, no TIME_WAIT left to run out of ports
+    struct linger lin = {1, 0};
+    while (!__stop) {
+        int sock = Connect(port);
+        if (sock < 0) {
+            continue;
+        }
+        setsockopt(sock, SOL_SOCKET, SO_LINGER, &lin, sizeof(lin));
+        int got = 0;
+        if (write(sock, msg, __msg_len) == __msg_len) {
+            while (got < __msg_len) {
+                int ret = read(sock, echo + got, __msg_len - got);
+                if (ret <= 0) {
+                    break;
+                }
+                got += ret;
+            }
+        }
+        close(sock);
+        if (got == __msg_len) {
+            __connections++;
+        }
+    }
+}
+
+void Lookup(int index) {
+    std::vector<Handle> live;
+    {
+        std::unique_lock<std::mutex> lock(__live_mutex);
+        live = __live;
+    }
+    std::string ip;
+    uint16_t port = 0;
+    long count = 0;
+    size_t i = index;
+    while (!__stop) {
+        for (int j = 0; j < 1000; ++j, ++i) {
+            GetIpAddress(live[i % live.size()], ip, port);
+        }
+        count += 1000;
+    }
+    __lookups += count;
+}
+
+int main(int argc, char* argv[]) {
+    int io_threads     = argc > 1 ? atoi(argv[1]) : 4;
+    int churn_threads  = argc > 2 ? atoi(argv[2]) : 4;
+    int lookup_threads = argc > 3 ? atoi(argv[3]) : 4;
+    int seconds        = argc > 4 ? atoi(argv[4]) : 5;
+    int port           = argc > 5 ? atoi(argv[5]) : 8923;
+
+    cppnet::Init(io_threads);
+    cppnet::SetAcceptCallback(OnAccept);
+    cppnet::SetReadCallback(OnRead);
+    cppnet::SetDisconnectionCallback(OnDisconnect);
+    if (!cppnet::ListenAndAccept("0.0.0.0", port)) {
+        std::cout << "listen failed" << std::endl;
+        return -1;
+    }
+
+    std::vector<int> live;
+    for (int i = 0; i < __live_num; ++i) {
+        live.push_back(Connect(port));
+    }
+    while (true) {
+        std::unique_lock<std::mutex> lock(__live_mutex);
+        if (__live.size() >= (size_t)__live_num) {
+            __accept_live = false;
+            break;
+        }
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < churn_threads; ++i) {
+        threads.push_back(std::thread(Churn, port));
+    }
+    for (int i = 0; i < lookup_threads; ++i) {
+        threads.push_back(std::thread(Lookup, i));
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    __stop = true;
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%d io threads, %d churn threads, %d lookup threads\n", io_threads, churn_threads, lookup_threads);
+    printf("%10.0f connections/s  %12.0f lookups/s  %ld disconnections\n",
+           __connections / elapsed, __lookups / elapsed, __disconnections.load());
+
+    for (size_t i = 0; i < live.size(); ++i) {
+        close(live[i]);
+    }
+    cppnet::Dealloc();
+    cppnet::Join();
+    return 0;
+}
@@ -0,0 +1,166 @@
+// Benchmark of CMemoryPool shared by several threads, as the epoll
+// threads share CCppNetImpl's pool and every socket's pool is touched
+// by its epoll thread and by the application threads writing to it.
+//
+// small:  PoolMalloc/PoolFree of 16..256 bytes, in bursts of 32.
+// object: PoolNew/PoolDelete of a 64 bytes object, in bursts of 32.
+// block:  PoolLargeMalloc/PoolLargeFree of socket buffer blocks, in bursts of 4.
+// handoff: blocks allocated on one thread and freed on the next one.
+//
+// Reports ns per allocation and free, and the voluntary context switches
+// taken meanwhile, which are the threads sleeping on a contended lock.
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+#include "CNConfig.h"
+#include "MemoryPool.h"
+
+using namespace base;
+using namespace cppnet;
+
+static const int __burst = 32;
+
+struct Object {
+    char _data[64];
+};
+
+long VoluntarySwitches() {
+#ifdef __linux__
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw;
+#else
+    return 0;
+#endif
+}
+
+void SmallLoop(CMemoryPool* pool, int rounds) {
+    char* mem[__burst];
+    for (int i = 0; i < rounds; ++i) {
+        for (int j = 0; j < __burst; ++j) {
+            mem[j] = pool->PoolMalloc<char>((j + 1) * __align);
+        }
+        for (int j = 0; j < __burst; ++j) {
+            pool->PoolFree<char>(mem[j], (j + 1) * __align);
+        }
+    }
+}
+
+void ObjectLoop(CMemoryPool* pool, int rounds) {
+    Object* obj[__burst];
+    for (int i = 0; i < rounds; ++i) {
+        for (int j = 0; j < __burst; ++j) {
+            obj[j] = pool->PoolNew<Object>();
+        }
+        for (int j = 0; j < __burst; ++j) {
+            pool->PoolDelete<Object>(obj[j]);
+        }
+    }
+}
+
+void BlockLoop(CMemoryPool* pool, int rounds) {
+    const int burst = 4;
+    char* mem[burst];
+    for (int i = 0; i < rounds * __burst / burst; ++i) {
+        for (int j = 0; j < burst; ++j) {
+            mem[j] = pool->PoolLargeMalloc<char>();
+            mem[j][0] = 0;
+        }
+        for (int j = 0; j < burst; ++j) {
+            pool->PoolLargeFree<char>(mem[j]);
+        }
+    }
+}
+
+// every thread hands its blocks to the next one, which frees them
+struct Handoff {
+    std::mutex          _mutex;
+    std::vector<char*>  _blocks;
+};
+
+static std::vector<Handoff>* __handoff = nullptr;
+static std::atomic_int __handoff_turn;
+
+void HandoffLoop(CMemoryPool* pool, int rounds, int index, int threads) {
+    Handoff& mine = (*__handoff)[index];
+    Handoff& next = (*__handoff)[(index + 1) % threads];
+    std::vector<char*> blocks;
+    for (int i = 0; i < rounds; ++i) {
+        blocks.clear();
+        for (int j = 0; j < __burst; ++j) {
+            blocks.push_back(pool->PoolLargeMalloc<char>());
+        }
+        size_t pending = 0;
+        {
+            std::unique_lock<std::mutex> lock(next._mutex);
+            next._blocks.insert(next._blocks.end(), blocks.begin(), blocks.end());
+            pending = next._blocks.size();
+        }
+        // as a socket's send queue, don't run far ahead of the consumer
+        if (pending > 8 * __burst) {
+            std::this_thread::yield();
+        }
+        blocks.clear();
+        {
+            std::unique_lock<std::mutex> lock(mine._mutex);
+            blocks.swap(mine._blocks);
+        }
+        for (size_t j = 0; j < blocks.size(); ++j) {
+            pool->PoolLargeFree<char>(blocks[j]);
+        }
+    }
+    __handoff_turn++;
+    while (__handoff_turn.load() < threads) {
+        std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock(mine._mutex);
+    for (size_t j = 0; j < mine._blocks.size(); ++j) {
+        pool->PoolLargeFree<char>(mine._blocks[j]);
+    }
+    mine._blocks.clear();
+}
+
+template<typename Func>
+void Bench(const char* name, Func func, int threads, int rounds) {
+    CMemoryPool pool(__mem_block_size, __mem_block_add_step);
+    std::vector<Handoff> handoff(threads);
+    __handoff = &handoff;
+    __handoff_turn = 0;
+
+    long switches = VoluntarySwitches();
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.push_back(std::thread(func, &pool, rounds, i, threads));
+    }
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    switches = VoluntarySwitches() - switches;
+
+    double ops = (double)threads * rounds * __burst;
+    printf("%-8s %2d threads  %7.1f ns/op  %8.2f Mops/s  %8ld context switches\n",
+           name, threads, seconds * 1e9 / ops, ops / seconds / 1e6, switches);
+}
+
+int main(int argc, char* argv[]) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 200000;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 8;
+
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        Bench("small", [](CMemoryPool* pool, int rounds, int, int) { SmallLoop(pool, rounds); }, threads, rounds);
+        Bench("object", [](CMemoryPool* pool, int rounds, int, int) { ObjectLoop(pool, rounds); }, threads, rounds);
+        Bench("block", [](CMemoryPool* pool, int rounds, int, int) { BlockLoop(pool, rounds); }, threads, rounds);
+        Bench("handoff", HandoffLoop, threads, rounds / 4);
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+// Benchmark of CTimer with many timers, as an io thread keeping a read
+// timeout for every connection.
+//
+// churn:  with all timers armed, delete one and add it again, as a
+//         connection pushes its idle timeout back on every read.
+// check:  TimeoutCheck with all timers armed and none of them due,
+//         what every loop of the io thread does.
+// expire: add timers due in the next second, then check once after they
+//         are all due.
+//
+// Reports ns per operation, or per expired timer.
+#include <chrono>
+#include <vector>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Timer.h"
+#include "EventHandler.h"
+
+using namespace cppnet;
+
+static long __fired = 0;
+
+void OnTimer(void*) {
+    __fired++;
+}
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Churn(int timers, int ops) {
+    CTimer timer;
+    std::mt19937 rand(1);
+    std::vector<uint64_t> ids;
+    for (int i = 0; i < timers; ++i) {
+        ids.push_back(timer.AddTimer(30000 + rand() % 30000, OnTimer, nullptr));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ops; ++i) {
+        uint64_t& id = ids[rand() % timers];
+        timer.DelTimer(id);
+        id = timer.AddTimer(30000 + rand() % 30000, OnTimer, nullptr);
+    }
+    double seconds = Seconds(start);
+    printf("churn   %8d timers  %7.1f ns/op  %8.2f Mops/s\n",
+           timer.GetTimerNum(), seconds * 1e9 / ops, ops / seconds / 1e6);
+}
+
+void Check(int timers, int ops) {
+    CTimer timer;
+    std::mt19937 rand(2);
+    for (int i = 0; i < timers; ++i) {
+        timer.AddTimer(30000 + rand() % 30000, OnTimer, nullptr);
+    }
+
+    std::vector<CTimerEvent> res;
+    uint32_t recent = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ops; ++i) {
+        recent += timer.TimeoutCheck(res);
+    }
+    double seconds = Seconds(start);
+    printf("check   %8d timers  %7.1f ns/op  %8.2f Mops/s  (%u)\n",
+           timer.GetTimerNum(), seconds * 1e9 / ops, ops / seconds / 1e6, recent / ops);
+}
+
+void Expire(int timers) {
+    CTimer timer;
+    std::mt19937 rand(3);
+    for (int i = 0; i < timers; ++i) {
+        timer.AddTimer(rand() % 1000, OnTimer, nullptr);
+    }
+
+    std::vector<CTimerEvent> res;
+    res.reserve(timers);
+    __fired = 0;
+    auto start = std::chrono::steady_clock::now();
+    timer.TimeoutCheck(CTimer::Now() + 1000, res);
+    for (size_t i = 0; i < res.size(); ++i) {
+        res[i]._timer_call_back(res[i]._timer_param);
+    }
+    double seconds = Seconds(start);
+    printf("expire  %8ld timers  %7.1f ns/op  %8.2f Mops/s  %u left\n",
+           __fired, seconds * 1e9 / timers, timers / seconds / 1e6, timer.GetTimerNum());
+}
+
+int main(int argc, char* argv[]) {
+    int timers = argc > 1 ? atoi(argv[1]) : 100000;
+    int ops    = argc > 2 ? atoi(argv[2]) : 1000000;
+
+    Churn(timers, ops);
+    Check(timers, ops);
+    Expire(timers);
+    return 0;
+}
@@ -0,0 +1,134 @@
+// Checks CBuffer and CLoopBuffer against a std::string.
+//
+// Random writes and reads, so data wraps around loop buffers and spans
+// several of them. Exits with 1 at the first difference.
+#include <string>
+#include <random>
+#include <memory>
+#include <stdio.h>
+
+#include "Buffer.h"
+#include "CNConfig.h"
+#include "LoopBuffer.h"
+#include "MemoryPool.h"
+
+using namespace base;
+using namespace cppnet;
+
+static const int __steps = 20000;
+
+static char __in[16384];
+static char __out[16384];
+
+// data read must be the front of what was written and not read yet
+bool Check(const char* name, int step, std::string& pending, const char* data, int len) {
+    if (len < 0 || len > (int)pending.size() || pending.compare(0, len, data, len) != 0) {
+        printf("%s: data differs at step %d\n", name, step);
+        return false;
+    }
+    pending.erase(0, len);
+    return true;
+}
+
+// one loop buffer, writes wrap around its end and fill it
+bool TestLoopBuffer(std::shared_ptr<CMemoryPool>& pool) {
+    std::mt19937 random(7);
+    CLoopBuffer buffer(pool);
+    std::string pending;
+    for (int i = 0; i < __steps; ++i) {
+        // may be more than is free, the buffer takes what fits
+        int n = (int)(random() % (pool->GetLargeBlockLength() + 1));
+        for (int j = 0; j < n; ++j) {
+            __in[j] = (char)random();
+        }
+        n = buffer.Write(__in, n);
+        pending.append(__in, n);
+
+        int m = (int)(random() % (pool->GetLargeBlockLength() + 1));
+        int k = buffer.Read(__out, m);
+        if (!Check("CLoopBuffer", i, pending, __out, k)) {
+            return false;
+        }
+        if (buffer.GetCanReadLength() != (int)pending.size()) {
+            printf("CLoopBuffer: %d readable, %d expected\n", buffer.GetCanReadLength(), (int)pending.size());
+            return false;
+        }
+    }
+    return true;
+}
+
+// reads spanning loop buffers, with and without clearing
+bool TestBuffer(std::shared_ptr<CMemoryPool>& pool) {
+    std::mt19937 random(7);
+    CBuffer buffer(pool);
+    std::string pending;
+    for (int i = 0; i < __steps; ++i) {
+        int n = (int)(random() % 3000);
+        for (int j = 0; j < n; ++j) {
+            __in[j] = (char)random();
+        }
+        buffer.Write(__in, n);
+        pending.append(__in, n);
+
+        int m = (int)(random() % 3000);
+        int peek = buffer.ReadNotClear(__out, m);
+        if (peek > (int)pending.size() || pending.compare(0, peek, __out, peek) != 0) {
+            printf("CBuffer::ReadNotClear: data differs at step %d\n", i);
+            return false;
+        }
+        int k = buffer.Read(__out, m);
+        if (k != peek || !Check("CBuffer::Read", i, pending, __out, k)) {
+            return false;
+        }
+        if (buffer.GetCanReadLength() != (int)pending.size()) {
+            printf("CBuffer: %d readable, %d expected\n", buffer.GetCanReadLength(), (int)pending.size());
+            return false;
+        }
+    }
+    return true;
+}
+
+// writes handed over with Append, as the linux posted buffer
+bool TestAppend(std::shared_ptr<CMemoryPool>& pool) {
+    std::mt19937 random(7);
+    CBuffer buffer(pool);
+    CBuffer posted(pool);
+    std::string pending;
+    for (int i = 0; i < __steps; ++i) {
+        int n = (int)(random() % 5000);
+        for (int j = 0; j < n; ++j) {
+            __in[j] = (char)random();
+        }
+        posted.Write(__in, n);
+        pending.append(__in, n);
+        if (random() % 3 == 0) {
+            buffer.Append(posted);
+        }
+
+        int k = buffer.Read(__out, (int)(random() % 6000));
+        if (!Check("CBuffer::Append", i, pending, __out, k)) {
+            return false;
+        }
+    }
+    buffer.Append(posted);
+    int k;
+    while ((k = buffer.Read(__out, sizeof(__out))) > 0) {
+        if (!Check("CBuffer::Append", __steps, pending, __out, k)) {
+            return false;
+        }
+    }
+    if (!pending.empty()) {
+        printf("CBuffer::Append: %d bytes not read\n", (int)pending.size());
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    std::shared_ptr<CMemoryPool> pool(new CMemoryPool(__mem_block_size, __mem_block_add_step));
+    if (!TestLoopBuffer(pool) || !TestBuffer(pool) || !TestAppend(pool)) {
+        return 1;
+    }
+    printf("ok\n");
+    return 0;
+}
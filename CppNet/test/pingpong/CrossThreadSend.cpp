@@ -0,0 +1,199 @@
+// Throughput of Write called from application threads, not from callbacks
+// on the io threads.
+//
+// Sender threads write small messages to the connections accepted by the
+// server in this process, receiver threads read them from the client side
+// with plain sockets. A sender keeps at most __window bytes unread on a
+// connection, so the queues to the io threads stay bounded.
+//
+// Reports messages and MiB per second, and the voluntary context switches
+// taken meanwhile.
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+
+#include "CppNet.h"
+
+using namespace cppnet;
+
+static const long __window = 256 * 1024;
+
+struct Session {
+    Handle              _handle;
+    int                 _sock;
+    std::atomic_long    _written;
+    std::atomic_long    _received;
+};
+
+static std::atomic_bool  __stop(false);
+static std::mutex        __accept_mutex;
+static std::vector<Handle> __accepted;
+
+void OnAccept(const Handle& handle, uint32_t) {
+    std::unique_lock<std::mutex> lock(__accept_mutex);
+    __accepted.push_back(handle);
+}
+
+void OnRead(const Handle&, base::CBuffer* data, uint32_t, uint32_t) {
+    data->Clear();
+}
+
+long VoluntarySwitches() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw;
+}
+
+int Connect(int port) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    if (connect(sock, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+int LocalPort(int sock) {
+    sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    getsockname(sock, (sockaddr*)&addr, &len);
+    return ntohs(addr.sin_port);
+}
+
+void Receive(Session* conn) {
+    char buf[65536];
+    while (!__stop) {
+        int ret = read(conn->_sock, buf, sizeof(buf));
+        if (ret <= 0) {
+            break;
+        }
+        conn->_received += ret;
+    }
+}
+
+void Send(std::vector<Session*> conns, int msg_size, std::atomic_long* messages) {
+    std::string msg(msg_size, 'x');
+    long count = 0;
+    while (!__stop) {
+        bool sent = false;
+        for (size_t i = 0; i < conns.size(); ++i) {
+            Session* conn = conns[i];
+            if (conn->_written - conn->_received < __window) {
+                Write(conn->_handle, msg.c_str(), msg_size);
+                conn->_written += msg_size;
+                count++;
+                sent = true;
+            }
+        }
+        if (!sent) {
+            std::this_thread::yield();
+        }
+    }
+    *messages += count;
+}
+
+int main(int argc, char* argv[]) {
+    int io_threads     = argc > 1 ? atoi(argv[1]) : 4;
+    int sender_threads = argc > 2 ? atoi(argv[2]) : 4;
+    int conn_num       = argc > 3 ? atoi(argv[3]) : 8;
+    int msg_size       = argc > 4 ? atoi(argv[4]) : 64;
+    int seconds        = argc > 5 ? atoi(argv[5]) : 5;
+    int port           = argc > 6 ? atoi(argv[6]) : 8924;
+
+    cppnet::Init(io_threads);
+    cppnet::SetAcceptCallback(OnAccept);
+    cppnet::SetReadCallback(OnRead);
+    if (!cppnet::ListenAndAccept("0.0.0.0", port)) {
+        std::cout << "listen failed" << std::endl;
+        return -1;
+    }
+
+    std::vector<Session*> conns;
+    for (int i = 0; i < conn_num; ++i) {
+        Session* conn = new Session();
+        conn->_sock = Connect(port);
+        conn->_written = 0;
+        conn->_received = 0;
+        conns.push_back(conn);
+    }
+    while (true) {
+        std::unique_lock<std::mutex> lock(__accept_mutex);
+        if (__accepted.size() >= (size_t)conn_num) {
+            break;
+        }
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    // pair the server side handles with the client sockets by port
+    for (size_t i = 0; i < __accepted.size(); ++i) {
+        std::string ip;
+        uint16_t peer_port = 0;
+        GetIpAddress(__accepted[i], ip, peer_port);
+        for (size_t j = 0; j < conns.size(); ++j) {
+            if (LocalPort(conns[j]->_sock) == peer_port) {
+                conns[j]->_handle = __accepted[i];
+            }
+        }
+    }
+
+    std::atomic_long messages(0);
+    long switches = VoluntarySwitches();
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < conns.size(); ++i) {
+        threads.push_back(std::thread(Receive, conns[i]));
+    }
+    for (int i = 0; i < sender_threads; ++i) {
+        std::vector<Session*> mine;
+        for (size_t j = i; j < conns.size(); j += sender_threads) {
+            mine.push_back(conns[j]);
+        }
+        threads.push_back(std::thread(Send, mine, msg_size, &messages));
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    __stop = true;
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    long received = 0;
+    for (size_t i = 0; i < conns.size(); ++i) {
+        received += conns[i]->_received;
+    }
+    switches = VoluntarySwitches() - switches;
+
+    // unblock the receivers
+    for (size_t i = 0; i < conns.size(); ++i) {
+        shutdown(conns[i]->_sock, SHUT_RDWR);
+    }
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+
+    printf("%d io threads, %d sender threads, %d connections, %d bytes messages\n",
+           io_threads, sender_threads, conn_num, msg_size);
+    printf("%10.0f messages/s  %8.2f MiB/s received  %8ld context switches\n",
+           messages / elapsed, received / elapsed / 1024 / 1024, switches);
+
+    for (size_t i = 0; i < conns.size(); ++i) {
+        close(conns[i]->_sock);
+        delete conns[i];
+    }
+    cppnet::Dealloc();
+    cppnet::Join();
+    return 0;
+}
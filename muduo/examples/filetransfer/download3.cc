@@ -2,7 +2,9 @@
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/TcpServer.h"
 
+#include <fcntl.h>
 #include <stdio.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 using namespace muduo;
@@ -15,7 +17,32 @@ void onHighWaterMark(const TcpConnectionPtr& conn, size_t len)
 
 const int kBufSize = 64*1024;
 const char* g_file = NULL;
-typedef std::shared_ptr<FILE> FilePtr;
+
+// a chunk at a time as before, but sent with sendfile(2),
+// so no chunk is read into user space.
+struct File : noncopyable
+{
+  File(int f, int64_t s) : fd(f), size(s), offset(0) { }
+  ~File() { ::close(fd); }
+
+  // returns false when all is sent
+  bool sendChunk(const TcpConnectionPtr& conn)
+  {
+    int64_t len = std::min<int64_t>(kBufSize, size - offset);
+    if (len <= 0)
+    {
+      return false;
+    }
+    conn->sendFile(fd, offset, static_cast<size_t>(len));
+    offset += len;
+    return true;
+  }
+
+  const int fd;
+  const int64_t size;
+  int64_t offset;
+};
+typedef std::shared_ptr<File> FilePtr;
 
 void onConnection(const TcpConnectionPtr& conn)
 {
@@ -28,17 +55,23 @@ void onConnection(const TcpConnectionPtr& conn)
              << " to " << conn->peerAddress().toIpPort();
     conn->setHighWaterMarkCallback(onHighWaterMark, kBufSize+1);
 
-    FILE* fp = ::fopen(g_file, "rb");
-    if (fp)
+    int fd = ::open(g_file, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd >= 0 && ::fstat(fd, &st) == 0)
     {
-      FilePtr ctx(fp, ::fclose);
+      FilePtr ctx(new File(fd, st.st_size));
       conn->setContext(ctx);
-      char buf[kBufSize];
-      size_t nread = ::fread(buf, 1, sizeof buf, fp);
-      conn->send(buf, static_cast<int>(nread));
+      if (!ctx->sendChunk(conn))
+      {
+        conn->shutdown();
+      }
     }
     else
     {
+      if (fd >= 0)
+      {
+        ::close(fd);
+      }
       conn->shutdown();
       LOG_INFO << "FileServer - no such file";
     }
@@ -48,13 +81,7 @@ void onConnection(const TcpConnectionPtr& conn)
 void onWriteComplete(const TcpConnectionPtr& conn)
 {
   const FilePtr& fp = boost::any_cast<const FilePtr&>(conn->getContext());
-  char buf[kBufSize];
-  size_t nread = ::fread(buf, 1, sizeof buf, get_pointer(fp));
-  if (nread > 0)
-  {
-    conn->send(buf, static_cast<int>(nread));
-  }
-  else
+  if (!fp->sendChunk(conn))
   {
     conn->shutdown();
     LOG_INFO << "FileServer - done";
@@ -0,0 +1,106 @@
+// C++ port of Client.java, measures download throughput of
+// filetransfer_download* servers.
+
+#include "muduo/base/Atomic.h"
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThreadPool.h"
+#include "muduo/net/InetAddress.h"
+#include "muduo/net/TcpClient.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+class Downloader : noncopyable
+{
+ public:
+  Downloader(EventLoop* loop, const InetAddress& serverAddr,
+             const string& name, const std::function<void(int64_t)>& done)
+    : client_(loop, serverAddr, name),
+      done_(done),
+      received_(0)
+  {
+    client_.setConnectionCallback(
+        std::bind(&Downloader::onConnection, this, _1));
+    client_.setMessageCallback(
+        std::bind(&Downloader::onMessage, this, _1, _2, _3));
+  }
+
+  void connect()
+  {
+    client_.connect();
+  }
+
+ private:
+  void onConnection(const TcpConnectionPtr& conn)
+  {
+    if (conn->disconnected())
+    {
+      // after TcpClient finished with this connection
+      conn->getLoop()->queueInLoop(std::bind(done_, received_));
+    }
+  }
+
+  void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+  {
+    received_ += static_cast<int64_t>(buf->readableBytes());
+    buf->retrieveAll();
+  }
+
+  TcpClient client_;
+  std::function<void(int64_t)> done_;
+  int64_t received_;
+};
+
+EventLoop* g_loop;
+AtomicInt64 g_bytes;
+AtomicInt32 g_remaining;
+Timestamp g_start;
+
+void onDone(int64_t received)
+{
+  g_bytes.add(received);
+  if (g_remaining.decrementAndGet() == 0)
+  {
+    double seconds = timeDifference(Timestamp::now(), g_start);
+    double mebibytes = static_cast<double>(g_bytes.get()) / 1024 / 1024;
+    printf("%.3f seconds\n%.3f MiB total\n%.3f MiB/s throughput\n",
+           seconds, mebibytes, mebibytes / seconds);
+    g_loop->queueInLoop(std::bind(&EventLoop::quit, g_loop));
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 3)
+  {
+    fprintf(stderr, "Usage: %s <host_ip> <clients> [threads]\n", argv[0]);
+    return 0;
+  }
+  Logger::setLogLevel(Logger::WARN);
+  const InetAddress serverAddr(argv[1], 2021);
+  const int numClients = atoi(argv[2]);
+  const int numThreads = argc > 3 ? atoi(argv[3]) : 0;
+
+  EventLoop loop;
+  g_loop = &loop;
+  EventLoopThreadPool pool(&loop, "loadtest");
+  pool.setThreadNum(numThreads);
+  pool.start();
+
+  g_remaining.getAndSet(numClients);
+  std::vector<std::unique_ptr<Downloader>> downloaders;
+  g_start = Timestamp::now();
+  for (int i = 0; i < numClients; ++i)
+  {
+    char name[32];
+    snprintf(name, sizeof name, "download%d", i);
+    downloaders.emplace_back(
+        new Downloader(pool.getNextLoop(), serverAddr, name, onDone));
+    downloaders.back()->connect();
+  }
+  loop.loop();
+}
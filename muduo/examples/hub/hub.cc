@@ -1,11 +1,13 @@
 #include "examples/hub/codec.h"
 
 #include "muduo/base/Logging.h"
+#include "muduo/base/Mutex.h"
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/TcpServer.h"
 
 #include <map>
 #include <set>
+#include <vector>
 #include <stdio.h>
 
 using namespace muduo;
@@ -14,8 +16,29 @@ using namespace muduo::net;
 namespace pubsub
 {
 
-typedef std::set<string> ConnectionSubscription;
+// "pub topic\r\ncontent\r\n", shared by all subscribers of a topic.
+typedef std::shared_ptr<const string> Payload;
 
+const size_t kHighMark = 64 * 1024;
+const size_t kLowMark = 16 * 1024;
+
+// a subscriber whose output queue reaches kHighMark is lagging,
+// messages to it are dropped until the queue drains to kLowMark,
+// then it gets the last message of each topic it missed.
+// it catches up at the latest when its output queue is empty.
+struct Subscriber
+{
+  Subscriber()
+    : lagging(false)
+  {
+  }
+
+  std::set<string> topics;
+  bool lagging;
+  std::set<string> missed;
+};
+
+// subscribers of a topic in one I/O loop.
 class Topic : public muduo::copyable
 {
  public:
@@ -24,13 +47,18 @@ class Topic : public muduo::copyable
   {
   }
 
-  void add(const TcpConnectionPtr& conn)
+  const string& name() const
+  { return topic_; }
+
+  const Payload& lastMessage() const
+  { return message_; }
+
+  const std::set<TcpConnectionPtr>& audiences() const
+  { return audiences_; }
+
+  bool add(const TcpConnectionPtr& conn)
   {
-    audiences_.insert(conn);
-    if (lastPubTime_.valid())
-    {
-      conn->send(makeMessage());
-    }
+    return audiences_.insert(conn).second;
   }
 
   void remove(const TcpConnectionPtr& conn)
@@ -38,30 +66,31 @@ class Topic : public muduo::copyable
     audiences_.erase(conn);
   }
 
-  void publish(const string& content, Timestamp time)
+  void setLastMessage(const Payload& message)
   {
-    content_ = content;
-    lastPubTime_ = time;
-    string message = makeMessage();
-    for (std::set<TcpConnectionPtr>::iterator it = audiences_.begin();
-         it != audiences_.end();
-         ++it)
-    {
-      (*it)->send(message);
-    }
+    message_ = message;
   }
 
  private:
+  string topic_;
+  Payload message_;
+  std::set<TcpConnectionPtr> audiences_;
+};
 
-  string makeMessage()
+// topics of subscribers in one I/O loop, touched in that loop only.
+// a topic is only kept in shards with subscribers of it, and in its owner,
+// which keeps the last message for later subscribers.
+struct Shard : noncopyable
+{
+  explicit Shard(EventLoop* ioLoop)
+    : loop(ioLoop),
+      dropped(0)
   {
-    return "pub " + topic_ + "\r\n" + content_ + "\r\n";
   }
 
-  string topic_;
-  string content_;
-  Timestamp lastPubTime_;
-  std::set<TcpConnectionPtr> audiences_;
+  EventLoop* loop;
+  std::map<string, Topic> topics;
+  int64_t dropped;
 };
 
 class PubSubServer : noncopyable
@@ -76,28 +105,59 @@ class PubSubServer : noncopyable
         std::bind(&PubSubServer::onConnection, this, _1));
     server_.setMessageCallback(
         std::bind(&PubSubServer::onMessage, this, _1, _2, _3));
+    server_.setWriteCompleteCallback(
+        std::bind(&PubSubServer::onWriteComplete, this, _1));
+    server_.setThreadInitCallback(
+        std::bind(&PubSubServer::onThreadInit, this, _1));
     loop_->runEvery(1.0, std::bind(&PubSubServer::timePublish, this));
   }
 
+  void setThreadNum(int numThreads)
+  {
+    server_.setThreadNum(numThreads);
+  }
+
   void start()
   {
     server_.start();
   }
 
  private:
+  void onThreadInit(EventLoop* loop)
+  {
+    std::unique_ptr<Shard> shard(new Shard(loop));
+    loop->setContext(shard.get());
+    MutexLockGuard lock(mutex_);
+    shards_.push_back(std::move(shard));
+  }
+
+  // all shards are created before the server starts accepting.
+  static Shard* shardOf(const TcpConnectionPtr& conn)
+  {
+    return boost::any_cast<Shard*>(conn->getLoop()->getContext());
+  }
+
+  // publishes of a topic go through its owner, so that every shard
+  // sees them in the same order.
+  Shard* ownerOf(const string& topic) const
+  {
+    size_t hash = std::hash<string>()(topic);
+    return shards_[hash % shards_.size()].get();
+  }
+
   void onConnection(const TcpConnectionPtr& conn)
   {
     if (conn->connected())
     {
-      conn->setContext(ConnectionSubscription());
+      conn->setContext(Subscriber());
     }
     else
     {
-      const ConnectionSubscription& connSub
-        = boost::any_cast<const ConnectionSubscription&>(conn->getContext());
+      const Subscriber& subscriber
+        = boost::any_cast<const Subscriber&>(conn->getContext());
       // subtle: doUnsubscribe will erase *it, so increase before calling.
-      for (ConnectionSubscription::const_iterator it = connSub.begin();
-           it != connSub.end();)
+      for (std::set<string>::const_iterator it = subscriber.topics.begin();
+           it != subscriber.topics.end();)
       {
         doUnsubscribe(conn, *it++);
       }
@@ -143,6 +203,16 @@ class PubSubServer : noncopyable
     }
   }
 
+  void onWriteComplete(const TcpConnectionPtr& conn)
+  {
+    Subscriber* subscriber
+      = boost::any_cast<Subscriber>(conn->getMutableContext());
+    if (subscriber->lagging && conn->connected())
+    {
+      catchUp(shardOf(conn), conn, subscriber, string());
+    }
+  }
+
   void timePublish()
   {
     Timestamp now = Timestamp::now();
@@ -152,22 +222,81 @@ class PubSubServer : noncopyable
   void doSubscribe(const TcpConnectionPtr& conn,
                    const string& topic)
   {
-    ConnectionSubscription* connSub
-      = boost::any_cast<ConnectionSubscription>(conn->getMutableContext());
+    Subscriber* subscriber
+      = boost::any_cast<Subscriber>(conn->getMutableContext());
+
+    subscriber->topics.insert(topic);
+    Shard* shard = shardOf(conn);
+    Topic& t = getTopic(shard, topic);
+    if (t.add(conn))
+    {
+      if (t.lastMessage())
+      {
+        deliver(shard, conn, t);
+      }
+      else
+      {
+        Shard* owner = ownerOf(topic);
+        if (owner != shard)
+        {
+          owner->loop->runInLoop(
+              std::bind(&PubSubServer::lastMessageInOwner, this, owner, shard, topic));
+        }
+      }
+    }
+  }
+
+  // the owner answers in order with the messages it fans out after,
+  // so shard gets no older message than it has.
+  void lastMessageInOwner(Shard* owner, Shard* shard, const string& topic)
+  {
+    std::map<string, Topic>::const_iterator it = owner->topics.find(topic);
+    if (it != owner->topics.end() && it->second.lastMessage())
+    {
+      shard->loop->runInLoop(
+          std::bind(&PubSubServer::receiveLastMessage, this, shard, topic,
+                    it->second.lastMessage()));
+    }
+  }
 
-    connSub->insert(topic);
-    getTopic(topic).add(conn);
+  // all subscribers here are waiting for it, unless a message
+  // was fanned out or received meanwhile.
+  void receiveLastMessage(Shard* shard, const string& topic, const Payload& message)
+  {
+    std::map<string, Topic>::iterator found = shard->topics.find(topic);
+    if (found == shard->topics.end() || found->second.lastMessage())
+    {
+      return;
+    }
+    Topic& t = found->second;
+    t.setLastMessage(message);
+    for (std::set<TcpConnectionPtr>::const_iterator it = t.audiences().begin();
+         it != t.audiences().end();
+         ++it)
+    {
+      deliver(shard, *it, t);
+    }
   }
 
   void doUnsubscribe(const TcpConnectionPtr& conn,
                      const string& topic)
   {
     LOG_INFO << conn->name() << " unsubscribes " << topic;
-    getTopic(topic).remove(conn);
+    Shard* shard = shardOf(conn);
+    std::map<string, Topic>::iterator it = shard->topics.find(topic);
+    if (it != shard->topics.end())
+    {
+      it->second.remove(conn);
+      if (it->second.audiences().empty() && ownerOf(topic) != shard)
+      {
+        shard->topics.erase(it);
+      }
+    }
     // topic could be the one to be destroyed, so don't use it after erasing.
-    ConnectionSubscription* connSub
-      = boost::any_cast<ConnectionSubscription>(conn->getMutableContext());
-    connSub->erase(topic);
+    Subscriber* subscriber
+      = boost::any_cast<Subscriber>(conn->getMutableContext());
+    subscriber->topics.erase(topic);
+    subscriber->missed.erase(topic);
   }
 
   void doPublish(const string& source,
@@ -175,22 +304,97 @@ class PubSubServer : noncopyable
                  const string& content,
                  Timestamp time)
   {
-    getTopic(topic).publish(content, time);
+    Payload message(new string("pub " + topic + "\r\n" + content + "\r\n"));
+    ownerOf(topic)->loop->runInLoop(
+        std::bind(&PubSubServer::publishInOwner, this, topic, message));
+  }
+
+  void publishInOwner(const string& topic, const Payload& message)
+  {
+    getTopic(ownerOf(topic), topic).setLastMessage(message);
+    // fanOut runs right here for this shard, nothing is locked meanwhile.
+    for (const auto& shard : shards_)
+    {
+      shard->loop->runInLoop(
+          std::bind(&PubSubServer::fanOut, this, shard.get(), topic, message));
+    }
   }
 
-  Topic& getTopic(const string& topic)
+  void fanOut(Shard* shard, const string& topic, const Payload& message)
   {
-    std::map<string, Topic>::iterator it = topics_.find(topic);
-    if (it == topics_.end())
+    std::map<string, Topic>::iterator found = shard->topics.find(topic);
+    if (found == shard->topics.end())
+    {
+      // no subscribers here
+      return;
+    }
+    Topic& t = found->second;
+    t.setLastMessage(message);
+    for (std::set<TcpConnectionPtr>::const_iterator it = t.audiences().begin();
+         it != t.audiences().end();
+         ++it)
     {
-      it = topics_.insert(make_pair(topic, Topic(topic))).first;
+      deliver(shard, *it, t);
+    }
+  }
+
+  // sends the last message of topic to conn, or drops it if conn is lagging.
+  void deliver(Shard* shard, const TcpConnectionPtr& conn, const Topic& topic)
+  {
+    Subscriber* subscriber
+      = boost::any_cast<Subscriber>(conn->getMutableContext());
+    if (subscriber->lagging)
+    {
+      if (conn->outputBytes() > kLowMark)
+      {
+        subscriber->missed.insert(topic.name());
+        ++shard->dropped;
+        return;
+      }
+      catchUp(shard, conn, subscriber, topic.name());
+    }
+    conn->send(topic.lastMessage());
+    if (conn->outputBytes() >= kHighMark)
+    {
+      LOG_WARN << conn->name() << " is lagging, "
+               << conn->outputBytes() << " bytes queued";
+      subscriber->lagging = true;
+    }
+  }
+
+  // sends the last message of each topic conn missed, but skip.
+  void catchUp(Shard* shard, const TcpConnectionPtr& conn,
+               Subscriber* subscriber, const string& skip)
+  {
+    LOG_INFO << conn->name() << " caught up";
+    subscriber->lagging = false;
+    std::set<string> missed;
+    missed.swap(subscriber->missed);
+    for (const string& name : missed)
+    {
+      if (name != skip)
+      {
+        conn->send(getTopic(shard, name).lastMessage());
+      }
+    }
+  }
+
+  Topic& getTopic(Shard* shard, const string& topic)
+  {
+    std::map<string, Topic>::iterator it = shard->topics.find(topic);
+    if (it == shard->topics.end())
+    {
+      it = shard->topics.insert(make_pair(topic, Topic(topic))).first;
     }
     return it->second;
   }
 
   EventLoop* loop_;
   TcpServer server_;
-  std::map<string, Topic> topics_;
+  MutexLock mutex_;
+  // one per I/O loop, loop threads add theirs under mutex_ in start(),
+  // it doesn't change afterwards, so it is read without locking.
+  std::vector<std::unique_ptr<Shard>> shards_;
 };
 
 }  // namespace pubsub
@@ -206,12 +410,16 @@ int main(int argc, char* argv[])
       //int inspectPort = atoi(argv[2]);
     }
     pubsub::PubSubServer server(&loop, InetAddress(port));
+    if (argc > 3)
+    {
+      server.setThreadNum(atoi(argv[3]));
+    }
     server.start();
     loop.loop();
   }
   else
   {
-    printf("Usage: %s pubsub_port [inspect_port]\n", argv[0]);
+    printf("Usage: %s pubsub_port [inspect_port [io_threads]]\n", argv[0]);
   }
 }
 
@@ -0,0 +1,314 @@
+// Benchmark of hub fan-out.
+//
+// Subscribers spread over topics, a publisher publishes on every topic
+// at a fixed interval, each message carrying its publish time, subscribers
+// report deliveries per second and latency from publish to receipt.
+// Stalled subscribers subscribe but never read, the hub should drop
+// messages to them instead of queueing without limit.
+//
+// Run hub first, e.g. ./hub 9999 0 4
+
+#include "examples/hub/pubsub.h"
+#include "muduo/base/Atomic.h"
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThreadPool.h"
+#include "muduo/net/InetAddress.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+using namespace pubsub;
+
+class Bench;
+
+class Subscriber : noncopyable
+{
+ public:
+  Subscriber(EventLoop* loop,
+             const InetAddress& hubAddr,
+             const string& name,
+             const string& topic,
+             Bench* owner)
+    : client_(loop, hubAddr, name),
+      topic_(topic),
+      owner_(owner),
+      bytes_(0)
+  {
+    client_.setConnectionCallback(
+        std::bind(&Subscriber::onConnection, this, _1));
+  }
+
+  void start()
+  {
+    client_.start();
+  }
+
+  void stop()
+  {
+    client_.stop();
+  }
+
+  const std::vector<int64_t>& latencies() const
+  { return latencies_; }
+
+  int64_t bytes() const
+  { return bytes_; }
+
+ private:
+  void onConnection(PubSubClient* client);
+
+  void onSubscription(const string& topic, const string& content, Timestamp receiveTime)
+  {
+    int64_t published = strtoll(content.c_str(), NULL, 10);
+    latencies_.push_back(receiveTime.microSecondsSinceEpoch() - published);
+    bytes_ += static_cast<int64_t>(content.size());
+  }
+
+  PubSubClient client_;
+  const string topic_;
+  Bench* owner_;
+  std::vector<int64_t> latencies_;
+  int64_t bytes_;
+};
+
+class Bench : noncopyable
+{
+ public:
+  Bench(EventLoop* loop,
+        const InetAddress& hubAddr,
+        int threadCount,
+        int numTopics,
+        int subscribersPerTopic,
+        int numStalled,
+        int payloadSize,
+        double interval,
+        double seconds)
+    : loop_(loop),
+      hubAddr_(hubAddr),
+      threadPool_(loop, "hub-bench"),
+      publisher_(loop, hubAddr, "publisher"),
+      numTopics_(numTopics),
+      numSubscribers_(numTopics * subscribersPerTopic),
+      numStalled_(numStalled),
+      payloadSize_(payloadSize),
+      interval_(interval),
+      seconds_(seconds),
+      published_(0)
+  {
+    threadPool_.setThreadNum(threadCount);
+    threadPool_.start();
+    publisher_.setConnectionCallback(std::bind(&Bench::onPublisherConnection, this, _1));
+    for (int i = 0; i < numSubscribers_; ++i)
+    {
+      char name[32];
+      snprintf(name, sizeof name, "S%05d", i);
+      Subscriber* subscriber = new Subscriber(threadPool_.getNextLoop(), hubAddr,
+                                              name, topicName(i % numTopics), this);
+      subscribers_.emplace_back(subscriber);
+      subscriber->start();
+    }
+  }
+
+  ~Bench()
+  {
+    for (int fd : stalled_)
+    {
+      ::close(fd);
+    }
+  }
+
+  static string topicName(int i)
+  {
+    char buf[32];
+    snprintf(buf, sizeof buf, "bench%d", i);
+    return buf;
+  }
+
+  void onConnect()
+  {
+    if (numConnected_.incrementAndGet() == numSubscribers_)
+    {
+      LOG_WARN << "all connected";
+      loop_->runInLoop(std::bind(&Bench::stall, this));
+    }
+  }
+
+  void onDisconnect()
+  {
+    if (numConnected_.decrementAndGet() == 0)
+    {
+      loop_->queueInLoop(std::bind(&Bench::report, this));
+    }
+  }
+
+ private:
+  // subscribes to the first topic, but never reads.
+  void stall()
+  {
+    const string message = "sub " + topicName(0) + "\r\n";
+    for (int i = 0; i < numStalled_; ++i)
+    {
+      int sockfd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+      // a small window, as a slow client on a slow link
+      int rcvbuf = 4096;
+      ::setsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof rcvbuf);
+      if (::connect(sockfd, hubAddr_.getSockAddr(),
+                    static_cast<socklen_t>(sizeof(struct sockaddr_in))) < 0
+          || ::write(sockfd, message.data(), message.size())
+             != static_cast<ssize_t>(message.size()))
+      {
+        LOG_SYSFATAL << "stalled subscriber";
+      }
+      stalled_.push_back(sockfd);
+    }
+    publisher_.start();
+  }
+
+  void onPublisherConnection(PubSubClient* client)
+  {
+    if (client->connected())
+    {
+      // lets subscriptions settle
+      loop_->runAfter(0.5, std::bind(&Bench::startPublishing, this));
+    }
+  }
+
+  void startPublishing()
+  {
+    LOG_WARN << "start publishing";
+    start_ = Timestamp::now();
+    timer_ = loop_->runEvery(interval_, std::bind(&Bench::publish, this));
+    loop_->runAfter(seconds_, std::bind(&Bench::stop, this));
+  }
+
+  void publish()
+  {
+    char buf[32];
+    snprintf(buf, sizeof buf, "%" PRId64 " ", Timestamp::now().microSecondsSinceEpoch());
+    string content(buf);
+    if (content.size() < static_cast<size_t>(payloadSize_))
+    {
+      content.append(payloadSize_ - content.size(), 'x');
+    }
+    for (int i = 0; i < numTopics_; ++i)
+    {
+      publisher_.publish(topicName(i), content);
+    }
+    ++published_;
+  }
+
+  void stop()
+  {
+    loop_->cancel(timer_);
+    elapsed_ = timeDifference(Timestamp::now(), start_);
+    // lets messages in flight arrive
+    loop_->runAfter(0.5, std::bind(&Bench::disconnect, this));
+  }
+
+  void disconnect()
+  {
+    publisher_.stop();
+    for (auto& subscriber : subscribers_)
+    {
+      subscriber->stop();
+    }
+  }
+
+  void report()
+  {
+    std::vector<int64_t> all;
+    int64_t bytes = 0;
+    for (const auto& subscriber : subscribers_)
+    {
+      all.insert(all.end(), subscriber->latencies().begin(), subscriber->latencies().end());
+      bytes += subscriber->bytes();
+    }
+    std::sort(all.begin(), all.end());
+    int64_t expected = published_ * numSubscribers_;
+    printf("%d subscribers on %d topics, %d stalled, %d bytes payload\n",
+           numSubscribers_, numTopics_, numStalled_, payloadSize_);
+    printf("published %" PRId64 " per topic, delivered %zd of %" PRId64 ", "
+           "%.0f deliveries/s, %.1f MiB/s\n",
+           published_, all.size(), expected,
+           static_cast<double>(all.size()) / elapsed_,
+           static_cast<double>(bytes) / elapsed_ / (1024 * 1024));
+    if (!all.empty())
+    {
+      printf("latency p50 %" PRId64 " us  p99 %" PRId64 " us  max %" PRId64 " us\n",
+             all[all.size() / 2], all[all.size() * 99 / 100], all.back());
+    }
+    loop_->quit();
+  }
+
+  EventLoop* loop_;
+  const InetAddress hubAddr_;
+  EventLoopThreadPool threadPool_;
+  PubSubClient publisher_;
+  const int numTopics_;
+  const int numSubscribers_;
+  const int numStalled_;
+  const int payloadSize_;
+  const double interval_;
+  const double seconds_;
+  std::vector<std::unique_ptr<Subscriber>> subscribers_;
+  std::vector<int> stalled_;
+  AtomicInt32 numConnected_;
+  TimerId timer_;
+  Timestamp start_;
+  double elapsed_;
+  int64_t published_;
+};
+
+void Subscriber::onConnection(PubSubClient* client)
+{
+  if (client->connected())
+  {
+    client->subscribe(topic_, std::bind(&Subscriber::onSubscription, this, _1, _2, _3));
+    owner_->onConnect();
+  }
+  else
+  {
+    owner_->onDisconnect();
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 3)
+  {
+    fprintf(stderr, "Usage: %s hub_ip:port threads [topics [subscribers_per_topic "
+                    "[stalled [payload [interval [seconds]]]]]]\n", argv[0]);
+    return 1;
+  }
+  Logger::setLogLevel(Logger::WARN);
+  string hostport = argv[1];
+  size_t colon = hostport.find(':');
+  if (colon == string::npos)
+  {
+    fprintf(stderr, "Usage: %s hub_ip:port ...\n", argv[0]);
+    return 1;
+  }
+  InetAddress hubAddr(hostport.substr(0, colon),
+                      static_cast<uint16_t>(atoi(hostport.c_str() + colon + 1)));
+  int threadCount = atoi(argv[2]);
+  int numTopics = argc > 3 ? atoi(argv[3]) : 4;
+  int subscribersPerTopic = argc > 4 ? atoi(argv[4]) : 250;
+  int numStalled = argc > 5 ? atoi(argv[5]) : 0;
+  int payloadSize = argc > 6 ? atoi(argv[6]) : 256;
+  double interval = argc > 7 ? atof(argv[7]) : 0.001;
+  double seconds = argc > 8 ? atof(argv[8]) : 5.0;
+
+  EventLoop loop;
+  Bench bench(&loop, hubAddr, threadCount, numTopics, subscribersPerTopic,
+              numStalled, payloadSize, interval, seconds);
+  loop.loop();
+}
@@ -1,5 +1,6 @@
 #include "muduo/base/CountDownLatch.h"
 #include "muduo/base/Logging.h"
+#include "muduo/net/Endian.h"
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/EventLoopThreadPool.h"
 #include "muduo/net/TcpClient.h"
@@ -8,6 +9,7 @@
 #include <iostream>
 
 #include <stdio.h>
+#include <string.h>
 
 namespace po = boost::program_options;
 using namespace muduo;
@@ -22,28 +24,42 @@ class Client : noncopyable
     kSet,
   };
 
+  enum Protocol
+  {
+    kText,
+    kBinary,
+  };
+
   Client(const string& name,
          EventLoop* loop,
          const InetAddress& serverAddr,
          Operation op,
+         Protocol protocol,
          int requests,
          int keys,
+         int multiget,
          int valuelen,
          CountDownLatch* connected,
          CountDownLatch* finished)
     : name_(name),
       client_(loop, serverAddr, name),
       op_(op),
+      protocol_(protocol),
       sent_(0),
       acked_(0),
+      hits_(0),
       requests_(requests),
       keys_(keys),
+      multiget_(multiget),
       valuelen_(valuelen),
       value_(valuelen_, 'a'),
       connected_(connected),
       finished_(finished)
   {
-    value_ += "\r\n";
+    if (protocol_ == kText)
+    {
+      value_ += "\r\n";
+    }
     client_.setConnectionCallback(std::bind(&Client::onConnection, this, _1));
     client_.setMessageCallback(std::bind(&Client::onMessage, this, _1, _2, _3));
     client_.connect();
@@ -56,7 +72,18 @@ class Client : noncopyable
     conn_->send(&buf);
   }
 
+  int64_t hits() const { return hits_; }
+
  private:
+  // memcached binary protocol
+  enum Opcode
+  {
+    kBinaryGet = 0x00,
+    kBinarySet = 0x01,
+    kBinaryNoop = 0x0a,
+    kBinaryGetKQ = 0x0d,
+  };
+  static const size_t kHeaderSize = 24;
 
   void onConnection(const TcpConnectionPtr& conn)
   {
@@ -76,7 +103,32 @@ class Client : noncopyable
                  Buffer* buffer,
                  Timestamp receiveTime)
   {
-    if (op_ == kSet)
+    if (protocol_ == kBinary)
+    {
+      while (buffer->readableBytes() >= kHeaderSize)
+      {
+        const size_t bodylen = static_cast<uint32_t>(
+            sockets::networkToHost32(*reinterpret_cast<const uint32_t*>(buffer->peek() + 8)));
+        if (buffer->readableBytes() < kHeaderSize + bodylen)
+        {
+          break;
+        }
+        const uint8_t opcode = static_cast<uint8_t>(buffer->peek()[1]);
+        uint16_t status = 0;
+        memcpy(&status, buffer->peek() + 6, sizeof status);
+        status = sockets::networkToHost16(status);
+        buffer->retrieve(kHeaderSize + bodylen);
+        if (op_ == kGet && opcode != kBinaryNoop && status == 0)
+        {
+          ++hits_;
+        }
+        if (op_ == kSet || multiget_ == 1 || opcode == kBinaryNoop)
+        {
+          acked();
+        }
+      }
+    }
+    else if (op_ == kSet)
     {
       while (buffer->readableBytes() > 0)
       {
@@ -84,11 +136,7 @@ class Client : noncopyable
         if (crlf)
         {
           buffer->retrieveUntil(crlf+2);
-          ++acked_;
-          if (sent_ < requests_)
-          {
-            send();
-          }
+          acked();
         }
         else
         {
@@ -105,12 +153,14 @@ class Client : noncopyable
                                                           "END\r\n", 5));
         if (end)
         {
-          buffer->retrieveUntil(end+5);
-          ++acked_;
-          if (sent_ < requests_)
+          const char* p = buffer->peek();
+          while ((p = static_cast<const char*>(memmem(p, end - p, "VALUE ", 6))) != NULL)
           {
-            send();
+            ++hits_;
+            p += 6;
           }
+          buffer->retrieveUntil(end+5);
+          acked();
         }
         else
         {
@@ -124,59 +174,187 @@ class Client : noncopyable
     }
   }
 
+  void acked()
+  {
+    ++acked_;
+    if (sent_ < requests_)
+    {
+      send();
+    }
+  }
+
   void fill(Buffer* buf)
   {
-    char req[256];
+    char key[64];
     if (op_ == kSet)
     {
-      snprintf(req, sizeof req, "set %s%d 42 0 %d\r\n", name_.c_str(), sent_ % keys_, valuelen_);
+      int keylen = snprintf(key, sizeof key, "%s%d", name_.c_str(), sent_ % keys_);
       ++sent_;
-      buf->append(req);
+      if (protocol_ == kBinary)
+      {
+        appendHeader(buf, kBinarySet, keylen, 8, keylen + 8 + valuelen_);
+        buf->appendInt32(42);  // flags
+        buf->appendInt32(0);   // exptime
+        buf->append(key, keylen);
+      }
+      else
+      {
+        char req[256];
+        snprintf(req, sizeof req, "set %s 42 0 %d\r\n", key, valuelen_);
+        buf->append(req);
+      }
       buf->append(value_);
+      return;
+    }
+
+    if (protocol_ == kText)
+    {
+      buf->append("get", 3);
+    }
+    for (int i = 0; i < multiget_; ++i)
+    {
+      int keylen = snprintf(key, sizeof key, "%s%d",
+                            name_.c_str(), (sent_ * multiget_ + i) % keys_);
+      if (protocol_ == kBinary)
+      {
+        appendHeader(buf, multiget_ == 1 ? kBinaryGet : kBinaryGetKQ, keylen, 0, keylen);
+      }
+      else
+      {
+        buf->append(" ", 1);
+      }
+      buf->append(key, keylen);
+    }
+    if (protocol_ == kBinary)
+    {
+      if (multiget_ > 1)
+      {
+        appendHeader(buf, kBinaryNoop, 0, 0, 0);
+      }
     }
     else
     {
-      snprintf(req, sizeof req, "get %s%d\r\n", name_.c_str(), sent_ % keys_);
-      ++sent_;
-      buf->append(req);
+      buf->append("\r\n", 2);
     }
+    ++sent_;
+  }
+
+  void appendHeader(Buffer* buf, uint8_t opcode, int keylen, int extlen, int bodylen)
+  {
+    buf->appendInt8(static_cast<int8_t>(0x80));
+    buf->appendInt8(static_cast<int8_t>(opcode));
+    buf->appendInt16(static_cast<int16_t>(keylen));
+    buf->appendInt8(static_cast<int8_t>(extlen));
+    buf->appendInt8(0);
+    buf->appendInt16(0);
+    buf->appendInt32(bodylen);
+    buf->appendInt32(sent_);  // opaque
+    buf->appendInt64(0);
   }
 
   string name_;
   TcpClient client_;
   TcpConnectionPtr conn_;
   const Operation op_;
+  const Protocol protocol_;
   int sent_;
   int acked_;
+  int64_t hits_;
   const int requests_;
   const int keys_;
+  const int multiget_;
   const int valuelen_;
   string value_;
   CountDownLatch* const connected_;
   CountDownLatch* const finished_;
 };
 
+struct Options
+{
+  int threads;
+  int clients;
+  int requests;
+  int keys;
+  int multiget;
+  int valuelen;
+  Client::Operation op;
+};
+
+void run(const InetAddress& serverAddr, const Options& options, Client::Protocol protocol)
+{
+  const char* name = protocol == Client::kBinary ? "binary" : "text";
+  EventLoop loop;
+  EventLoopThreadPool pool(&loop, "bench-memcache");
+  pool.setThreadNum(options.threads);
+  pool.start();
+
+  char buf[32];
+  CountDownLatch connected(options.clients);
+  CountDownLatch finished(options.clients);
+  std::vector<std::unique_ptr<Client>> holder;
+  for (int i = 0; i < options.clients; ++i)
+  {
+    snprintf(buf, sizeof buf, "%d-", i+1);
+    holder.emplace_back(new Client(buf,
+                                pool.getNextLoop(),
+                                serverAddr,
+                                options.op,
+                                protocol,
+                                options.requests,
+                                options.keys,
+                                options.multiget,
+                                options.valuelen,
+                                &connected,
+                                &finished));
+  }
+  connected.wait();
+  LOG_WARN << options.clients << " clients all connected, " << name << " protocol";
+  Timestamp start = Timestamp::now();
+  for (int i = 0; i < options.clients; ++i)
+  {
+    holder[i]->send();
+  }
+  finished.wait();
+  Timestamp end = Timestamp::now();
+  double seconds = timeDifference(end, start);
+  int64_t hits = 0;
+  for (const auto& client : holder)
+  {
+    hits += client->hits();
+  }
+  double requests = 1.0 * options.clients * options.requests;
+  LOG_WARN << name << ": " << seconds << " sec, "
+           << requests / seconds << " QPS, "
+           << requests * (options.op == Client::kGet ? options.multiget : 1) / seconds << " keys/s, "
+           << hits << " hits";
+}
+
 int main(int argc, char* argv[])
 {
   Logger::setLogLevel(Logger::WARN);
 
   uint16_t tcpport = 11211;
   string hostIp = "127.0.0.1";
-  int threads = 4;
-  int clients = 100;
-  int requests = 100000;
-  int keys = 10000;
-  bool set = false;
+  string protocol = "both";
+  Options options;
+  options.threads = 4;
+  options.clients = 100;
+  options.requests = 100000;
+  options.keys = 10000;
+  options.multiget = 1;
+  options.valuelen = 100;
 
   po::options_description desc("Allowed options");
   desc.add_options()
       ("help,h", "Help")
       ("port,p", po::value<uint16_t>(&tcpport), "TCP port")
       ("ip,i", po::value<string>(&hostIp), "Host IP")
-      ("threads,t", po::value<int>(&threads), "Number of worker threads")
-      ("clients,c", po::value<int>(&clients), "Number of concurrent clients")
-      ("requests,r", po::value<int>(&requests), "Number of requests per clients")
-      ("keys,k", po::value<int>(&keys), "Number of keys per clients")
+      ("threads,t", po::value<int>(&options.threads), "Number of worker threads")
+      ("clients,c", po::value<int>(&options.clients), "Number of concurrent clients")
+      ("requests,r", po::value<int>(&options.requests), "Number of requests per clients")
+      ("keys,k", po::value<int>(&options.keys), "Number of keys per clients")
+      ("multiget,m", po::value<int>(&options.multiget), "Number of keys per get request")
+      ("protocol,P", po::value<string>(&protocol), "text, binary or both")
       ("set,s", "Get or Set")
       ;
 
@@ -189,51 +367,24 @@ int main(int argc, char* argv[])
     std::cout << desc << "\n";
     return 0;
   }
-  set = vm.count("set");
+  options.op = vm.count("set") ? Client::kSet : Client::kGet;
+  if (options.multiget < 1)
+  {
+    options.multiget = 1;
+  }
 
   InetAddress serverAddr(hostIp, tcpport);
   LOG_WARN << "Connecting " << serverAddr.toIpPort();
 
-  EventLoop loop;
-  EventLoopThreadPool pool(&loop, "bench-memcache");
-
-  int valuelen = 100;
-  Client::Operation op = set ? Client::kSet : Client::kGet;
-
-  double memoryMiB = 1.0 * clients * keys * (32+80+valuelen+8) / 1024 / 1024;
+  double memoryMiB = 1.0 * options.clients * options.keys * (32+80+options.valuelen+8) / 1024 / 1024;
   LOG_WARN << "estimated memcached-debug memory usage " << int(memoryMiB) << " MiB";
 
-  pool.setThreadNum(threads);
-  pool.start();
-
-  char buf[32];
-  CountDownLatch connected(clients);
-  CountDownLatch finished(clients);
-  std::vector<std::unique_ptr<Client>> holder;
-  for (int i = 0; i < clients; ++i)
+  if (protocol != "binary")
   {
-    snprintf(buf, sizeof buf, "%d-", i+1);
-    holder.emplace_back(new Client(buf,
-                                pool.getNextLoop(),
-                                serverAddr,
-                                op,
-                                requests,
-                                keys,
-                                valuelen,
-                                &connected,
-                                &finished));
+    run(serverAddr, options, Client::kText);
   }
-  connected.wait();
-  LOG_WARN << clients << " clients all connected";
-  Timestamp start = Timestamp::now();
-  for (int i = 0; i < clients; ++i)
+  if (protocol != "text")
   {
-    holder[i]->send();
+    run(serverAddr, options, Client::kBinary);
   }
-  finished.wait();
-  Timestamp end = Timestamp::now();
-  LOG_WARN << "All finished";
-  double seconds = timeDifference(end, start);
-  LOG_WARN << seconds << " sec";
-  LOG_WARN << 1.0 * clients * requests / seconds << " QPS";
 }
@@ -11,53 +11,80 @@
 using namespace muduo;
 using namespace muduo::net;
 
+namespace
+{
+int digits(uint32_t x)
+{
+  int n = 1;
+  while (x >= 10)
+  {
+    x /= 10;
+    ++n;
+  }
+  return n;
+}
+}
+
+size_t Item::hashKey(StringPiece key)
+{
+  return boost::hash_range(key.begin(), key.end());
+}
+
+int Item::suffixLength(uint32_t flags, int valuelen)
+{
+  assert(valuelen >= 2);
+  return 1 + digits(flags) + 1 + digits(static_cast<uint32_t>(valuelen - 2)) + 2;
+}
+
 Item::Item(StringPiece keyArg,
+           size_t hashArg,
            uint32_t flagsArg,
            int exptimeArg,
            int valuelen,
-           uint64_t casArg)
-  : keylen_(keyArg.size()),
+           uint64_t casArg,
+           int slabClassArg)
+  : hash_(hashArg),
+    cas_(casArg),
     flags_(flagsArg),
     rel_exptime_(exptimeArg),
     valuelen_(valuelen),
     receivedBytes_(0),
-    cas_(casArg),
-    hash_(boost::hash_range(keyArg.begin(), keyArg.end())),
-    data_(static_cast<char*>(::malloc(totalLen())))
+    keylen_(static_cast<uint8_t>(keyArg.size())),
+    suffixlen_(static_cast<uint8_t>(suffixLength(flagsArg, valuelen))),
+    slabClass_(static_cast<uint8_t>(slabClassArg)),
+    allocated_(true),
+    linked_(false),
+    referenced_(false)
 {
+  assert(keyArg.size() <= 250);
   assert(valuelen_ >= 2);
-  assert(receivedBytes_ < totalLen());
-  append(keyArg.data(), keylen_);
+  memcpy(data(), keyArg.data(), keylen_);
+  char* suffix = data() + keylen_;
+  int n = snprintf(suffix, suffixlen_ + 1u, " %u %d\r", flags_, valuelen_ - 2);
+  assert(n == suffixlen_ - 1); (void) n;
+  suffix[suffixlen_ - 1] = '\n';  // overwrites NUL from snprintf
+  receivedBytes_ = keylen_;
 }
 
 void Item::append(const char* data, size_t len)
 {
   assert(len <= neededBytes());
-  memcpy(data_ + receivedBytes_, data, len);
+  memcpy(this->data() + suffixlen_ + receivedBytes_, data, len);
   receivedBytes_ += static_cast<int>(len);
   assert(receivedBytes_ <= totalLen());
 }
 
 void Item::output(Buffer* out, bool needCas) const
 {
-  out->append("VALUE ");
-  out->append(data_, keylen_);
-  LogStream buf;
-  buf << ' ' << flags_ << ' ' << valuelen_-2;
-  if (needCas)
+  out->append("VALUE ", 6);
+  if (!needCas)
   {
-    buf << ' ' << cas_;
+    out->append(data(), keylen_ + suffixlen_ + valuelen_);
+    return;
   }
-  buf << "\r\n";
+  out->append(data(), keylen_);
+  LogStream buf;
+  buf << ' ' << flags_ << ' ' << valuelen_-2 << ' ' << cas_ << "\r\n";
   out->append(buf.buffer().data(), buf.buffer().length());
   out->append(value(), valuelen_);
 }
-
-void Item::resetKey(StringPiece k)
-{
-  assert(k.size() <= 250);
-  keylen_ = k.size();
-  receivedBytes_ = 0;
-  append(k.data(), k.size());
-  hash_ = boost::hash_range(k.begin(), k.end());
-}
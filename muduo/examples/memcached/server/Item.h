@@ -1,11 +1,11 @@
 #ifndef MUDUO_EXAMPLES_MEMCACHED_SERVER_ITEM_H
 #define MUDUO_EXAMPLES_MEMCACHED_SERVER_ITEM_H
 
-#include "muduo/base/Atomic.h"
 #include "muduo/base/StringPiece.h"
 #include "muduo/base/Types.h"
+#include "muduo/base/noncopyable.h"
 
-#include <memory>
+#include <atomic>
 
 namespace muduo
 {
@@ -15,11 +15,14 @@ class Buffer;
 }
 }
 
-class Item;
-typedef std::shared_ptr<Item> ItemPtr;  // TODO: use unique_ptr
-typedef std::shared_ptr<const Item> ConstItemPtr;  // TODO: use unique_ptr
-
-// Item is immutable once added into hash table
+// Item is the header of a chunk from SlabAllocator, followed by key,
+// suffix of text protocol " <flags> <bytes>\r\n", and value with CRLF,
+// so that "VALUE " and the rest of a chunk make a reply of 'get'.
+//
+// Item is immutable once linked into hash table, except the reference bit
+// of CLOCK eviction.
+// allocated() is guarded by the mutex of its slab class,
+// linked() is guarded by the mutex of its stripe in MemcacheServer.
 class Item : muduo::noncopyable
 {
  public:
@@ -34,30 +37,27 @@ class Item : muduo::noncopyable
     kCas,
   };
 
-  static ItemPtr makeItem(muduo::StringPiece keyArg,
-                          uint32_t flagsArg,
-                          int exptimeArg,
-                          int valuelen,
-                          uint64_t casArg)
+  static size_t totalSize(size_t keylen, uint32_t flags, int valuelen)
   {
-    return std::make_shared<Item>(keyArg, flagsArg, exptimeArg, valuelen, casArg);
-    //return ItemPtr(new Item(keyArg, flagsArg, exptimeArg, valuelen, casArg));
+    return sizeof(Item) + keylen + suffixLength(flags, valuelen) + valuelen;
   }
 
+  static int suffixLength(uint32_t flags, int valuelen);
+
+  static size_t hashKey(muduo::StringPiece key);
+
+  // constructed in place by SlabAllocator
   Item(muduo::StringPiece keyArg,
+       size_t hashArg,
        uint32_t flagsArg,
        int exptimeArg,
        int valuelen,
-       uint64_t casArg);
-
-  ~Item()
-  {
-    ::free(data_);
-  }
+       uint64_t casArg,
+       int slabClassArg);
 
   muduo::StringPiece key() const
   {
-    return muduo::StringPiece(data_, keylen_);
+    return muduo::StringPiece(data(), keylen_);
   }
 
   uint32_t flags() const
@@ -72,7 +72,7 @@ class Item : muduo::noncopyable
 
   const char* value() const
   {
-    return data_+keylen_;
+    return data()+keylen_+suffixlen_;
   }
 
   size_t valueLength() const
@@ -90,6 +90,16 @@ class Item : muduo::noncopyable
     return hash_;
   }
 
+  int slabClass() const
+  {
+    return slabClass_;
+  }
+
+  size_t totalSize() const
+  {
+    return sizeof(Item) + keylen_ + suffixlen_ + valuelen_;
+  }
+
   void setCas(uint64_t casArg)
   {
     cas_ = casArg;
@@ -105,25 +115,49 @@ class Item : muduo::noncopyable
   bool endsWithCRLF() const
   {
     return receivedBytes_ == totalLen()
-        && data_[totalLen()-2] == '\r'
-        && data_[totalLen()-1] == '\n';
+        && value()[valuelen_-2] == '\r'
+        && value()[valuelen_-1] == '\n';
   }
 
   void output(muduo::net::Buffer* out, bool needCas = false) const;
 
-  void resetKey(muduo::StringPiece k);
+  bool allocated() const { return allocated_; }
+  void setFree() { allocated_ = false; }
+
+  bool linked() const { return linked_; }
+  void setLinked(bool on) { linked_ = on; }
+
+  void setReferenced()
+  {
+    if (!referenced_.load(std::memory_order_relaxed))
+    {
+      referenced_.store(true, std::memory_order_relaxed);
+    }
+  }
+
+  // returns previous value
+  bool clearReferenced()
+  {
+    return referenced_.exchange(false, std::memory_order_relaxed);
+  }
 
  private:
   int totalLen() const { return keylen_ + valuelen_; }
+  char* data() { return reinterpret_cast<char*>(this + 1); }
+  const char* data() const { return reinterpret_cast<const char*>(this + 1); }
 
-  int            keylen_;
+  size_t         hash_;
+  uint64_t       cas_;
   const uint32_t flags_;
   const int      rel_exptime_;
   const int      valuelen_;
-  int            receivedBytes_;  // FIXME: remove this member
-  uint64_t       cas_;
-  size_t         hash_;
-  char*          data_;
+  int            receivedBytes_;  // of key and value
+  const uint8_t  keylen_;
+  const uint8_t  suffixlen_;
+  const uint8_t  slabClass_;
+  bool           allocated_;
+  bool           linked_;
+  std::atomic<bool> referenced_;
 };
 
 #endif  // MUDUO_EXAMPLES_MEMCACHED_SERVER_ITEM_H
@@ -4,6 +4,8 @@
 #include "muduo/base/Logging.h"
 #include "muduo/net/EventLoop.h"
 
+#include <algorithm>
+
 using namespace muduo;
 using namespace muduo::net;
 
@@ -22,6 +24,7 @@ MemcacheServer::MemcacheServer(muduo::net::EventLoop* loop, const Options& optio
   : loop_(loop),
     options_(options),
     startTime_(::time(NULL)-1),
+    slab_(options.memoryLimit, std::bind(&MemcacheServer::unlinkItem, this, _1)),
     server_(loop, InetAddress(options.tcpport), "muduo-memcached"),
     stats_(new Stats)
 {
@@ -41,61 +44,132 @@ void MemcacheServer::stop()
   loop_->runAfter(3.0, std::bind(&EventLoop::quit, loop_));
 }
 
-bool MemcacheServer::storeItem(const ItemPtr& item, const Item::UpdatePolicy policy, bool* exists)
+Item* MemcacheServer::allocItem(StringPiece key,
+                                uint32_t flags,
+                                int exptime,
+                                int valuelen,
+                                uint64_t cas)
+{
+  return slab_.alloc(key, Item::hashKey(key), flags, exptime, valuelen, cas);
+}
+
+void MemcacheServer::releaseItem(Item* item)
+{
+  slab_.free(item);
+}
+
+bool MemcacheServer::storeItem(Item* item, const Item::UpdatePolicy policy, bool* exists,
+                               uint64_t* cas)
 {
   assert(item->neededBytes() == 0);
-  MutexLock& mutex = shards_[item->hash() % kShards].mutex;
-  ItemMap& items = shards_[item->hash() % kShards].items;
-  MutexLockGuard lock(mutex);
-  ItemMap::const_iterator it = items.find(item);
-  *exists = it != items.end();
+  assert(item->endsWithCRLF());
+  if (policy == Item::kAppend || policy == Item::kPrepend)
+  {
+    return concatItem(item, policy, exists, cas);
+  }
+
+  Item* garbage = item;
+  {
+  Stripe& stripe = stripeOf(item->hash());
+  MutexLockGuard lock(stripe.mutex);
+  size_t index = find(stripe, item->key(), item->hash());
+  *exists = index != stripe.slots.size();
+  bool store = false;
   if (policy == Item::kSet)
+  {
+    store = true;
+  }
+  else if (policy == Item::kAdd)
+  {
+    store = !*exists;
+  }
+  else if (policy == Item::kReplace)
+  {
+    store = *exists;
+  }
+  else if (policy == Item::kCas)
+  {
+    store = *exists && stripe.slots[index].item->cas() == item->cas();
+  }
+  else
+  {
+    assert(false);
+  }
+
+  if (store)
   {
     item->setCas(g_cas.incrementAndGet());
+    item->setLinked(true);
+    if (cas)
+    {
+      *cas = item->cas();
+    }
     if (*exists)
     {
-      items.erase(it);
+      garbage = stripe.slots[index].item;
+      garbage->setLinked(false);
+      stripe.slots[index].item = item;
+    }
+    else
+    {
+      garbage = NULL;
+      insert(&stripe, item);
     }
-    items.insert(item);
   }
-  else
+  }
+
+  bool stored = garbage != item;
+  if (garbage)
   {
-    if (policy == Item::kAdd)
+    slab_.free(garbage);
+  }
+  return stored;
+}
+
+// The new item is allocated without the stripe locked,
+// retries if the old one was changed in the meantime.
+bool MemcacheServer::concatItem(Item* item, const Item::UpdatePolicy policy, bool* exists,
+                                uint64_t* cas)
+{
+  Stripe& stripe = stripeOf(item->hash());
+  bool stored = false;
+  *exists = true;
+  while (!stored && *exists)
+  {
+    uint32_t flags = 0;
+    int exptime = 0;
+    size_t oldLen = 0;
+    uint64_t oldCas = 0;
     {
-      if (*exists)
+      MutexLockGuard lock(stripe.mutex);
+      size_t index = find(stripe, item->key(), item->hash());
+      *exists = index != stripe.slots.size();
+      if (!*exists)
       {
-        return false;
-      }
-      else
-      {
-        item->setCas(g_cas.incrementAndGet());
-        items.insert(item);
+        break;
       }
+      const Item* oldItem = stripe.slots[index].item;
+      flags = oldItem->flags();
+      exptime = oldItem->rel_exptime();
+      oldLen = oldItem->valueLength();
+      oldCas = oldItem->cas();
     }
-    else if (policy == Item::kReplace)
+
+    int newLen = static_cast<int>(item->valueLength() + oldLen - 2);
+    Item* newItem = slab_.alloc(item->key(), item->hash(), flags, exptime, newLen, 0);
+    if (newItem == NULL)
     {
-      if (*exists)
-      {
-        item->setCas(g_cas.incrementAndGet());
-        items.erase(it);
-        items.insert(item);
-      }
-      else
-      {
-        return false;
-      }
+      break;
     }
-    else if (policy == Item::kAppend || policy == Item::kPrepend)
+
+    Item* garbage = newItem;
     {
-      if (*exists)
+      MutexLockGuard lock(stripe.mutex);
+      size_t index = find(stripe, item->key(), item->hash());
+      *exists = index != stripe.slots.size();
+      if (*exists && stripe.slots[index].item->cas() == oldCas)
       {
-        const ConstItemPtr& oldItem = *it;
-        int newLen = static_cast<int>(item->valueLength() + oldItem->valueLength() - 2);
-        ItemPtr newItem(Item::makeItem(item->key(),
-                                       oldItem->flags(),
-                                       oldItem->rel_exptime(),
-                                       newLen,
-                                       g_cas.incrementAndGet()));
+        Item* oldItem = stripe.slots[index].item;
         if (policy == Item::kAppend)
         {
           newItem->append(oldItem->value(), oldItem->valueLength() - 2);
@@ -108,50 +182,244 @@ bool MemcacheServer::storeItem(const ItemPtr& item, const Item::UpdatePolicy pol
         }
         assert(newItem->neededBytes() == 0);
         assert(newItem->endsWithCRLF());
-        items.erase(it);
-        items.insert(newItem);
-      }
-      else
-      {
-        return false;
+        newItem->setCas(g_cas.incrementAndGet());
+        newItem->setLinked(true);
+        if (cas)
+        {
+          *cas = newItem->cas();
+        }
+        oldItem->setLinked(false);
+        stripe.slots[index].item = newItem;
+        garbage = oldItem;
+        stored = true;
       }
     }
-    else if (policy == Item::kCas)
+    slab_.free(garbage);
+  }
+  slab_.free(item);
+  return stored;
+}
+
+bool MemcacheServer::getItem(StringPiece key, Buffer* out, bool needCas) const
+{
+  size_t hash = Item::hashKey(key);
+  const Stripe& stripe = stripeOf(hash);
+  MutexLockGuard lock(stripe.mutex);
+  size_t index = find(stripe, key, hash);
+  if (index != stripe.slots.size())
+  {
+    Item* item = stripe.slots[index].item;
+    item->setReferenced();
+    item->output(out, needCas);
+    return true;
+  }
+  return false;
+}
+
+void MemcacheServer::getItems(const StringPiece* keys, size_t count,
+                              const ItemVisitor& visit) const
+{
+  // bounds the number of stripes locked at a time
+  const size_t kBatch = 64;
+  size_t hashes[kBatch];
+  const Item* items[kBatch];
+  int locked[kBatch];
+  for (size_t first = 0; first < count; first += kBatch)
+  {
+    const size_t n = std::min(count - first, kBatch);
+    for (size_t i = 0; i < n; ++i)
     {
-      if (*exists && (*it)->cas() == item->cas())
+      hashes[i] = Item::hashKey(keys[first + i]);
+      locked[i] = static_cast<int>(hashes[i] % kStripes);
+      __builtin_prefetch(&stripes_[locked[i]]);
+    }
+
+    // in ascending order, so batches never deadlock with each other,
+    // and other holders of a stripe lock never take a second one.
+    std::sort(locked, locked + n);
+    const int numLocked = static_cast<int>(std::unique(locked, locked + n) - locked);
+    for (int i = 0; i < numLocked; ++i)
+    {
+      stripes_[locked[i]].mutex.lock();
+    }
+
+    for (size_t i = 0; i < n; ++i)
+    {
+      const std::vector<Slot>& slots = stripeOf(hashes[i]).slots;
+      if (!slots.empty())
       {
-        item->setCas(g_cas.incrementAndGet());
-        items.erase(it);
-        items.insert(item);
+        __builtin_prefetch(&slots[(hashes[i] / kStripes) & (slots.size() - 1)]);
       }
-      else
+    }
+
+    for (size_t i = 0; i < n; ++i)
+    {
+      const Stripe& stripe = stripeOf(hashes[i]);
+      size_t index = find(stripe, keys[first + i], hashes[i]);
+      items[i] = NULL;
+      if (index != stripe.slots.size())
       {
-        return false;
+        Item* item = stripe.slots[index].item;
+        item->setReferenced();
+        __builtin_prefetch(item->value());
+        items[i] = item;
       }
     }
-    else
+
+    for (size_t i = 0; i < n; ++i)
+    {
+      visit(first + i, items[i]);
+    }
+
+    for (int i = numLocked; i > 0; --i)
     {
-      assert(false);
+      stripes_[locked[i-1]].mutex.unlock();
     }
   }
+}
+
+bool MemcacheServer::deleteItem(StringPiece key)
+{
+  size_t hash = Item::hashKey(key);
+  Stripe& stripe = stripeOf(hash);
+  Item* item = NULL;
+  {
+  MutexLockGuard lock(stripe.mutex);
+  size_t index = find(stripe, key, hash);
+  if (index != stripe.slots.size())
+  {
+    item = stripe.slots[index].item;
+    item->setLinked(false);
+    erase(&stripe, index);
+  }
+  }
+
+  if (item)
+  {
+    slab_.free(item);
+  }
+  return item != NULL;
+}
+
+size_t MemcacheServer::indexBytes() const
+{
+  size_t bytes = sizeof stripes_;
+  for (const Stripe& stripe : stripes_)
+  {
+    MutexLockGuard lock(stripe.mutex);
+    bytes += stripe.slots.capacity() * sizeof(Slot);
+  }
+  return bytes;
+}
+
+bool MemcacheServer::unlinkItem(Item* item)
+{
+  Stripe& stripe = stripeOf(item->hash());
+  MutexLockGuard lock(stripe.mutex);
+  if (!item->linked())
+  {
+    return false;
+  }
+  size_t index = find(stripe, item);
+  assert(index != stripe.slots.size());
+  item->setLinked(false);
+  erase(&stripe, index);
   return true;
 }
 
-ConstItemPtr MemcacheServer::getItem(const ConstItemPtr& key) const
+size_t MemcacheServer::find(const Stripe& stripe, StringPiece key, size_t hash)
+{
+  const std::vector<Slot>& slots = stripe.slots;
+  if (slots.empty())
+  {
+    return 0;
+  }
+  const size_t mask = slots.size() - 1;
+  size_t index = (hash / kStripes) & mask;
+  while (slots[index].item)
+  {
+    if (slots[index].hash == hash && slots[index].item->key() == key)
+    {
+      return index;
+    }
+    index = (index + 1) & mask;
+  }
+  return slots.size();
+}
+
+size_t MemcacheServer::find(const Stripe& stripe, const Item* item)
 {
-  MutexLock& mutex = shards_[key->hash() % kShards].mutex;
-  const ItemMap& items = shards_[key->hash() % kShards].items;
-  MutexLockGuard lock(mutex);
-  ItemMap::const_iterator it = items.find(key);
-  return it != items.end() ? *it : ConstItemPtr();
+  const std::vector<Slot>& slots = stripe.slots;
+  if (slots.empty())
+  {
+    return 0;
+  }
+  const size_t mask = slots.size() - 1;
+  size_t index = (item->hash() / kStripes) & mask;
+  while (slots[index].item)
+  {
+    if (slots[index].item == item)
+    {
+      return index;
+    }
+    index = (index + 1) & mask;
+  }
+  return slots.size();
 }
 
-bool MemcacheServer::deleteItem(const ConstItemPtr& key)
+void MemcacheServer::insert(Stripe* stripe, Item* item)
 {
-  MutexLock& mutex = shards_[key->hash() % kShards].mutex;
-  ItemMap& items = shards_[key->hash() % kShards].items;
-  MutexLockGuard lock(mutex);
-  return items.erase(key) == 1;
+  // load factor is at most 3/4
+  if ((stripe->size + 1) * 4 > stripe->slots.size() * 3)
+  {
+    rehash(stripe, std::max<size_t>(stripe->slots.size() * 2, 16));
+  }
+  std::vector<Slot>& slots = stripe->slots;
+  const size_t mask = slots.size() - 1;
+  size_t index = (item->hash() / kStripes) & mask;
+  while (slots[index].item)
+  {
+    index = (index + 1) & mask;
+  }
+  slots[index].hash = item->hash();
+  slots[index].item = item;
+  ++stripe->size;
+}
+
+// backward shift deletion, no tombstones
+void MemcacheServer::erase(Stripe* stripe, size_t index)
+{
+  std::vector<Slot>& slots = stripe->slots;
+  const size_t mask = slots.size() - 1;
+  size_t hole = index;
+  size_t next = (hole + 1) & mask;
+  while (slots[next].item)
+  {
+    size_t home = (slots[next].hash / kStripes) & mask;
+    // moves it to the hole, unless its home is in (hole, next]
+    if (((next - home) & mask) >= ((next - hole) & mask))
+    {
+      slots[hole] = slots[next];
+      hole = next;
+    }
+    next = (next + 1) & mask;
+  }
+  slots[hole] = Slot();
+  --stripe->size;
+}
+
+void MemcacheServer::rehash(Stripe* stripe, size_t newSize)
+{
+  std::vector<Slot> old(newSize);
+  old.swap(stripe->slots);
+  stripe->size = 0;
+  for (const Slot& slot : old)
+  {
+    if (slot.item)
+    {
+      insert(stripe, slot.item);
+    }
+  }
 }
 
 void MemcacheServer::onConnection(const TcpConnectionPtr& conn)
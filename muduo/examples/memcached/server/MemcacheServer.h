@@ -3,14 +3,16 @@
 
 #include "examples/memcached/server/Item.h"
 #include "examples/memcached/server/Session.h"
+#include "examples/memcached/server/SlabAllocator.h"
 
 #include "muduo/base/Mutex.h"
 #include "muduo/net/TcpServer.h"
 #include "examples/wordcount/hash.h"
 
 #include <array>
+#include <functional>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 class MemcacheServer : muduo::noncopyable
 {
@@ -22,6 +24,7 @@ class MemcacheServer : muduo::noncopyable
     uint16_t udpport;
     uint16_t gperfport;
     int threads;
+    size_t memoryLimit;  // in bytes, 0 for unlimited
   };
 
   MemcacheServer(muduo::net::EventLoop* loop, const Options&);
@@ -33,9 +36,33 @@ class MemcacheServer : muduo::noncopyable
 
   time_t startTime() const { return startTime_; }
 
-  bool storeItem(const ItemPtr& item, Item::UpdatePolicy policy, bool* exists);
-  ConstItemPtr getItem(const ConstItemPtr& key) const;
-  bool deleteItem(const ConstItemPtr& key);
+  // returns NULL if too large or out of memory,
+  // the item must be given to storeItem() or releaseItem().
+  Item* allocItem(muduo::StringPiece key,
+                  uint32_t flags,
+                  int exptime,
+                  int valuelen,
+                  uint64_t cas);
+  void releaseItem(Item* item);
+
+  // takes ownership of item, cas of the stored item is returned if not NULL.
+  bool storeItem(Item* item, Item::UpdatePolicy policy, bool* exists,
+                 uint64_t* cas = NULL);
+  // appends item to out if found
+  bool getItem(muduo::StringPiece key, muduo::net::Buffer* out, bool needCas) const;
+
+  // index of key, NULL if not found
+  typedef std::function<void (size_t, const Item*)> ItemVisitor;
+
+  // Looks up keys in one pass, every stripe involved is locked once,
+  // and items are visited in order of keys with their stripes locked.
+  // visit must not call back into MemcacheServer.
+  void getItems(const muduo::StringPiece* keys, size_t count,
+                const ItemVisitor& visit) const;
+  bool deleteItem(muduo::StringPiece key);
+
+  SlabAllocator::Stats slabStats() const { return slab_.stats(); }
+  size_t indexBytes() const;
 
  private:
   void onConnection(const muduo::net::TcpConnectionPtr& conn);
@@ -46,37 +73,46 @@ class MemcacheServer : muduo::noncopyable
   Options options_;
   const time_t startTime_;
 
+  // outlives sessions_, which may hold items being received.
+  SlabAllocator slab_;
+
   mutable muduo::MutexLock mutex_;
   std::unordered_map<string, SessionPtr> sessions_ GUARDED_BY(mutex_);
 
-  // a complicated solution to save memory
-  struct Hash
+  // Hash table of open addressing with linear probing, striped by lock.
+  // Holders of a stripe lock never take a lock of SlabAllocator,
+  // items are freed after the stripe is unlocked.
+  struct Slot
   {
-    size_t operator()(const ConstItemPtr& x) const
-    {
-      return x->hash();
-    }
+    Slot() : hash(0), item(NULL) { }
+    size_t hash;
+    Item* item;
   };
 
-  struct Equal
+  struct Stripe
   {
-    bool operator()(const ConstItemPtr& x, const ConstItemPtr& y) const
-    {
-      return x->key() == y->key();
-    }
+    Stripe() : size(0) { }
+    mutable muduo::MutexLock mutex;
+    std::vector<Slot> slots GUARDED_BY(mutex);
+    size_t size GUARDED_BY(mutex);
   };
 
-  typedef std::unordered_set<ConstItemPtr, Hash, Equal> ItemMap;
+  const static int kStripes = 1024;
 
-  struct MapWithLock
-  {
-    ItemMap items;
-    mutable muduo::MutexLock mutex;
-  };
+  Stripe& stripeOf(size_t hash) { return stripes_[hash % kStripes]; }
+  const Stripe& stripeOf(size_t hash) const { return stripes_[hash % kStripes]; }
+  // return index of slot, or slots.size() if not found
+  static size_t find(const Stripe& stripe, muduo::StringPiece key, size_t hash);
+  static size_t find(const Stripe& stripe, const Item* item);
+  static void insert(Stripe* stripe, Item* item);
+  static void erase(Stripe* stripe, size_t index);
+  static void rehash(Stripe* stripe, size_t newSize);
 
-  const static int kShards = 4096;
+  // called by SlabAllocator to evict an item
+  bool unlinkItem(Item* item);
+  bool concatItem(Item* item, Item::UpdatePolicy policy, bool* exists, uint64_t* cas);
 
-  std::array<MapWithLock, kShards> shards_;
+  std::array<Stripe, kStripes> stripes_;
 
   // NOT guarded by mutex_, but here because server_ has to destructs before
   // sessions_
@@ -1,6 +1,8 @@
 #include "examples/memcached/server/Session.h"
 #include "examples/memcached/server/MemcacheServer.h"
 
+#include "muduo/net/Endian.h"
+
 #ifdef HAVE_TCMALLOC
 #include <gperftools/malloc_extension.h>
 #endif
@@ -8,13 +10,107 @@
 using namespace muduo;
 using namespace muduo::net;
 
+namespace binary
+{
+const uint8_t kRequestMagic = 0x80;
+const uint8_t kResponseMagic = 0x81;
+
+enum Opcode
+{
+  kGet = 0x00,
+  kSet = 0x01,
+  kAdd = 0x02,
+  kReplace = 0x03,
+  kDelete = 0x04,
+  kQuit = 0x07,
+  kGetQ = 0x09,
+  kNoop = 0x0a,
+  kVersion = 0x0b,
+  kGetK = 0x0c,
+  kGetKQ = 0x0d,
+  kAppend = 0x0e,
+  kPrepend = 0x0f,
+  kSetQ = 0x11,
+  kAddQ = 0x12,
+  kReplaceQ = 0x13,
+  kDeleteQ = 0x14,
+  kQuitQ = 0x17,
+  kAppendQ = 0x19,
+  kPrependQ = 0x1a,
+};
+
+enum Status
+{
+  kSuccess = 0x00,
+  kKeyNotFound = 0x01,
+  kKeyExists = 0x02,
+  kValueTooLarge = 0x03,
+  kInvalidArguments = 0x04,
+  kNotStored = 0x05,
+  kUnknownCommand = 0x81,
+  kOutOfMemory = 0x82,
+};
+
+bool isQuiet(uint8_t opcode)
+{
+  return opcode == kGetQ || opcode == kGetKQ || opcode == kQuitQ
+      || (opcode >= kSetQ && opcode <= kDeleteQ)
+      || opcode == kAppendQ || opcode == kPrependQ;
+}
+
+const char* statusMessage(uint16_t status)
+{
+  switch (status)
+  {
+    case kKeyNotFound: return "Not found";
+    case kKeyExists: return "Data exists for key.";
+    case kValueTooLarge: return "Too large.";
+    case kInvalidArguments: return "Invalid arguments";
+    case kNotStored: return "Not stored.";
+    case kUnknownCommand: return "Unknown command";
+    case kOutOfMemory: return "Out of memory";
+    default: return "";
+  }
+}
+}  // namespace binary
+
 static bool isBinaryProtocol(uint8_t firstByte)
 {
-  return firstByte == 0x80;
+  return firstByte == binary::kRequestMagic;
 }
 
 const int kLongestKeySize = 250;
-string Session::kLongestKey(kLongestKeySize, 'x');
+// a request line without CRLF longer than this is an error,
+// a multi-get line may carry a few hundred keys.
+const size_t kLongestLine = 1024;
+const size_t kLongestGetLine = 64 * 1024;
+
+static bool isGetCommand(const muduo::net::Buffer* buf)
+{
+  StringPiece line(buf->peek(), static_cast<int>(buf->readableBytes()));
+  return line.starts_with("get ") || line.starts_with("gets ");
+}
+
+struct Session::BinaryHeader
+{
+  uint8_t magic;
+  uint8_t opcode;
+  uint16_t keylen;
+  uint8_t extlen;
+  uint8_t datatype;
+  uint16_t status;  // vbucket of request
+  uint32_t bodylen;
+  uint32_t opaque;
+  uint64_t cas;
+};
+
+Session::~Session()
+{
+  resetRequest();
+  LOG_INFO << "requests processed: " << requestsProcessed_
+           << " input buffer size: " << conn_->inputBuffer()->internalCapacity()
+           << " output buffer size: " << conn_->outputBuffer()->internalCapacity();
+}
 
 template <typename InputIterator, typename Token>
 bool Session::SpaceSeparator::operator()(InputIterator& next, InputIterator end, Token& tok)
@@ -90,7 +186,10 @@ void Session::onMessage(const muduo::net::TcpConnectionPtr& conn,
       assert(protocol_ == kAscii || protocol_ == kBinary);
       if (protocol_ == kBinary)
       {
-        // FIXME
+        if (!processBinary(buf))
+        {
+          break;
+        }
       }
       else  // ASCII protocol
       {
@@ -107,9 +206,10 @@ void Session::onMessage(const muduo::net::TcpConnectionPtr& conn,
         }
         else
         {
-          if (buf->readableBytes() > 1024)
+          size_t longest = isGetCommand(buf) ? kLongestGetLine : kLongestLine;
+          if (buf->readableBytes() > longest)
           {
-            // FIXME: check for 'get' and 'gets'
+            flush();
             conn_->shutdown();
             // buf->retrieveAll() ???
           }
@@ -130,17 +230,18 @@ void Session::onMessage(const muduo::net::TcpConnectionPtr& conn,
       assert(false);
     }
   }
+  doBinaryGets();
+  flush();
   bytesRead_ += initialReadable - buf->readableBytes();
 }
 
 void Session::receiveValue(muduo::net::Buffer* buf)
 {
-  assert(currItem_.get());
+  assert(currItem_);
   assert(state_ == kReceiveValue);
   // if (protocol_ == kBinary)
 
   const size_t avail = std::min(buf->readableBytes(), currItem_->neededBytes());
-  assert(currItem_.unique());
   currItem_->append(buf->peek(), avail);
   buf->retrieve(avail);
   if (currItem_->neededBytes() == 0)
@@ -148,7 +249,9 @@ void Session::receiveValue(muduo::net::Buffer* buf)
     if (currItem_->endsWithCRLF())
     {
       bool exists = false;
-      if (owner_->storeItem(currItem_, policy_, &exists))
+      Item* item = currItem_;
+      currItem_ = NULL;
+      if (owner_->storeItem(item, policy_, &exists))
       {
         reply("STORED\r\n");
       }
@@ -236,36 +339,21 @@ bool Session::processRequest(StringPiece request)
   }
   else if (command_ == "get" || command_ == "gets")
   {
-    bool cas = command_ == "gets";
-
-    // FIXME: send multiple chunks with write complete callback.
-    while (beg != tok.end())
+    needCas_ = command_ == "gets";
+    keys_.clear();
+    for (; beg != tok.end(); ++beg)
     {
       StringPiece key = *beg;
-      bool good = key.size() <= kLongestKeySize;
-      if (!good)
+      if (key.size() > kLongestKeySize)
       {
         reply("CLIENT_ERROR bad command line format\r\n");
         return true;
       }
-
-      needle_->resetKey(key);
-      ConstItemPtr item = owner_->getItem(needle_);
-      ++beg;
-      if (item)
-      {
-        item->output(&outputBuf_, cas);
-      }
+      keys_.push_back(key);
     }
+    owner_->getItems(keys_.data(), keys_.size(), asciiGet_);
+    keys_.clear();
     outputBuf_.append("END\r\n");
-
-    if (conn_->outputBuffer()->writableBytes() > 65536 + outputBuf_.readableBytes())
-    {
-      LOG_DEBUG << "shrink output buffer from " << conn_->outputBuffer()->internalCapacity();
-      conn_->outputBuffer()->shrink(65536 + outputBuf_.readableBytes());
-    }
-
-    conn_->send(&outputBuf_);
   }
   else if (command_ == "delete")
   {
@@ -289,11 +377,13 @@ bool Session::processRequest(StringPiece request)
 #endif
   else if (command_ == "quit")
   {
+    flush();
     conn_->shutdown();
   }
   else if (command_ == "shutdown")
   {
     // "ERROR: shutdown not enabled"
+    flush();
     conn_->shutdown();
     owner_->stop();
   }
@@ -310,7 +400,11 @@ void Session::resetRequest()
   command_.clear();
   noreply_ = false;
   policy_ = Item::kInvalid;
-  currItem_.reset();
+  if (currItem_)
+  {
+    owner_->releaseItem(currItem_);
+    currItem_ = NULL;
+  }
   bytesToDiscard_ = 0;
 }
 
@@ -318,7 +412,46 @@ void Session::reply(muduo::StringPiece msg)
 {
   if (!noreply_)
   {
-    conn_->send(msg.data(), msg.size());
+    outputBuf_.append(msg.data(), msg.size());
+  }
+}
+
+void Session::flush()
+{
+  if (outputBuf_.readableBytes() > 0)
+  {
+    if (conn_->outputBuffer()->writableBytes() > 65536 + outputBuf_.readableBytes())
+    {
+      LOG_DEBUG << "shrink output buffer from " << conn_->outputBuffer()->internalCapacity();
+      conn_->outputBuffer()->shrink(65536 + outputBuf_.readableBytes());
+    }
+    conn_->send(&outputBuf_);
+  }
+}
+
+int Session::relativeExptime(time_t exptime) const
+{
+  int rel_exptime = static_cast<int>(exptime);
+  if (exptime > 60*60*24*30)
+  {
+    rel_exptime = static_cast<int>(exptime - owner_->startTime());
+    if (rel_exptime < 1)
+    {
+      rel_exptime = 1;
+    }
+  }
+  else
+  {
+    // rel_exptime = exptime + currentTime;
+  }
+  return rel_exptime;
+}
+
+void Session::outputAsciiGet(size_t, const Item* item)
+{
+  if (item)
+  {
+    item->output(&outputBuf_, needCas_);
   }
 }
 
@@ -352,45 +485,37 @@ bool Session::doUpdate(Session::Tokenizer::iterator& beg, Session::Tokenizer::it
   Reader r(beg, end);
   good = good && r.read(&flags) && r.read(&exptime) && r.read(&bytes);
 
-  int rel_exptime = static_cast<int>(exptime);
-  if (exptime > 60*60*24*30)
-  {
-    rel_exptime = static_cast<int>(exptime - owner_->startTime());
-    if (rel_exptime < 1)
-    {
-      rel_exptime = 1;
-    }
-  }
-  else
-  {
-    // rel_exptime = exptime + currentTime;
-  }
+  int rel_exptime = relativeExptime(exptime);
 
   if (good && policy_ == Item::kCas)
   {
     good = r.read(&cas);
   }
 
-  if (!good)
+  if (!good || bytes < 0)
   {
     reply("CLIENT_ERROR bad command line format\r\n");
     return true;
   }
-  if (bytes > 1024*1024)
+  if (Item::totalSize(key.size(), flags, bytes + 2) > SlabAllocator::kMaxItemSize)
   {
     reply("SERVER_ERROR object too large for cache\r\n");
-    needle_->resetKey(key);
-    owner_->deleteItem(needle_);
-    bytesToDiscard_ = bytes + 2;
-    state_ = kDiscardValue;
-    return false;
   }
   else
   {
-    currItem_ = Item::makeItem(key, flags, rel_exptime, bytes + 2, cas);
-    state_ = kReceiveValue;
-    return false;
+    currItem_ = owner_->allocItem(key, flags, rel_exptime, bytes + 2, cas);
+    if (currItem_)
+    {
+      state_ = kReceiveValue;
+      return false;
+    }
+    reply("SERVER_ERROR out of memory storing object\r\n");
   }
+  // like memcached, a failed update removes the old value
+  owner_->deleteItem(key);
+  bytesToDiscard_ = bytes + 2;
+  state_ = kDiscardValue;
+  return false;
 }
 
 void Session::doDelete(Session::Tokenizer::iterator& beg, Session::Tokenizer::iterator end)
@@ -410,8 +535,7 @@ void Session::doDelete(Session::Tokenizer::iterator& beg, Session::Tokenizer::it
   }
   else
   {
-    needle_->resetKey(key);
-    if (owner_->deleteItem(needle_))
+    if (owner_->deleteItem(key))
     {
       reply("DELETED\r\n");
     }
@@ -421,3 +545,274 @@ void Session::doDelete(Session::Tokenizer::iterator& beg, Session::Tokenizer::it
     }
   }
 }
+
+bool Session::processBinary(muduo::net::Buffer* buf)
+{
+  using namespace binary;
+  static_assert(sizeof(BinaryHeader) == 24, "header of binary protocol");
+  BinaryHeader req;
+  if (buf->readableBytes() < sizeof req)
+  {
+    return false;
+  }
+  memcpy(&req, buf->peek(), sizeof req);
+  req.keylen = sockets::networkToHost16(req.keylen);
+  req.bodylen = sockets::networkToHost32(req.bodylen);
+  req.opaque = sockets::networkToHost32(req.opaque);
+  req.cas = sockets::networkToHost64(req.cas);
+  if (req.magic != kRequestMagic || req.extlen + req.keylen > req.bodylen)
+  {
+    LOG_INFO << "Bad binary request from " << conn_->peerAddress().toIpPort();
+    buf->retrieveAll();
+    // answer the gets before it, in order
+    doBinaryGets();
+    if (req.magic == kRequestMagic)
+    {
+      binaryReply(req.opcode, kInvalidArguments, req.opaque, 0,
+                  StringPiece(), StringPiece(), statusMessage(kInvalidArguments));
+    }
+    flush();
+    conn_->shutdown();
+    return false;
+  }
+
+  const bool isUpdate = (req.opcode >= kSet && req.opcode <= kReplace)
+                     || req.opcode == kAppend || req.opcode == kPrepend
+                     || (req.opcode >= kSetQ && req.opcode <= kReplaceQ)
+                     || req.opcode == kAppendQ || req.opcode == kPrependQ;
+  if (req.bodylen > SlabAllocator::kMaxItemSize && isUpdate)
+  {
+    ++requestsProcessed_;
+    doBinaryGets();
+    binaryReply(req.opcode, kValueTooLarge, req.opaque, 0,
+                StringPiece(), StringPiece(), statusMessage(kValueTooLarge));
+    buf->retrieve(sizeof req);
+    bytesToDiscard_ = req.bodylen;
+    state_ = kDiscardValue;
+    return true;
+  }
+  if (buf->readableBytes() < sizeof req + req.bodylen)
+  {
+    // FIXME: limit body of other commands
+    return false;
+  }
+
+  ++requestsProcessed_;
+  // stays valid until the end of onMessage(), as nothing is written to buf.
+  const char* body = buf->peek() + sizeof req;
+  StringPiece extras(body, req.extlen);
+  StringPiece key(body + req.extlen, req.keylen);
+  StringPiece value(body + req.extlen + req.keylen,
+                    static_cast<int>(req.bodylen - req.extlen - req.keylen));
+  buf->retrieve(sizeof req + req.bodylen);
+
+  if (req.opcode == kGet || req.opcode == kGetQ
+      || req.opcode == kGetK || req.opcode == kGetKQ)
+  {
+    if (key.size() > 0 && key.size() <= kLongestKeySize && extras.empty())
+    {
+      BinaryGet get = { req.opcode, req.opaque };
+      binaryGets_.push_back(get);
+      keys_.push_back(key);
+    }
+    else
+    {
+      doBinaryGets();
+      binaryReply(req.opcode, kInvalidArguments, req.opaque, 0,
+                  StringPiece(), StringPiece(), statusMessage(kInvalidArguments));
+    }
+    return true;
+  }
+
+  // replies in order of requests
+  doBinaryGets();
+  if (isUpdate)
+  {
+    doBinaryUpdate(req, extras, key, value);
+  }
+  else if (req.opcode == kDelete || req.opcode == kDeleteQ)
+  {
+    uint16_t status = kInvalidArguments;
+    if (key.size() > 0 && key.size() <= kLongestKeySize && extras.empty())
+    {
+      status = owner_->deleteItem(key) ? kSuccess : kKeyNotFound;
+    }
+    if (status != kSuccess || !isQuiet(req.opcode))
+    {
+      binaryReply(req.opcode, status, req.opaque, 0,
+                  StringPiece(), StringPiece(), statusMessage(status));
+    }
+  }
+  else if (req.opcode == kNoop)
+  {
+    binaryReply(req.opcode, kSuccess, req.opaque, 0,
+                StringPiece(), StringPiece(), StringPiece());
+  }
+  else if (req.opcode == kVersion)
+  {
+    binaryReply(req.opcode, kSuccess, req.opaque, 0,
+                StringPiece(), StringPiece(), "0.01 muduo");
+  }
+  else if (req.opcode == kQuit || req.opcode == kQuitQ)
+  {
+    if (req.opcode == kQuit)
+    {
+      binaryReply(req.opcode, kSuccess, req.opaque, 0,
+                  StringPiece(), StringPiece(), StringPiece());
+    }
+    flush();
+    conn_->shutdown();
+  }
+  else
+  {
+    binaryReply(req.opcode, kUnknownCommand, req.opaque, 0,
+                StringPiece(), StringPiece(), statusMessage(kUnknownCommand));
+    LOG_INFO << "Unknown binary command: " << req.opcode;
+  }
+  return true;
+}
+
+void Session::doBinaryUpdate(const BinaryHeader& req, StringPiece extras,
+                             StringPiece key, StringPiece value)
+{
+  using namespace binary;
+  Item::UpdatePolicy policy = Item::kInvalid;
+  switch (req.opcode)
+  {
+    case kSet: case kSetQ:
+      policy = req.cas ? Item::kCas : Item::kSet;
+      break;
+    case kAdd: case kAddQ:
+      policy = Item::kAdd;
+      break;
+    case kReplace: case kReplaceQ:
+      policy = req.cas ? Item::kCas : Item::kReplace;
+      break;
+    case kAppend: case kAppendQ:
+      policy = Item::kAppend;
+      break;
+    case kPrepend: case kPrependQ:
+      policy = Item::kPrepend;
+      break;
+    default:
+      assert(false);
+  }
+
+  const bool hasExtras = policy != Item::kAppend && policy != Item::kPrepend;
+  uint16_t status = kSuccess;
+  uint64_t cas = 0;
+  if (key.size() == 0 || key.size() > kLongestKeySize
+      || extras.size() != (hasExtras ? 8 : 0))
+  {
+    status = kInvalidArguments;
+  }
+  else
+  {
+    uint32_t flags = 0;
+    uint32_t exptime = 0;
+    if (hasExtras)
+    {
+      memcpy(&flags, extras.data(), sizeof flags);
+      memcpy(&exptime, extras.data() + sizeof flags, sizeof exptime);
+      flags = sockets::networkToHost32(flags);
+      exptime = sockets::networkToHost32(exptime);
+    }
+    const int valuelen = value.size() + 2;
+    Item* item = NULL;
+    if (Item::totalSize(key.size(), flags, valuelen) > SlabAllocator::kMaxItemSize)
+    {
+      status = kValueTooLarge;
+    }
+    else if ((item = owner_->allocItem(key, flags, relativeExptime(exptime),
+                                       valuelen, req.cas)) == NULL)
+    {
+      status = kOutOfMemory;
+    }
+
+    if (item)
+    {
+      item->append(value.data(), value.size());
+      item->append("\r\n", 2);
+      bool exists = false;
+      if (!owner_->storeItem(item, policy, &exists, &cas))
+      {
+        if (policy == Item::kAdd)
+          status = kKeyExists;
+        else if (policy == Item::kReplace)
+          status = kKeyNotFound;
+        else if (policy == Item::kCas)
+          status = exists ? kKeyExists : kKeyNotFound;
+        else
+          status = kNotStored;
+      }
+    }
+    else
+    {
+      // like memcached, a failed update removes the old value
+      owner_->deleteItem(key);
+    }
+  }
+
+  if (status != kSuccess)
+  {
+    binaryReply(req.opcode, status, req.opaque, 0,
+                StringPiece(), StringPiece(), statusMessage(status));
+  }
+  else if (!isQuiet(req.opcode))
+  {
+    binaryReply(req.opcode, status, req.opaque, cas,
+                StringPiece(), StringPiece(), StringPiece());
+  }
+}
+
+void Session::doBinaryGets()
+{
+  if (!binaryGets_.empty())
+  {
+    assert(keys_.size() == binaryGets_.size());
+    owner_->getItems(keys_.data(), keys_.size(), binaryGet_);
+    keys_.clear();
+    binaryGets_.clear();
+  }
+}
+
+void Session::outputBinaryGet(size_t index, const Item* item)
+{
+  using namespace binary;
+  const BinaryGet& get = binaryGets_[index];
+  const bool withKey = get.opcode == kGetK || get.opcode == kGetKQ;
+  if (item)
+  {
+    uint32_t flags = sockets::hostToNetwork32(item->flags());
+    binaryReply(get.opcode, kSuccess, get.opaque, item->cas(),
+                StringPiece(reinterpret_cast<const char*>(&flags), sizeof flags),
+                withKey ? item->key() : StringPiece(),
+                StringPiece(item->value(), static_cast<int>(item->valueLength() - 2)));
+  }
+  else if (!isQuiet(get.opcode))
+  {
+    binaryReply(get.opcode, kKeyNotFound, get.opaque, 0,
+                StringPiece(), withKey ? keys_[index] : StringPiece(),
+                statusMessage(kKeyNotFound));
+  }
+}
+
+void Session::binaryReply(uint8_t opcode, uint16_t status, uint32_t opaque, uint64_t cas,
+                          StringPiece extras, StringPiece key, StringPiece value)
+{
+  BinaryHeader header;
+  header.magic = binary::kResponseMagic;
+  header.opcode = opcode;
+  header.keylen = sockets::hostToNetwork16(static_cast<uint16_t>(key.size()));
+  header.extlen = static_cast<uint8_t>(extras.size());
+  header.datatype = 0;
+  header.status = sockets::hostToNetwork16(status);
+  header.bodylen = sockets::hostToNetwork32(extras.size() + key.size() + value.size());
+  header.opaque = sockets::hostToNetwork32(opaque);
+  header.cas = sockets::hostToNetwork64(cas);
+  outputBuf_.ensureWritableBytes(sizeof header + extras.size() + key.size() + value.size());
+  outputBuf_.append(&header, sizeof header);
+  outputBuf_.append(extras.data(), extras.size());
+  outputBuf_.append(key.data(), key.size());
+  outputBuf_.append(value.data(), value.size());
+}
@@ -9,6 +9,9 @@
 
 #include <boost/tokenizer.hpp>
 
+#include <functional>
+#include <vector>
+
 using muduo::string;
 
 class MemcacheServer;
@@ -21,11 +24,12 @@ class Session : public std::enable_shared_from_this<Session>,
     : owner_(owner),
       conn_(conn),
       state_(kNewCommand),
-      protocol_(kAscii), // FIXME
+      protocol_(kAuto),
       noreply_(false),
       policy_(Item::kInvalid),
+      currItem_(NULL),
       bytesToDiscard_(0),
-      needle_(Item::makeItem(kLongestKey, 0, 0, 2, 0)),
+      needCas_(false),
       bytesRead_(0),
       requestsProcessed_(0)
   {
@@ -35,14 +39,11 @@ class Session : public std::enable_shared_from_this<Session>,
 
     conn_->setMessageCallback(
         std::bind(&Session::onMessage, this, _1, _2, _3));
+    asciiGet_ = std::bind(&Session::outputAsciiGet, this, _1, _2);
+    binaryGet_ = std::bind(&Session::outputBinaryGet, this, _1, _2);
   }
 
-  ~Session()
-  {
-    LOG_INFO << "requests processed: " << requestsProcessed_
-             << " input buffer size: " << conn_->inputBuffer()->internalCapacity()
-             << " output buffer size: " << conn_->outputBuffer()->internalCapacity();
-  }
+  ~Session();
 
  private:
   enum State
@@ -72,6 +73,21 @@ class Session : public std::enable_shared_from_this<Session>,
   bool processRequest(muduo::StringPiece request);
   void resetRequest();
   void reply(muduo::StringPiece msg);
+  // sends replies of all requests of this message in one write
+  void flush();
+  int relativeExptime(time_t exptime) const;
+  void outputAsciiGet(size_t index, const Item* item);
+
+  // binary protocol, returns false if request is incomplete
+  struct BinaryHeader;
+  bool processBinary(muduo::net::Buffer* buf);
+  void doBinaryUpdate(const BinaryHeader& req, muduo::StringPiece extras,
+                      muduo::StringPiece key, muduo::StringPiece value);
+  void doBinaryGets();
+  void outputBinaryGet(size_t index, const Item* item);
+  void binaryReply(uint8_t opcode, uint16_t status, uint32_t opaque, uint64_t cas,
+                   muduo::StringPiece extras, muduo::StringPiece key,
+                   muduo::StringPiece value);
 
   struct SpaceSeparator
   {
@@ -96,17 +112,28 @@ class Session : public std::enable_shared_from_this<Session>,
   string command_;
   bool noreply_;
   Item::UpdatePolicy policy_;
-  ItemPtr currItem_;
+  Item* currItem_;  // owned, not linked
   size_t bytesToDiscard_;
+
+  // keys of a multi-get, point to input buffer
+  std::vector<muduo::StringPiece> keys_;
+  bool needCas_;
+  struct BinaryGet
+  {
+    uint8_t opcode;
+    uint32_t opaque;
+  };
+  // binary gets are batched until the next other command
+  std::vector<BinaryGet> binaryGets_;
+  std::function<void (size_t, const Item*)> asciiGet_;
+  std::function<void (size_t, const Item*)> binaryGet_;
+
   // cached
-  ItemPtr needle_;
   muduo::net::Buffer outputBuf_;
 
   // per session stats
   size_t bytesRead_;
   size_t requestsProcessed_;
-
-  static string kLongestKey;
 };
 
 typedef std::shared_ptr<Session> SessionPtr;
@@ -0,0 +1,208 @@
+#include "examples/memcached/server/SlabAllocator.h"
+
+#include <algorithm>
+#include <new>
+
+#include <assert.h>
+#include <stdlib.h>
+
+using namespace muduo;
+
+const size_t SlabAllocator::kPageSize;
+const size_t SlabAllocator::kMaxItemSize;
+
+namespace
+{
+const size_t kMinChunkSize = 64;
+const double kGrowthFactor = 1.25;
+}
+
+struct SlabAllocator::SlabClass
+{
+  explicit SlabClass(size_t size)
+    : chunkSize(size),
+      perPage(kPageSize / size),
+      hand(0),
+      bytesRequested(0),
+      evictions(0)
+  {
+  }
+
+  Item* chunkAt(size_t index) REQUIRES(mutex)
+  {
+    char* page = pages[index / perPage];
+    return reinterpret_cast<Item*>(page + index % perPage * chunkSize);
+  }
+
+  const size_t chunkSize;
+  const size_t perPage;
+  mutable MutexLock mutex;
+  std::vector<char*> pages GUARDED_BY(mutex);
+  std::vector<Item*> freeChunks GUARDED_BY(mutex);
+  // CLOCK hand, index of chunk
+  size_t hand GUARDED_BY(mutex);
+  int64_t bytesRequested GUARDED_BY(mutex);
+  int64_t evictions GUARDED_BY(mutex);
+};
+
+SlabAllocator::SlabAllocator(size_t memoryLimit, const UnlinkCallback& cb)
+  : maxPages_(memoryLimit == 0 ? 0 : static_cast<int64_t>(std::max<size_t>(memoryLimit / kPageSize, 1))),
+    unlinkCallback_(cb)
+{
+  size_t size = kMinChunkSize;
+  while (size <= kPageSize / 2)
+  {
+    chunkSizes_.push_back(size);
+    size = static_cast<size_t>(static_cast<double>(size) * kGrowthFactor);
+    size = (size + 7) & ~static_cast<size_t>(7);
+  }
+  chunkSizes_.push_back(kPageSize);
+  assert(chunkSizes_.size() <= 256);
+  for (size_t chunkSize : chunkSizes_)
+  {
+    classes_.emplace_back(new SlabClass(chunkSize));
+  }
+}
+
+SlabAllocator::~SlabAllocator()
+{
+  for (const auto& cls : classes_)
+  {
+    MutexLockGuard lock(cls->mutex);
+    for (char* page : cls->pages)
+    {
+      ::free(page);
+    }
+  }
+}
+
+Item* SlabAllocator::alloc(StringPiece key,
+                           size_t hash,
+                           uint32_t flags,
+                           int exptime,
+                           int valuelen,
+                           uint64_t cas)
+{
+  const size_t size = Item::totalSize(key.size(), flags, valuelen);
+  int slabClass = classOf(size);
+  if (slabClass < 0)
+  {
+    return NULL;
+  }
+
+  SlabClass* cls = classes_[slabClass].get();
+  MutexLockGuard lock(cls->mutex);
+  if (cls->freeChunks.empty())
+  {
+    grow(cls);
+  }
+
+  Item* chunk = NULL;
+  if (!cls->freeChunks.empty())
+  {
+    chunk = cls->freeChunks.back();
+    cls->freeChunks.pop_back();
+  }
+  else
+  {
+    chunk = evict(cls);
+    if (chunk == NULL)
+    {
+      return NULL;
+    }
+  }
+  cls->bytesRequested += static_cast<int64_t>(size);
+  // constructed with lock held, as evict() reads the header
+  return new (chunk) Item(key, hash, flags, exptime, valuelen, cas, slabClass);
+}
+
+void SlabAllocator::free(Item* item)
+{
+  assert(!item->linked());
+  SlabClass* cls = classes_[item->slabClass()].get();
+  MutexLockGuard lock(cls->mutex);
+  assert(item->allocated());
+  item->setFree();
+  cls->bytesRequested -= static_cast<int64_t>(item->totalSize());
+  cls->freeChunks.push_back(item);
+}
+
+size_t SlabAllocator::chunkSize(int slabClass) const
+{
+  return chunkSizes_[slabClass];
+}
+
+SlabAllocator::Stats SlabAllocator::stats() const
+{
+  Stats result;
+  for (const auto& cls : classes_)
+  {
+    MutexLockGuard lock(cls->mutex);
+    int64_t chunks = static_cast<int64_t>(cls->pages.size() * cls->perPage);
+    int64_t items = chunks - static_cast<int64_t>(cls->freeChunks.size());
+    result.pages += static_cast<int64_t>(cls->pages.size());
+    result.chunks += chunks;
+    result.items += items;
+    result.bytesUsed += items * static_cast<int64_t>(cls->chunkSize);
+    result.bytesRequested += cls->bytesRequested;
+    result.evictions += cls->evictions;
+  }
+  return result;
+}
+
+int SlabAllocator::classOf(size_t size) const
+{
+  std::vector<size_t>::const_iterator it =
+      std::lower_bound(chunkSizes_.begin(), chunkSizes_.end(), size);
+  return it != chunkSizes_.end() ? static_cast<int>(it - chunkSizes_.begin()) : -1;
+}
+
+char* SlabAllocator::newPage()
+{
+  if (pages_.incrementAndGet() > maxPages_ && maxPages_ > 0)
+  {
+    pages_.decrement();
+    return NULL;
+  }
+  return static_cast<char*>(::malloc(kPageSize));
+}
+
+void SlabAllocator::grow(SlabClass* cls)
+{
+  char* page = newPage();
+  if (page)
+  {
+    cls->pages.push_back(page);
+    cls->freeChunks.reserve(cls->freeChunks.size() + cls->perPage);
+    for (size_t i = cls->perPage; i > 0; --i)
+    {
+      cls->freeChunks.push_back(reinterpret_cast<Item*>(page + (i-1) * cls->chunkSize));
+    }
+  }
+}
+
+Item* SlabAllocator::evict(SlabClass* cls)
+{
+  // every chunk is allocated, either linked, being received, or being freed.
+  const size_t total = cls->pages.size() * cls->perPage;
+  for (size_t n = 0; n < 2 * total; ++n)
+  {
+    Item* item = cls->chunkAt(cls->hand);
+    if (++cls->hand == total)
+    {
+      cls->hand = 0;
+    }
+    assert(item->allocated());
+    if (item->clearReferenced())
+    {
+      continue;  // second chance
+    }
+    if (unlinkCallback_(item))
+    {
+      cls->bytesRequested -= static_cast<int64_t>(item->totalSize());
+      ++cls->evictions;
+      return item;
+    }
+  }
+  return NULL;
+}
@@ -0,0 +1,75 @@
+#ifndef MUDUO_EXAMPLES_MEMCACHED_SERVER_SLABALLOCATOR_H
+#define MUDUO_EXAMPLES_MEMCACHED_SERVER_SLABALLOCATOR_H
+
+#include "examples/memcached/server/Item.h"
+
+#include "muduo/base/Atomic.h"
+#include "muduo/base/Mutex.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Allocates Items from 1MiB pages, each page is cut into chunks of one
+// size class, sizes grow by a factor of 1.25 like memcached.
+//
+// Pages are never returned. Once memory limit is reached, a size class
+// reuses its own chunks, victims are chosen by CLOCK: a chunk whose
+// reference bit is set gets a second chance.
+class SlabAllocator : muduo::noncopyable
+{
+ public:
+  // Tries to take a victim out of the hash table, called with slab class locked.
+  // Returns false if it is not linked.
+  typedef std::function<bool (Item*)> UnlinkCallback;
+
+  static const size_t kPageSize = 1024 * 1024;
+  static const size_t kMaxItemSize = kPageSize;
+
+  struct Stats
+  {
+    Stats() : pages(0), chunks(0), items(0), bytesUsed(0), bytesRequested(0), evictions(0) { }
+    int64_t pages;
+    int64_t chunks;
+    int64_t items;
+    int64_t bytesUsed;       // chunk size of allocated items
+    int64_t bytesRequested;  // totalSize() of allocated items
+    int64_t evictions;
+  };
+
+  // memoryLimit is in bytes, 0 for unlimited.
+  SlabAllocator(size_t memoryLimit, const UnlinkCallback& cb);
+  ~SlabAllocator();
+
+  // returns NULL if too large or out of memory
+  Item* alloc(muduo::StringPiece key,
+              size_t hash,
+              uint32_t flags,
+              int exptime,
+              int valuelen,
+              uint64_t cas);
+
+  // item must not be linked
+  void free(Item* item);
+
+  int numClasses() const { return static_cast<int>(classes_.size()); }
+  size_t chunkSize(int slabClass) const;
+  Stats stats() const;
+
+ private:
+  struct SlabClass;
+
+  int classOf(size_t size) const;
+  char* newPage();
+  // called with cls->mutex locked
+  void grow(SlabClass* cls);
+  Item* evict(SlabClass* cls);
+
+  const int64_t maxPages_;
+  UnlinkCallback unlinkCallback_;
+  std::vector<size_t> chunkSizes_;
+  std::vector<std::unique_ptr<SlabClass>> classes_;
+  muduo::AtomicInt64 pages_;
+};
+
+#endif  // MUDUO_EXAMPLES_MEMCACHED_SERVER_SLABALLOCATOR_H
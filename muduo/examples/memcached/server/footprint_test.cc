@@ -1,4 +1,5 @@
 #include "examples/memcached/server/MemcacheServer.h"
+#include "muduo/base/ProcessInfo.h"
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/inspect/ProcessInspector.h"
 
@@ -10,6 +11,23 @@
 
 using namespace muduo::net;
 
+// resident memory from /proc/self/statm
+int64_t residentBytes()
+{
+  long size = 0;
+  long pages = 0;
+  FILE* fp = fopen("/proc/self/statm", "r");
+  if (fp)
+  {
+    if (fscanf(fp, "%ld %ld", &size, &pages) != 2)
+    {
+      pages = 0;
+    }
+    fclose(fp);
+  }
+  return static_cast<int64_t>(pages) * muduo::ProcessInfo::pageSize();
+}
+
 int main(int argc, char* argv[])
 {
 #ifdef HAVE_TCMALLOC
@@ -26,11 +44,13 @@ int main(int argc, char* argv[])
          sizeof(Item), getpid(), items, keylen, valuelen);
   char key[256] = { 0 };
   string value;
+  const int64_t residentBefore = residentBytes();
   for (int i = 0; i < items; ++i)
   {
     snprintf(key, sizeof key, "%0*d", keylen, i);
     value.assign(valuelen, "0123456789"[i % 10]);
-    ItemPtr item(Item::makeItem(key, 0, 0, valuelen+2, 1));
+    Item* item = server.allocItem(key, 0, 0, valuelen+2, 1);
+    assert(item);
     item->append(value.data(), value.size());
     item->append("\r\n", 2);
     assert(item->endsWithCRLF());
@@ -39,10 +59,24 @@ int main(int argc, char* argv[])
     assert(stored); (void) stored;
     assert(!exists);
   }
+  const int64_t residentAfter = residentBytes();
   Inspector::ArgList arg;
   printf("==========\n%s\n",
          ProcessInspector::overview(HttpRequest::kGet, arg).c_str());
-  // TODO: print bytes per item, overhead percent
+
+  // payload is what a client sends: key, value and its CRLF
+  const double payload = keylen + valuelen + 2;
+  const double perItem = static_cast<double>(residentAfter - residentBefore) / items;
+  SlabAllocator::Stats stats = server.slabStats();
+  printf("==========\n");
+  printf("slab pages = %lld\nslab chunk bytes per item = %.1f\nitem bytes per item = %.1f\n",
+         static_cast<long long>(stats.pages),
+         static_cast<double>(stats.bytesUsed) / items,
+         static_cast<double>(stats.bytesRequested) / items);
+  printf("index bytes per item = %.1f\n",
+         static_cast<double>(server.indexBytes()) / items);
+  printf("resident bytes per item = %.1f\npayload bytes per item = %.0f\noverhead = %.1f%%\n",
+         perItem, payload, (perItem - payload) * 100 / payload);
   fflush(stdout);
 #ifdef HAVE_TCMALLOC
   char buf[8192];
@@ -0,0 +1,120 @@
+// Test of the ASCII request line of Session over TCP.
+//
+// A multi-get line longer than 1 KiB arrives in two writes, the server
+// must wait for the rest of it instead of closing the connection.
+
+#undef NDEBUG
+#include "examples/memcached/server/MemcacheServer.h"
+
+#include "muduo/base/Thread.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/InetAddress.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const uint16_t kPort = 11311;
+const int kKeys = 100;
+
+void makeKey(char* buf, size_t len, int i)
+{
+  snprintf(buf, len, "key:%010d", i);
+}
+
+void setItem(MemcacheServer* server, StringPiece key, StringPiece value)
+{
+  Item* item = server->allocItem(key, 0, 0, value.size() + 2, 0);
+  assert(item != NULL);
+  item->append(value.data(), value.size());
+  item->append("\r\n", 2);
+  bool exists = false;
+  bool stored = server->storeItem(item, Item::kSet, &exists);
+  assert(stored); (void) stored;
+}
+
+void writeAll(int sockfd, const string& data)
+{
+  ssize_t n = ::write(sockfd, data.data(), data.size());
+  assert(n == static_cast<ssize_t>(data.size())); (void) n;
+}
+
+// reads until the reply ends with END\r\n or the connection closes
+string readReply(int sockfd)
+{
+  string reply;
+  char buf[4096];
+  while (reply.size() < 5 || reply.compare(reply.size() - 5, 5, "END\r\n") != 0)
+  {
+    ssize_t n = ::read(sockfd, buf, sizeof buf);
+    if (n <= 0)
+    {
+      break;
+    }
+    reply.append(buf, n);
+  }
+  return reply;
+}
+
+void client(EventLoop* loop)
+{
+  InetAddress serverAddr("127.0.0.1", kPort);
+  int sockfd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+  int ret = ::connect(sockfd, serverAddr.getSockAddr(),
+                      static_cast<socklen_t>(sizeof(struct sockaddr_in)));
+  assert(ret == 0); (void) ret;
+
+  string request = "get";
+  string expected;
+  char key[32];
+  for (int i = 0; i < kKeys; ++i)
+  {
+    makeKey(key, sizeof key, i);
+    request += ' ';
+    request += key;
+    expected += "VALUE ";
+    expected += key;
+    expected += " 0 5\r\nvalue\r\n";
+  }
+  request += "\r\n";
+  expected += "END\r\n";
+  assert(request.size() > 1024);
+
+  // the first write alone is over 1 KiB without CRLF
+  size_t first = request.size() - 10;
+  writeAll(sockfd, request.substr(0, first));
+  usleep(100*1000);
+  writeAll(sockfd, request.substr(first));
+  string reply = readReply(sockfd);
+  assert(reply == expected);
+
+  ::close(sockfd);
+  loop->queueInLoop(std::bind(&EventLoop::quit, loop));
+}
+
+int main()
+{
+  EventLoop loop;
+  MemcacheServer::Options options;
+  options.tcpport = kPort;
+  MemcacheServer server(&loop, options);
+
+  char key[32];
+  for (int i = 0; i < kKeys; ++i)
+  {
+    makeKey(key, sizeof key, i);
+    setItem(&server, key, "value");
+  }
+  server.start();
+
+  Thread thr(std::bind(client, &loop), "client");
+  thr.start();
+  loop.loop();
+  thr.join();
+  printf("PASS\n");
+}
@@ -0,0 +1,142 @@
+// Benchmark of item store of MemcacheServer, without network.
+//
+// Threads set and get random keys of a fixed key space, 9 gets per set,
+// reports operations per second and the hit ratio. With a memory limit
+// smaller than the key space, sets evict by CLOCK.
+
+#include "examples/memcached/server/MemcacheServer.h"
+
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/Logging.h"
+#include "muduo/base/Thread.h"
+#include "muduo/base/Timestamp.h"
+#include "muduo/net/EventLoop.h"
+
+#include <random>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+struct Config
+{
+  int keys;
+  int valuelen;
+  int opsPerThread;
+  int getsPerSet;
+};
+
+bool setItem(MemcacheServer* server, StringPiece key, const string& value)
+{
+  Item* item = server->allocItem(key, 0, 0, static_cast<int>(value.size()) + 2, 0);
+  if (item == NULL)
+  {
+    return false;
+  }
+  item->append(value.data(), value.size());
+  item->append("\r\n", 2);
+  bool exists = false;
+  return server->storeItem(item, Item::kSet, &exists);
+}
+
+void makeKey(char* buf, size_t len, int i)
+{
+  snprintf(buf, len, "key:%010d", i);
+}
+
+void fill(MemcacheServer* server, const Config& config)
+{
+  string value(config.valuelen, 'v');
+  char key[32];
+  for (int i = 0; i < config.keys; ++i)
+  {
+    makeKey(key, sizeof key, i);
+    setItem(server, key, value);
+  }
+}
+
+void worker(MemcacheServer* server, const Config& config, int seed,
+            CountDownLatch* start, int64_t* hits)
+{
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<int> dist(0, config.keys - 1);
+  string value(config.valuelen, 'w');
+  Buffer output;
+  char key[32];
+  start->wait();
+  for (int i = 0; i < config.opsPerThread; ++i)
+  {
+    makeKey(key, sizeof key, dist(gen));
+    if (i % (config.getsPerSet + 1) == 0)
+    {
+      setItem(server, key, value);
+    }
+    else if (server->getItem(key, &output, false))
+    {
+      ++*hits;
+    }
+    output.retrieveAll();
+  }
+}
+
+void bench(int threads, size_t memoryLimit, const Config& config)
+{
+  EventLoop loop;
+  MemcacheServer::Options options;
+  options.memoryLimit = memoryLimit;
+  MemcacheServer server(&loop, options);
+  fill(&server, config);
+
+  CountDownLatch start(1);
+  std::vector<int64_t> hits(threads * 8);  // padded
+  std::vector<std::unique_ptr<Thread>> workers;
+  for (int i = 0; i < threads; ++i)
+  {
+    workers.emplace_back(new Thread(std::bind(worker, &server, config, i, &start, &hits[i * 8])));
+    workers.back()->start();
+  }
+  Timestamp begin(Timestamp::now());
+  start.countDown();
+  for (auto& thr : workers)
+  {
+    thr->join();
+  }
+  double seconds = timeDifference(Timestamp::now(), begin);
+
+  int64_t totalHits = 0;
+  for (int64_t h : hits)
+  {
+    totalHits += h;
+  }
+  const double ops = static_cast<double>(config.opsPerThread) * threads;
+  const double gets = ops * config.getsPerSet / (config.getsPerSet + 1);
+  SlabAllocator::Stats stats = server.slabStats();
+  printf("threads %d limit %4zdMiB: %10.0f ops/s, hit %5.1f%%, %lld evictions\n",
+         threads, memoryLimit / (1024 * 1024), ops / seconds,
+         static_cast<double>(totalHits) * 100 / gets,
+         static_cast<long long>(stats.evictions));
+}
+
+int main(int argc, char* argv[])
+{
+  Logger::setLogLevel(Logger::WARN);
+  Config config;
+  config.keys = argc > 1 ? atoi(argv[1]) : 1000*1000;
+  config.valuelen = argc > 2 ? atoi(argv[2]) : 100;
+  config.opsPerThread = argc > 3 ? atoi(argv[3]) : 2000*1000;
+  config.getsPerSet = 9;
+  int maxThreads = argc > 4 ? atoi(argv[4]) : 4;
+
+  printf("keys %d, value %d bytes, %d ops per thread\n",
+         config.keys, config.valuelen, config.opsPerThread);
+  // about half of the key space fits
+  size_t halfLimit = static_cast<size_t>(config.keys) * (config.valuelen + 64) / 2;
+  for (int threads = 1; threads <= maxThreads; threads *= 2)
+  {
+    bench(threads, 0, config);
+    bench(threads, halfLimit, config);
+  }
+}
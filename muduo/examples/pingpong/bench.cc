@@ -7,6 +7,7 @@
 #include "muduo/net/EventLoop.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <sys/resource.h>
 #include <sys/socket.h>
 #include <unistd.h>
@@ -81,7 +82,7 @@ int main(int argc, char* argv[])
   numActive = 1;
   numWrites = 100;
   int c;
-  while ((c = getopt(argc, argv, "n:a:w:")) != -1)
+  while ((c = getopt(argc, argv, "n:a:w:p:")) != -1)
   {
     switch (c)
     {
@@ -94,6 +95,22 @@ int main(int argc, char* argv[])
       case 'w':
         numWrites = atoi(optarg);
         break;
+      case 'p':
+        // select Poller::newDefaultPoller() backend: poll, epoll or uring (poll mode)
+        if (strcmp(optarg, "poll") == 0)
+        {
+          ::setenv("MUDUO_USE_POLL", "1", 1);
+        }
+        else if (strcmp(optarg, "uring") == 0)
+        {
+          ::setenv("MUDUO_USE_IOURING", "1", 1);
+        }
+        else if (strcmp(optarg, "epoll") != 0)
+        {
+          fprintf(stderr, "Unknown poller \"%s\"\n", optarg);
+          return 1;
+        }
+        break;
       default:
         fprintf(stderr, "Illegal argument \"%c\"\n", c);
         return 1;
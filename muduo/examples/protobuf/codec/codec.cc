@@ -9,7 +9,9 @@
 #include "examples/protobuf/codec/codec.h"
 
 #include "muduo/base/Logging.h"
+#include "muduo/base/ThreadLocalSingleton.h"
 #include "muduo/net/Endian.h"
+#include "muduo/net/EventLoop.h"
 #include "muduo/net/protorpc/google-inl.h"
 
 #include <google/protobuf/descriptor.h>
@@ -19,6 +21,75 @@
 using namespace muduo;
 using namespace muduo::net;
 
+namespace
+{
+  // of the last message sent in the loop thread of its connection,
+  // reused for next one.
+  struct SendBuffer
+  {
+    static const size_t kMaxCapacity = 64*1024;
+    Buffer buffer;
+  };
+
+  // messages of last frames parsed in this thread, by prototype.
+  struct MessageCache
+  {
+    std::vector<std::pair<const google::protobuf::Message*, MessagePtr>> messages;
+  };
+
+  const google::protobuf::Message* findPrototype(const std::string& typeName)
+  {
+    const google::protobuf::Descriptor* descriptor =
+      google::protobuf::DescriptorPool::generated_pool()->FindMessageTypeByName(typeName);
+    if (descriptor)
+    {
+      return google::protobuf::MessageFactory::generated_factory()->GetPrototype(descriptor);
+    }
+    return NULL;
+  }
+
+  MessagePtr reusedMessage(const google::protobuf::Message* prototype)
+  {
+    auto& messages = ThreadLocalSingleton<MessageCache>::instance().messages;
+    for (auto& item : messages)
+    {
+      if (item.first == prototype)
+      {
+        if (item.second.use_count() > 1)
+        {
+          item.second.reset(prototype->New());
+        }
+        return item.second;
+      }
+    }
+    messages.push_back(std::make_pair(prototype, MessagePtr(prototype->New())));
+    return messages.back().second;
+  }
+}
+
+void ProtobufCodec::send(const muduo::net::TcpConnectionPtr& conn,
+                         const google::protobuf::Message& message)
+{
+  if (conn->getLoop()->isInLoopThread())
+  {
+    Buffer& buf = ThreadLocalSingleton<SendBuffer>::instance().buffer;
+    buf.retrieveAll();
+    fillEmptyBuffer(&buf, message);
+    conn->send(&buf);
+    if (buf.internalCapacity() > SendBuffer::kMaxCapacity)
+    {
+      buf.shrink(0);
+    }
+  }
+  else
+  {
+    // moved to the loop of conn
+    Buffer buf;
+    fillEmptyBuffer(&buf, message);
+    conn->send(std::move(buf));
+  }
+}
+
 void ProtobufCodec::fillEmptyBuffer(Buffer* buf, const google::protobuf::Message& message)
 {
   // buf->retrieveAll();
@@ -127,7 +198,7 @@ void ProtobufCodec::onMessage(const TcpConnectionPtr& conn,
     else if (buf->readableBytes() >= implicit_cast<size_t>(len + kHeaderLen))
     {
       ErrorCode errorCode = kNoError;
-      MessagePtr message = parse(buf->peek()+kHeaderLen, len, &errorCode);
+      MessagePtr message = parse(buf->peek()+kHeaderLen, len, &errorCode, reuseMessage_);
       if (errorCode == kNoError && message)
       {
         messageCallback_(conn, message, receiveTime);
@@ -149,21 +220,15 @@ void ProtobufCodec::onMessage(const TcpConnectionPtr& conn,
 google::protobuf::Message* ProtobufCodec::createMessage(const std::string& typeName)
 {
   google::protobuf::Message* message = NULL;
-  const google::protobuf::Descriptor* descriptor =
-    google::protobuf::DescriptorPool::generated_pool()->FindMessageTypeByName(typeName);
-  if (descriptor)
+  const google::protobuf::Message* prototype = findPrototype(typeName);
+  if (prototype)
   {
-    const google::protobuf::Message* prototype =
-      google::protobuf::MessageFactory::generated_factory()->GetPrototype(descriptor);
-    if (prototype)
-    {
-      message = prototype->New();
-    }
+    message = prototype->New();
   }
   return message;
 }
 
-MessagePtr ProtobufCodec::parse(const char* buf, int len, ErrorCode* error)
+MessagePtr ProtobufCodec::parse(const char* buf, int len, ErrorCode* error, bool reuseMessage)
 {
   MessagePtr message;
 
@@ -180,8 +245,19 @@ MessagePtr ProtobufCodec::parse(const char* buf, int len, ErrorCode* error)
     if (nameLen >= 2 && nameLen <= len - 2*kHeaderLen)
     {
       std::string typeName(buf + kHeaderLen, buf + kHeaderLen + nameLen - 1);
-      // create message object
-      message.reset(createMessage(typeName));
+      // create message object, or reuse one, which ParseFromArray() clears.
+      if (reuseMessage)
+      {
+        const google::protobuf::Message* prototype = findPrototype(typeName);
+        if (prototype)
+        {
+          message = reusedMessage(prototype);
+        }
+      }
+      else
+      {
+        message.reset(createMessage(typeName));
+      }
       if (message)
       {
         // parse from buffer
@@ -53,33 +53,35 @@ class ProtobufCodec : muduo::noncopyable
 
   explicit ProtobufCodec(const ProtobufMessageCallback& messageCb)
     : messageCallback_(messageCb),
-      errorCallback_(defaultErrorCallback)
+      errorCallback_(defaultErrorCallback),
+      reuseMessage_(false)
   {
   }
 
   ProtobufCodec(const ProtobufMessageCallback& messageCb, const ErrorCallback& errorCb)
     : messageCallback_(messageCb),
-      errorCallback_(errorCb)
+      errorCallback_(errorCb),
+      reuseMessage_(false)
   {
   }
 
+  // parses into the message of the same type of last frame in this thread,
+  // if the callback didn't keep it, off by default.
+  void setReuseMessage(bool on)
+  { reuseMessage_ = on; }
+
   void onMessage(const muduo::net::TcpConnectionPtr& conn,
                  muduo::net::Buffer* buf,
                  muduo::Timestamp receiveTime);
 
   void send(const muduo::net::TcpConnectionPtr& conn,
-            const google::protobuf::Message& message)
-  {
-    // FIXME: serialize to TcpConnection::outputBuffer()
-    muduo::net::Buffer buf;
-    fillEmptyBuffer(&buf, message);
-    conn->send(&buf);
-  }
+            const google::protobuf::Message& message);
 
   static const muduo::string& errorCodeToString(ErrorCode errorCode);
   static void fillEmptyBuffer(muduo::net::Buffer* buf, const google::protobuf::Message& message);
   static google::protobuf::Message* createMessage(const std::string& type_name);
-  static MessagePtr parse(const char* buf, int len, ErrorCode* errorCode);
+  static MessagePtr parse(const char* buf, int len, ErrorCode* errorCode,
+                          bool reuseMessage = false);
 
  private:
   static void defaultErrorCallback(const muduo::net::TcpConnectionPtr&,
@@ -89,6 +91,7 @@ class ProtobufCodec : muduo::noncopyable
 
   ProtobufMessageCallback messageCallback_;
   ErrorCallback errorCallback_;
+  bool reuseMessage_;
 
   const static int kHeaderLen = sizeof(int32_t);
   const static int kMinMessageLen = 2*kHeaderLen + 2; // nameLen + typeName + checkSum
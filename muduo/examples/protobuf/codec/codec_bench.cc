@@ -0,0 +1,180 @@
+// Benchmark of protobuf codecs, small and large messages.
+//
+// encode: serializing into a Buffer, a new one per message vs. a reused one,
+// and via an intermediate std::string.
+// decode: ProtobufCodec and ProtobufCodecLiteT parsing frames from a Buffer,
+// a new message per frame vs. a reused one.
+
+#include "examples/protobuf/codec/codec.h"
+#include "examples/protobuf/codec/query.pb.h"
+#include "muduo/net/protobuf/ProtobufCodecLite.h"
+#include "muduo/base/Timestamp.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <zlib.h>  // adler32
+
+using namespace muduo;
+using namespace muduo::net;
+
+const char kTag[] = "BNCH";
+typedef ProtobufCodecLiteT<muduo::Answer, kTag> AnswerCodec;
+
+int g_received = 0;
+
+void makeSmall(muduo::Answer* answer)
+{
+  answer->set_id(1);
+  answer->set_questioner("Chen Shuo");
+  answer->set_answerer("blog.csdn.net/Solstice");
+  answer->add_solution("Jump!");
+}
+
+void makeLarge(muduo::Answer* answer)
+{
+  answer->set_id(2);
+  answer->set_questioner("Chen Shuo");
+  answer->set_answerer("blog.csdn.net/Solstice");
+  for (int i = 0; i < 1000; ++i)
+  {
+    answer->add_solution(string(64, static_cast<char>('a' + i % 26)));
+  }
+}
+
+void report(const char* name, int count, size_t bytes, Timestamp start)
+{
+  double seconds = timeDifference(Timestamp::now(), start);
+  printf("%-44s %8.0f ns/msg  %8.1f MB/s\n",
+         name, seconds * 1e9 / count,
+         static_cast<double>(bytes) / seconds / (1024 * 1024));
+}
+
+void encodeNewBuffer(const muduo::Answer& answer, int count)
+{
+  size_t bytes = 0;
+  Timestamp start(Timestamp::now());
+  for (int i = 0; i < count; ++i)
+  {
+    Buffer buf;
+    ProtobufCodec::fillEmptyBuffer(&buf, answer);
+    bytes += buf.readableBytes();
+  }
+  report("  encode, new Buffer", count, bytes, start);
+}
+
+void encodeReusedBuffer(const muduo::Answer& answer, int count)
+{
+  size_t bytes = 0;
+  Buffer buf;
+  Timestamp start(Timestamp::now());
+  for (int i = 0; i < count; ++i)
+  {
+    buf.retrieveAll();
+    ProtobufCodec::fillEmptyBuffer(&buf, answer);
+    bytes += buf.readableBytes();
+  }
+  report("  encode, reused Buffer", count, bytes, start);
+}
+
+// the same frame, with the message serialized into a std::string first
+void encodeViaString(const muduo::Answer& answer, int count)
+{
+  size_t bytes = 0;
+  Buffer buf;
+  Timestamp start(Timestamp::now());
+  for (int i = 0; i < count; ++i)
+  {
+    buf.retrieveAll();
+    const string& typeName = answer.GetTypeName();
+    int32_t nameLen = static_cast<int32_t>(typeName.size()+1);
+    buf.appendInt32(nameLen);
+    buf.append(typeName.c_str(), nameLen);
+    string data;
+    answer.SerializeToString(&data);
+    buf.append(data);
+    int32_t checkSum = static_cast<int32_t>(
+        ::adler32(1,
+                  reinterpret_cast<const Bytef*>(buf.peek()),
+                  static_cast<int>(buf.readableBytes())));
+    buf.appendInt32(checkSum);
+    buf.prependInt32(static_cast<int32_t>(buf.readableBytes()));
+    bytes += buf.readableBytes();
+  }
+  report("  encode, via std::string", count, bytes, start);
+}
+
+void onAnswer(const TcpConnectionPtr&, const MessagePtr&, Timestamp)
+{
+  ++g_received;
+}
+
+void onConcreteAnswer(const TcpConnectionPtr&,
+                      const AnswerCodec::ConcreteMessagePtr&,
+                      Timestamp)
+{
+  ++g_received;
+}
+
+// feeds frames in batches, as they come from a socket
+template<typename CODEC>
+void decode(const char* name, CODEC* codec, const Buffer& frame, int count)
+{
+  const int kBatch = 16;
+  Buffer buf;
+  g_received = 0;
+  Timestamp start(Timestamp::now());
+  for (int i = 0; i < count; i += kBatch)
+  {
+    for (int j = 0; j < kBatch; ++j)
+    {
+      buf.append(frame.peek(), frame.readableBytes());
+    }
+    codec->onMessage(TcpConnectionPtr(), &buf, Timestamp());
+  }
+  int received = g_received;
+  report(name, received, frame.readableBytes() * received, start);
+  if (buf.readableBytes() != 0 || received < count)
+  {
+    printf("decode error\n");
+  }
+}
+
+void bench(const char* name, const muduo::Answer& answer, int count)
+{
+  printf("%s message, %d bytes\n", name, answer.ByteSize());
+  encodeNewBuffer(answer, count);
+  encodeReusedBuffer(answer, count);
+  encodeViaString(answer, count);
+
+  Buffer frame;
+  ProtobufCodec::fillEmptyBuffer(&frame, answer);
+  ProtobufCodec codec(onAnswer);
+  codec.setReuseMessage(false);
+  decode("  decode ProtobufCodec, new message", &codec, frame, count);
+  codec.setReuseMessage(true);
+  decode("  decode ProtobufCodec, reused message", &codec, frame, count);
+
+  AnswerCodec lite(onConcreteAnswer);
+  Buffer liteFrame;
+  lite.fillEmptyBuffer(&liteFrame, answer);
+  lite.setReuseMessage(false);
+  decode("  decode ProtobufCodecLiteT, new message", &lite, liteFrame, count);
+  lite.setReuseMessage(true);
+  decode("  decode ProtobufCodecLiteT, reused message", &lite, liteFrame, count);
+}
+
+int main(int argc, char* argv[])
+{
+  GOOGLE_PROTOBUF_VERIFY_VERSION;
+  int count = argc > 1 ? atoi(argv[1]) : 1000000;
+
+  muduo::Answer small;
+  makeSmall(&small);
+  bench("small", small, count);
+
+  muduo::Answer large;
+  makeLarge(&large);
+  bench("large", large, count / 200);
+
+  google::protobuf::ShutdownProtobufLibrary();
+}
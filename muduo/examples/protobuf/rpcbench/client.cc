@@ -9,6 +9,8 @@
 #include "muduo/net/TcpConnection.h"
 #include "muduo/net/protorpc/RpcChannel.h"
 
+#include <algorithm>
+
 #include <stdio.h>
 #include <unistd.h>
 
@@ -23,15 +25,15 @@ class RpcClient : noncopyable
 
   RpcClient(EventLoop* loop,
             const InetAddress& serverAddr,
-            CountDownLatch* allConnected,
-            CountDownLatch* allFinished)
+            CountDownLatch* allConnected)
     : // loop_(loop),
       client_(loop, serverAddr, "RpcClient"),
       channel_(new RpcChannel),
       stub_(get_pointer(channel_)),
       allConnected_(allConnected),
-      allFinished_(allFinished),
-      count_(0)
+      finished_(NULL),
+      count_(0),
+      sent_(0)
   {
     client_.setConnectionCallback(
         std::bind(&RpcClient::onConnection, this, _1));
@@ -45,15 +47,35 @@ class RpcClient : noncopyable
     client_.connect();
   }
 
+  // keeps depth calls outstanding, till kRequests are replied.
+  void start(int depth, CountDownLatch* finished)
+  {
+    count_ = 0;
+    sent_ = 0;
+    finished_ = finished;
+    latencies_.clear();
+    for (int i = 0; i < depth; ++i)
+    {
+      sendRequest();
+    }
+  }
+
+  const std::vector<int32_t>& latencies() const
+  {
+    return latencies_;
+  }
+
+ private:
   void sendRequest()
   {
+    ++sent_;
     echo::EchoRequest request;
     request.set_payload("001010");
     echo::EchoResponse* response = new echo::EchoResponse;
-    stub_.Echo(NULL, &request, response, NewCallback(this, &RpcClient::replied, response));
+    stub_.Echo(NULL, &request, response,
+               NewCallback(this, &RpcClient::replied, response, Timestamp::now()));
   }
 
- private:
   void onConnection(const TcpConnectionPtr& conn)
   {
     if (conn->connected())
@@ -65,19 +87,21 @@ class RpcClient : noncopyable
     }
   }
 
-  void replied(echo::EchoResponse* resp)
+  void replied(echo::EchoResponse* resp, Timestamp sent)
   {
     // LOG_INFO << "replied:\n" << resp->DebugString();
     // loop_->quit();
+    latencies_.push_back(static_cast<int32_t>(
+        Timestamp::now().microSecondsSinceEpoch() - sent.microSecondsSinceEpoch()));
     ++count_;
-    if (count_ < kRequests)
+    if (sent_ < kRequests)
     {
       sendRequest();
     }
-    else
+    else if (count_ == kRequests)
     {
       LOG_INFO << "RpcClient " << this << " finished";
-      allFinished_->countDown();
+      finished_->countDown();
     }
   }
 
@@ -86,10 +110,46 @@ class RpcClient : noncopyable
   RpcChannelPtr channel_;
   echo::EchoService::Stub stub_;
   CountDownLatch* allConnected_;
-  CountDownLatch* allFinished_;
+  CountDownLatch* finished_;
   int count_;
+  int sent_;
+  std::vector<int32_t> latencies_;
 };
 
+void startClient(RpcClient* client, int depth, CountDownLatch* finished)
+{
+  client->start(depth, finished);
+}
+
+void bench(EventLoopThreadPool* pool,
+           const std::vector<std::unique_ptr<RpcClient>>& clients,
+           int depth)
+{
+  CountDownLatch allFinished(static_cast<int>(clients.size()));
+  Timestamp start(Timestamp::now());
+  for (size_t i = 0; i < clients.size(); ++i)
+  {
+    // clients are assigned to loops round-robin
+    pool->getLoopForHash(i)->runInLoop(
+        std::bind(startClient, get_pointer(clients[i]), depth, &allFinished));
+  }
+  allFinished.wait();
+  double seconds = timeDifference(Timestamp::now(), start);
+
+  std::vector<int32_t> latencies;
+  for (const auto& client : clients)
+  {
+    latencies.insert(latencies.end(),
+                     client->latencies().begin(), client->latencies().end());
+  }
+  std::sort(latencies.begin(), latencies.end());
+  size_t n = latencies.size();
+  printf("clients %3zd depth %3d: %10.1f calls/s, latency us p50 %6d p90 %6d p99 %6d p999 %6d\n",
+         clients.size(), depth, static_cast<double>(n) / seconds,
+         latencies[n / 2], latencies[n * 9 / 10], latencies[n * 99 / 100],
+         latencies[n * 999 / 1000]);
+}
+
 int main(int argc, char* argv[])
 {
   LOG_INFO << "pid = " << getpid();
@@ -109,8 +169,18 @@ int main(int argc, char* argv[])
       nThreads = atoi(argv[3]);
     }
 
+    // outstanding calls per client, all of 1 4 16 64 if not given
+    std::vector<int> depths;
+    if (argc > 4)
+    {
+      depths.push_back(atoi(argv[4]));
+    }
+    else
+    {
+      depths = { 1, 4, 16, 64 };
+    }
+
     CountDownLatch allConnected(nClients);
-    CountDownLatch allFinished(nClients);
 
     EventLoop loop;
     EventLoopThreadPool pool(&loop, "rpcbench-client");
@@ -121,28 +191,21 @@ int main(int argc, char* argv[])
     std::vector<std::unique_ptr<RpcClient>> clients;
     for (int i = 0; i < nClients; ++i)
     {
-      clients.emplace_back(new RpcClient(pool.getNextLoop(), serverAddr, &allConnected, &allFinished));
+      clients.emplace_back(new RpcClient(pool.getLoopForHash(i), serverAddr, &allConnected));
       clients.back()->connect();
     }
     allConnected.wait();
-    Timestamp start(Timestamp::now());
     LOG_INFO << "all connected";
-    for (int i = 0; i < nClients; ++i)
+    for (int depth : depths)
     {
-      clients[i]->sendRequest();
+      bench(&pool, clients, depth);
     }
-    allFinished.wait();
-    Timestamp end(Timestamp::now());
-    LOG_INFO << "all finished";
-    double seconds = timeDifference(end, start);
-    printf("%f seconds\n", seconds);
-    printf("%.1f calls per second\n", nClients * kRequests / seconds);
 
     exit(0);
   }
   else
   {
-    printf("Usage: %s host_ip numClients [numThreads]\n", argv[0]);
+    printf("Usage: %s host_ip numClients [numThreads] [depth]\n", argv[0]);
   }
 }
 
@@ -0,0 +1,23 @@
+#!/bin/sh
+
+# Throughput of tcprelay, copying through Buffers vs. splice(2),
+# measured with ttcp through the relay, and CPU time of the relay.
+# Usage: relay_bench.sh [bin_dir] [number_of_64KiB_buffers]
+
+BIN=${1:-../build/release-cpp11/bin}
+NUMBER=${2:-32768}
+
+for mode in copy splice
+do
+  $BIN/ttcp_blocking -r -p 5001 > /dev/null &
+  RECV=$!
+  $BIN/tcprelay 127.0.0.1 5001 5002 $mode > /dev/null 2>&1 &
+  RELAY=$!
+  sleep 1
+  THROUGHPUT=`$BIN/ttcp_blocking -t 127.0.0.1 -p 5002 -n $NUMBER | tail -1`
+  # utime + stime in clock ticks
+  TICKS=`awk '{print $14+$15}' /proc/$RELAY/stat`
+  kill $RELAY
+  wait $RECV
+  echo "$mode: $THROUGHPUT, relay CPU $TICKS ticks"
+done
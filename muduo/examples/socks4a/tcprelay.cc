@@ -2,6 +2,7 @@
 
 #include <malloc.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/resource.h>
 #include <unistd.h>
 
@@ -10,6 +11,7 @@ using namespace muduo::net;
 
 EventLoop* g_eventLoop;
 InetAddress* g_serverAddr;
+bool g_splice = false;
 std::map<string, TunnelPtr> g_tunnels;
 
 void onServerConnection(const TcpConnectionPtr& conn)
@@ -21,6 +23,7 @@ void onServerConnection(const TcpConnectionPtr& conn)
     conn->stopRead();
     TunnelPtr tunnel(new Tunnel(g_eventLoop, *g_serverAddr, conn));
     tunnel->setup();
+    tunnel->setSplice(g_splice);
     tunnel->connect();
     g_tunnels[conn->name()] = tunnel;
   }
@@ -52,7 +55,7 @@ int main(int argc, char* argv[])
 {
   if (argc < 4)
   {
-    fprintf(stderr, "Usage: %s <host_ip> <port> <listen_port>\n", argv[0]);
+    fprintf(stderr, "Usage: %s <host_ip> <port> <listen_port> [splice]\n", argv[0]);
   }
   else
   {
@@ -70,6 +73,7 @@ int main(int argc, char* argv[])
 
     uint16_t acceptPort = static_cast<uint16_t>(atoi(argv[3]));
     InetAddress listenAddr(acceptPort);
+    g_splice = argc > 4 && strcmp(argv[4], "splice") == 0;
 
     EventLoop loop;
     g_eventLoop = &loop;
@@ -15,7 +15,8 @@ class Tunnel : public std::enable_shared_from_this<Tunnel>,
          const muduo::net::InetAddress& serverAddr,
          const muduo::net::TcpConnectionPtr& serverConn)
     : client_(loop, serverAddr, serverConn->name()),
-      serverConn_(serverConn)
+      serverConn_(serverConn),
+      splice_(false)
   {
     LOG_INFO << "Tunnel " << serverConn->peerAddress().toIpPort()
              << " <-> " << serverAddr.toIpPort();
@@ -42,6 +43,13 @@ class Tunnel : public std::enable_shared_from_this<Tunnel>,
         1024*1024);
   }
 
+  // relays with splice(2) instead of copying through Buffers,
+  // call it before connect().
+  void setSplice(bool on)
+  {
+    splice_ = on;
+  }
+
   void connect()
   {
     client_.connect();
@@ -82,7 +90,12 @@ class Tunnel : public std::enable_shared_from_this<Tunnel>,
       serverConn_->setContext(conn);
       serverConn_->startRead();
       clientConn_ = conn;
-      if (serverConn_->inputBuffer()->readableBytes() > 0)
+      // spliceTo() sends what's in inputBuffer() first
+      if (splice_ && serverConn_->spliceTo(conn) && conn->spliceTo(serverConn_))
+      {
+        LOG_DEBUG << "splice " << conn->name();
+      }
+      else if (serverConn_->inputBuffer()->readableBytes() > 0)
       {
         conn->send(serverConn_->inputBuffer());
       }
@@ -126,7 +139,7 @@ class Tunnel : public std::enable_shared_from_this<Tunnel>,
 
     if (which == kServer)
     {
-      if (serverConn_->outputBuffer()->readableBytes() > 0)
+      if (serverConn_->outputBytes() > 0)
       {
         clientConn_->stopRead();
         serverConn_->setWriteCompleteCallback(
@@ -136,7 +149,7 @@ class Tunnel : public std::enable_shared_from_this<Tunnel>,
     }
     else
     {
-      if (clientConn_->outputBuffer()->readableBytes() > 0)
+      if (clientConn_->outputBytes() > 0)
       {
         serverConn_->stopRead();
         clientConn_->setWriteCompleteCallback(
@@ -189,6 +202,7 @@ class Tunnel : public std::enable_shared_from_this<Tunnel>,
   muduo::net::TcpClient client_;
   muduo::net::TcpConnectionPtr serverConn_;
   muduo::net::TcpConnectionPtr clientConn_;
+  bool splice_;
 };
 typedef std::shared_ptr<Tunnel> TunnelPtr;
 
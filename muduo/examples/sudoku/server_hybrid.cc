@@ -3,7 +3,7 @@
 #include "muduo/base/Atomic.h"
 #include "muduo/base/Logging.h"
 #include "muduo/base/Thread.h"
-#include "muduo/base/ThreadPool.h"
+#include "muduo/base/WorkStealingThreadPool.h"
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/EventLoopThread.h"
 #include "muduo/net/InetAddress.h"
@@ -154,7 +154,7 @@ class SudokuServer : noncopyable
   }
 
   TcpServer server_;
-  ThreadPool threadPool_;
+  WorkStealingThreadPool threadPool_;
   const int numThreads_;
   const bool tcpNoDelay_;
   const Timestamp startTime_;
@@ -3,8 +3,10 @@
 class SudokuStat : muduo::noncopyable
 {
  public:
-  SudokuStat(const ThreadPool& pool)
-    : pool_(pool),
+  // Pool is ThreadPool or WorkStealingThreadPool
+  template<typename Pool>
+  explicit SudokuStat(const Pool& pool)
+    : queueSize_(std::bind(&Pool::queueSize, &pool)),
       lastSecond_(0),
       requests_(kSeconds),
       latencies_(kSeconds),
@@ -21,7 +23,7 @@ class SudokuStat : muduo::noncopyable
   string report() const
   {
     LogStream result;
-    size_t queueSize = pool_.queueSize();
+    size_t queueSize = queueSize_();
     result << "task_queue_size " << queueSize << '\n';
 
     {
@@ -178,7 +180,7 @@ class SudokuStat : muduo::noncopyable
   }
 
  private:
-  const ThreadPool& pool_;  // only for ThreadPool::queueSize()
+  const std::function<size_t ()> queueSize_;  // of thread pool
   mutable MutexLock mutex_;
   // invariant:
   // 0. requests_.size() == latencies_.size()
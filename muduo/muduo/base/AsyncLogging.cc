@@ -7,50 +7,182 @@
 #include "muduo/base/LogFile.h"
 #include "muduo/base/Timestamp.h"
 
+#include <algorithm>
 #include <stdio.h>
+#include <sys/uio.h>
 
 using namespace muduo;
 
+namespace
+{
+const size_t kQueueSize = 1024;
+const size_t kMaxFreeBuffers = 4;
+// seconds kBlock waits before it retries a full queue
+const double kQueueFullWait = 0.001;
+}  // namespace
+
+struct AsyncLogging::Stage
+{
+  Stage()
+    : returned(mutex),
+      inFlight(0),
+      queued(0),
+      exited(false)
+  {
+  }
+
+  muduo::MutexLock mutex;
+  muduo::Condition returned GUARDED_BY(mutex);
+  BufferPtr current GUARDED_BY(mutex);
+  // null if handed to backend, and not returned yet
+  BufferPtr spare GUARDED_BY(mutex);
+  // number of buffers owned by backend
+  int inFlight GUARDED_BY(mutex);
+  // of those, pushed to fullBuffers_ and not collected yet,
+  // current is not stolen before them, or lines would be out of order.
+  int queued GUARDED_BY(mutex);
+  bool exited GUARDED_BY(mutex);
+};
+
+AsyncLogging::StageHolder::~StageHolder()
+{
+  if (stage)
+  {
+    // backend deletes it after writing out everything
+    MutexLockGuard lock(stage->mutex);
+    stage->exited = true;
+  }
+}
+
 AsyncLogging::AsyncLogging(const string& basename,
                            off_t rollSize,
-                           int flushInterval)
+                           int flushInterval,
+                           BackpressurePolicy policy,
+                           int maxBuffers)
   : flushInterval_(flushInterval),
+    policy_(policy),
+    maxBuffers_(maxBuffers),
     running_(false),
     basename_(basename),
     rollSize_(rollSize),
     thread_(std::bind(&AsyncLogging::threadFunc, this), "Logging"),
     latch_(1),
+    fullBuffers_(kQueueSize),
+    sleeping_(false),
     mutex_(),
     cond_(mutex_),
-    currentBuffer_(new Buffer),
-    nextBuffer_(new Buffer),
-    buffers_()
+    reportedDropped_(0)
 {
-  currentBuffer_->bzero();
-  nextBuffer_->bzero();
-  buffers_.reserve(16);
 }
 
-void AsyncLogging::append(const char* logline, int len)
+AsyncLogging::~AsyncLogging()
 {
-  muduo::MutexLockGuard lock(mutex_);
-  if (currentBuffer_->avail() > len)
+  if (running_)
+  {
+    stop();
+  }
+  Chunk chunk;
+  while (fullBuffers_.tryPop(&chunk))
   {
-    currentBuffer_->append(logline, len);
   }
-  else
+  MutexLockGuard lock(mutex_);
+  for (Stage* stage : stages_)
   {
-    buffers_.push_back(std::move(currentBuffer_));
+    delete stage;
+  }
+}
 
-    if (nextBuffer_)
+void AsyncLogging::append(const char* logline, int len)
+{
+  Stage* stage = currentStage();
+  // would never fit in a buffer, cut it and keep the line ending.
+  // splitting it would let other threads' buffers in between.
+  bool truncated = len >= muduo::detail::kLargeBuffer;
+  if (truncated)
+  {
+    droppedBytes_.add(len - (muduo::detail::kLargeBuffer - 2));
+    len = muduo::detail::kLargeBuffer - 2;
+  }
+  const int needed = truncated ? len + 1 : len;
+  bool handedOver = false;
+  {
+  MutexLockGuard lock(stage->mutex);
+  while (stage->current->avail() <= needed)
+  {
+    BufferPtr next;
+    if (stage->spare)
+    {
+      next = std::move(stage->spare);
+    }
+    else if (buffersInFlight_.get() < maxBuffers_)
+    {
+      next.reset(new Buffer);
+    }
+    if (next)
     {
-      currentBuffer_ = std::move(nextBuffer_);
+      Chunk chunk(stage, std::move(stage->current));
+      if (fullBuffers_.tryPush(std::move(chunk)))
+      {
+        ++stage->inFlight;
+        ++stage->queued;
+        buffersInFlight_.increment();
+        stage->current = std::move(next);
+        handedOver = true;
+        break;
+      }
+      stage->current = std::move(chunk.buffer);
+      if (!stage->spare)
+      {
+        stage->spare = std::move(next);
+      }
     }
-    else
+    if (policy_ != kBlock || !running_)
     {
-      currentBuffer_.reset(new Buffer); // Rarely happens
+      droppedMessages_.increment();
+      droppedBytes_.add(len);
+      return;
     }
-    currentBuffer_->append(logline, len);
+    wakeup(false);
+    // returned is notified when a buffer comes back, but not when
+    // the backend makes room in a full queue, so check that again soon.
+    // the backend may steal current meanwhile.
+    stage->returned.waitForSeconds(stage->spare ? kQueueFullWait : flushInterval_);
+  }
+  stage->current->append(logline, len);
+  if (truncated)
+  {
+    stage->current->append("\n", 1);
+  }
+  }
+
+  if (handedOver)
+  {
+    wakeup(false);
+  }
+}
+
+AsyncLogging::Stage* AsyncLogging::currentStage()
+{
+  StageHolder& holder = holder_.value();
+  if (!holder.stage)
+  {
+    Stage* stage = new Stage;
+    stage->current.reset(new Buffer);
+    stage->spare.reset(new Buffer);
+    holder.stage = stage;
+    MutexLockGuard lock(mutex_);
+    stages_.push_back(stage);
+  }
+  return holder.stage;
+}
+
+void AsyncLogging::wakeup(bool force)
+{
+  // backend checks fullBuffers_ after setting sleeping_,
+  // only the first one to clear it needs to signal.
+  if (force || (sleeping_.load() && sleeping_.exchange(false)))
+  {
+    MutexLockGuard lock(mutex_);
     cond_.notify();
   }
 }
@@ -60,77 +192,161 @@ void AsyncLogging::threadFunc()
   assert(running_ == true);
   latch_.countDown();
   LogFile output(basename_, rollSize_, false);
-  BufferPtr newBuffer1(new Buffer);
-  BufferPtr newBuffer2(new Buffer);
-  newBuffer1->bzero();
-  newBuffer2->bzero();
-  BufferVector buffersToWrite;
-  buffersToWrite.reserve(16);
+  std::vector<Chunk> chunks;
+  chunks.reserve(16);
+  Timestamp lastSteal(Timestamp::now());
   while (running_)
   {
-    assert(newBuffer1 && newBuffer1->length() == 0);
-    assert(newBuffer2 && newBuffer2->length() == 0);
-    assert(buffersToWrite.empty());
-
     {
       muduo::MutexLockGuard lock(mutex_);
-      if (buffers_.empty())  // unusual usage!
+      sleeping_.store(true);
+      if (running_ && fullBuffers_.empty())
       {
         cond_.waitForSeconds(flushInterval_);
       }
-      buffers_.push_back(std::move(currentBuffer_));
-      currentBuffer_ = std::move(newBuffer1);
-      buffersToWrite.swap(buffers_);
-      if (!nextBuffer_)
-      {
-        nextBuffer_ = std::move(newBuffer2);
-      }
+      sleeping_.store(false);
     }
 
-    assert(!buffersToWrite.empty());
-
-    if (buffersToWrite.size() > 25)
+    collect(&chunks);
+    // buffers of threads that log slowly are taken every flushInterval_.
+    Timestamp now(Timestamp::now());
+    if (chunks.empty() || timeDifference(now, lastSteal) >= flushInterval_)
     {
-      char buf[256];
-      snprintf(buf, sizeof buf, "Dropped log messages at %s, %zd larger buffers\n",
-               Timestamp::now().toFormattedString().c_str(),
-               buffersToWrite.size()-2);
-      fputs(buf, stderr);
-      output.append(buf, static_cast<int>(strlen(buf)));
-      buffersToWrite.erase(buffersToWrite.begin()+2, buffersToWrite.end());
+      steal(&chunks);
+      lastSteal = now;
     }
+    reportDropped(&output);
+    write(&output, chunks);
+    recycle(&chunks);
+    output.flush();
+  }
+
+  // a stage skipped by steal() has its chunks collected the next round
+  do
+  {
+    collect(&chunks);
+  } while (steal(&chunks));
+  reportDropped(&output);
+  write(&output, chunks);
+  recycle(&chunks);
+  output.flush();
+}
 
-    for (const auto& buffer : buffersToWrite)
+void AsyncLogging::collect(std::vector<Chunk>* chunks)
+{
+  Chunk chunk;
+  while (fullBuffers_.tryPop(&chunk))
+  {
     {
-      // FIXME: use unbuffered stdio FILE ? or use ::writev ?
-      output.append(buffer->data(), buffer->length());
+    MutexLockGuard lock(chunk.stage->mutex);
+    --chunk.stage->queued;
     }
+    chunks->push_back(std::move(chunk));
+  }
+}
+
+bool AsyncLogging::steal(std::vector<Chunk>* chunks)
+{
+  // stages are only deleted in this thread, so a copy is safe to use.
+  std::vector<Stage*> stages;
+  {
+    MutexLockGuard lock(mutex_);
+    stages = stages_;
+  }
 
-    if (buffersToWrite.size() > 2)
+  bool skipped = false;
+  for (Stage* stage : stages)
+  {
+    bool exited = false;
     {
-      // drop non-bzero-ed buffers, avoid trashing
-      buffersToWrite.resize(2);
+      MutexLockGuard lock(stage->mutex);
+      if (stage->queued > 0)
+      {
+        // filled after collect(), written next round, current after it.
+        skipped = true;
+      }
+      else if (stage->current->length() > 0)
+      {
+        chunks->push_back(Chunk(stage, std::move(stage->current)));
+        ++stage->inFlight;
+        buffersInFlight_.increment();
+        stage->current = newBuffer();
+      }
+      exited = stage->exited && stage->inFlight == 0;
     }
 
-    if (!newBuffer1)
+    if (exited)
     {
-      assert(!buffersToWrite.empty());
-      newBuffer1 = std::move(buffersToWrite.back());
-      buffersToWrite.pop_back();
-      newBuffer1->reset();
+      {
+        MutexLockGuard lock(mutex_);
+        stages_.erase(std::find(stages_.begin(), stages_.end(), stage));
+      }
+      delete stage;
     }
+  }
+  return skipped;
+}
+
+void AsyncLogging::write(LogFile* output, const std::vector<Chunk>& chunks)
+{
+  if (chunks.empty())
+  {
+    return;
+  }
+  std::vector<struct iovec> iov(chunks.size());
+  for (size_t i = 0; i < chunks.size(); ++i)
+  {
+    iov[i].iov_base = const_cast<char*>(chunks[i].buffer->data());
+    iov[i].iov_len = static_cast<size_t>(chunks[i].buffer->length());
+  }
+  output->append(iov.data(), static_cast<int>(iov.size()));
+}
 
-    if (!newBuffer2)
+void AsyncLogging::recycle(std::vector<Chunk>* chunks)
+{
+  for (Chunk& chunk : *chunks)
+  {
+    chunk.buffer->reset();
+    Stage* stage = chunk.stage;
+    MutexLockGuard lock(stage->mutex);
+    --stage->inFlight;
+    buffersInFlight_.decrement();
+    if (!stage->spare)
     {
-      assert(!buffersToWrite.empty());
-      newBuffer2 = std::move(buffersToWrite.back());
-      buffersToWrite.pop_back();
-      newBuffer2->reset();
+      stage->spare = std::move(chunk.buffer);
+      stage->returned.notify();
     }
+    else if (freeBuffers_.size() < kMaxFreeBuffers)
+    {
+      freeBuffers_.push_back(std::move(chunk.buffer));
+    }
+  }
+  chunks->clear();
+}
 
-    buffersToWrite.clear();
-    output.flush();
+void AsyncLogging::reportDropped(LogFile* output)
+{
+  int64_t dropped = droppedMessages_.get();
+  if (dropped != reportedDropped_)
+  {
+    char buf[256];
+    snprintf(buf, sizeof buf, "Dropped %lld log messages at %s, %lld in total\n",
+             static_cast<long long>(dropped - reportedDropped_),
+             Timestamp::now().toFormattedString().c_str(),
+             static_cast<long long>(dropped));
+    fputs(buf, stderr);
+    output->append(buf, static_cast<int>(strlen(buf)));
+    reportedDropped_ = dropped;
   }
-  output.flush();
 }
 
+AsyncLogging::BufferPtr AsyncLogging::newBuffer()
+{
+  if (freeBuffers_.empty())
+  {
+    return BufferPtr(new Buffer);
+  }
+  BufferPtr buffer(std::move(freeBuffers_.back()));
+  freeBuffers_.pop_back();
+  return buffer;
+}
@@ -6,11 +6,12 @@
 #ifndef MUDUO_BASE_ASYNCLOGGING_H
 #define MUDUO_BASE_ASYNCLOGGING_H
 
-#include "muduo/base/BlockingQueue.h"
-#include "muduo/base/BoundedBlockingQueue.h"
+#include "muduo/base/Atomic.h"
 #include "muduo/base/CountDownLatch.h"
+#include "muduo/base/MpscQueue.h"
 #include "muduo/base/Mutex.h"
 #include "muduo/base/Thread.h"
+#include "muduo/base/ThreadLocal.h"
 #include "muduo/base/LogStream.h"
 
 #include <atomic>
@@ -19,21 +20,34 @@
 namespace muduo
 {
 
+class LogFile;
+
+///
+/// Every logging thread appends to a buffer of its own, which is handed
+/// to the backend thread through a lock-free queue when it's full,
+/// the backend writes them out with writev(2).
+///
+/// A thread has two buffers of its own, and takes more while fewer than
+/// maxBuffers of all threads are waiting to be written. Past that,
+/// or if the queue is full, the policy decides whether to drop the message
+/// or block the thread. A message longer than a buffer is truncated.
+///
 class AsyncLogging : noncopyable
 {
  public:
+  enum BackpressurePolicy
+  {
+    kDrop,   // counts and drops messages, never blocks
+    kBlock,  // waits for the backend, never drops
+  };
 
   AsyncLogging(const string& basename,
                off_t rollSize,
-               int flushInterval = 3);
+               int flushInterval = 3,
+               BackpressurePolicy policy = kDrop,
+               int maxBuffers = 25);
 
-  ~AsyncLogging()
-  {
-    if (running_)
-    {
-      stop();
-    }
-  }
+  ~AsyncLogging();
 
   void append(const char* logline, int len);
 
@@ -44,32 +58,72 @@ class AsyncLogging : noncopyable
     latch_.wait();
   }
 
-  void stop() NO_THREAD_SAFETY_ANALYSIS
+  void stop()
   {
     running_ = false;
-    cond_.notify();
+    wakeup(true);
     thread_.join();
   }
 
+  int64_t droppedMessages() const { return droppedMessages_.get(); }
+  int64_t droppedBytes() const { return droppedBytes_.get(); }
+
  private:
+  typedef muduo::detail::FixedBuffer<muduo::detail::kLargeBuffer> Buffer;
+  typedef std::unique_ptr<Buffer> BufferPtr;
 
-  void threadFunc();
+  // per-thread buffers, deleted by backend thread after its thread exits.
+  struct Stage;
 
-  typedef muduo::detail::FixedBuffer<muduo::detail::kLargeBuffer> Buffer;
-  typedef std::vector<std::unique_ptr<Buffer>> BufferVector;
-  typedef BufferVector::value_type BufferPtr;
+  struct StageHolder
+  {
+    StageHolder() : stage(NULL) { }
+    ~StageHolder();
+    Stage* stage;
+  };
+
+  struct Chunk
+  {
+    Chunk() : stage(NULL) { }
+    Chunk(Stage* s, BufferPtr&& b) : stage(s), buffer(std::move(b)) { }
+    Stage* stage;
+    BufferPtr buffer;
+  };
+
+  void threadFunc();
+  Stage* currentStage();
+  void wakeup(bool force);
+  // backend thread only
+  void collect(std::vector<Chunk>* chunks);
+  // returns true if a stage was skipped, for chunks not collected yet
+  bool steal(std::vector<Chunk>* chunks);
+  void write(LogFile* output, const std::vector<Chunk>& chunks);
+  void recycle(std::vector<Chunk>* chunks);
+  void reportDropped(LogFile* output);
+  BufferPtr newBuffer();
 
   const int flushInterval_;
+  const BackpressurePolicy policy_;
+  const int maxBuffers_;
   std::atomic<bool> running_;
   const string basename_;
   const off_t rollSize_;
   muduo::Thread thread_;
   muduo::CountDownLatch latch_;
+  muduo::ThreadLocal<StageHolder> holder_;
+  MpscQueue<Chunk> fullBuffers_;
+  // set while backend waits on cond_
+  std::atomic<bool> sleeping_;
+  mutable AtomicInt64 droppedMessages_;
+  mutable AtomicInt64 droppedBytes_;
+  // buffers of all threads owned by backend
+  AtomicInt32 buffersInFlight_;
   muduo::MutexLock mutex_;
   muduo::Condition cond_ GUARDED_BY(mutex_);
-  BufferPtr currentBuffer_ GUARDED_BY(mutex_);
-  BufferPtr nextBuffer_ GUARDED_BY(mutex_);
-  BufferVector buffers_ GUARDED_BY(mutex_);
+  std::vector<Stage*> stages_ GUARDED_BY(mutex_);
+  // owned by backend thread
+  std::vector<BufferPtr> freeBuffers_;
+  int64_t reportedDropped_;
 };
 
 }  // namespace muduo
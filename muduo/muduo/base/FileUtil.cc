@@ -10,9 +10,14 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <limits.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <vector>
+
 using namespace muduo;
 
 FileUtil::AppendFile::AppendFile(StringArg filename)
@@ -52,6 +57,40 @@ void FileUtil::AppendFile::append(const char* logline, const size_t len)
   writtenBytes_ += len;
 }
 
+void FileUtil::AppendFile::append(const struct iovec* iov, int iovcnt)
+{
+  // keeps the order with what is buffered in fp_
+  ::fflush(fp_);
+  std::vector<struct iovec> vec(iov, iov + iovcnt);
+  size_t i = 0;
+  while (i < vec.size())
+  {
+    int n = static_cast<int>(std::min(vec.size() - i, static_cast<size_t>(IOV_MAX)));
+    ssize_t nw = ::writev(::fileno(fp_), &vec[i], n);
+    if (nw < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      fprintf(stderr, "AppendFile::append() failed %s\n", strerror_tl(errno));
+      break;
+    }
+    writtenBytes_ += nw;
+    size_t x = static_cast<size_t>(nw);
+    while (i < vec.size() && x >= vec[i].iov_len)
+    {
+      x -= vec[i].iov_len;
+      ++i;
+    }
+    if (x > 0)
+    {
+      vec[i].iov_base = static_cast<char*>(vec[i].iov_base) + x;
+      vec[i].iov_len -= x;
+    }
+  }
+}
+
 void FileUtil::AppendFile::flush()
 {
   ::fflush(fp_);
@@ -12,6 +12,8 @@
 #include "muduo/base/StringPiece.h"
 #include <sys/types.h>  // for off_t
 
+struct iovec;
+
 namespace muduo
 {
 namespace FileUtil
@@ -69,6 +71,9 @@ class AppendFile : noncopyable
 
   void append(const char* logline, size_t len);
 
+  /// Writes many pieces with writev(2), after flushing stdio buffer.
+  void append(const struct iovec* iov, int iovcnt);
+
   void flush();
 
   off_t writtenBytes() const { return writtenBytes_; }
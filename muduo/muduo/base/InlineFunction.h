@@ -0,0 +1,188 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_INLINEFUNCTION_H
+#define MUDUO_BASE_INLINEFUNCTION_H
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace muduo
+{
+
+///
+/// A copyable callable of void(), like std::function<void()>,
+/// but a callable of up to kInlineSize bytes is stored in the object itself.
+///
+/// std::function of libstdc++ only keeps two pointers inline, so
+/// std::bind(&TcpConnection::sendInLoop, this, message) or a lambda capturing
+/// a shared_ptr and a string goes to the heap. EventLoop queues functors
+/// in a preallocated ring, with InlineFunction such a functor is not
+/// allocated either. Larger ones, or ones which may throw when moved,
+/// are still stored on the heap.
+///
+class InlineFunction
+{
+ public:
+  static const size_t kInlineSize = 56;
+
+  InlineFunction() noexcept
+    : ops_(NULL)
+  {
+  }
+
+  InlineFunction(std::nullptr_t) noexcept
+    : ops_(NULL)
+  {
+  }
+
+  template<typename F,
+           typename = typename std::enable_if<
+               !std::is_same<typename std::decay<F>::type, InlineFunction>::value>::type>
+  InlineFunction(F&& f)
+    : ops_(opsOf<typename std::decay<F>::type>())
+  {
+    Manager<typename std::decay<F>::type>::create(storage_, std::forward<F>(f));
+  }
+
+  InlineFunction(const InlineFunction& rhs)
+    : ops_(rhs.ops_)
+  {
+    if (ops_)
+    {
+      ops_->copy(storage_, rhs.storage_);
+    }
+  }
+
+  InlineFunction(InlineFunction&& rhs) noexcept
+    : ops_(rhs.ops_)
+  {
+    if (ops_)
+    {
+      ops_->move(storage_, rhs.storage_);
+      rhs.ops_ = NULL;
+    }
+  }
+
+  ~InlineFunction()
+  {
+    reset();
+  }
+
+  InlineFunction& operator=(const InlineFunction& rhs)
+  {
+    if (this != &rhs)
+    {
+      InlineFunction tmp(rhs);
+      *this = std::move(tmp);
+    }
+    return *this;
+  }
+
+  InlineFunction& operator=(InlineFunction&& rhs) noexcept
+  {
+    if (this != &rhs)
+    {
+      reset();
+      if (rhs.ops_)
+      {
+        rhs.ops_->move(storage_, rhs.storage_);
+        ops_ = rhs.ops_;
+        rhs.ops_ = NULL;
+      }
+    }
+    return *this;
+  }
+
+  InlineFunction& operator=(std::nullptr_t) noexcept
+  {
+    reset();
+    return *this;
+  }
+
+  void operator()() const
+  {
+    if (!ops_)
+    {
+      throw std::bad_function_call();
+    }
+    ops_->invoke(storage_);
+  }
+
+  explicit operator bool() const noexcept
+  {
+    return ops_ != NULL;
+  }
+
+  /// Stored in the object, not on the heap.
+  template<typename F>
+  static constexpr bool storedInline()
+  {
+    return sizeof(F) <= kInlineSize
+        && alignof(F) <= alignof(std::max_align_t)
+        && std::is_nothrow_move_constructible<F>::value;
+  }
+
+ private:
+  struct Ops
+  {
+    void (*invoke)(void*);
+    void (*copy)(void* dst, const void* src);
+    // moves to dst and destroys src
+    void (*move)(void* dst, void* src);
+    void (*destroy)(void*);
+  };
+
+  template<typename F, bool = storedInline<F>()>
+  struct Manager
+  {
+    template<typename G>
+    static void create(void* p, G&& f) { new (p) F(std::forward<G>(f)); }
+    static F* get(void* p) { return static_cast<F*>(p); }
+    static void invoke(void* p) { (*get(p))(); }
+    static void copy(void* dst, const void* src) { new (dst) F(*static_cast<const F*>(src)); }
+    static void move(void* dst, void* src) { new (dst) F(std::move(*get(src))); get(src)->~F(); }
+    static void destroy(void* p) { get(p)->~F(); }
+  };
+
+  template<typename F>
+  struct Manager<F, false>
+  {
+    template<typename G>
+    static void create(void* p, G&& f) { *static_cast<F**>(p) = new F(std::forward<G>(f)); }
+    static F* get(void* p) { return *static_cast<F**>(p); }
+    static void invoke(void* p) { (*get(p))(); }
+    static void copy(void* dst, const void* src) { *static_cast<F**>(dst) = new F(**static_cast<F* const*>(src)); }
+    static void move(void* dst, void* src) { *static_cast<F**>(dst) = get(src); }
+    static void destroy(void* p) { delete get(p); }
+  };
+
+  template<typename F>
+  static const Ops* opsOf()
+  {
+    static const Ops ops = { &Manager<F>::invoke, &Manager<F>::copy,
+                             &Manager<F>::move, &Manager<F>::destroy };
+    return &ops;
+  }
+
+  void reset() noexcept
+  {
+    if (ops_)
+    {
+      ops_->destroy(storage_);
+      ops_ = NULL;
+    }
+  }
+
+  alignas(std::max_align_t) mutable unsigned char storage_[kInlineSize];
+  const Ops* ops_;
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_INLINEFUNCTION_H
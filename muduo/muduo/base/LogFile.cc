@@ -48,6 +48,19 @@ void LogFile::append(const char* logline, int len)
   }
 }
 
+void LogFile::append(const struct iovec* iov, int iovcnt)
+{
+  if (mutex_)
+  {
+    MutexLockGuard lock(*mutex_);
+    append_unlocked(iov, iovcnt);
+  }
+  else
+  {
+    append_unlocked(iov, iovcnt);
+  }
+}
+
 void LogFile::flush()
 {
   if (mutex_)
@@ -64,7 +77,17 @@ void LogFile::flush()
 void LogFile::append_unlocked(const char* logline, int len)
 {
   file_->append(logline, len);
+  rollOrFlush();
+}
 
+void LogFile::append_unlocked(const struct iovec* iov, int iovcnt)
+{
+  file_->append(iov, iovcnt);
+  rollOrFlush();
+}
+
+void LogFile::rollOrFlush()
+{
   if (file_->writtenBytes() > rollSize_)
   {
     rollFile();
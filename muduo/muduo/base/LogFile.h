@@ -11,6 +11,8 @@
 
 #include <memory>
 
+struct iovec;
+
 namespace muduo
 {
 
@@ -30,11 +32,15 @@ class LogFile : noncopyable
   ~LogFile();
 
   void append(const char* logline, int len);
+  /// Appends many buffers with one writev(2).
+  void append(const struct iovec* iov, int iovcnt);
   void flush();
   bool rollFile();
 
  private:
   void append_unlocked(const char* logline, int len);
+  void append_unlocked(const struct iovec* iov, int iovcnt);
+  void rollOrFlush();
 
   static string getLogFileName(const string& basename, time_t* now);
 
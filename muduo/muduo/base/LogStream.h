@@ -75,6 +75,9 @@ class FixedBuffer : noncopyable
   char* cur_;
 };
 
+// Writes value < 10^8 in exactly 8 digits, with leading zeros, no NUL.
+void formatEightDigits(char buf[], uint32_t value);
+
 }  // namespace detail
 
 class LogStream : noncopyable
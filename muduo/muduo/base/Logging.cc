@@ -148,23 +148,32 @@ void Logger::Impl::formatTime()
       ::gmtime_r(&seconds, &tm_time); // FIXME TimeZone::fromUtcTime
     }
 
-    int len = snprintf(t_time, sizeof(t_time), "%4d%02d%02d %02d:%02d:%02d",
-        tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday,
-        tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec);
-    assert(len == 17); (void)len;
+    // "YYYYMMDD HH:MM:SS", with the digits of "00HHMMSS"
+    detail::formatEightDigits(t_time, static_cast<uint32_t>(
+        (tm_time.tm_year + 1900) * 10000 + (tm_time.tm_mon + 1) * 100 + tm_time.tm_mday));
+    char hms[8];
+    detail::formatEightDigits(hms, static_cast<uint32_t>(
+        tm_time.tm_hour * 10000 + tm_time.tm_min * 100 + tm_time.tm_sec));
+    const char hhmmss[] = { ' ', hms[2], hms[3], ':', hms[4], hms[5], ':', hms[6], hms[7], '\0' };
+    memcpy(t_time + 8, hhmmss, sizeof hhmmss);
   }
 
+  // ".uuuuuu " or ".uuuuuuZ ", with the digits of "00uuuuuu"
+  char us[12];
+  detail::formatEightDigits(us, static_cast<uint32_t>(microseconds));
+  us[1] = '.';
   if (g_logTimeZone.valid())
   {
-    Fmt us(".%06d ", microseconds);
-    assert(us.length() == 8);
-    stream_ << T(t_time, 17) << T(us.data(), 8);
+    us[8] = ' ';
+    us[9] = '\0';
+    stream_ << T(t_time, 17) << T(us + 1, 8);
   }
   else
   {
-    Fmt us(".%06dZ ", microseconds);
-    assert(us.length() == 9);
-    stream_ << T(t_time, 17) << T(us.data(), 9);
+    us[8] = 'Z';
+    us[9] = ' ';
+    us[10] = '\0';
+    stream_ << T(t_time, 17) << T(us + 1, 9);
   }
 }
 
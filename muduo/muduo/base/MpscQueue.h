@@ -0,0 +1,132 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_MPSCQUEUE_H
+#define MUDUO_BASE_MPSCQUEUE_H
+
+#include "muduo/base/noncopyable.h"
+
+#include <atomic>
+#include <memory>
+#include <assert.h>
+#include <stdint.h>
+
+namespace muduo
+{
+
+///
+/// Bounded lock-free queue, for many producers and one consumer.
+///
+/// Elements live in a preallocated ring, so push() and pop() don't allocate.
+/// Each cell carries a sequence number, as in Dmitry Vyukov's bounded queue,
+/// a producer claims a cell with a CAS on tail, then publishes it.
+/// Producers never block, tryPush() returns false if the ring is full.
+///
+template<typename T>
+class MpscQueue : noncopyable
+{
+ public:
+  /// capacity must be a power of 2
+  explicit MpscQueue(size_t capacity)
+    : mask_(capacity - 1),
+      cells_(new Cell[capacity]),
+      tail_(0),
+      head_(0)
+  {
+    assert(capacity >= 2 && (capacity & mask_) == 0);
+    for (size_t i = 0; i < capacity; ++i)
+    {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /// Thread safe, x is left untouched if it returns false.
+  bool tryPush(T&& x)
+  {
+    Cell* cell;
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0)
+      {
+        if (tail_.compare_exchange_weak(pos, pos + 1))
+        {
+          break;
+        }
+      }
+      else if (diff < 0)
+      {
+        return false;
+      }
+      else
+      {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->value = std::move(x);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Consumer thread only.
+  /// Returns false if empty, or the next element is not published yet.
+  bool tryPop(T* x)
+  {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    Cell* cell = &cells_[pos & mask_];
+    size_t seq = cell->sequence.load(std::memory_order_acquire);
+    if (seq != pos + 1)
+    {
+      return false;
+    }
+    *x = std::move(cell->value);
+    cell->value = T();
+    cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    head_.store(pos + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  /// False once an element is claimed, even if not published yet.
+  /// Sequentially consistent with tryPush(), see EventLoop::loop().
+  bool empty() const
+  {
+    return tail_.load() == head_.load();
+  }
+
+  /// Approximate
+  size_t size() const
+  {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+  }
+
+  size_t capacity() const
+  {
+    return mask_ + 1;
+  }
+
+ private:
+  struct Cell
+  {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  const size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+  // producers and consumer on separate cache lines
+  char pad0_[64];
+  std::atomic<size_t> tail_;
+  char pad1_[64];
+  std::atomic<size_t> head_;
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_MPSCQUEUE_H
@@ -8,6 +8,7 @@
 #include "muduo/base/Date.h"
 
 #include <algorithm>
+#include <limits>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -73,6 +74,18 @@ struct Localtime
   { }
 };
 
+// [begin, end) in UTC, between two transitions
+struct Period
+{
+  time_t begin;
+  time_t end;
+  int localtimeIdx;
+
+  Period(time_t b, time_t e, int localIdx)
+    : begin(b), end(e), localtimeIdx(localIdx)
+  { }
+};
+
 inline void fillHMS(unsigned seconds, struct tm* utc)
 {
   utc->tm_sec = seconds % 60;
@@ -94,6 +107,8 @@ struct TimeZone::Data
   vector<detail::Localtime> localtimes;
   vector<string> names;
   string abbreviation;
+  // covers all time, sorted, built from transitions for toLocalTime()
+  vector<detail::Period> periods;
 };
 
 namespace muduo
@@ -254,6 +269,57 @@ const Localtime* findLocaltime(const TimeZone::Data& data, Transition sentry, Co
   return local;
 }
 
+// Same result as findLocaltime(data, Transition(gmt, 0, 0), Comp(true))
+void buildPeriods(TimeZone::Data* data)
+{
+  if (data->localtimes.empty())
+  {
+    return;
+  }
+  const time_t kMin = std::numeric_limits<time_t>::min();
+  const time_t kMax = std::numeric_limits<time_t>::max();
+  const vector<Transition>& trans = data->transitions;
+  // FIXME: should be first non dst time zone
+  data->periods.push_back(Period(kMin, trans.empty() ? kMax : trans.front().gmttime, 0));
+  for (size_t i = 0; i < trans.size(); ++i)
+  {
+    time_t end = i + 1 < trans.size() ? trans[i+1].gmttime : kMax;
+    data->periods.push_back(Period(trans[i].gmttime, end, trans[i].localtimeIdx));
+  }
+}
+
+// period found last in this thread, most likely the current one.
+// a zone freed and another allocated at the same address only misses.
+__thread const TimeZone::Data* t_lastZone = NULL;
+__thread size_t t_lastPeriod = 0;
+
+const Localtime* findPeriod(const TimeZone::Data& data, time_t gmt)
+{
+  const vector<Period>& periods = data.periods;
+  if (t_lastZone == &data && t_lastPeriod < periods.size())
+  {
+    const Period& last = periods[t_lastPeriod];
+    if (last.begin <= gmt && gmt < last.end)
+    {
+      return &data.localtimes[last.localtimeIdx];
+    }
+  }
+
+  // the first period ends after gmt
+  size_t low = 0, high = periods.size() - 1;
+  while (low < high)
+  {
+    size_t mid = low + (high - low) / 2;
+    if (periods[mid].end <= gmt)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  t_lastZone = &data;
+  t_lastPeriod = low;
+  return &data.localtimes[periods[low].localtimeIdx];
+}
+
 }  // namespace detail
 }  // namespace muduo
 
@@ -265,6 +331,10 @@ TimeZone::TimeZone(const char* zonefile)
   {
     data_.reset();
   }
+  else
+  {
+    detail::buildPeriods(data_.get());
+  }
 }
 
 TimeZone::TimeZone(int eastOfUtc, const char* name)
@@ -272,6 +342,7 @@ TimeZone::TimeZone(int eastOfUtc, const char* name)
 {
   data_->localtimes.push_back(detail::Localtime(eastOfUtc, false, 0));
   data_->abbreviation = name;
+  detail::buildPeriods(data_.get());
 }
 
 struct tm TimeZone::toLocalTime(time_t seconds) const
@@ -281,8 +352,16 @@ struct tm TimeZone::toLocalTime(time_t seconds) const
   assert(data_ != NULL);
   const Data& data(*data_);
 
-  detail::Transition sentry(seconds, 0, 0);
-  const detail::Localtime* local = findLocaltime(data, sentry, detail::Comp(true));
+  const detail::Localtime* local = NULL;
+  if (!data.periods.empty())
+  {
+    local = detail::findPeriod(data, seconds);
+  }
+  else
+  {
+    detail::Transition sentry(seconds, 0, 0);
+    local = findLocaltime(data, sentry, detail::Comp(true));
+  }
 
   if (local)
   {
@@ -0,0 +1,168 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_WORKSTEALINGDEQUE_H
+#define MUDUO_BASE_WORKSTEALINGDEQUE_H
+
+#include "muduo/base/noncopyable.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <assert.h>
+#include <stdint.h>
+
+namespace muduo
+{
+
+///
+/// Lock-free deque of pointers, one owner and many thieves.
+///
+/// The owner pushes and pops at the bottom (LIFO), other threads steal
+/// from the top (FIFO). This is the Chase-Lev deque, with memory orders
+/// of Le, Pop, Cohen and Zappa Nardelli, "Correct and Efficient
+/// Work-Stealing for Weak Memory Models", PPoPP 2013.
+///
+/// The ring grows when full, old rings are kept until destruction,
+/// since a thief may still read from them. Elements are not owned.
+///
+template<typename T>
+class WorkStealingDeque : noncopyable
+{
+ public:
+  /// capacity must be a power of 2
+  explicit WorkStealingDeque(size_t capacity = 256)
+    : top_(0),
+      bottom_(0)
+  {
+    assert(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+    rings_.emplace_back(new Ring(capacity));
+    ring_.store(rings_.back().get(), std::memory_order_relaxed);
+  }
+
+  /// Owner thread only, never fails.
+  void push(T* x)
+  {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_acquire);
+    Ring* ring = ring_.load(std::memory_order_relaxed);
+    if (b - t > static_cast<int64_t>(ring->mask))
+    {
+      ring = grow(ring, t, b);
+    }
+    ring->put(b, x);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+  }
+
+  /// Owner thread only, returns NULL if empty.
+  T* pop()
+  {
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    Ring* ring = ring_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b)
+    {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return NULL;
+    }
+    T* x = ring->get(b);
+    if (t == b)
+    {
+      // the last one, race with thieves
+      if (!top_.compare_exchange_strong(t, t + 1,
+                                        std::memory_order_seq_cst,
+                                        std::memory_order_relaxed))
+      {
+        x = NULL;
+      }
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return x;
+  }
+
+  /// Thread safe, returns NULL if empty or lost a race to another thread.
+  T* steal()
+  {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b)
+    {
+      return NULL;
+    }
+    // FIXME: memory_order_consume
+    Ring* ring = ring_.load(std::memory_order_acquire);
+    T* x = ring->get(t);
+    if (!top_.compare_exchange_strong(t, t + 1,
+                                      std::memory_order_seq_cst,
+                                      std::memory_order_relaxed))
+    {
+      return NULL;
+    }
+    return x;
+  }
+
+  /// Approximate
+  size_t size() const
+  {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    return b > t ? static_cast<size_t>(b - t) : 0;
+  }
+
+  bool empty() const
+  {
+    return size() == 0;
+  }
+
+ private:
+  struct Ring
+  {
+    explicit Ring(size_t capacity)
+      : mask(capacity - 1),
+        slots(new std::atomic<T*>[capacity])
+    {
+    }
+
+    T* get(int64_t i) const
+    {
+      return slots[static_cast<size_t>(i) & mask].load(std::memory_order_relaxed);
+    }
+
+    void put(int64_t i, T* x)
+    {
+      slots[static_cast<size_t>(i) & mask].store(x, std::memory_order_relaxed);
+    }
+
+    const size_t mask;
+    std::unique_ptr<std::atomic<T*>[]> slots;
+  };
+
+  Ring* grow(Ring* ring, int64_t t, int64_t b)
+  {
+    Ring* bigger = new Ring(2 * (ring->mask + 1));
+    for (int64_t i = t; i < b; ++i)
+    {
+      bigger->put(i, ring->get(i));
+    }
+    rings_.emplace_back(bigger);
+    ring_.store(bigger, std::memory_order_release);
+    return bigger;
+  }
+
+  // thieves and owner on separate cache lines
+  std::atomic<int64_t> top_;
+  char pad0_[64];
+  std::atomic<int64_t> bottom_;
+  std::atomic<Ring*> ring_;
+  std::vector<std::unique_ptr<Ring>> rings_;  // owner only
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_WORKSTEALINGDEQUE_H
@@ -0,0 +1,554 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/base/WorkStealingThreadPool.h"
+
+#include "muduo/base/Exception.h"
+#include "muduo/base/WorkStealingDeque.h"
+
+#include <algorithm>
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+
+using namespace muduo;
+
+namespace
+{
+const size_t kDefaultRingSize = 16 * 1024;
+const size_t kMaxBatch = 32;
+
+// the pool and index of worker running in this thread
+__thread const void* t_pool = NULL;
+__thread int t_workerIndex = -1;
+}
+
+// Bounded lock-free queue for many producers and many consumers,
+// MpscQueue with a CAS on head.
+class WorkStealingThreadPool::Injector : noncopyable
+{
+ public:
+  explicit Injector(size_t capacity)
+    : mask_(capacity - 1),
+      cells_(new Cell[capacity]),
+      tail_(0),
+      head_(0)
+  {
+    assert(capacity >= 2 && (capacity & mask_) == 0);
+    for (size_t i = 0; i < capacity; ++i)
+    {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+      cells_[i].task = NULL;
+    }
+  }
+
+  bool tryPush(Task* task)
+  {
+    Cell* cell;
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0)
+      {
+        if (tail_.compare_exchange_weak(pos, pos + 1))
+        {
+          break;
+        }
+      }
+      else if (diff < 0)
+      {
+        return false;
+      }
+      else
+      {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->task = task;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // returns NULL if empty
+  Task* tryPop()
+  {
+    Cell* cell;
+    size_t pos = head_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0)
+      {
+        if (head_.compare_exchange_weak(pos, pos + 1))
+        {
+          break;
+        }
+      }
+      else if (diff < 0)
+      {
+        return NULL;
+      }
+      else
+      {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+    Task* task = cell->task;
+    cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return task;
+  }
+
+  bool empty() const
+  {
+    return tail_.load() == head_.load();
+  }
+
+  bool full() const
+  {
+    return size() > mask_;
+  }
+
+  // Approximate
+  size_t size() const
+  {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+  }
+
+ private:
+  struct Cell
+  {
+    std::atomic<size_t> sequence;
+    Task* task;
+  };
+
+  const size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+  char pad0_[64];
+  std::atomic<size_t> tail_;
+  char pad1_[64];
+  std::atomic<size_t> head_;
+};
+
+struct WorkStealingThreadPool::Worker : noncopyable
+{
+  explicit Worker(uint32_t seedArg)
+    : seed(seedArg)
+  {
+  }
+
+  // xorshift, for choosing victims
+  uint32_t nextRandom()
+  {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+  }
+
+  WorkStealingDeque<Task> deque;
+  uint32_t seed;
+};
+
+WorkStealingThreadPool::WorkStealingThreadPool(const string& nameArg)
+  : mutex_(),
+    notEmpty_(mutex_),
+    notFull_(mutex_),
+    wakeups_(0),
+    name_(nameArg),
+    maxQueueSize_(0),
+    cpuAffinity_(false),
+    running_(false),
+    idleWorkers_(0),
+    blockedProducers_(0),
+    overflowSize_(0)
+{
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool()
+{
+  if (running_)
+  {
+    stop();
+  }
+  // tasks not run yet
+  if (injector_)
+  {
+    while (Task* task = injector_->tryPop())
+    {
+      delete task;
+    }
+  }
+  for (Task* task : overflow_)
+  {
+    delete task;
+  }
+  for (auto& worker : workers_)
+  {
+    while (Task* task = worker->deque.pop())
+    {
+      delete task;
+    }
+  }
+}
+
+void WorkStealingThreadPool::start(int numThreads)
+{
+  assert(threads_.empty());
+  size_t ringSize = kDefaultRingSize;
+  if (maxQueueSize_ > 0)
+  {
+    ringSize = 2;
+    while (ringSize < maxQueueSize_)
+    {
+      ringSize *= 2;
+    }
+  }
+  injector_.reset(new Injector(ringSize));
+
+  if (cpuAffinity_)
+  {
+    cpu_set_t allowed;
+    if (::sched_getaffinity(0, sizeof allowed, &allowed) == 0)
+    {
+      for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+      {
+        if (CPU_ISSET(cpu, &allowed))
+        {
+          cpus_.push_back(cpu);
+        }
+      }
+    }
+  }
+
+  running_ = true;
+  workers_.reserve(numThreads);
+  for (int i = 0; i < numThreads; ++i)
+  {
+    workers_.emplace_back(new Worker(2654435761u * (i+1)));
+  }
+  threads_.reserve(numThreads);
+  for (int i = 0; i < numThreads; ++i)
+  {
+    char id[32];
+    snprintf(id, sizeof id, "%d", i+1);
+    threads_.emplace_back(new muduo::Thread(
+          std::bind(&WorkStealingThreadPool::runInThread, this, i), name_+id));
+    threads_[i]->start();
+  }
+  if (numThreads == 0 && threadInitCallback_)
+  {
+    threadInitCallback_();
+  }
+}
+
+void WorkStealingThreadPool::stop()
+{
+  {
+  MutexLockGuard lock(mutex_);
+  running_ = false;
+  notEmpty_.notifyAll();
+  notFull_.notifyAll();
+  }
+  for (auto& thr : threads_)
+  {
+    thr->join();
+  }
+}
+
+size_t WorkStealingThreadPool::queueSize() const
+{
+  size_t size = injector_ ? injector_->size() : 0;
+  size += overflowSize_.load(std::memory_order_relaxed);
+  for (const auto& worker : workers_)
+  {
+    size += worker->deque.size();
+  }
+  return size;
+}
+
+void WorkStealingThreadPool::run(Task f)
+{
+  if (threads_.empty())
+  {
+    f();
+  }
+  else
+  {
+    push(new Task(std::move(f)));
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (idleWorkers_.load(std::memory_order_relaxed) > 0)
+    {
+      wakeUp(1);
+    }
+  }
+}
+
+void WorkStealingThreadPool::runBatch(std::vector<Task>* tasks)
+{
+  if (threads_.empty())
+  {
+    for (auto& task : *tasks)
+    {
+      task();
+    }
+  }
+  else
+  {
+    for (auto& task : *tasks)
+    {
+      push(new Task(std::move(task)));
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (idleWorkers_.load(std::memory_order_relaxed) > 0)
+    {
+      wakeUp(tasks->size());
+    }
+  }
+  tasks->clear();
+}
+
+void WorkStealingThreadPool::push(Task* task)
+{
+  if (t_pool == this)
+  {
+    workers_[t_workerIndex]->deque.push(task);
+    return;
+  }
+
+  while (!injector_->tryPush(task))
+  {
+    if (maxQueueSize_ == 0)
+    {
+      MutexLockGuard lock(mutex_);
+      overflow_.push_back(task);
+      overflowSize_.store(overflow_.size());
+      return;
+    }
+    // workers could be asleep if we are pushing a batch
+    wakeUp(workers_.size());
+    MutexLockGuard lock(mutex_);
+    blockedProducers_.fetch_add(1);
+    // pairs with the fence in notifyNotFull()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (injector_->full() && running_)
+    {
+      notFull_.wait();
+    }
+    blockedProducers_.fetch_sub(1);
+    if (!running_)
+    {
+      delete task;
+      return;
+    }
+  }
+}
+
+void WorkStealingThreadPool::wakeUp(size_t count)
+{
+  MutexLockGuard lock(mutex_);
+  size_t idle = static_cast<size_t>(idleWorkers_.load());
+  size_t n = std::min(count, idle > wakeups_ ? idle - wakeups_ : 0);
+  wakeups_ += n;
+  if (n > 0 && n == idle)
+  {
+    notEmpty_.notifyAll();
+  }
+  else
+  {
+    for (size_t i = 0; i < n; ++i)
+    {
+      notEmpty_.notify();
+    }
+  }
+}
+
+void WorkStealingThreadPool::park()
+{
+  MutexLockGuard lock(mutex_);
+  idleWorkers_.fetch_add(1);
+  // pairs with the fence in run(), either we see the task,
+  // or the producer sees us idle.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!hasWork())
+  {
+    // always use a while-loop, due to spurious wakeup
+    while (wakeups_ == 0 && running_)
+    {
+      notEmpty_.wait();
+    }
+    if (wakeups_ > 0)
+    {
+      --wakeups_;
+    }
+  }
+  idleWorkers_.fetch_sub(1);
+}
+
+void WorkStealingThreadPool::notifyNotFull()
+{
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (blockedProducers_.load(std::memory_order_relaxed) > 0)
+  {
+    MutexLockGuard lock(mutex_);
+    notFull_.notifyAll();
+  }
+}
+
+bool WorkStealingThreadPool::hasWork() const
+{
+  if (!injector_->empty() || overflowSize_.load() > 0)
+  {
+    return true;
+  }
+  for (const auto& worker : workers_)
+  {
+    if (!worker->deque.empty())
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+WorkStealingThreadPool::Task* WorkStealingThreadPool::take(Worker* self)
+{
+  if (Task* task = self->deque.pop())
+  {
+    return task;
+  }
+
+  // older than those in the ring
+  if (overflowSize_.load(std::memory_order_relaxed) > 0)
+  {
+    if (Task* task = takeOverflow(self))
+    {
+      return task;
+    }
+  }
+
+  if (Task* task = injector_->tryPop())
+  {
+    // take a fair share, so that idle workers could steal them from us
+    size_t batch = std::min(kMaxBatch, injector_->size() / workers_.size());
+    for (size_t i = 0; i < batch; ++i)
+    {
+      Task* more = injector_->tryPop();
+      if (more == NULL)
+      {
+        break;
+      }
+      self->deque.push(more);
+    }
+    notifyNotFull();
+    return task;
+  }
+
+  return steal(self);
+}
+
+WorkStealingThreadPool::Task* WorkStealingThreadPool::takeOverflow(Worker* self)
+{
+  MutexLockGuard lock(mutex_);
+  if (overflow_.empty())
+  {
+    return NULL;
+  }
+  Task* task = overflow_.front();
+  overflow_.pop_front();
+  size_t batch = std::min(kMaxBatch, overflow_.size() / workers_.size());
+  for (size_t i = 0; i < batch; ++i)
+  {
+    self->deque.push(overflow_.front());
+    overflow_.pop_front();
+  }
+  overflowSize_.store(overflow_.size());
+  return task;
+}
+
+WorkStealingThreadPool::Task* WorkStealingThreadPool::steal(Worker* self)
+{
+  const size_t n = workers_.size();
+  const size_t first = self->nextRandom() % n;
+  for (size_t i = 0; i < n; ++i)
+  {
+    Worker* victim = workers_[(first + i) % n].get();
+    if (victim == self)
+    {
+      continue;
+    }
+    // retry if lost a race
+    while (!victim->deque.empty())
+    {
+      if (Task* task = victim->deque.steal())
+      {
+        return task;
+      }
+    }
+  }
+  return NULL;
+}
+
+void WorkStealingThreadPool::runInThread(int index)
+{
+  t_pool = this;
+  t_workerIndex = index;
+  Worker* self = workers_[index].get();
+  try
+  {
+    if (!cpus_.empty())
+    {
+      cpu_set_t cpuset;
+      CPU_ZERO(&cpuset);
+      CPU_SET(cpus_[index % cpus_.size()], &cpuset);
+      if (::pthread_setaffinity_np(::pthread_self(), sizeof cpuset, &cpuset) != 0)
+      {
+        fprintf(stderr, "failed to set CPU affinity in %s\n", name_.c_str());
+      }
+    }
+    if (threadInitCallback_)
+    {
+      threadInitCallback_();
+    }
+    while (running_)
+    {
+      std::unique_ptr<Task> task(take(self));
+      if (task)
+      {
+        (*task)();
+      }
+      else
+      {
+        park();
+      }
+    }
+  }
+  catch (const Exception& ex)
+  {
+    fprintf(stderr, "exception caught in WorkStealingThreadPool %s\n", name_.c_str());
+    fprintf(stderr, "reason: %s\n", ex.what());
+    fprintf(stderr, "stack trace: %s\n", ex.stackTrace());
+    abort();
+  }
+  catch (const std::exception& ex)
+  {
+    fprintf(stderr, "exception caught in WorkStealingThreadPool %s\n", name_.c_str());
+    fprintf(stderr, "reason: %s\n", ex.what());
+    abort();
+  }
+  catch (...)
+  {
+    fprintf(stderr, "unknown exception caught in WorkStealingThreadPool %s\n", name_.c_str());
+    throw; // rethrow
+  }
+}
@@ -0,0 +1,101 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_WORKSTEALINGTHREADPOOL_H
+#define MUDUO_BASE_WORKSTEALINGTHREADPOOL_H
+
+#include "muduo/base/Condition.h"
+#include "muduo/base/Mutex.h"
+#include "muduo/base/Thread.h"
+#include "muduo/base/Types.h"
+
+#include <atomic>
+#include <deque>
+#include <vector>
+
+namespace muduo
+{
+
+///
+/// Thread pool with the interface of ThreadPool, for many short tasks.
+///
+/// Each worker owns a WorkStealingDeque, tasks run from a worker go to
+/// its own deque. Tasks from other threads go to a lock-free ring shared
+/// by all workers, a worker takes them in batches into its deque.
+/// An idle worker steals from others before going to sleep.
+///
+/// Tasks are not run in FIFO order.
+///
+class WorkStealingThreadPool : noncopyable
+{
+ public:
+  typedef std::function<void ()> Task;
+
+  explicit WorkStealingThreadPool(const string& nameArg = string("WorkStealingThreadPool"));
+  ~WorkStealingThreadPool();
+
+  // Must be called before start().
+  // Bounds the shared ring, rounded up to a power of two,
+  // workers could hold more in their deques.
+  // 0 means unbounded, as in ThreadPool.
+  void setMaxQueueSize(int maxSize) { maxQueueSize_ = maxSize; }
+  void setThreadInitCallback(const Task& cb)
+  { threadInitCallback_ = cb; }
+  // Pins the i-th worker to the i-th CPU allowed for this process.
+  void setCpuAffinity(bool on) { cpuAffinity_ = on; }
+
+  void start(int numThreads);
+  void stop();
+
+  const string& name() const
+  { return name_; }
+
+  // Approximate
+  size_t queueSize() const;
+
+  // Could block if max queue size is set and the shared ring is full,
+  // never blocks in a worker.
+  void run(Task f);
+
+  // Wakes up workers once for all tasks, tasks is cleared.
+  void runBatch(std::vector<Task>* tasks);
+
+ private:
+  class Injector;
+  struct Worker;
+
+  void runInThread(int index);
+  Task* take(Worker* self);
+  Task* steal(Worker* self);
+  Task* takeOverflow(Worker* self);
+  bool hasWork() const;
+  void push(Task* task);
+  void wakeUp(size_t count);
+  void park();
+  void notifyNotFull();
+
+  mutable MutexLock mutex_;
+  Condition notEmpty_ GUARDED_BY(mutex_);
+  Condition notFull_ GUARDED_BY(mutex_);
+  size_t wakeups_ GUARDED_BY(mutex_);
+  // tasks not fitting in the shared ring when unbounded
+  std::deque<Task*> overflow_ GUARDED_BY(mutex_);
+  string name_;
+  Task threadInitCallback_;
+  std::vector<std::unique_ptr<muduo::Thread>> threads_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::unique_ptr<Injector> injector_;
+  std::vector<int> cpus_;
+  size_t maxQueueSize_;
+  bool cpuAffinity_;
+  std::atomic<bool> running_;
+  std::atomic<int> idleWorkers_;
+  std::atomic<int> blockedProducers_;
+  std::atomic<size_t> overflowSize_;
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_WORKSTEALINGTHREADPOOL_H
@@ -1,7 +1,10 @@
 #include "muduo/base/AsyncLogging.h"
 #include "muduo/base/Logging.h"
+#include "muduo/base/Thread.h"
 #include "muduo/base/Timestamp.h"
 
+#include <memory>
+#include <vector>
 #include <stdio.h>
 #include <sys/resource.h>
 #include <unistd.h>
@@ -42,6 +45,39 @@ void bench(bool longLog)
   }
 }
 
+void logLines(int count)
+{
+  for (int i = 0; i < count; ++i)
+  {
+    LOG_INFO << "Hello 0123456789" << " abcdefghijklmnopqrstuvwxyz " << i;
+  }
+}
+
+// lines per second of all threads, each logs as fast as it can.
+void benchThreads(int maxThreads)
+{
+  const int kLines = 1000*1000;
+  for (int nThreads = 1; nThreads <= maxThreads; ++nThreads)
+  {
+    int64_t droppedBefore = g_asyncLog->droppedMessages();
+    std::vector<std::unique_ptr<muduo::Thread>> threads;
+    muduo::Timestamp start = muduo::Timestamp::now();
+    for (int i = 0; i < nThreads; ++i)
+    {
+      threads.emplace_back(new muduo::Thread(std::bind(logLines, kLines / nThreads)));
+      threads.back()->start();
+    }
+    for (auto& thr : threads)
+    {
+      thr->join();
+    }
+    double seconds = timeDifference(muduo::Timestamp::now(), start);
+    printf("%d threads: %.0f lines/s, %lld dropped\n",
+           nThreads, kLines / seconds,
+           static_cast<long long>(g_asyncLog->droppedMessages() - droppedBefore));
+  }
+}
+
 int main(int argc, char* argv[])
 {
   {
@@ -55,10 +91,24 @@ int main(int argc, char* argv[])
 
   char name[256] = { 0 };
   strncpy(name, argv[0], sizeof name - 1);
-  muduo::AsyncLogging log(::basename(name), kRollSize);
+  // asynclogging_test [long [max_threads [block]]]
+  // any first argument logs long lines, as it always did
+  muduo::AsyncLogging::BackpressurePolicy policy =
+      argc > 3 && strcmp(argv[3], "block") == 0
+      ? muduo::AsyncLogging::kBlock : muduo::AsyncLogging::kDrop;
+  muduo::AsyncLogging log(::basename(name), kRollSize, 3, policy);
   log.start();
   g_asyncLog = &log;
 
   bool longLog = argc > 1;
-  bench(longLog);
+  int maxThreads = argc > 2 ? atoi(argv[2]) : 0;
+  if (maxThreads > 0)
+  {
+    muduo::Logger::setOutput(asyncOutput);
+    benchThreads(maxThreads);
+  }
+  else
+  {
+    bench(longLog);
+  }
 }
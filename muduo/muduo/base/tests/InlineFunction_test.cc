@@ -0,0 +1,149 @@
+#undef NDEBUG
+#include "muduo/base/InlineFunction.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Small callables are stored without allocation, large ones on the heap,
+// each is destroyed once whether copied, moved or assigned.
+
+std::atomic<int> g_allocations(0);
+
+void* operator new(size_t size)
+{
+  ++g_allocations;
+  void* p = malloc(size);
+  if (p == NULL)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept
+{
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+  free(p);
+}
+
+using muduo::InlineFunction;
+
+int g_alive = 0;
+int g_calls = 0;
+
+struct Counted
+{
+  Counted() { ++g_alive; }
+  Counted(const Counted&) { ++g_alive; }
+  Counted(Counted&&) noexcept { ++g_alive; }
+  ~Counted() { --g_alive; }
+  void operator()() const { ++g_calls; }
+};
+
+struct Large : Counted
+{
+  char padding[InlineFunction::kInlineSize + 1];
+};
+
+struct Connection
+{
+  void send(const std::string& message) { sent += message; }
+  std::string sent;
+};
+
+typedef std::shared_ptr<Connection> ConnectionPtr;
+
+void onHighWaterMark(const ConnectionPtr& conn, size_t len)
+{
+  conn->sent += std::to_string(len);
+}
+
+void testInline()
+{
+  ConnectionPtr conn(new Connection);
+  std::function<void (const ConnectionPtr&, size_t)> callback(onHighWaterMark);
+  std::string message("hello");
+  int before = g_allocations;
+  {
+  // as TcpConnection::send() queues sendInLoop()
+  InlineFunction f(std::bind(&Connection::send, conn.get(), message));
+  InlineFunction g(std::move(f));
+  assert(!f);
+  g();
+  InlineFunction h(g);
+  h();
+  // as TcpConnection::sendInLoop() queues highWaterMarkCallback_
+  InlineFunction k(std::bind(callback, conn, 42));
+  k();
+  }
+  assert(g_allocations == before);
+  assert(conn->sent == "hellohello42");
+  assert(conn.use_count() == 1);
+}
+
+template<typename F>
+void testLifetime(bool stored)
+{
+  assert(InlineFunction::storedInline<F>() == stored);
+  g_calls = 0;
+  {
+  InlineFunction f((F()));
+  assert(g_alive == 1);
+  InlineFunction g(f);
+  assert(g_alive == 2);
+  InlineFunction h(std::move(f));
+  assert(g_alive == 2);
+  f = g;
+  assert(g_alive == 3);
+  g = nullptr;
+  assert(g_alive == 2);
+  g = std::move(h);
+  assert(g_alive == 2);
+  g = g;
+  assert(g_alive == 2);
+  f();
+  g();
+  assert(g_calls == 2);
+  std::vector<InlineFunction> functors(10, f);
+  assert(g_alive == 12);
+  }
+  assert(g_alive == 0);
+}
+
+void testEmpty()
+{
+  InlineFunction f;
+  assert(!f);
+  bool thrown = false;
+  try
+  {
+    f();
+  }
+  catch (const std::bad_function_call&)
+  {
+    thrown = true;
+  }
+  assert(thrown);
+  f = InlineFunction(Counted());
+  assert(f);
+}
+
+int main()
+{
+  testInline();
+  testLifetime<Counted>(true);
+  testLifetime<Large>(false);
+  testEmpty();
+  printf("sizeof(InlineFunction) = %zu, sizeof(std::function<void()>) = %zu\n",
+         sizeof(InlineFunction), sizeof(std::function<void()>));
+  printf("PASS\n");
+}
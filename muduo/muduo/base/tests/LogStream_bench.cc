@@ -1,8 +1,15 @@
 #include "muduo/base/LogStream.h"
+#include "muduo/base/Logging.h"
+#include "muduo/base/Thread.h"
 #include "muduo/base/Timestamp.h"
+#include "muduo/base/TimeZone.h"
+
+#include <memory>
+#include <vector>
 
 #include <sstream>
 #include <stdio.h>
+#include <stdlib.h>
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
 
@@ -55,7 +62,67 @@ void benchLogStream()
   printf("benchLogStream %f\n", timeDifference(end, start));
 }
 
-int main()
+void nullOutput(const char*, int)
+{
+}
+
+void logLines(size_t count)
+{
+  for (size_t i = 0; i < count; ++i)
+  {
+    LOG_INFO << "Hello 0123456789" << " abcdefghijklmnopqrstuvwxyz " << i;
+  }
+}
+
+// formats whole log lines in nThreads, without output.
+void benchLogLines(int nThreads)
+{
+  Logger::setOutput(nullOutput);
+  std::vector<std::unique_ptr<Thread>> threads;
+  Timestamp start(Timestamp::now());
+  for (int i = 0; i < nThreads; ++i)
+  {
+    threads.emplace_back(new Thread(std::bind(logLines, N / nThreads)));
+    threads.back()->start();
+  }
+  for (auto& thr : threads)
+  {
+    thr->join();
+  }
+  Timestamp end(Timestamp::now());
+  printf("benchLogLines %d threads %.0f lines/s\n",
+         nThreads, static_cast<double>(N) / timeDifference(end, start));
+}
+
+int64_t g_bytes = 0;
+
+void countOutput(const char*, int len)
+{
+  g_bytes += len;
+}
+
+// formats typical lines in one thread, the timestamp and numbers in each
+// line are different.
+void benchFormattedLines(const char* name, const TimeZone& tz)
+{
+  Logger::setOutput(countOutput);
+  Logger::setTimeZone(tz);
+  g_bytes = 0;
+  Timestamp start(Timestamp::now());
+  for (size_t i = 0; i < N; ++i)
+  {
+    LOG_INFO << "conn " << i % 1000 << " read " << i * 37 << " bytes, seq " << i
+             << ", latency " << static_cast<int64_t>(i * 1000003 % 999983) << "us";
+  }
+  Timestamp end(Timestamp::now());
+  double seconds = timeDifference(end, start);
+  printf("benchFormattedLines %-8s %.0f lines/s %.1f MiB/s\n", name,
+         static_cast<double>(N) / seconds,
+         static_cast<double>(g_bytes) / seconds / 1024 / 1024);
+  Logger::setTimeZone(TimeZone());
+}
+
+int main(int argc, char* argv[])
 {
   benchPrintf<int>("%d");
 
@@ -79,4 +146,19 @@ int main()
   benchStringStream<void*>();
   benchLogStream<void*>();
 
+  puts("formatted lines");
+  benchFormattedLines("UTC", TimeZone());
+  benchFormattedLines("fixed", TimeZone(8*3600, "CST"));
+  TimeZone newYork("/usr/share/zoneinfo/America/New_York");
+  if (newYork.valid())
+  {
+    benchFormattedLines("New_York", newYork);
+  }
+
+  puts("log lines");
+  int maxThreads = argc > 1 ? atoi(argv[1]) : 4;
+  for (int n = 1; n <= maxThreads; ++n)
+  {
+    benchLogLines(n);
+  }
 }
@@ -2,6 +2,7 @@
 
 #include <limits>
 #include <stdint.h>
+#include <stdio.h>
 
 //#define BOOST_TEST_MODULE LogStreamTest
 #define BOOST_TEST_MAIN
@@ -110,6 +111,40 @@ BOOST_AUTO_TEST_CASE(testLogStreamIntegerLimits)
   BOOST_CHECK_EQUAL(buf.toString(), string("000"));
 }
 
+BOOST_AUTO_TEST_CASE(testLogStreamIntegerDigits)
+{
+  muduo::LogStream os;
+  const muduo::LogStream::Buffer& buf = os.buffer();
+  // around every power of 10, where the number of digits changes
+  uint64_t power = 1;
+  for (int i = 0; i < 20; ++i)
+  {
+    for (uint64_t x = power - 1; x <= power + 1; ++x)
+    {
+      char expected[32];
+      snprintf(expected, sizeof expected, "%llu", static_cast<unsigned long long>(x));
+      os << x;
+      BOOST_CHECK_EQUAL(buf.toString(), string(expected));
+      os.resetBuffer();
+
+      int64_t y = -static_cast<int64_t>(x);
+      snprintf(expected, sizeof expected, "%lld", static_cast<long long>(y));
+      os << y;
+      BOOST_CHECK_EQUAL(buf.toString(), string(expected));
+      os.resetBuffer();
+    }
+    power *= 10;
+  }
+
+  char digits[9] = { 0 };
+  muduo::detail::formatEightDigits(digits, 0);
+  BOOST_CHECK_EQUAL(string(digits), string("00000000"));
+  muduo::detail::formatEightDigits(digits, 1020304);
+  BOOST_CHECK_EQUAL(string(digits), string("01020304"));
+  muduo::detail::formatEightDigits(digits, 99999999);
+  BOOST_CHECK_EQUAL(string(digits), string("99999999"));
+}
+
 BOOST_AUTO_TEST_CASE(testLogStreamFloats)
 {
   muduo::LogStream os;
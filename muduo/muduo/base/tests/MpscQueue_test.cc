@@ -0,0 +1,72 @@
+#include "muduo/base/MpscQueue.h"
+#include "muduo/base/Thread.h"
+
+#include <memory>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+
+// Each producer pushes increasing numbers, the consumer checks
+// they come out in order per producer, and none is lost.
+
+const int kProducers = 4;
+const int kCount = 100*1000;
+
+muduo::MpscQueue<int64_t> g_queue(256);
+
+void produce(int id)
+{
+  for (int i = 0; i < kCount; ++i)
+  {
+    int64_t x = static_cast<int64_t>(id) << 32 | i;
+    while (!g_queue.tryPush(std::move(x)))
+    {
+      sched_yield();
+    }
+  }
+}
+
+int main()
+{
+  std::vector<std::unique_ptr<muduo::Thread>> threads;
+  for (int i = 0; i < kProducers; ++i)
+  {
+    threads.emplace_back(new muduo::Thread(std::bind(produce, i), "producer"));
+    threads.back()->start();
+  }
+
+  std::vector<int> next(kProducers, 0);
+  int64_t received = 0;
+  while (received < int64_t(kProducers) * kCount)
+  {
+    int64_t x;
+    if (g_queue.tryPop(&x))
+    {
+      int id = static_cast<int>(x >> 32);
+      int seq = static_cast<int>(x & 0xFFFFFFFF);
+      if (id < 0 || id >= kProducers || seq != next[id])
+      {
+        fprintf(stderr, "producer %d expects %d, got %d\n", id, next[id], seq);
+        abort();
+      }
+      ++next[id];
+      ++received;
+    }
+    else
+    {
+      sched_yield();
+    }
+  }
+
+  for (auto& thr : threads)
+  {
+    thr->join();
+  }
+  if (!g_queue.empty() || g_queue.size() != 0)
+  {
+    fprintf(stderr, "queue is not empty\n");
+    abort();
+  }
+  printf("%lld received\n", static_cast<long long>(received));
+}
@@ -0,0 +1,127 @@
+// Benchmark of ThreadPool and WorkStealingThreadPool,
+// reports tasks per second vs number of threads.
+//
+// usage: threadpool_bench [tasks] [work per task] [max threads]
+
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/ThreadPool.h"
+#include "muduo/base/Timestamp.h"
+#include "muduo/base/WorkStealingThreadPool.h"
+
+#include <atomic>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+int g_work = 100;
+std::atomic<int64_t> g_result(0);
+
+void task(muduo::CountDownLatch* latch)
+{
+  // a little computing, so that tasks are not all about queueing
+  uint32_t x = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(latch));
+  for (int i = 0; i < g_work; ++i)
+  {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+  }
+  g_result.fetch_add(x & 1, std::memory_order_relaxed);
+  latch->countDown();
+}
+
+template<typename Pool>
+void spawn(Pool* pool, int depth, muduo::CountDownLatch* latch)
+{
+  if (depth == 0)
+  {
+    task(latch);
+  }
+  else
+  {
+    pool->run(std::bind(spawn<Pool>, pool, depth-1, latch));
+    pool->run(std::bind(spawn<Pool>, pool, depth-1, latch));
+  }
+}
+
+// one thread submits all tasks
+template<typename Pool>
+double benchSubmit(Pool* pool, int tasks)
+{
+  muduo::CountDownLatch latch(tasks);
+  muduo::Timestamp start(muduo::Timestamp::now());
+  for (int i = 0; i < tasks; ++i)
+  {
+    pool->run(std::bind(task, &latch));
+  }
+  latch.wait();
+  return tasks / timeDifference(muduo::Timestamp::now(), start);
+}
+
+double benchBatch(muduo::WorkStealingThreadPool* pool, int tasks)
+{
+  const size_t kBatch = 64;
+  muduo::CountDownLatch latch(tasks);
+  std::vector<muduo::WorkStealingThreadPool::Task> batch;
+  batch.reserve(kBatch);
+  muduo::Timestamp start(muduo::Timestamp::now());
+  for (int i = 0; i < tasks; ++i)
+  {
+    batch.push_back(std::bind(task, &latch));
+    if (batch.size() == kBatch)
+    {
+      pool->runBatch(&batch);
+    }
+  }
+  pool->runBatch(&batch);
+  latch.wait();
+  return tasks / timeDifference(muduo::Timestamp::now(), start);
+}
+
+// tasks spawn tasks, as divide and conquer does
+template<typename Pool>
+double benchSpawn(Pool* pool, int tasks)
+{
+  int depth = 0;
+  while ((2 << depth) <= tasks)
+  {
+    ++depth;
+  }
+  muduo::CountDownLatch latch(1 << depth);
+  muduo::Timestamp start(muduo::Timestamp::now());
+  pool->run(std::bind(spawn<Pool>, pool, depth, &latch));
+  latch.wait();
+  // count inner nodes too
+  return ((2 << depth) - 1) / timeDifference(muduo::Timestamp::now(), start);
+}
+
+int main(int argc, char* argv[])
+{
+  int tasks = argc > 1 ? atoi(argv[1]) : 1000*1000;
+  g_work = argc > 2 ? atoi(argv[2]) : 100;
+  int maxThreads = argc > 3 ? atoi(argv[3]) : 8;
+  printf("%d tasks, %d work per task, tasks per second:\n", tasks, g_work);
+  printf("threads      ThreadPool  WorkStealing     WS batch  |  ThreadPool  WorkStealing  (spawn)\n");
+
+  for (int threads = 1; threads <= maxThreads; threads *= 2)
+  {
+    double tp, tpSpawn, ws, wsBatch, wsSpawn;
+    {
+    muduo::ThreadPool pool;
+    pool.start(threads);
+    tp = benchSubmit(&pool, tasks);
+    tpSpawn = benchSpawn(&pool, tasks);
+    pool.stop();
+    }
+    {
+    muduo::WorkStealingThreadPool pool;
+    pool.start(threads);
+    ws = benchSubmit(&pool, tasks);
+    wsBatch = benchBatch(&pool, tasks);
+    wsSpawn = benchSpawn(&pool, tasks);
+    pool.stop();
+    }
+    printf("%7d  %12.0f  %12.0f %12.0f  |%12.0f  %12.0f\n",
+           threads, tp, ws, wsBatch, tpSpawn, wsSpawn);
+  }
+}
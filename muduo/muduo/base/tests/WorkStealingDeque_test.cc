@@ -0,0 +1,102 @@
+#include "muduo/base/WorkStealingDeque.h"
+#include "muduo/base/Thread.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+// The owner pushes and pops, thieves steal, every element
+// must be taken exactly once, while the deque grows from 2.
+
+const int kThieves = 3;
+const int kCount = 1000*1000;
+
+muduo::WorkStealingDeque<int> g_deque(2);
+std::vector<int> g_elements(kCount);
+std::unique_ptr<std::atomic<int>[]> g_taken(new std::atomic<int>[kCount]);
+std::atomic<bool> g_done(false);
+
+void take(int* x)
+{
+  if (g_taken[x - &g_elements[0]].fetch_add(1) != 0)
+  {
+    fprintf(stderr, "element %d is taken twice\n", *x);
+    abort();
+  }
+}
+
+void thief(int64_t* stolen)
+{
+  while (!g_done.load() || !g_deque.empty())
+  {
+    if (int* x = g_deque.steal())
+    {
+      take(x);
+      ++*stolen;
+    }
+  }
+}
+
+int main()
+{
+  for (int i = 0; i < kCount; ++i)
+  {
+    g_elements[i] = i;
+    g_taken[i].store(0);
+  }
+
+  std::vector<int64_t> stolen(kThieves * 8);  // padded
+  std::vector<std::unique_ptr<muduo::Thread>> threads;
+  for (int i = 0; i < kThieves; ++i)
+  {
+    threads.emplace_back(new muduo::Thread(std::bind(thief, &stolen[i * 8]), "thief"));
+    threads.back()->start();
+  }
+
+  int64_t popped = 0;
+  for (int i = 0; i < kCount; ++i)
+  {
+    g_deque.push(&g_elements[i]);
+    if (i % 3 == 0)
+    {
+      if (int* x = g_deque.pop())
+      {
+        take(x);
+        ++popped;
+      }
+    }
+  }
+  while (int* x = g_deque.pop())
+  {
+    take(x);
+    ++popped;
+  }
+  g_done.store(true);
+  for (auto& thr : threads)
+  {
+    thr->join();
+  }
+
+  int64_t total = popped;
+  for (int i = 0; i < kThieves; ++i)
+  {
+    total += stolen[i * 8];
+  }
+  for (int i = 0; i < kCount; ++i)
+  {
+    if (g_taken[i].load() != 1)
+    {
+      fprintf(stderr, "element %d is taken %d times\n", i, g_taken[i].load());
+      abort();
+    }
+  }
+  if (total != kCount || !g_deque.empty())
+  {
+    fprintf(stderr, "total %lld\n", static_cast<long long>(total));
+    abort();
+  }
+  printf("%lld popped, %lld stolen\n", static_cast<long long>(popped),
+         static_cast<long long>(total - popped));
+}
@@ -0,0 +1,130 @@
+#include "muduo/base/WorkStealingThreadPool.h"
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/CurrentThread.h"
+#include "muduo/base/Logging.h"
+
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+
+std::atomic<int64_t> g_sum(0);
+
+void add(int x)
+{
+  g_sum.fetch_add(x);
+}
+
+// spawns tasks from inside workers, which go to their own deques
+void fib(muduo::WorkStealingThreadPool* pool, int n, muduo::CountDownLatch* latch)
+{
+  if (n < 2)
+  {
+    add(n);
+    latch->countDown();
+  }
+  else
+  {
+    pool->run(std::bind(fib, pool, n-1, latch));
+    pool->run(std::bind(fib, pool, n-2, latch));
+  }
+}
+
+int fibLeaves(int n)
+{
+  return n < 2 ? 1 : fibLeaves(n-1) + fibLeaves(n-2);
+}
+
+void check(int64_t expected)
+{
+  if (g_sum.load() != expected)
+  {
+    fprintf(stderr, "sum %lld, expect %lld\n",
+            static_cast<long long>(g_sum.load()), static_cast<long long>(expected));
+    abort();
+  }
+  g_sum.store(0);
+}
+
+void test(int maxSize, int numThreads)
+{
+  LOG_WARN << "Test WorkStealingThreadPool with max queue size = " << maxSize
+           << ", threads = " << numThreads;
+  muduo::WorkStealingThreadPool pool("MainThreadPool");
+  pool.setMaxQueueSize(maxSize);
+  pool.setCpuAffinity(numThreads % 2 == 0);
+  pool.start(numThreads);
+
+  const int kTasks = 100*1000;
+  {
+  muduo::CountDownLatch latch(kTasks);
+  for (int i = 1; i <= kTasks; ++i)
+  {
+    pool.run([i, &latch] { add(i); latch.countDown(); });
+  }
+  latch.wait();
+  check(int64_t(kTasks) * (kTasks + 1) / 2);
+  }
+
+  {
+  muduo::CountDownLatch latch(kTasks);
+  std::vector<muduo::WorkStealingThreadPool::Task> tasks;
+  for (int i = 1; i <= kTasks; ++i)
+  {
+    tasks.push_back([i, &latch] { add(i); latch.countDown(); });
+    if (tasks.size() == 1000)
+    {
+      pool.runBatch(&tasks);
+    }
+  }
+  pool.runBatch(&tasks);
+  latch.wait();
+  check(int64_t(kTasks) * (kTasks + 1) / 2);
+  }
+
+  {
+  const int n = 20;
+  muduo::CountDownLatch latch(fibLeaves(n));
+  pool.run(std::bind(fib, &pool, n, &latch));
+  latch.wait();
+  check(6765);
+  }
+
+  pool.stop();
+}
+
+// unbounded: a producer never blocks, even with all workers busy
+void testUnbounded(int numThreads)
+{
+  LOG_WARN << "Test unbounded WorkStealingThreadPool, threads = " << numThreads;
+  muduo::WorkStealingThreadPool pool("UnboundedThreadPool");
+  pool.start(numThreads);
+
+  muduo::CountDownLatch gate(1);
+  for (int i = 0; i < numThreads; ++i)
+  {
+    pool.run([&gate] { gate.wait(); });
+  }
+  // more than the shared ring holds
+  const int kTasks = 100*1000;
+  muduo::CountDownLatch latch(kTasks);
+  for (int i = 1; i <= kTasks; ++i)
+  {
+    pool.run([i, &latch] { add(i); latch.countDown(); });
+  }
+  gate.countDown();
+  latch.wait();
+  check(int64_t(kTasks) * (kTasks + 1) / 2);
+  pool.stop();
+}
+
+int main()
+{
+  test(0, 0);
+  test(0, 1);
+  test(0, 4);
+  test(1, 4);
+  test(10, 3);
+  test(50, 8);
+  testUnbounded(2);
+  printf("pid = %d, tid = %d\n", getpid(), muduo::CurrentThread::tid());
+}
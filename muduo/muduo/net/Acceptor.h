@@ -38,9 +38,17 @@ class Acceptor : noncopyable
   void setNewConnectionCallback(const NewConnectionCallback& cb)
   { newConnectionCallback_ = cb; }
 
+  /// Accepts up to n connections per readable event, default 1.
+  void setAcceptBatch(int n)
+  { acceptBatch_ = n; }
+
   bool listenning() const { return listenning_; }
   void listen();
 
+  /// Puts the socket in listening state, callable in any thread before
+  /// listen(). Connections wait in the backlog until listen() accepts them.
+  void listenSocket();
+
  private:
   void handleRead();
 
@@ -49,7 +57,9 @@ class Acceptor : noncopyable
   Channel acceptChannel_;
   NewConnectionCallback newConnectionCallback_;
   bool listenning_;
+  bool socketListening_;
   int idleFd_;
+  int acceptBatch_;
 };
 
 }  // namespace net
@@ -9,6 +9,7 @@
 
 #include "muduo/net/Buffer.h"
 
+#include "muduo/net/ByteScan.h"
 #include "muduo/net/SocketsOps.h"
 
 #include <errno.h>
@@ -22,6 +23,14 @@ const char Buffer::kCRLF[] = "\r\n";
 const size_t Buffer::kCheapPrepend;
 const size_t Buffer::kInitialSize;
 
+const char* Buffer::findCRLF(const char* start) const
+{
+  assert(peek() <= start);
+  assert(start <= beginWrite());
+  const char* crlf = scan::findCRLF(start, beginWrite());
+  return crlf == beginWrite() ? NULL : crlf;
+}
+
 ssize_t Buffer::readFd(int fd, int* savedErrno)
 {
   // saved an ioctl()/FIONREAD call to tell how much to read
@@ -77,21 +77,13 @@ class Buffer : public muduo::copyable
   const char* peek() const
   { return begin() + readerIndex_; }
 
+  // vectorized, see ByteScan.h
   const char* findCRLF() const
   {
-    // FIXME: replace with memmem()?
-    const char* crlf = std::search(peek(), beginWrite(), kCRLF, kCRLF+2);
-    return crlf == beginWrite() ? NULL : crlf;
+    return findCRLF(peek());
   }
 
-  const char* findCRLF(const char* start) const
-  {
-    assert(peek() <= start);
-    assert(start <= beginWrite());
-    // FIXME: replace with memmem()?
-    const char* crlf = std::search(start, beginWrite(), kCRLF, kCRLF+2);
-    return crlf == beginWrite() ? NULL : crlf;
-  }
+  const char* findCRLF(const char* start) const;
 
   const char* findEOL() const
   {
@@ -0,0 +1,308 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+
+#include "muduo/net/ByteScan.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MUDUO_SCAN_X86 1
+#endif
+
+using namespace muduo::net;
+
+namespace
+{
+
+const char* findCRLFScalar(const char* begin, const char* end)
+{
+  const char* p = begin;
+  while (end - p >= 2)
+  {
+    const void* cr = memchr(p, '\r', static_cast<size_t>(end - p - 1));
+    if (cr == NULL)
+    {
+      break;
+    }
+    p = static_cast<const char*>(cr);
+    if (p[1] == '\n')
+    {
+      return p;
+    }
+    ++p;
+  }
+  return end;
+}
+
+const char* findCharScalar(const char* begin, const char* end, char c)
+{
+  const void* p = memchr(begin, c, static_cast<size_t>(end - begin));
+  return p ? static_cast<const char*>(p) : end;
+}
+
+const char* findEitherScalar(const char* begin, const char* end, char c1, char c2)
+{
+  const char* p = begin;
+  while (p < end && *p != c1 && *p != c2)
+  {
+    ++p;
+  }
+  return p;
+}
+
+const scan::Scanner kScalarScanner =
+{
+  findCRLFScalar,
+  findCharScalar,
+  findEitherScalar,
+};
+
+#if MUDUO_SCAN_X86 && defined(__SSE2__)
+
+// Each loop reads 16 bytes at p, and for CRLF 16 more at p+1,
+// so it stops 16 (or 17) bytes before end, the tail is done by scalar.
+
+const char* findCRLFSse2(const char* begin, const char* end)
+{
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+  const char* p = begin;
+  while (end - p > 16)
+  {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+    int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, cr),
+                                               _mm_cmpeq_epi8(b, lf)));
+    if (mask)
+    {
+      return p + __builtin_ctz(static_cast<unsigned>(mask));
+    }
+    p += 16;
+  }
+  return findCRLFScalar(p, end);
+}
+
+const char* findCharSse2(const char* begin, const char* end, char c)
+{
+  const __m128i x = _mm_set1_epi8(c);
+  const char* p = begin;
+  while (end - p >= 16)
+  {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(a, x));
+    if (mask)
+    {
+      return p + __builtin_ctz(static_cast<unsigned>(mask));
+    }
+    p += 16;
+  }
+  return findEitherScalar(p, end, c, c);
+}
+
+const char* findEitherSse2(const char* begin, const char* end, char c1, char c2)
+{
+  const __m128i x1 = _mm_set1_epi8(c1);
+  const __m128i x2 = _mm_set1_epi8(c2);
+  const char* p = begin;
+  while (end - p >= 16)
+  {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(a, x1),
+                                              _mm_cmpeq_epi8(a, x2)));
+    if (mask)
+    {
+      return p + __builtin_ctz(static_cast<unsigned>(mask));
+    }
+    p += 16;
+  }
+  return findEitherScalar(p, end, c1, c2);
+}
+
+const scan::Scanner kSse2Scanner =
+{
+  findCRLFSse2,
+  findCharSse2,
+  findEitherSse2,
+};
+
+#define MUDUO_SCAN_SSE2 1
+#endif
+
+#if MUDUO_SCAN_X86 && defined(__GNUC__)
+
+// compiled for AVX2 regardless of -march, only called if CPU supports it.
+
+__attribute__((target("avx2")))
+const char* findCRLFAvx2(const char* begin, const char* end)
+{
+  const __m256i cr = _mm256_set1_epi8('\r');
+  const __m256i lf = _mm256_set1_epi8('\n');
+  const char* p = begin;
+  while (end - p > 32)
+  {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1));
+    int mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, cr),
+                                                     _mm256_cmpeq_epi8(b, lf)));
+    if (mask)
+    {
+      return p + __builtin_ctz(static_cast<unsigned>(mask));
+    }
+    p += 32;
+  }
+  return findCRLFScalar(p, end);
+}
+
+__attribute__((target("avx2")))
+const char* findCharAvx2(const char* begin, const char* end, char c)
+{
+  const __m256i x = _mm256_set1_epi8(c);
+  const char* p = begin;
+  while (end - p >= 32)
+  {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(a, x));
+    if (mask)
+    {
+      return p + __builtin_ctz(static_cast<unsigned>(mask));
+    }
+    p += 32;
+  }
+  return findEitherScalar(p, end, c, c);
+}
+
+__attribute__((target("avx2")))
+const char* findEitherAvx2(const char* begin, const char* end, char c1, char c2)
+{
+  const __m256i x1 = _mm256_set1_epi8(c1);
+  const __m256i x2 = _mm256_set1_epi8(c2);
+  const char* p = begin;
+  while (end - p >= 32)
+  {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    int mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(a, x1),
+                                                    _mm256_cmpeq_epi8(a, x2)));
+    if (mask)
+    {
+      return p + __builtin_ctz(static_cast<unsigned>(mask));
+    }
+    p += 32;
+  }
+  return findEitherScalar(p, end, c1, c2);
+}
+
+const scan::Scanner kAvx2Scanner =
+{
+  findCRLFAvx2,
+  findCharAvx2,
+  findEitherAvx2,
+};
+
+#define MUDUO_SCAN_AVX2 1
+#endif
+
+bool supported(scan::Impl impl)
+{
+  switch (impl)
+  {
+    case scan::kScalar:
+      return true;
+#if MUDUO_SCAN_SSE2
+    case scan::kSse2:
+      return true;
+#endif
+#if MUDUO_SCAN_AVX2
+    case scan::kAvx2:
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+const scan::Scanner* scannerOf(scan::Impl impl)
+{
+  switch (impl)
+  {
+#if MUDUO_SCAN_SSE2
+    case scan::kSse2:
+      return &kSse2Scanner;
+#endif
+#if MUDUO_SCAN_AVX2
+    case scan::kAvx2:
+      return &kAvx2Scanner;
+#endif
+    default:
+      return &kScalarScanner;
+  }
+}
+
+// constant initialized, usable by other static initializers.
+scan::Impl g_impl = scan::kScalar;
+
+}  // namespace
+
+const scan::Scanner* scan::g_scanner = &kScalarScanner;
+
+namespace
+{
+
+class ScanInitializer
+{
+ public:
+  ScanInitializer()
+  {
+    scan::setImpl(scan::bestImpl());
+  }
+};
+
+ScanInitializer initObj;
+
+}  // namespace
+
+scan::Impl scan::bestImpl()
+{
+  if (supported(kAvx2))
+  {
+    return kAvx2;
+  }
+  else if (supported(kSse2))
+  {
+    return kSse2;
+  }
+  return kScalar;
+}
+
+scan::Impl scan::currentImpl()
+{
+  return g_impl;
+}
+
+bool scan::setImpl(Impl impl)
+{
+  if (!supported(impl))
+  {
+    return false;
+  }
+  g_impl = impl;
+  g_scanner = scannerOf(impl);
+  return true;
+}
+
+const char* scan::implName(Impl impl)
+{
+  switch (impl)
+  {
+    case kSse2:
+      return "sse2";
+    case kAvx2:
+      return "avx2";
+    default:
+      return "scalar";
+  }
+}
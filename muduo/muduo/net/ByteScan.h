@@ -0,0 +1,73 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_BYTESCAN_H
+#define MUDUO_NET_BYTESCAN_H
+
+namespace muduo
+{
+namespace net
+{
+namespace scan
+{
+
+///
+/// Delimiter search for protocol parsers, vectorized with SSE2 or AVX2
+/// on x86, chosen at startup by what the CPU supports.
+///
+/// All return end if not found, like std::find().
+///
+
+enum Impl
+{
+  kScalar,
+  kSse2,
+  kAvx2,
+};
+
+struct Scanner
+{
+  const char* (*findCRLF)(const char* begin, const char* end);
+  const char* (*findChar)(const char* begin, const char* end, char c);
+  const char* (*findEither)(const char* begin, const char* end, char c1, char c2);
+};
+
+extern const Scanner* g_scanner;
+
+/// the best one supported by this CPU
+Impl bestImpl();
+
+Impl currentImpl();
+
+/// For tests and benchmarks, not thread safe.
+/// Returns false if not supported by this CPU or build.
+bool setImpl(Impl impl);
+
+const char* implName(Impl impl);
+
+/// first "\r\n"
+inline const char* findCRLF(const char* begin, const char* end)
+{
+  return g_scanner->findCRLF(begin, end);
+}
+
+inline const char* findChar(const char* begin, const char* end, char c)
+{
+  return g_scanner->findChar(begin, end, c);
+}
+
+/// first c1 or c2
+inline const char* findEither(const char* begin, const char* end, char c1, char c2)
+{
+  return g_scanner->findEither(begin, end, c1, c2);
+}
+
+}  // namespace scan
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_BYTESCAN_H
@@ -0,0 +1,225 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/net/ChainBuffer.h"
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/SocketsOps.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const size_t ChainBuffer::kSliceSize;
+const int ChainBuffer::kMaxIovec;
+
+namespace
+{
+
+void closeFile(int* fd)
+{
+  ::close(*fd);
+  delete fd;
+}
+
+}  // namespace
+
+void ChainBuffer::append(const char* data, size_t len)
+{
+  if (len == 0)
+  {
+    return;
+  }
+  if (slices_.empty()
+      || slices_.back().buffer == NULL
+      || slices_.back().buffer->writableBytes() < len)
+  {
+    // a fresh slice, never realloc and memmove what is already queued.
+    std::shared_ptr<Buffer> buf(new Buffer(std::max(len, kSliceSize)));
+    Slice slice = { buf, buf.get(), NULL, 0, 0, -1, false, false };
+    slices_.push_back(slice);
+  }
+  slices_.back().buffer->append(data, len);
+  readable_ += len;
+}
+
+void ChainBuffer::append(Buffer&& buf)
+{
+  const size_t len = buf.readableBytes();
+  if (len == 0)
+  {
+    return;
+  }
+  std::shared_ptr<Buffer> holder(new Buffer(0));
+  holder->swap(buf);
+  Slice slice = { holder, holder.get(), NULL, 0, 0, -1, false, false };
+  slices_.push_back(slice);
+  readable_ += len;
+}
+
+void ChainBuffer::append(const std::shared_ptr<const string>& str)
+{
+  if (!str || str->empty())
+  {
+    return;
+  }
+  Slice slice = { str, NULL, str->data(), str->size(), 0, -1, false, false };
+  slices_.push_back(slice);
+  readable_ += str->size();
+}
+
+void ChainBuffer::append(ChainBuffer&& rhs)
+{
+  if (slices_.empty())
+  {
+    swap(rhs);
+    return;
+  }
+  for (Slice& slice : rhs.slices_)
+  {
+    slices_.push_back(std::move(slice));
+  }
+  readable_ += rhs.readable_;
+  rhs.retrieveAll();
+}
+
+void ChainBuffer::appendFile(int fd, int64_t offset, size_t len)
+{
+  std::shared_ptr<int> holder(new int(fd), closeFile);
+  if (len == 0)
+  {
+    return;
+  }
+  struct stat st;
+  bool isPipe = ::fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+  Slice slice = { holder, NULL, NULL, len, offset, fd, true, isPipe };
+  slices_.push_back(slice);
+  readable_ += len;
+}
+
+void ChainBuffer::retrieve(size_t len)
+{
+  assert(len <= readable_);
+  readable_ -= len;
+  while (len > 0)
+  {
+    assert(!slices_.empty());
+    Slice& front = slices_.front();
+    const size_t n = front.readableBytes();
+    if (len < n)
+    {
+      front.retrieve(len);
+      break;
+    }
+    len -= n;
+    slices_.pop_front();
+  }
+}
+
+string ChainBuffer::retrieveAllAsString()
+{
+  string result;
+  result.reserve(readable_);
+  for (const Slice& slice : slices_)
+  {
+    if (!slice.isFile)
+    {
+      result.append(slice.peek(), slice.readableBytes());
+    }
+  }
+  retrieveAll();
+  return result;
+}
+
+int ChainBuffer::fillIovec(struct iovec* vec, int maxIov) const
+{
+  int n = 0;
+  for (std::deque<Slice>::const_iterator it = slices_.begin();
+       it != slices_.end() && !it->isFile && n < maxIov; ++it)
+  {
+    vec[n].iov_base = const_cast<char*>(it->peek());
+    vec[n].iov_len = it->readableBytes();
+    ++n;
+  }
+  return n;
+}
+
+ssize_t ChainBuffer::writeFd(int fd, int* savedErrno)
+{
+  if (!slices_.empty() && slices_.front().isFile)
+  {
+    return writeFileFd(fd, savedErrno);
+  }
+  struct iovec vec[kMaxIovec];
+  const int iovcnt = fillIovec(vec, kMaxIovec);
+  const ssize_t n = sockets::writev(fd, vec, iovcnt);
+  if (n < 0)
+  {
+    *savedErrno = errno;
+  }
+  else
+  {
+    retrieve(implicit_cast<size_t>(n));
+  }
+  return n;
+}
+
+void ChainBuffer::appendPipe(int fd, size_t len, const std::shared_ptr<const void>& holder)
+{
+  if (len == 0)
+  {
+    return;
+  }
+  if (!slices_.empty() && slices_.back().isPipe && slices_.back().fd == fd)
+  {
+    slices_.back().len += len;
+  }
+  else
+  {
+    Slice slice = { holder, NULL, NULL, len, 0, fd, true, true };
+    slices_.push_back(slice);
+  }
+  readable_ += len;
+}
+
+ssize_t ChainBuffer::writeFileFd(int fd, int* savedErrno)
+{
+  Slice& front = slices_.front();
+  assert(front.isFile);
+  ssize_t n = 0;
+  if (front.isPipe)
+  {
+    n = ::splice(front.fd, NULL, fd, NULL, front.len,
+                 SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  }
+  else
+  {
+    off_t offset = static_cast<off_t>(front.offset);
+    n = ::sendfile(fd, front.fd, &offset, front.len);
+  }
+  if (n < 0)
+  {
+    *savedErrno = errno;
+  }
+  else if (n == 0)
+  {
+    // EOF before len bytes, drop the rest of this region.
+    LOG_ERROR << "ChainBuffer::writeFileFd - fd " << front.fd
+              << " is short of " << front.len << " bytes";
+    readable_ -= front.len;
+    slices_.pop_front();
+  }
+  else
+  {
+    retrieve(implicit_cast<size_t>(n));
+  }
+  return n;
+}
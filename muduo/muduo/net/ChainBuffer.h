@@ -0,0 +1,169 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_CHAINBUFFER_H
+#define MUDUO_NET_CHAINBUFFER_H
+
+#include "muduo/base/StringPiece.h"
+#include "muduo/base/Types.h"
+#include "muduo/net/Buffer.h"
+
+#include <deque>
+#include <memory>
+
+struct iovec;
+
+namespace muduo
+{
+namespace net
+{
+
+/// A chain of refcounted byte slices, used as the output queue
+/// of TcpConnection.
+///
+/// Payloads are handed over by move (Buffer) or shared (string),
+/// so they are never copied into a contiguous region,
+/// and the whole chain is flushed with one writev(2).
+/// Small pieces appended by copy are coalesced into the last slice.
+/// File regions are sent with sendfile(2), or splice(2) for pipes,
+/// without being read into user space.
+///
+/// Movable, but not copyable, the last slice is modified in place.
+class ChainBuffer
+{
+ public:
+  static const size_t kSliceSize = 4096;
+  static const int kMaxIovec = 64;
+
+  ChainBuffer()
+    : readable_(0)
+  {
+  }
+
+  ChainBuffer(ChainBuffer&& rhs) = default;
+  ChainBuffer& operator=(ChainBuffer&& rhs) = default;
+  ChainBuffer(const ChainBuffer&) = delete;
+  ChainBuffer& operator=(const ChainBuffer&) = delete;
+
+  void swap(ChainBuffer& rhs)
+  {
+    slices_.swap(rhs.slices_);
+    std::swap(readable_, rhs.readable_);
+  }
+
+  size_t readableBytes() const
+  { return readable_; }
+
+  size_t numSlices() const
+  { return slices_.size(); }
+
+  bool empty() const
+  { return readable_ == 0; }
+
+  /// Copies data into the last slice, or a new one if it doesn't fit.
+  void append(const char* data, size_t len);
+
+  void append(const StringPiece& str)
+  {
+    append(str.data(), str.size());
+  }
+
+  /// Takes over the content of buf without copying, buf becomes empty.
+  void append(Buffer&& buf);
+
+  /// Shares str without copying, str must not be modified afterwards.
+  void append(const std::shared_ptr<const string>& str);
+
+  /// Moves all slices of rhs to the end of this chain.
+  void append(ChainBuffer&& rhs);
+
+  /// Appends len bytes of fd starting at offset, takes ownership of fd.
+  /// fd is closed when the region is retrieved or the chain destructs.
+  /// For a pipe, offset is ignored and len bytes will be spliced.
+  void appendFile(int fd, int64_t offset, size_t len);
+
+  /// Appends len bytes of a pipe kept open by holder, without taking
+  /// ownership of fd, for a pipe reused by successive regions.
+  /// Merged into the last slice if it is of the same pipe.
+  void appendPipe(int fd, size_t len, const std::shared_ptr<const void>& holder);
+
+  void retrieve(size_t len);
+
+  void retrieveAll()
+  {
+    slices_.clear();
+    readable_ = 0;
+  }
+
+  /// Content of file regions is not included.
+  string retrieveAllAsString();
+
+  /// Fills at most maxIov entries starting from the first slice,
+  /// stops at the first file region,
+  /// returns number of entries filled.
+  int fillIovec(struct iovec* vec, int maxIov) const;
+
+  /// fd of the pipe the chain sends from next, -1 if it does not start
+  /// with a pipe.
+  int frontPipe() const
+  { return !slices_.empty() && slices_.front().isPipe ? slices_.front().fd : -1; }
+
+  /// Writes as much as possible to fd with writev(2),
+  /// or sendfile(2) if the chain starts with a file region,
+  /// and retrieves the bytes written.
+  ssize_t writeFd(int fd, int* savedErrno);
+
+ private:
+  struct Slice
+  {
+    // keeps the payload alive
+    std::shared_ptr<const void> holder;
+    // non-null for slices owning a Buffer, which may grow in place
+    Buffer* buffer;
+    const char* data;
+    size_t len;
+    // file region, data is NULL and fd is owned by holder
+    int64_t offset;
+    int fd;
+    bool isFile;
+    bool isPipe;
+
+    const char* peek() const
+    { return buffer ? buffer->peek() : data; }
+
+    size_t readableBytes() const
+    { return buffer ? buffer->readableBytes() : len; }
+
+    void retrieve(size_t n)
+    {
+      if (buffer)
+      {
+        buffer->retrieve(n);
+      }
+      else if (isFile)
+      {
+        offset += static_cast<int64_t>(n);
+        len -= n;
+      }
+      else
+      {
+        data += n;
+        len -= n;
+      }
+    }
+  };
+
+  ssize_t writeFileFd(int fd, int* savedErrno);
+
+  std::deque<Slice> slices_;
+  size_t readable_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_CHAINBUFFER_H
@@ -11,11 +11,13 @@
 #include "muduo/base/Logging.h"
 #include "muduo/base/Mutex.h"
 #include "muduo/net/Channel.h"
+#include "muduo/net/LoopMetrics.h"
 #include "muduo/net/Poller.h"
 #include "muduo/net/SocketsOps.h"
 #include "muduo/net/TimerQueue.h"
 
 #include <algorithm>
+#include <iterator>
 
 #include <signal.h>
 #include <sys/eventfd.h>
@@ -29,6 +31,7 @@ namespace
 __thread EventLoop* t_loopInThisThread = 0;
 
 const int kPollTimeMs = 10000;
+const size_t kPendingFunctorsCapacity = 1024;
 
 int createEventfd()
 {
@@ -70,9 +73,13 @@ EventLoop::EventLoop()
     threadId_(CurrentThread::tid()),
     poller_(Poller::newDefaultPoller(this)),
     timerQueue_(new TimerQueue(this)),
+    metrics_(new LoopMetrics),
     wakeupFd_(createEventfd()),
     wakeupChannel_(new Channel(this, wakeupFd_)),
-    currentActiveChannel_(NULL)
+    currentActiveChannel_(NULL),
+    sleeping_(false),
+    pendingFunctors_(kPendingFunctorsCapacity),
+    overflowing_(false)
 {
   LOG_DEBUG << "EventLoop created " << this << " in thread " << threadId_;
   if (t_loopInThisThread)
@@ -108,11 +115,19 @@ void EventLoop::loop()
   quit_ = false;  // FIXME: what if someone calls quit() before loop() ?
   LOG_TRACE << "EventLoop " << this << " start looping";
 
+  int64_t handled = LoopMetrics::now();
   while (!quit_)
   {
     activeChannels_.clear();
-    pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
+    // checks after setting sleeping_, either we see a functor queued,
+    // or its producer sees us sleeping and wakes us up.
+    sleeping_.store(true);
+    int timeoutMs = hasPendingFunctors() ? 0 : kPollTimeMs;
+    pollReturnTime_ = poller_->poll(timeoutMs, &activeChannels_);
+    sleeping_.store(false);
     ++iteration_;
+    int64_t polled = LoopMetrics::now();
+    metrics_->pollWait.add(polled - handled);
     if (Logger::logLevel() <= Logger::TRACE)
     {
       printActiveChannels();
@@ -127,6 +142,8 @@ void EventLoop::loop()
     currentActiveChannel_ = NULL;
     eventHandling_ = false;
     doPendingFunctors();
+    handled = LoopMetrics::now();
+    metrics_->handling.add(handled - polled);
   }
 
   LOG_TRACE << "EventLoop " << this << " stop looping";
@@ -159,12 +176,17 @@ void EventLoop::runInLoop(Functor cb)
 
 void EventLoop::queueInLoop(Functor cb)
 {
+  if (overflowing_.load(std::memory_order_acquire)
+      || !pendingFunctors_.tryPush(std::move(cb)))
   {
-  MutexLockGuard lock(mutex_);
-  pendingFunctors_.push_back(std::move(cb));
+    MutexLockGuard lock(mutex_);
+    overflowFunctors_.push_back(std::move(cb));
+    overflowing_.store(true);
   }
 
-  if (!isInLoopThread() || callingPendingFunctors_)
+  // no need to wake up the loop thread if it's not blocked in poll,
+  // it always checks pending functors before polling.
+  if (sleeping_.load() && sleeping_.exchange(false))
   {
     wakeup();
   }
@@ -173,7 +195,7 @@ void EventLoop::queueInLoop(Functor cb)
 size_t EventLoop::queueSize() const
 {
   MutexLockGuard lock(mutex_);
-  return pendingFunctors_.size();
+  return pendingFunctors_.size() + overflowFunctors_.size();
 }
 
 TimerId EventLoop::runAt(Timestamp time, TimerCallback cb)
@@ -198,6 +220,12 @@ void EventLoop::cancel(TimerId timerId)
   return timerQueue_->cancel(timerId);
 }
 
+void EventLoop::setTimingWheel(double tickSeconds)
+{
+  assertInLoopThread();
+  timerQueue_->setTimingWheel(tickSeconds);
+}
+
 void EventLoop::updateChannel(Channel* channel)
 {
   assert(channel->ownerLoop() == this);
@@ -253,21 +281,50 @@ void EventLoop::handleRead()
 
 void EventLoop::doPendingFunctors()
 {
-  std::vector<Functor> functors;
   callingPendingFunctors_ = true;
 
+  // functors queued from now on, including by these ones, run next time.
+  Functor functor;
+  const size_t pending = pendingFunctors_.size();
+  size_t run = 0;
+  while (run < pending && pendingFunctors_.tryPop(&functor))
   {
-  MutexLockGuard lock(mutex_);
-  functors.swap(pendingFunctors_);
+    functor();
+    ++run;
   }
 
-  for (const Functor& functor : functors)
+  if (overflowing_.load(std::memory_order_acquire))
   {
-    functor();
+    // overflowed functors are behind all in pendingFunctors_,
+    // which is not refilled while overflowing_.
+    std::vector<Functor> functors;
+    while (pendingFunctors_.tryPop(&functor))
+    {
+      functors.push_back(std::move(functor));
+    }
+    if (pendingFunctors_.empty())
+    {
+      MutexLockGuard lock(mutex_);
+      std::move(overflowFunctors_.begin(), overflowFunctors_.end(),
+                std::back_inserter(functors));
+      overflowFunctors_.clear();
+      overflowing_.store(false);
+    }
+    for (const Functor& f : functors)
+    {
+      f();
+    }
+    run += functors.size();
   }
+  metrics_->addFunctors(pending, run);
   callingPendingFunctors_ = false;
 }
 
+bool EventLoop::hasPendingFunctors() const
+{
+  return !pendingFunctors_.empty() || overflowing_.load();
+}
+
 void EventLoop::printActiveChannels() const
 {
   for (const Channel* channel : activeChannels_)
@@ -17,7 +17,9 @@
 
 #include <boost/any.hpp>
 
+#include "muduo/base/InlineFunction.h"
 #include "muduo/base/Mutex.h"
+#include "muduo/base/MpscQueue.h"
 #include "muduo/base/CurrentThread.h"
 #include "muduo/base/Timestamp.h"
 #include "muduo/net/Callbacks.h"
@@ -29,6 +31,7 @@ namespace net
 {
 
 class Channel;
+class LoopMetrics;
 class Poller;
 class TimerQueue;
 
@@ -39,7 +42,8 @@ class TimerQueue;
 class EventLoop : noncopyable
 {
  public:
-  typedef std::function<void()> Functor;
+  // small functors are kept in the queue cell, without allocation
+  typedef InlineFunction Functor;
 
   EventLoop();
   ~EventLoop();  // force out-line dtor, for std::unique_ptr members.
@@ -98,12 +102,21 @@ class EventLoop : noncopyable
   /// Safe to call from other threads.
   ///
   void cancel(TimerId timerId);
+  ///
+  /// Keeps timers in a hierarchical timing wheel with @c tickSeconds
+  /// resolution, instead of a balanced tree.
+  /// Suits many short-lived timers which are mostly canceled,
+  /// e.g. idle timeouts, timers fire up to one tick late.
+  /// Must be called in loop thread.
+  ///
+  void setTimingWheel(double tickSeconds);
 
   // internal usage
   void wakeup();
   void updateChannel(Channel* channel);
   void removeChannel(Channel* channel);
   bool hasChannel(Channel* channel);
+  LoopMetrics* metrics() { return metrics_.get(); }
 
   // pid_t threadId() const { return threadId_; }
   void assertInLoopThread()
@@ -132,6 +145,7 @@ class EventLoop : noncopyable
   void abortNotInLoopThread();
   void handleRead();  // waked up
   void doPendingFunctors();
+  bool hasPendingFunctors() const;
 
   void printActiveChannels() const; // DEBUG
 
@@ -146,6 +160,7 @@ class EventLoop : noncopyable
   Timestamp pollReturnTime_;
   std::unique_ptr<Poller> poller_;
   std::unique_ptr<TimerQueue> timerQueue_;
+  std::unique_ptr<LoopMetrics> metrics_;
   int wakeupFd_;
   // unlike in TimerQueue, which is an internal class,
   // we don't expose Channel to client.
@@ -156,8 +171,15 @@ class EventLoop : noncopyable
   ChannelList activeChannels_;
   Channel* currentActiveChannel_;
 
+  // set while loop thread is (about to be) blocked in poll,
+  // the first producer clears it and writes to wakeupFd_.
+  std::atomic<bool> sleeping_;
+  MpscQueue<Functor> pendingFunctors_;
+  // pendingFunctors_ was full, later functors go to overflowFunctors_
+  // until both are drained, to keep them in order.
+  std::atomic<bool> overflowing_;
   mutable MutexLock mutex_;
-  std::vector<Functor> pendingFunctors_ GUARDED_BY(mutex_);
+  std::vector<Functor> overflowFunctors_ GUARDED_BY(mutex_);
 };
 
 }  // namespace net
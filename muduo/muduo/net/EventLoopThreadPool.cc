@@ -10,18 +10,31 @@
 
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/EventLoopThread.h"
+#include "muduo/net/LoopMetrics.h"
+
+#include <algorithm>
 
 #include <stdio.h>
 
 using namespace muduo;
 using namespace muduo::net;
 
+namespace
+{
+// busy ratio is sampled at most once in this interval
+const double kSampleInterval = 0.1;
+// loops whose busy ratios are this close are equally busy,
+// so that connections accepted between two samples spread out.
+const int kBusyLevels = 20;
+}
+
 EventLoopThreadPool::EventLoopThreadPool(EventLoop* baseLoop, const string& nameArg)
   : baseLoop_(baseLoop),
     name_(nameArg),
     started_(false),
     numThreads_(0),
-    next_(0)
+    next_(0),
+    policy_(kRoundRobin)
 {
 }
 
@@ -45,6 +58,9 @@ void EventLoopThreadPool::start(const ThreadInitCallback& cb)
     threads_.push_back(std::unique_ptr<EventLoopThread>(t));
     loops_.push_back(t->startLoop());
   }
+  Load idle = { 0, 0.0 };
+  loads_.assign(loops_.size(), idle);
+  lastSample_ = Timestamp::now();
   if (numThreads_ == 0 && cb)
   {
     cb(baseLoop_);
@@ -59,9 +75,13 @@ EventLoop* EventLoopThreadPool::getNextLoop()
 
   if (!loops_.empty())
   {
-    // round-robin
-    loop = loops_[next_];
-    ++next_;
+    size_t index = next_;
+    if (policy_ != kRoundRobin)
+    {
+      index = selectLeastLoaded();
+    }
+    loop = loops_[index];
+    next_ = static_cast<int>(index + 1);
     if (implicit_cast<size_t>(next_) >= loops_.size())
     {
       next_ = 0;
@@ -70,6 +90,59 @@ EventLoop* EventLoopThreadPool::getNextLoop()
   return loop;
 }
 
+size_t EventLoopThreadPool::selectLeastLoaded()
+{
+  if (policy_ == kLeastBusy)
+  {
+    Timestamp now(Timestamp::now());
+    if (timeDifference(now, lastSample_) >= kSampleInterval)
+    {
+      sampleLoad(now);
+    }
+  }
+
+  // starts from next_, so ties go round-robin
+  const size_t n = loops_.size();
+  size_t best = next_;
+  int bestLevel = 0;
+  int64_t bestConnections = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    size_t index = (next_ + i) % n;
+    int level = 0;
+    if (policy_ == kLeastBusy)
+    {
+      level = static_cast<int>(loads_[index].busyRatio * kBusyLevels);
+    }
+    // counted by TcpConnection::ctor, not after connectEstablished(),
+    // so a burst of new connections see each other.
+    int64_t connections = loops_[index]->metrics()->connections();
+    if (i == 0
+        || level < bestLevel
+        || (level == bestLevel && connections < bestConnections))
+    {
+      best = index;
+      bestLevel = level;
+      bestConnections = connections;
+    }
+  }
+  return best;
+}
+
+void EventLoopThreadPool::sampleLoad(Timestamp now)
+{
+  double elapsed = timeDifference(now, lastSample_) * Timestamp::kMicroSecondsPerSecond;
+  for (size_t i = 0; i < loops_.size(); ++i)
+  {
+    int64_t busyTime = loops_[i]->metrics()->busyTime();
+    double ratio = static_cast<double>(busyTime - loads_[i].busyTime) / elapsed;
+    // moving average, halves the old ratio in every sample
+    loads_[i].busyRatio = (loads_[i].busyRatio + std::min(ratio, 1.0)) / 2;
+    loads_[i].busyTime = busyTime;
+  }
+  lastSample_ = now;
+}
+
 EventLoop* EventLoopThreadPool::getLoopForHash(size_t hashCode)
 {
   baseLoop_->assertInLoopThread();
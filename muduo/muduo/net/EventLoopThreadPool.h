@@ -12,6 +12,7 @@
 #define MUDUO_NET_EVENTLOOPTHREADPOOL_H
 
 #include "muduo/base/noncopyable.h"
+#include "muduo/base/Timestamp.h"
 #include "muduo/base/Types.h"
 
 #include <functional>
@@ -32,13 +33,22 @@ class EventLoopThreadPool : noncopyable
  public:
   typedef std::function<void(EventLoop*)> ThreadInitCallback;
 
+  /// How getNextLoop() chooses, ties are broken in round-robin.
+  enum SelectPolicy
+  {
+    kRoundRobin,
+    kLeastConnections,  // fewest TcpConnections
+    kLeastBusy,  // least busy time recently, then fewest TcpConnections
+  };
+
   EventLoopThreadPool(EventLoop* baseLoop, const string& nameArg);
   ~EventLoopThreadPool();
   void setThreadNum(int numThreads) { numThreads_ = numThreads; }
+  void setSelectPolicy(SelectPolicy policy) { policy_ = policy; }
   void start(const ThreadInitCallback& cb = ThreadInitCallback());
 
   // valid after calling start()
-  /// round-robin
+  /// by SelectPolicy, round-robin by default
   EventLoop* getNextLoop();
 
   /// with the same hash code, it will always return the same EventLoop
@@ -53,14 +63,25 @@ class EventLoopThreadPool : noncopyable
   { return name_; }
 
  private:
+  struct Load
+  {
+    int64_t busyTime;  // microseconds, at last sample
+    double busyRatio;  // smoothed
+  };
+
+  size_t selectLeastLoaded();
+  void sampleLoad(Timestamp now);
 
   EventLoop* baseLoop_;
   string name_;
   bool started_;
   int numThreads_;
   int next_;
+  SelectPolicy policy_;
   std::vector<std::unique_ptr<EventLoopThread>> threads_;
   std::vector<EventLoop*> loops_;
+  std::vector<Load> loads_;
+  Timestamp lastSample_;
 };
 
 }  // namespace net
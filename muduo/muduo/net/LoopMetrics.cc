@@ -0,0 +1,116 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/net/LoopMetrics.h"
+
+#include "muduo/base/CurrentThread.h"
+#include "muduo/base/Mutex.h"
+
+#include <algorithm>
+
+#include <time.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int LoopMetrics::Histogram::kBuckets;
+
+namespace
+{
+// loops register themselves, so that Inspector finds them.
+struct Registry
+{
+  MutexLock mutex;
+  std::vector<const LoopMetrics*> loops GUARDED_BY(mutex);
+};
+
+// constructed on first use, an EventLoop could be a global object.
+Registry& registry()
+{
+  static Registry instance;
+  return instance;
+}
+}
+
+int64_t LoopMetrics::now()
+{
+  struct timespec ts;
+  ::clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000 * 1000 + ts.tv_nsec / 1000;
+}
+
+LoopMetrics::Histogram::Histogram()
+  : sum_(0)
+{
+  for (auto& count : counts_)
+  {
+    count.store(0, std::memory_order_relaxed);
+  }
+}
+
+LoopMetrics::LoopMetrics()
+  : name_(CurrentThread::name()),
+    tid_(CurrentThread::tid()),
+    functors_(0),
+    pendingFunctors_(0),
+    maxPendingFunctors_(0),
+    bytesRead_(0),
+    bytesWritten_(0),
+    outputBufferHighWater_(0),
+    connections_(0)
+{
+  Registry& reg = registry();
+  MutexLockGuard lock(reg.mutex);
+  reg.loops.push_back(this);
+}
+
+LoopMetrics::~LoopMetrics()
+{
+  Registry& reg = registry();
+  MutexLockGuard lock(reg.mutex);
+  reg.loops.erase(std::remove(reg.loops.begin(), reg.loops.end(), this), reg.loops.end());
+}
+
+std::vector<LoopMetrics::Snapshot> LoopMetrics::snapshotAll()
+{
+  std::vector<Snapshot> result;
+  Registry& reg = registry();
+  MutexLockGuard lock(reg.mutex);
+  result.reserve(reg.loops.size());
+  for (const LoopMetrics* loop : reg.loops)
+  {
+    result.push_back(loop->snapshot());
+  }
+  return result;
+}
+
+LoopMetrics::Snapshot LoopMetrics::snapshot() const
+{
+  Snapshot result;
+  result.name = name_;
+  result.tid = tid_;
+  fill(pollWait, &result.pollWait);
+  fill(handling, &result.handling);
+  fill(timerLateness, &result.timerLateness);
+  result.functors = functors_.load(std::memory_order_relaxed);
+  result.pendingFunctors = pendingFunctors_.load(std::memory_order_relaxed);
+  result.maxPendingFunctors = maxPendingFunctors_.load(std::memory_order_relaxed);
+  result.bytesRead = bytesRead_.load(std::memory_order_relaxed);
+  result.bytesWritten = bytesWritten_.load(std::memory_order_relaxed);
+  result.outputBufferHighWater = outputBufferHighWater_.load(std::memory_order_relaxed);
+  result.connections = connections_.load(std::memory_order_relaxed);
+  return result;
+}
+
+void LoopMetrics::fill(const Histogram& h, HistogramSnapshot* out)
+{
+  out->count = 0;
+  for (int i = 0; i <= Histogram::kBuckets; ++i)
+  {
+    out->counts[i] = h.counts_[i].load(std::memory_order_relaxed);
+    out->count += out->counts[i];
+  }
+  out->sum = h.sum_.load(std::memory_order_relaxed);
+}
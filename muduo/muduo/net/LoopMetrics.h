@@ -0,0 +1,158 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_LOOPMETRICS_H
+#define MUDUO_NET_LOOPMETRICS_H
+
+#include "muduo/base/noncopyable.h"
+#include "muduo/base/Types.h"
+
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Statistics of an EventLoop, always on.
+///
+/// Every field but connections is written only in the loop thread,
+/// so a write is a relaxed load and store without a locked instruction,
+/// and is read by other threads, e.g. Inspector, in snapshots.
+/// EventLoopThreadPool reads connections and busy time to choose a loop.
+///
+class LoopMetrics : noncopyable
+{
+ public:
+  /// Histogram of durations, bucket i counts those <= 2^i microseconds,
+  /// the last one counts the rest.
+  class Histogram : noncopyable
+  {
+   public:
+    static const int kBuckets = 24;
+
+    Histogram();
+
+    void add(int64_t microseconds)
+    {
+      increase(&counts_[bucketOf(microseconds)], 1);
+      increase(&sum_, microseconds);
+    }
+
+    static int bucketOf(int64_t microseconds)
+    {
+      if (microseconds <= 1)
+        return 0;
+      int bucket = 64 - __builtin_clzll(static_cast<uint64_t>(microseconds - 1));
+      return bucket < kBuckets ? bucket : kBuckets;
+    }
+
+   private:
+    friend class LoopMetrics;
+    std::atomic<int64_t> counts_[kBuckets + 1];
+    std::atomic<int64_t> sum_;
+  };
+
+  struct HistogramSnapshot
+  {
+    int64_t counts[Histogram::kBuckets + 1];  // not cumulative
+    int64_t sum;  // microseconds
+    int64_t count;
+  };
+
+  struct Snapshot
+  {
+    string name;  // of loop thread
+    int tid;
+    HistogramSnapshot pollWait;
+    HistogramSnapshot handling;
+    HistogramSnapshot timerLateness;
+    int64_t functors;
+    int64_t pendingFunctors;
+    int64_t maxPendingFunctors;
+    int64_t bytesRead;
+    int64_t bytesWritten;
+    int64_t outputBufferHighWater;
+    int64_t connections;
+  };
+
+  /// Must be constructed in the loop thread.
+  LoopMetrics();
+  ~LoopMetrics();
+
+  /// of all live loops, ordered by construction.
+  static std::vector<Snapshot> snapshotAll();
+
+  /// Microseconds of the monotonic clock, to time pollWait and handling,
+  /// which must not jump with the wall clock.
+  static int64_t now();
+
+  Snapshot snapshot() const;
+
+  // time blocked in poller, per iteration
+  Histogram pollWait;
+  // time handling active channels and pending functors, per iteration
+  Histogram handling;
+  // from expiration of a timer to running it
+  Histogram timerLateness;
+
+  void addFunctors(size_t pending, size_t run)
+  {
+    int64_t n = static_cast<int64_t>(pending);
+    pendingFunctors_.store(n, std::memory_order_relaxed);
+    setMax(&maxPendingFunctors_, n);
+    increase(&functors_, static_cast<int64_t>(run));
+  }
+
+  void addBytesRead(int64_t n) { increase(&bytesRead_, n); }
+  void addBytesWritten(int64_t n) { increase(&bytesWritten_, n); }
+  void setOutputBytes(size_t n)
+  { setMax(&outputBufferHighWater_, static_cast<int64_t>(n)); }
+
+  // a TcpConnection is counted by the thread creating it,
+  // usually not the loop thread.
+  void addConnection() { connections_.fetch_add(1, std::memory_order_relaxed); }
+  void removeConnection() { connections_.fetch_sub(1, std::memory_order_relaxed); }
+  int64_t connections() const { return connections_.load(std::memory_order_relaxed); }
+
+  // microseconds, sum of handling
+  int64_t busyTime() const { return handling.sum_.load(std::memory_order_relaxed); }
+
+ private:
+  static void increase(std::atomic<int64_t>* x, int64_t n)
+  {
+    x->store(x->load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  static void setMax(std::atomic<int64_t>* x, int64_t n)
+  {
+    if (n > x->load(std::memory_order_relaxed))
+    {
+      x->store(n, std::memory_order_relaxed);
+    }
+  }
+
+  static void fill(const Histogram& h, HistogramSnapshot* out);
+
+  const string name_;
+  const int tid_;
+  std::atomic<int64_t> functors_;
+  std::atomic<int64_t> pendingFunctors_;  // in the last iteration
+  std::atomic<int64_t> maxPendingFunctors_;
+  std::atomic<int64_t> bytesRead_;  // of all TcpConnections
+  std::atomic<int64_t> bytesWritten_;
+  std::atomic<int64_t> outputBufferHighWater_;  // of any TcpConnection
+  std::atomic<int64_t> connections_;  // TcpConnections owned by this loop
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_LOOPMETRICS_H
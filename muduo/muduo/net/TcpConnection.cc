@@ -12,10 +12,15 @@
 #include "muduo/base/WeakCallback.h"
 #include "muduo/net/Channel.h"
 #include "muduo/net/EventLoop.h"
+#include "muduo/net/LoopMetrics.h"
 #include "muduo/net/Socket.h"
 #include "muduo/net/SocketsOps.h"
 
 #include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
 
 using namespace muduo;
 using namespace muduo::net;
@@ -35,6 +40,35 @@ void muduo::net::defaultMessageCallback(const TcpConnectionPtr&,
   buf->retrieveAll();
 }
 
+struct TcpConnection::Pipe : noncopyable
+{
+  static const int kPipeSize = 1024*1024;
+
+  Pipe()
+  {
+    if (::pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0)
+    {
+      fds[0] = fds[1] = -1;
+    }
+    else
+    {
+      // fewer wakeups, up to /proc/sys/fs/pipe-max-size, 1MiB by default
+      ::fcntl(fds[1], F_SETPIPE_SZ, kPipeSize);
+    }
+  }
+
+  ~Pipe()
+  {
+    if (fds[0] >= 0)
+    {
+      ::close(fds[0]);
+      ::close(fds[1]);
+    }
+  }
+
+  int fds[2];  // read end, write end
+};
+
 TcpConnection::TcpConnection(EventLoop* loop,
                              const string& nameArg,
                              int sockfd,
@@ -44,11 +78,15 @@ TcpConnection::TcpConnection(EventLoop* loop,
     name_(nameArg),
     state_(kConnecting),
     reading_(true),
+    throttled_(false),
+    relayFull_(false),
     socket_(new Socket(sockfd)),
     channel_(new Channel(loop, sockfd)),
     localAddr_(localAddr),
     peerAddr_(peerAddr),
-    highWaterMark_(64*1024*1024)
+    highWaterMark_(64*1024*1024),
+    backpressureHigh_(0),
+    backpressureLow_(0)
 {
   channel_->setReadCallback(
       std::bind(&TcpConnection::handleRead, this, _1));
@@ -61,6 +99,7 @@ TcpConnection::TcpConnection(EventLoop* loop,
   LOG_DEBUG << "TcpConnection::ctor[" <<  name_ << "] at " << this
             << " fd=" << sockfd;
   socket_->setKeepAlive(true);
+  loop->metrics()->addConnection();
 }
 
 TcpConnection::~TcpConnection()
@@ -93,14 +132,14 @@ void TcpConnection::send(const StringPiece& message)
 {
   if (state_ == kConnected)
   {
-    if (loop_->isInLoopThread())
+    if (loop()->isInLoopThread())
     {
       sendInLoop(message);
     }
     else
     {
       void (TcpConnection::*fp)(const StringPiece& message) = &TcpConnection::sendInLoop;
-      loop_->runInLoop(
+      loop()->runInLoop(
           std::bind(fp,
                     this,     // FIXME
                     message.as_string()));
@@ -109,36 +148,121 @@ void TcpConnection::send(const StringPiece& message)
   }
 }
 
-// FIXME efficiency!!!
 void TcpConnection::send(Buffer* buf)
 {
   if (state_ == kConnected)
   {
-    if (loop_->isInLoopThread())
+    if (loop()->isInLoopThread())
     {
       sendInLoop(buf->peek(), buf->readableBytes());
       buf->retrieveAll();
     }
     else
     {
-      void (TcpConnection::*fp)(const StringPiece& message) = &TcpConnection::sendInLoop;
-      loop_->runInLoop(
-          std::bind(fp,
+      std::shared_ptr<ChainBuffer> message(new ChainBuffer);
+      message->append(std::move(*buf));
+      loop()->runInLoop(
+          std::bind(&TcpConnection::sendChainInLoop,
                     this,     // FIXME
-                    buf->retrieveAllAsString()));
-                    //std::forward<string>(message)));
+                    message));
     }
   }
 }
 
+void TcpConnection::send(Buffer&& buf)
+{
+  if (state_ == kConnected)
+  {
+    ChainBuffer message;
+    message.append(std::move(buf));
+    send(std::move(message));
+  }
+}
+
+void TcpConnection::send(ChainBuffer&& message)
+{
+  if (state_ == kConnected)
+  {
+    if (loop()->isInLoopThread())
+    {
+      sendInLoop(&message);
+    }
+    else
+    {
+      loop()->runInLoop(
+          std::bind(&TcpConnection::sendChainInLoop,
+                    this,     // FIXME
+                    std::make_shared<ChainBuffer>(std::move(message))));
+    }
+  }
+}
+
+void TcpConnection::send(const std::shared_ptr<const string>& message)
+{
+  if (state_ == kConnected)
+  {
+    if (loop()->isInLoopThread())
+    {
+      sendSharedInLoop(message);
+    }
+    else
+    {
+      loop()->runInLoop(
+          std::bind(&TcpConnection::sendSharedInLoop,
+                    this,     // FIXME
+                    message));
+    }
+  }
+}
+
+void TcpConnection::sendFile(int fd, int64_t offset, size_t len)
+{
+  if (state_ == kConnected)
+  {
+    int dupfd = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (dupfd < 0)
+    {
+      LOG_SYSERR << "TcpConnection::sendFile";
+      return;
+    }
+    ChainBuffer message;
+    message.appendFile(dupfd, offset, len);
+    send(std::move(message));
+  }
+}
+
 void TcpConnection::sendInLoop(const StringPiece& message)
 {
+  if (!loop()->isInLoopThread())
+  {
+    // queued before migrateTo()
+    void (TcpConnection::*fp)(const StringPiece& message) = &TcpConnection::sendInLoop;
+    loop()->queueInLoop(std::bind(fp, this, message.as_string()));
+    return;
+  }
   sendInLoop(message.data(), message.size());
 }
 
+void TcpConnection::sendSharedInLoop(const std::shared_ptr<const string>& message)
+{
+  if (!loop()->isInLoopThread())
+  {
+    // queued before migrateTo()
+    loop()->queueInLoop(std::bind(&TcpConnection::sendSharedInLoop, this, message));
+    return;
+  }
+  sendInLoop(message->data(), message->size(), message);
+}
+
 void TcpConnection::sendInLoop(const void* data, size_t len)
 {
-  loop_->assertInLoopThread();
+  sendInLoop(data, len, std::shared_ptr<const string>());
+}
+
+void TcpConnection::sendInLoop(const void* data, size_t len,
+                               const std::shared_ptr<const string>& holder)
+{
+  loop()->assertInLoopThread();
   ssize_t nwrote = 0;
   size_t remaining = len;
   bool faultError = false;
@@ -148,15 +272,16 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
     return;
   }
   // if no thing in output queue, try writing directly
-  if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0)
+  if (!channel_->isWriting() && outputBytes() == 0)
   {
     nwrote = sockets::write(channel_->fd(), data, len);
     if (nwrote >= 0)
     {
+      loop()->metrics()->addBytesWritten(nwrote);
       remaining = len - nwrote;
       if (remaining == 0 && writeCompleteCallback_)
       {
-        loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+        loop()->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
       }
     }
     else // nwrote < 0
@@ -176,19 +301,142 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
   assert(remaining <= len);
   if (!faultError && remaining > 0)
   {
-    size_t oldLen = outputBuffer_.readableBytes();
+    size_t oldLen = outputBytes();
+    if (oldLen + remaining >= highWaterMark_
+        && oldLen < highWaterMark_
+        && highWaterMarkCallback_)
+    {
+      loop()->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), oldLen + remaining));
+    }
+    if (holder)
+    {
+      ChainBuffer rest;
+      rest.append(holder);
+      rest.retrieve(nwrote);
+      outputChain_.append(std::move(rest));
+    }
+    else if (outputChain_.empty())
+    {
+      outputBuffer_.append(static_cast<const char*>(data)+nwrote, remaining);
+    }
+    else
+    {
+      outputChain_.append(static_cast<const char*>(data)+nwrote, remaining);
+    }
+    loop()->metrics()->setOutputBytes(outputBytes());
+    if (!channel_->isWriting())
+    {
+      channel_->enableWriting();
+    }
+    updateBackpressure();
+  }
+}
+
+void TcpConnection::sendChainInLoop(const std::shared_ptr<ChainBuffer>& message)
+{
+  if (!loop()->isInLoopThread())
+  {
+    // queued before migrateTo()
+    loop()->queueInLoop(std::bind(&TcpConnection::sendChainInLoop, this, message));
+    return;
+  }
+  sendInLoop(message.get());
+}
+
+void TcpConnection::sendInLoop(ChainBuffer* message)
+{
+  loop()->assertInLoopThread();
+  bool faultError = false;
+  if (state_ == kDisconnected)
+  {
+    LOG_WARN << "disconnected, give up writing";
+    return;
+  }
+  // if no thing in output queue, try writing directly
+  if (!channel_->isWriting() && outputBytes() == 0 && !message->empty())
+  {
+    int savedErrno = 0;
+    ssize_t nwrote = message->writeFd(channel_->fd(), &savedErrno);
+    if (nwrote >= 0)
+    {
+      loop()->metrics()->addBytesWritten(nwrote);
+      if (message->empty() && writeCompleteCallback_)
+      {
+        loop()->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+      }
+    }
+    else if (savedErrno != EWOULDBLOCK)
+    {
+      errno = savedErrno;
+      LOG_SYSERR << "TcpConnection::sendInLoop";
+      if (errno == EPIPE || errno == ECONNRESET) // FIXME: any others?
+      {
+        faultError = true;
+      }
+    }
+  }
+
+  const size_t remaining = message->readableBytes();
+  if (!faultError && remaining > 0)
+  {
+    size_t oldLen = outputBytes();
     if (oldLen + remaining >= highWaterMark_
         && oldLen < highWaterMark_
         && highWaterMarkCallback_)
     {
-      loop_->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), oldLen + remaining));
+      loop()->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), oldLen + remaining));
     }
-    outputBuffer_.append(static_cast<const char*>(data)+nwrote, remaining);
+    outputChain_.append(std::move(*message));
+    loop()->metrics()->setOutputBytes(outputBytes());
     if (!channel_->isWriting())
     {
       channel_->enableWriting();
     }
+    updateBackpressure();
+  }
+}
+
+ssize_t TcpConnection::writeOutput()
+{
+  if (outputChain_.empty())
+  {
+    ssize_t n = sockets::write(channel_->fd(),
+                               outputBuffer_.peek(),
+                               outputBuffer_.readableBytes());
+    if (n > 0)
+    {
+      outputBuffer_.retrieve(n);
+    }
+    return n;
+  }
+  if (outputBuffer_.readableBytes() == 0)
+  {
+    int savedErrno = 0;
+    ssize_t n = outputChain_.writeFd(channel_->fd(), &savedErrno);
+    errno = savedErrno;
+    return n;
+  }
+
+  // outputBuffer_ goes first, then the chain, in one writev(2)
+  struct iovec vec[ChainBuffer::kMaxIovec + 1];
+  int iovcnt = 0;
+  const size_t bufferBytes = outputBuffer_.readableBytes();
+  if (bufferBytes > 0)
+  {
+    vec[0].iov_base = const_cast<char*>(outputBuffer_.peek());
+    vec[0].iov_len = bufferBytes;
+    ++iovcnt;
   }
+  iovcnt += outputChain_.fillIovec(vec + iovcnt, ChainBuffer::kMaxIovec);
+  ssize_t n = sockets::writev(channel_->fd(), vec, iovcnt);
+  if (n > 0)
+  {
+    size_t nwrote = implicit_cast<size_t>(n);
+    size_t fromBuffer = std::min(nwrote, bufferBytes);
+    outputBuffer_.retrieve(fromBuffer);
+    outputChain_.retrieve(nwrote - fromBuffer);
+  }
+  return n;
 }
 
 void TcpConnection::shutdown()
@@ -198,14 +446,19 @@ void TcpConnection::shutdown()
   {
     setState(kDisconnecting);
     // FIXME: shared_from_this()?
-    loop_->runInLoop(std::bind(&TcpConnection::shutdownInLoop, this));
+    loop()->runInLoop(std::bind(&TcpConnection::shutdownInLoop, this));
   }
 }
 
 void TcpConnection::shutdownInLoop()
 {
-  loop_->assertInLoopThread();
-  if (!channel_->isWriting())
+  if (!loop()->isInLoopThread())
+  {
+    // queued before migrateTo()
+    loop()->queueInLoop(std::bind(&TcpConnection::shutdownInLoop, this));
+    return;
+  }
+  if (!channel_->isWriting() && !pipeChannel_)
   {
     // we are not writing
     socket_->shutdownWrite();
@@ -218,19 +471,19 @@ void TcpConnection::shutdownInLoop()
 //   if (state_ == kConnected)
 //   {
 //     setState(kDisconnecting);
-//     loop_->runInLoop(std::bind(&TcpConnection::shutdownAndForceCloseInLoop, this, seconds));
+//     loop()->runInLoop(std::bind(&TcpConnection::shutdownAndForceCloseInLoop, this, seconds));
 //   }
 // }
 
 // void TcpConnection::shutdownAndForceCloseInLoop(double seconds)
 // {
-//   loop_->assertInLoopThread();
+//   loop()->assertInLoopThread();
 //   if (!channel_->isWriting())
 //   {
 //     // we are not writing
 //     socket_->shutdownWrite();
 //   }
-//   loop_->runAfter(
+//   loop()->runAfter(
 //       seconds,
 //       makeWeakCallback(shared_from_this(),
 //                        &TcpConnection::forceCloseInLoop));
@@ -242,7 +495,7 @@ void TcpConnection::forceClose()
   if (state_ == kConnected || state_ == kDisconnecting)
   {
     setState(kDisconnecting);
-    loop_->queueInLoop(std::bind(&TcpConnection::forceCloseInLoop, shared_from_this()));
+    loop()->queueInLoop(std::bind(&TcpConnection::forceCloseInLoop, shared_from_this()));
   }
 }
 
@@ -251,7 +504,7 @@ void TcpConnection::forceCloseWithDelay(double seconds)
   if (state_ == kConnected || state_ == kDisconnecting)
   {
     setState(kDisconnecting);
-    loop_->runAfter(
+    loop()->runAfter(
         seconds,
         makeWeakCallback(shared_from_this(),
                          &TcpConnection::forceClose));  // not forceCloseInLoop to avoid race condition
@@ -260,7 +513,12 @@ void TcpConnection::forceCloseWithDelay(double seconds)
 
 void TcpConnection::forceCloseInLoop()
 {
-  loop_->assertInLoopThread();
+  if (!loop()->isInLoopThread())
+  {
+    // queued before migrateTo()
+    loop()->queueInLoop(std::bind(&TcpConnection::forceCloseInLoop, shared_from_this()));
+    return;
+  }
   if (state_ == kConnected || state_ == kDisconnecting)
   {
     // as if we received 0 byte in handleRead();
@@ -292,27 +550,40 @@ void TcpConnection::setTcpNoDelay(bool on)
 
 void TcpConnection::startRead()
 {
-  loop_->runInLoop(std::bind(&TcpConnection::startReadInLoop, this));
+  loop()->runInLoop(std::bind(&TcpConnection::startReadInLoop, this));
 }
 
 void TcpConnection::startReadInLoop()
 {
-  loop_->assertInLoopThread();
+  if (!loop()->isInLoopThread())
+  {
+    // queued before migrateTo()
+    loop()->queueInLoop(std::bind(&TcpConnection::startReadInLoop, this));
+    return;
+  }
   if (!reading_ || !channel_->isReading())
   {
-    channel_->enableReading();
+    if (!throttled_ && !relayFull_)
+    {
+      channel_->enableReading();
+    }
     reading_ = true;
   }
 }
 
 void TcpConnection::stopRead()
 {
-  loop_->runInLoop(std::bind(&TcpConnection::stopReadInLoop, this));
+  loop()->runInLoop(std::bind(&TcpConnection::stopReadInLoop, this));
 }
 
 void TcpConnection::stopReadInLoop()
 {
-  loop_->assertInLoopThread();
+  if (!loop()->isInLoopThread())
+  {
+    // queued before migrateTo()
+    loop()->queueInLoop(std::bind(&TcpConnection::stopReadInLoop, this));
+    return;
+  }
   if (reading_ || channel_->isReading())
   {
     channel_->disableReading();
@@ -320,9 +591,169 @@ void TcpConnection::stopReadInLoop()
   }
 }
 
+void TcpConnection::updateBackpressure()
+{
+  if (throttled_)
+  {
+    if (outputBytes() <= backpressureLow_)
+    {
+      throttled_ = false;
+      if (reading_ && !relayFull_ && state_ != kDisconnected)
+      {
+        channel_->enableReading();
+      }
+    }
+  }
+  else if (backpressureHigh_ > 0 && outputBytes() >= backpressureHigh_)
+  {
+    throttled_ = true;
+    if (channel_->isReading())
+    {
+      channel_->disableReading();
+    }
+  }
+}
+
+bool TcpConnection::spliceTo(const TcpConnectionPtr& dest)
+{
+  loop()->assertInLoopThread();
+  assert(dest->getLoop() == loop());
+  std::shared_ptr<Pipe> pipe(new Pipe);
+  if (pipe->fds[0] < 0)
+  {
+    LOG_SYSERR << "TcpConnection::spliceTo";
+    return false;
+  }
+  if (inputBuffer_.readableBytes() > 0)
+  {
+    dest->sendInLoop(inputBuffer_.peek(), inputBuffer_.readableBytes());
+    inputBuffer_.retrieveAll();
+  }
+  relayPipe_ = pipe;
+  relayTo_ = dest;
+  dest->relayFrom_ = shared_from_this();
+  return true;
+}
+
+bool TcpConnection::handleRelayRead()
+{
+  TcpConnectionPtr dest = relayTo_.lock();
+  if (!dest)
+  {
+    relayPipe_.reset();
+    return false;
+  }
+  // as much as the pipe takes
+  const size_t kMaxChunk = 1024*1024;
+  ssize_t n = ::splice(channel_->fd(), NULL, relayPipe_->fds[1], NULL, kMaxChunk,
+                       SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  if (n > 0)
+  {
+    loop()->metrics()->addBytesRead(n);
+    ChainBuffer message;
+    message.appendPipe(relayPipe_->fds[0], implicit_cast<size_t>(n), relayPipe_);
+    dest->sendInLoop(&message);
+  }
+  else if (n == 0)
+  {
+    handleClose();
+  }
+  else if (errno == EAGAIN)
+  {
+    // the socket is readable, so the pipe is full, unless it's spurious.
+    int inPipe = 0;
+    if (::ioctl(relayPipe_->fds[0], FIONREAD, &inPipe) == 0 && inPipe > 0)
+    {
+      relayFull_ = true;
+      channel_->disableReading();
+    }
+  }
+  else
+  {
+    LOG_SYSERR << "TcpConnection::handleRelayRead";
+    handleError();
+  }
+  return true;
+}
+
+// dest has written some bytes, maybe from the pipe.
+void TcpConnection::resumeRelay()
+{
+  if (relayFull_)
+  {
+    relayFull_ = false;
+    if (reading_ && !throttled_ && state_ != kDisconnected)
+    {
+      channel_->enableReading();
+    }
+  }
+}
+
+void TcpConnection::migrateTo(EventLoop* loop, const ConnectionCallback& cb)
+{
+  // always queued, so that callbacks queued earlier run in the old loop.
+  getLoop()->queueInLoop(
+      std::bind(&TcpConnection::migrateInLoop, shared_from_this(), loop, cb));
+}
+
+void TcpConnection::migrateInLoop(EventLoop* loop, const ConnectionCallback& cb)
+{
+  if (!getLoop()->isInLoopThread())
+  {
+    // another migrateTo() went first
+    migrateTo(loop, cb);
+    return;
+  }
+  if (state_ != kConnected || loop == getLoop())
+  {
+    return;
+  }
+  LOG_DEBUG << "TcpConnection::migrateTo [" << name_ << "] from "
+            << getLoop() << " to " << loop;
+  channel_->disableAll();
+  channel_->remove();
+  // attachInLoop() writes again, and waits for the pipe in the new loop
+  stopWaitingPipe();
+  channel_.reset(new Channel(loop, socket_->fd()));
+  channel_->setReadCallback(
+      std::bind(&TcpConnection::handleRead, this, _1));
+  channel_->setWriteCallback(
+      std::bind(&TcpConnection::handleWrite, this));
+  channel_->setCloseCallback(
+      std::bind(&TcpConnection::handleClose, this));
+  channel_->setErrorCallback(
+      std::bind(&TcpConnection::handleError, this));
+  channel_->tie(shared_from_this());
+  getLoop()->metrics()->removeConnection();
+  loop->metrics()->addConnection();
+  // publishes buffers and the new channel to the new loop
+  loop_.store(loop, std::memory_order_release);
+  loop->queueInLoop(std::bind(&TcpConnection::attachInLoop, shared_from_this(), cb));
+}
+
+void TcpConnection::attachInLoop(const ConnectionCallback& cb)
+{
+  loop()->assertInLoopThread();
+  if (state_ == kConnected || state_ == kDisconnecting)
+  {
+    if (reading_ && !throttled_ && !channel_->isReading())
+    {
+      channel_->enableReading();
+    }
+    if (outputBytes() > 0 && !channel_->isWriting())
+    {
+      channel_->enableWriting();
+    }
+    if (cb)
+    {
+      cb(shared_from_this());
+    }
+  }
+}
+
 void TcpConnection::connectEstablished()
 {
-  loop_->assertInLoopThread();
+  loop()->assertInLoopThread();
   assert(state_ == kConnecting);
   setState(kConnected);
   channel_->tie(shared_from_this());
@@ -333,7 +764,7 @@ void TcpConnection::connectEstablished()
 
 void TcpConnection::connectDestroyed()
 {
-  loop_->assertInLoopThread();
+  loop()->assertInLoopThread();
   if (state_ == kConnected)
   {
     setState(kDisconnected);
@@ -341,16 +772,23 @@ void TcpConnection::connectDestroyed()
 
     connectionCallback_(shared_from_this());
   }
+  stopWaitingPipe();
   channel_->remove();
+  loop()->metrics()->removeConnection();
 }
 
 void TcpConnection::handleRead(Timestamp receiveTime)
 {
-  loop_->assertInLoopThread();
+  loop()->assertInLoopThread();
+  if (relayPipe_ && handleRelayRead())
+  {
+    return;
+  }
   int savedErrno = 0;
   ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
   if (n > 0)
   {
+    loop()->metrics()->addBytesRead(n);
     messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
   }
   else if (n == 0)
@@ -367,21 +805,26 @@ void TcpConnection::handleRead(Timestamp receiveTime)
 
 void TcpConnection::handleWrite()
 {
-  loop_->assertInLoopThread();
+  loop()->assertInLoopThread();
   if (channel_->isWriting())
   {
-    ssize_t n = sockets::write(channel_->fd(),
-                               outputBuffer_.peek(),
-                               outputBuffer_.readableBytes());
-    if (n > 0)
+    ssize_t n = writeOutput();
+    // n == 0 if a file region was shorter than expected and dropped
+    if (n >= 0)
     {
-      outputBuffer_.retrieve(n);
-      if (outputBuffer_.readableBytes() == 0)
+      loop()->metrics()->addBytesWritten(n);
+      updateBackpressure();
+      TcpConnectionPtr source = relayFrom_.lock();
+      if (source)
+      {
+        source->resumeRelay();
+      }
+      if (outputBytes() == 0)
       {
         channel_->disableWriting();
         if (writeCompleteCallback_)
         {
-          loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+          loop()->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
         }
         if (state_ == kDisconnecting)
         {
@@ -389,6 +832,11 @@ void TcpConnection::handleWrite()
         }
       }
     }
+    else if (errno == EWOULDBLOCK)
+    {
+      // the socket is full, or the pipe sent from is empty
+      waitForPipe();
+    }
     else
     {
       LOG_SYSERR << "TcpConnection::handleWrite";
@@ -405,14 +853,61 @@ void TcpConnection::handleWrite()
   }
 }
 
+void TcpConnection::waitForPipe()
+{
+  int fd = outputChain_.frontPipe();
+  if (fd < 0 || outputBuffer_.readableBytes() > 0)
+  {
+    return;
+  }
+  if (!pipeChannel_)
+  {
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    if (::poll(&pfd, 1, 0) != 0)
+    {
+      // readable or hung up, so the socket is full
+      return;
+    }
+    pipeChannel_.reset(new Channel(loop(), fd));
+    pipeChannel_->setReadCallback(
+        std::bind(&TcpConnection::handlePipeReadable, this));
+    pipeChannel_->setCloseCallback(
+        std::bind(&TcpConnection::handlePipeReadable, this));
+    pipeChannel_->tie(shared_from_this());
+    pipeChannel_->enableReading();
+  }
+  channel_->disableWriting();
+}
+
+void TcpConnection::handlePipeReadable()
+{
+  loop()->assertInLoopThread();
+  stopWaitingPipe();
+  if (state_ != kDisconnected && outputBytes() > 0 && !channel_->isWriting())
+  {
+    channel_->enableWriting();
+  }
+}
+
+void TcpConnection::stopWaitingPipe()
+{
+  if (pipeChannel_)
+  {
+    pipeChannel_->disableAll();
+    pipeChannel_->remove();
+    pipeChannel_.reset();
+  }
+}
+
 void TcpConnection::handleClose()
 {
-  loop_->assertInLoopThread();
+  loop()->assertInLoopThread();
   LOG_TRACE << "fd = " << channel_->fd() << " state = " << stateToString();
   assert(state_ == kConnected || state_ == kDisconnecting);
   // we don't close fd, leave it to dtor, so we can find leaks easily.
   setState(kDisconnected);
   channel_->disableAll();
+  stopWaitingPipe();
 
   TcpConnectionPtr guardThis(shared_from_this());
   connectionCallback_(guardThis);
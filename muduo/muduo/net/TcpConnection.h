@@ -16,8 +16,10 @@
 #include "muduo/base/Types.h"
 #include "muduo/net/Callbacks.h"
 #include "muduo/net/Buffer.h"
+#include "muduo/net/ChainBuffer.h"
 #include "muduo/net/InetAddress.h"
 
+#include <atomic>
 #include <memory>
 
 #include <boost/any.hpp>
@@ -52,7 +54,7 @@ class TcpConnection : noncopyable,
                 const InetAddress& peerAddr);
   ~TcpConnection();
 
-  EventLoop* getLoop() const { return loop_; }
+  EventLoop* getLoop() const { return loop_.load(std::memory_order_acquire); }
   const string& name() const { return name_; }
   const InetAddress& localAddress() const { return localAddr_; }
   const InetAddress& peerAddress() const { return peerAddr_; }
@@ -65,8 +67,17 @@ class TcpConnection : noncopyable,
   // void send(string&& message); // C++11
   void send(const void* message, int len);
   void send(const StringPiece& message);
-  // void send(Buffer&& message); // C++11
   void send(Buffer* message);  // this one will swap data
+  // zero copy, message is moved into the output chain
+  void send(Buffer&& message);
+  void send(ChainBuffer&& message);
+  // zero copy, message is shared with other connections, e.g. by fan-out,
+  // it must not be modified afterwards.
+  void send(const std::shared_ptr<const string>& message);
+  // zero copy with sendfile(2), or splice(2) if fd is a pipe.
+  // fd is dup'ed, so caller may close it right after.
+  // A pipe must already hold len bytes, or be fed without delay.
+  void sendFile(int fd, int64_t offset, size_t len);
   void shutdown(); // NOT thread safe, no simultaneous calling
   // void shutdownAndForceCloseAfter(double seconds); // NOT thread safe, no simultaneous calling
   void forceClose();
@@ -76,6 +87,33 @@ class TcpConnection : noncopyable,
   void startRead();
   void stopRead();
   bool isReading() const { return reading_; }; // NOT thread safe, may race with start/stopReadInLoop
+  // bytes queued but not yet written to the socket.
+  // NOT thread safe, call it in loop thread.
+  size_t outputBytes() const
+  { return outputBuffer_.readableBytes() + outputChain_.readableBytes(); }
+  // stops reading when output bytes reach highMark, resumes reading when
+  // they drain to lowMark, so a peer not receiving could not blow up memory.
+  // 0 disables, the default. NOT thread safe, call it in loop thread.
+  void setReadBackpressure(size_t highMark, size_t lowMark)
+  { backpressureHigh_ = highMark; backpressureLow_ = lowMark; }
+
+  // Moves this connection to another I/O loop, for a long-lived connection
+  // that makes its loop much busier than others, thread safe.
+  // Callbacks and functors queued in the old loop run before moving,
+  // cb runs in the new loop after it.
+  // Timers of the old loop are not moved, nor is getLoop() of TcpClient,
+  // so it works for connections of TcpServer only, with any Option.
+  void migrateTo(EventLoop* loop,
+                 const ConnectionCallback& cb = ConnectionCallback());
+
+  // Relays bytes received from now on to dest with splice(2) through a pipe,
+  // without copying them to user space, messageCallback is not called.
+  // Bytes already in inputBuffer() are sent to dest first.
+  // Bytes in the pipe count as output bytes of dest, so its high water
+  // mark works as before, and reading stops while the pipe is full.
+  // dest must be in the same loop, neither may be migrated afterwards.
+  // Returns false if pipe(2) fails. NOT thread safe, call it in loop thread.
+  bool spliceTo(const std::shared_ptr<TcpConnection>& dest);
 
   void setContext(const boost::any& context)
   { context_ = context; }
@@ -116,13 +154,28 @@ class TcpConnection : noncopyable,
 
  private:
   enum StateE { kDisconnected, kConnecting, kConnected, kDisconnecting };
+  struct Pipe;
   void handleRead(Timestamp receiveTime);
+  // returns false if dest is gone, then reads as usual.
+  bool handleRelayRead();
+  void resumeRelay();
   void handleWrite();
+  // the output starts with an empty pipe, wait for it instead of the socket.
+  void waitForPipe();
+  void handlePipeReadable();
+  void stopWaitingPipe();
   void handleClose();
   void handleError();
   // void sendInLoop(string&& message);
   void sendInLoop(const StringPiece& message);
   void sendInLoop(const void* message, size_t len);
+  // holder, if any, owns message, whose unwritten part is queued without copying.
+  void sendInLoop(const void* message, size_t len,
+                  const std::shared_ptr<const string>& holder);
+  void sendSharedInLoop(const std::shared_ptr<const string>& message);
+  void sendInLoop(ChainBuffer* message);
+  void sendChainInLoop(const std::shared_ptr<ChainBuffer>& message);
+  ssize_t writeOutput();
   void shutdownInLoop();
   // void shutdownAndForceCloseInLoop(double seconds);
   void forceCloseInLoop();
@@ -130,11 +183,19 @@ class TcpConnection : noncopyable,
   const char* stateToString() const;
   void startReadInLoop();
   void stopReadInLoop();
-
-  EventLoop* loop_;
+  void updateBackpressure();
+  void migrateInLoop(EventLoop* loop, const ConnectionCallback& cb);
+  void attachInLoop(const ConnectionCallback& cb);
+  EventLoop* loop() const { return getLoop(); }
+
+  // changed by migrateTo() only, a functor arriving at the old loop
+  // afterwards chases it to the new one.
+  std::atomic<EventLoop*> loop_;
   const string name_;
   StateE state_;  // FIXME: use atomic variable
   bool reading_;
+  bool throttled_;  // not reading due to backpressure
+  bool relayFull_;  // not reading until dest drains the relay pipe
   // we don't expose those classes to client.
   std::unique_ptr<Socket> socket_;
   std::unique_ptr<Channel> channel_;
@@ -146,8 +207,18 @@ class TcpConnection : noncopyable,
   HighWaterMarkCallback highWaterMarkCallback_;
   CloseCallback closeCallback_;
   size_t highWaterMark_;
+  size_t backpressureHigh_;
+  size_t backpressureLow_;
   Buffer inputBuffer_;
-  Buffer outputBuffer_; // FIXME: use list<Buffer> as output buffer.
+  Buffer outputBuffer_;
+  // data sent by move, and everything queued after it, to keep the order.
+  ChainBuffer outputChain_;
+  // watches the empty pipe output waits for, see waitForPipe()
+  std::unique_ptr<Channel> pipeChannel_;
+  // see spliceTo()
+  std::shared_ptr<Pipe> relayPipe_;
+  std::weak_ptr<TcpConnection> relayTo_;
+  std::weak_ptr<TcpConnection> relayFrom_;
   boost::any context_;
   // FIXME: creationTime_, lastReceiveTime_
   //        bytesReceived_, bytesSent_
@@ -8,6 +8,7 @@
 
 #include "muduo/net/TcpServer.h"
 
+#include "muduo/base/CountDownLatch.h"
 #include "muduo/base/Logging.h"
 #include "muduo/net/Acceptor.h"
 #include "muduo/net/EventLoop.h"
@@ -19,6 +20,15 @@
 using namespace muduo;
 using namespace muduo::net;
 
+struct TcpServer::LoopAcceptor
+{
+  EventLoop* loop;
+  int index;
+  std::unique_ptr<Acceptor> acceptor;
+  int nextConnId;
+  ConnectionMap connections;
+};
+
 TcpServer::TcpServer(EventLoop* loop,
                      const InetAddress& listenAddr,
                      const string& nameArg,
@@ -26,14 +36,22 @@ TcpServer::TcpServer(EventLoop* loop,
   : loop_(CHECK_NOTNULL(loop)),
     ipPort_(listenAddr.toIpPort()),
     name_(nameArg),
-    acceptor_(new Acceptor(loop, listenAddr, option == kReusePort)),
+    listenAddr_(listenAddr),
+    option_(option),
+    acceptBatch_(1),
     threadPool_(new EventLoopThreadPool(loop, name_)),
     connectionCallback_(defaultConnectionCallback),
     messageCallback_(defaultMessageCallback),
     nextConnId_(1)
 {
-  acceptor_->setNewConnectionCallback(
-      std::bind(&TcpServer::newConnection, this, _1, _2));
+  // with kReusePortPerLoop, sockets are created in start(),
+  // when I/O loops are known.
+  if (option_ != kReusePortPerLoop)
+  {
+    acceptor_.reset(new Acceptor(loop, listenAddr, option_ == kReusePort));
+    acceptor_->setNewConnectionCallback(
+        std::bind(&TcpServer::newConnection, this, _1, _2));
+  }
 }
 
 TcpServer::~TcpServer()
@@ -48,6 +66,23 @@ TcpServer::~TcpServer()
     conn->getLoop()->runInLoop(
       std::bind(&TcpConnection::connectDestroyed, conn));
   }
+
+  for (const auto& acceptor : loopAcceptors_)
+  {
+    // Acceptor and connections belong to the I/O loop, which may be
+    // accepting right now, waits until it's done.
+    if (acceptor->loop->isInLoopThread())
+    {
+      destroyPerLoop(get_pointer(acceptor), NULL);
+    }
+    else
+    {
+      CountDownLatch latch(1);
+      acceptor->loop->runInLoop(
+          std::bind(&TcpServer::destroyPerLoop, get_pointer(acceptor), &latch));
+      latch.wait();
+    }
+  }
 }
 
 void TcpServer::setThreadNum(int numThreads)
@@ -56,13 +91,45 @@ void TcpServer::setThreadNum(int numThreads)
   threadPool_->setThreadNum(numThreads);
 }
 
+void TcpServer::setLoopSelection(LoopSelection selection)
+{
+  static_assert(static_cast<int>(kLeastBusy) ==
+                static_cast<int>(EventLoopThreadPool::kLeastBusy),
+                "LoopSelection mirrors EventLoopThreadPool::SelectPolicy");
+  threadPool_->setSelectPolicy(
+      static_cast<EventLoopThreadPool::SelectPolicy>(selection));
+}
+
 void TcpServer::start()
 {
   if (started_.getAndSet(1) == 0)
   {
     threadPool_->start(threadInitCallback_);
 
+    if (option_ == kReusePortPerLoop)
+    {
+      std::vector<EventLoop*> loops = threadPool_->getAllLoops();
+      for (size_t i = 0; i < loops.size(); ++i)
+      {
+        LoopAcceptor* acceptor = new LoopAcceptor;
+        acceptor->loop = loops[i];
+        acceptor->index = static_cast<int>(i);
+        acceptor->acceptor.reset(new Acceptor(loops[i], listenAddr_, true));
+        acceptor->acceptor->setAcceptBatch(acceptBatch_);
+        acceptor->acceptor->setNewConnectionCallback(
+            std::bind(&TcpServer::newConnectionPerLoop, this, acceptor, _1, _2));
+        acceptor->nextConnId = 1;
+        loopAcceptors_.emplace_back(acceptor);
+        // listening before start() returns, the loop accepts when it gets to it
+        acceptor->acceptor->listenSocket();
+        loops[i]->runInLoop(
+            std::bind(&Acceptor::listen, get_pointer(acceptor->acceptor)));
+      }
+      return;
+    }
+
     assert(!acceptor_->listenning());
+    acceptor_->setAcceptBatch(acceptBatch_);
     loop_->runInLoop(
         std::bind(&Acceptor::listen, get_pointer(acceptor_)));
   }
@@ -77,6 +144,18 @@ void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr)
   ++nextConnId_;
   string connName = name_ + buf;
 
+  TcpConnectionPtr conn = createConnection(ioLoop, connName, sockfd, peerAddr);
+  connections_[connName] = conn;
+  conn->setCloseCallback(
+      std::bind(&TcpServer::removeConnection, this, _1)); // FIXME: unsafe
+  ioLoop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
+}
+
+TcpConnectionPtr TcpServer::createConnection(EventLoop* ioLoop,
+                                             const string& connName,
+                                             int sockfd,
+                                             const InetAddress& peerAddr)
+{
   LOG_INFO << "TcpServer::newConnection [" << name_
            << "] - new connection [" << connName
            << "] from " << peerAddr.toIpPort();
@@ -88,13 +167,10 @@ void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr)
                                           sockfd,
                                           localAddr,
                                           peerAddr));
-  connections_[connName] = conn;
   conn->setConnectionCallback(connectionCallback_);
   conn->setMessageCallback(messageCallback_);
   conn->setWriteCompleteCallback(writeCompleteCallback_);
-  conn->setCloseCallback(
-      std::bind(&TcpServer::removeConnection, this, _1)); // FIXME: unsafe
-  ioLoop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
+  return conn;
 }
 
 void TcpServer::removeConnection(const TcpConnectionPtr& conn)
@@ -116,3 +192,61 @@ void TcpServer::removeConnectionInLoop(const TcpConnectionPtr& conn)
       std::bind(&TcpConnection::connectDestroyed, conn));
 }
 
+
+void TcpServer::newConnectionPerLoop(LoopAcceptor* acceptor,
+                                     int sockfd, const InetAddress& peerAddr)
+{
+  acceptor->loop->assertInLoopThread();
+  char buf[64];
+  snprintf(buf, sizeof buf, "-%s#%d-%d",
+           ipPort_.c_str(), acceptor->index, acceptor->nextConnId);
+  ++acceptor->nextConnId;
+  string connName = name_ + buf;
+
+  TcpConnectionPtr conn = createConnection(acceptor->loop, connName, sockfd, peerAddr);
+  acceptor->connections[connName] = conn;
+  conn->setCloseCallback(
+      std::bind(&TcpServer::removeConnectionPerLoop, this, acceptor, _1)); // FIXME: unsafe
+  conn->connectEstablished();
+}
+
+void TcpServer::removeConnectionPerLoop(LoopAcceptor* acceptor,
+                                        const TcpConnectionPtr& conn)
+{
+  // a connection moved by TcpConnection::migrateTo() closes in another loop
+  acceptor->loop->runInLoop(
+      std::bind(&TcpServer::removeConnectionPerLoopInLoop, this, acceptor, conn));
+}
+
+void TcpServer::removeConnectionPerLoopInLoop(LoopAcceptor* acceptor,
+                                              const TcpConnectionPtr& conn)
+{
+  acceptor->loop->assertInLoopThread();
+  LOG_INFO << "TcpServer::removeConnectionPerLoop [" << name_
+           << "] - connection " << conn->name();
+  size_t n = acceptor->connections.erase(conn->name());
+  (void)n;
+  assert(n == 1);
+  EventLoop* ioLoop = conn->getLoop();
+  ioLoop->queueInLoop(
+      std::bind(&TcpConnection::connectDestroyed, conn));
+}
+
+void TcpServer::destroyPerLoop(LoopAcceptor* acceptor, CountDownLatch* latch)
+{
+  acceptor->loop->assertInLoopThread();
+  acceptor->acceptor.reset();
+  for (auto& item : acceptor->connections)
+  {
+    TcpConnectionPtr conn(item.second);
+    item.second.reset();
+    // in this loop unless migrated
+    conn->getLoop()->runInLoop(
+      std::bind(&TcpConnection::connectDestroyed, conn));
+  }
+  acceptor->connections.clear();
+  if (latch)
+  {
+    latch->countDown();
+  }
+}
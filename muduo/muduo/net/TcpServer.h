@@ -16,9 +16,12 @@
 #include "muduo/net/TcpConnection.h"
 
 #include <map>
+#include <vector>
 
 namespace muduo
 {
+class CountDownLatch;
+
 namespace net
 {
 
@@ -38,6 +41,18 @@ class TcpServer : noncopyable
   {
     kNoReusePort,
     kReusePort,
+    // Every I/O loop listens on its own socket with SO_REUSEPORT,
+    // kernel spreads new connections among them,
+    // which are accepted and served in the same thread.
+    kReusePortPerLoop,
+  };
+  // How a new connection is assigned to an I/O loop,
+  // not used by kReusePortPerLoop.
+  enum LoopSelection
+  {
+    kRoundRobin,
+    kLeastConnections,
+    kLeastBusy,  // least busy time in the last second or so
   };
 
   //TcpServer(EventLoop* loop, const InetAddress& listenAddr);
@@ -53,17 +68,25 @@ class TcpServer : noncopyable
 
   /// Set the number of threads for handling input.
   ///
-  /// Always accepts new connection in loop's thread.
+  /// Accepts new connection in loop's thread,
+  /// or in every I/O thread with kReusePortPerLoop.
   /// Must be called before @c start
   /// @param numThreads
   /// - 0 means all I/O in loop's thread, no thread will created.
   ///   this is the default value.
   /// - 1 means all I/O in another thread.
   /// - N means a thread pool with N threads, new connections
-  ///   are assigned on a round-robin basis.
+  ///   are assigned by setLoopSelection(), round-robin by default.
   void setThreadNum(int numThreads);
+  /// Must be called before @c start
+  void setLoopSelection(LoopSelection selection);
   void setThreadInitCallback(const ThreadInitCallback& cb)
   { threadInitCallback_ = cb; }
+  /// Accepts up to n connections each time listening socket is readable,
+  /// default 1.
+  /// Must be called before @c start
+  void setAcceptBatch(int n)
+  { acceptBatch_ = n; }
   /// valid after calling start()
   std::shared_ptr<EventLoopThreadPool> threadPool()
   { return threadPool_; }
@@ -97,12 +120,32 @@ class TcpServer : noncopyable
   /// Not thread safe, but in loop
   void removeConnectionInLoop(const TcpConnectionPtr& conn);
 
+  // for kReusePortPerLoop, all in its I/O loop
+  struct LoopAcceptor;
+  void newConnectionPerLoop(LoopAcceptor* acceptor,
+                            int sockfd, const InetAddress& peerAddr);
+  /// Thread safe, a migrated connection closes in another loop.
+  void removeConnectionPerLoop(LoopAcceptor* acceptor,
+                               const TcpConnectionPtr& conn);
+  void removeConnectionPerLoopInLoop(LoopAcceptor* acceptor,
+                                     const TcpConnectionPtr& conn);
+  static void destroyPerLoop(LoopAcceptor* acceptor, CountDownLatch* latch);
+
+  TcpConnectionPtr createConnection(EventLoop* ioLoop,
+                                    const string& connName,
+                                    int sockfd,
+                                    const InetAddress& peerAddr);
+
   typedef std::map<string, TcpConnectionPtr> ConnectionMap;
 
   EventLoop* loop_;  // the acceptor loop
   const string ipPort_;
   const string name_;
+  const InetAddress listenAddr_;
+  const Option option_;
+  int acceptBatch_;
   std::unique_ptr<Acceptor> acceptor_; // avoid revealing Acceptor
+  std::vector<std::unique_ptr<LoopAcceptor>> loopAcceptors_;
   std::shared_ptr<EventLoopThreadPool> threadPool_;
   ConnectionCallback connectionCallback_;
   MessageCallback messageCallback_;
@@ -8,6 +8,8 @@
 
 #include "muduo/net/Timer.h"
 
+#include <assert.h>
+
 using namespace muduo;
 using namespace muduo::net;
 
@@ -24,3 +26,20 @@ void Timer::restart(Timestamp now)
     expiration_ = Timestamp::invalid();
   }
 }
+
+void Timer::reuse(TimerCallback cb, Timestamp when, double interval)
+{
+  assert(pprev_ == NULL);
+  callback_ = std::move(cb);
+  expiration_ = when;
+  interval_ = interval;
+  repeat_ = interval > 0.0;
+  sequence_ = s_numCreated_.incrementAndGet();
+}
+
+void Timer::release()
+{
+  assert(pprev_ == NULL);
+  callback_ = TimerCallback();
+  sequence_ = 0;
+}
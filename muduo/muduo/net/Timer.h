@@ -31,7 +31,10 @@ class Timer : noncopyable
       expiration_(when),
       interval_(interval),
       repeat_(interval > 0.0),
-      sequence_(s_numCreated_.incrementAndGet())
+      sequence_(s_numCreated_.incrementAndGet()),
+      next_(NULL),
+      pprev_(NULL),
+      level_(-1)
   { }
 
   void run() const
@@ -45,14 +48,27 @@ class Timer : noncopyable
 
   void restart(Timestamp now);
 
+  /// Reinitializes a pooled timer, with a new sequence.
+  void reuse(TimerCallback cb, Timestamp when, double interval);
+  /// Drops the callback and invalidates the sequence,
+  /// so that stale TimerId of a pooled timer matches nothing.
+  void release();
+
   static int64_t numCreated() { return s_numCreated_.get(); }
 
  private:
-  const TimerCallback callback_;
+  friend class TimerWheel;
+
+  TimerCallback callback_;
   Timestamp expiration_;
-  const double interval_;
-  const bool repeat_;
-  const int64_t sequence_;
+  double interval_;
+  bool repeat_;
+  int64_t sequence_;
+
+  // intrusive list hook of TimerWheel
+  Timer* next_;
+  Timer** pprev_;
+  int level_;
 
   static AtomicInt64 s_numCreated_;
 };
@@ -14,8 +14,10 @@
 
 #include "muduo/base/Logging.h"
 #include "muduo/net/EventLoop.h"
+#include "muduo/net/LoopMetrics.h"
 #include "muduo/net/Timer.h"
 #include "muduo/net/TimerId.h"
+#include "muduo/net/TimerWheel.h"
 
 #include <sys/timerfd.h>
 #include <unistd.h>
@@ -111,16 +113,31 @@ TimerQueue::~TimerQueue()
   {
     delete timer.second;
   }
+  if (wheel_)
+  {
+    std::vector<Timer*> timers;
+    wheel_->removeAll(&timers);
+    for (Timer* timer : timers)
+    {
+      delete timer;
+    }
+  }
+  for (Timer* timer : freeTimers_)
+  {
+    delete timer;
+  }
 }
 
 TimerId TimerQueue::addTimer(TimerCallback cb,
                              Timestamp when,
                              double interval)
 {
-  Timer* timer = new Timer(std::move(cb), when, interval);
+  Timer* timer = newTimer(std::move(cb), when, interval);
+  // the loop thread may fire and reuse the timer before runInLoop returns.
+  int64_t sequence = timer->sequence();
   loop_->runInLoop(
       std::bind(&TimerQueue::addTimerInLoop, this, timer));
-  return TimerId(timer, timer->sequence());
+  return TimerId(timer, sequence);
 }
 
 void TimerQueue::cancel(TimerId timerId)
@@ -129,9 +146,39 @@ void TimerQueue::cancel(TimerId timerId)
       std::bind(&TimerQueue::cancelInLoop, this, timerId));
 }
 
+void TimerQueue::setTimingWheel(double tickSeconds)
+{
+  loop_->assertInLoopThread();
+  assert(tickSeconds > 0.0);
+  if (wheel_)
+  {
+    LOG_WARN << "TimerQueue::setTimingWheel() timing wheel already in use";
+    return;
+  }
+  int64_t tick = static_cast<int64_t>(tickSeconds * Timestamp::kMicroSecondsPerSecond);
+  wheel_.reset(new TimerWheel(std::max(tick, int64_t(1)), Timestamp::now()));
+  for (const Entry& it : timers_)
+  {
+    wheel_->insert(it.second);
+  }
+  timers_.clear();
+  activeTimers_.clear();
+  nextWakeup_ = wheel_->nextExpiration();
+  if (nextWakeup_.valid())
+  {
+    resetTimerfd(timerfd_, nextWakeup_);
+  }
+}
+
 void TimerQueue::addTimerInLoop(Timer* timer)
 {
   loop_->assertInLoopThread();
+  if (wheel_)
+  {
+    wheel_->insert(timer);
+    rearmWheel(timer);
+    return;
+  }
   bool earliestChanged = insert(timer);
 
   if (earliestChanged)
@@ -145,19 +192,36 @@ void TimerQueue::cancelInLoop(TimerId timerId)
   loop_->assertInLoopThread();
   assert(timers_.size() == activeTimers_.size());
   ActiveTimer timer(timerId.timer_, timerId.sequence_);
-  ActiveTimerSet::iterator it = activeTimers_.find(timer);
-  if (it != activeTimers_.end())
+  if (wheel_)
   {
-    size_t n = timers_.erase(Entry(it->first->expiration(), it->first));
-    assert(n == 1); (void)n;
-    delete it->first; // FIXME: no delete please
-    activeTimers_.erase(it);
+    // timers are not deleted, sequence tells if it was reused.
+    Timer* t = timerId.timer_;
+    if (t && t->sequence() == timerId.sequence_
+        && TimerWheel::linked(t))
+    {
+      wheel_->remove(t);
+      releaseTimer(t);
+      return;
+    }
+  }
+  else
+  {
+    ActiveTimerSet::iterator it = activeTimers_.find(timer);
+    if (it != activeTimers_.end())
+    {
+      size_t n = timers_.erase(Entry(it->first->expiration(), it->first));
+      assert(n == 1); (void)n;
+      releaseTimer(it->first);
+      activeTimers_.erase(it);
+      assert(timers_.size() == activeTimers_.size());
+      return;
+    }
   }
-  else if (callingExpiredTimers_)
+
+  if (callingExpiredTimers_)
   {
     cancelingTimers_.insert(timer);
   }
-  assert(timers_.size() == activeTimers_.size());
 }
 
 void TimerQueue::handleRead()
@@ -167,6 +231,12 @@ void TimerQueue::handleRead()
   readTimerfd(timerfd_, now);
 
   std::vector<Entry> expired = getExpired(now);
+  LoopMetrics* metrics = loop_->metrics();
+  for (const Entry& it : expired)
+  {
+    metrics->timerLateness.add(now.microSecondsSinceEpoch()
+                               - it.first.microSecondsSinceEpoch());
+  }
 
   callingExpiredTimers_ = true;
   cancelingTimers_.clear();
@@ -184,6 +254,17 @@ std::vector<TimerQueue::Entry> TimerQueue::getExpired(Timestamp now)
 {
   assert(timers_.size() == activeTimers_.size());
   std::vector<Entry> expired;
+  if (wheel_)
+  {
+    std::vector<Timer*> timers;
+    wheel_->expire(now, &timers);
+    expired.reserve(timers.size());
+    for (Timer* timer : timers)
+    {
+      expired.push_back(Entry(timer->expiration(), timer));
+    }
+    return expired;
+  }
   Entry sentry(now, reinterpret_cast<Timer*>(UINTPTR_MAX));
   TimerList::iterator end = timers_.lower_bound(sentry);
   assert(end == timers_.end() || now < end->first);
@@ -212,16 +293,27 @@ void TimerQueue::reset(const std::vector<Entry>& expired, Timestamp now)
         && cancelingTimers_.find(timer) == cancelingTimers_.end())
     {
       it.second->restart(now);
-      insert(it.second);
+      if (wheel_)
+      {
+        wheel_->insert(it.second);
+      }
+      else
+      {
+        insert(it.second);
+      }
     }
     else
     {
-      // FIXME move to a free list
-      delete it.second; // FIXME: no delete please
+      releaseTimer(it.second);
     }
   }
 
-  if (!timers_.empty())
+  if (wheel_)
+  {
+    nextExpire = wheel_->nextExpiration();
+    nextWakeup_ = nextExpire;
+  }
+  else if (!timers_.empty())
   {
     nextExpire = timers_.begin()->second->expiration();
   }
@@ -258,3 +350,34 @@ bool TimerQueue::insert(Timer* timer)
   return earliestChanged;
 }
 
+
+void TimerQueue::rearmWheel(Timer* timer)
+{
+  // timerfd is armed no later than this timer needs, nothing to do.
+  // Otherwise the wheel knows when to wake up, maybe for a cascade.
+  if (!nextWakeup_.valid() || timer->expiration() < nextWakeup_)
+  {
+    nextWakeup_ = wheel_->nextExpiration();
+    resetTimerfd(timerfd_, nextWakeup_);
+  }
+}
+
+Timer* TimerQueue::newTimer(TimerCallback cb, Timestamp when, double interval)
+{
+  // freeTimers_ is owned by loop thread, other threads allocate a new one.
+  if (loop_->isInLoopThread() && !freeTimers_.empty())
+  {
+    Timer* timer = freeTimers_.back();
+    freeTimers_.pop_back();
+    timer->reuse(std::move(cb), when, interval);
+    return timer;
+  }
+  return new Timer(std::move(cb), when, interval);
+}
+
+void TimerQueue::releaseTimer(Timer* timer)
+{
+  loop_->assertInLoopThread();
+  timer->release();
+  freeTimers_.push_back(timer);
+}
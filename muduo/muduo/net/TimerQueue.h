@@ -11,6 +11,7 @@
 #ifndef MUDUO_NET_TIMERQUEUE_H
 #define MUDUO_NET_TIMERQUEUE_H
 
+#include <memory>
 #include <set>
 #include <vector>
 
@@ -27,6 +28,7 @@ namespace net
 class EventLoop;
 class Timer;
 class TimerId;
+class TimerWheel;
 
 ///
 /// A best efforts timer queue.
@@ -49,6 +51,14 @@ class TimerQueue : noncopyable
 
   void cancel(TimerId timerId);
 
+  ///
+  /// Switches to a hierarchical timing wheel with given tick,
+  /// existing timers are moved over.
+  /// Adding and canceling become O(1), expirations are rounded up to tick.
+  ///
+  /// Must be called in loop thread.
+  void setTimingWheel(double tickSeconds);
+
  private:
 
   // FIXME: use unique_ptr<Timer> instead of raw pointers.
@@ -68,6 +78,10 @@ class TimerQueue : noncopyable
   void reset(const std::vector<Entry>& expired, Timestamp now);
 
   bool insert(Timer* timer);
+  void rearmWheel(Timer* timer);
+
+  Timer* newTimer(TimerCallback cb, Timestamp when, double interval);
+  void releaseTimer(Timer* timer);
 
   EventLoop* loop_;
   const int timerfd_;
@@ -79,6 +93,17 @@ class TimerQueue : noncopyable
   ActiveTimerSet activeTimers_;
   bool callingExpiredTimers_; /* atomic */
   ActiveTimerSet cancelingTimers_;
+
+  // released timers for reuse. A timer is not deleted before the queue,
+  // so a stale TimerId always points to a live timer, whose sequence
+  // tells if it is still the same one. It holds as many timers as were
+  // ever alive at once.
+  std::vector<Timer*> freeTimers_;
+
+  // if set, timers_ and activeTimers_ are not used.
+  std::unique_ptr<TimerWheel> wheel_;
+  // when timerfd is armed to, in wheel mode
+  Timestamp nextWakeup_;
 };
 
 }  // namespace net
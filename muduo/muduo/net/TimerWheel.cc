@@ -0,0 +1,208 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/net/TimerWheel.h"
+
+#include "muduo/net/Timer.h"
+
+#include <assert.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int TimerWheel::kLevels;
+const int64_t TimerWheel::kRootSize;
+const int64_t TimerWheel::kLevelSize;
+
+TimerWheel::TimerWheel(int64_t tickMicroSeconds, Timestamp now)
+  : tickMicroSeconds_(tickMicroSeconds),
+    currentTick_(0),
+    size_(0),
+    upperSize_(0),
+    slots_(kRootSize + (kLevels-1) * kLevelSize, NULL)
+{
+  assert(tickMicroSeconds_ > 0);
+  currentTick_ = now.microSecondsSinceEpoch() / tickMicroSeconds_ + 1;
+}
+
+TimerWheel::~TimerWheel()
+{
+  assert(size_ == 0);
+}
+
+bool TimerWheel::linked(const Timer* timer)
+{
+  return timer->pprev_ != NULL;
+}
+
+void TimerWheel::insert(Timer* timer)
+{
+  assert(!linked(timer));
+  int64_t expires = toTick(timer->expiration());
+  if (expires < currentTick_)
+  {
+    expires = currentTick_;
+  }
+  int64_t delta = expires - currentTick_;
+  if (delta < kRootSize)
+  {
+    link(timer, 0, expires & kRootMask);
+  }
+  else
+  {
+    if (delta > kMaxDelta)
+    {
+      // re-inserted on cascade, with its real expiration
+      expires = currentTick_ + kMaxDelta;
+      delta = kMaxDelta;
+    }
+    int level = 1;
+    int shift = kRootBits;
+    while (delta >= (int64_t(1) << (shift + kLevelBits)))
+    {
+      ++level;
+      shift += kLevelBits;
+    }
+    assert(level < kLevels);
+    link(timer, level, (expires >> shift) & kLevelMask);
+    ++upperSize_;
+  }
+  ++size_;
+}
+
+void TimerWheel::remove(Timer* timer)
+{
+  assert(linked(timer));
+  *timer->pprev_ = timer->next_;
+  if (timer->next_)
+  {
+    timer->next_->pprev_ = timer->pprev_;
+  }
+  if (timer->level_ > 0)
+  {
+    --upperSize_;
+  }
+  timer->next_ = NULL;
+  timer->pprev_ = NULL;
+  timer->level_ = -1;
+  --size_;
+}
+
+void TimerWheel::expire(Timestamp now, std::vector<Timer*>* expired)
+{
+  const int64_t nowTick = now.microSecondsSinceEpoch() / tickMicroSeconds_;
+  while (currentTick_ <= nowTick && size_ > 0)
+  {
+    const int64_t index = currentTick_ & kRootMask;
+    if (index == 0 && upperSize_ > 0)
+    {
+      for (int level = 1; level < kLevels && cascade(level) == 0; ++level)
+      {
+      }
+    }
+    Timer** head = slot(0, index);
+    while (*head)
+    {
+      Timer* timer = *head;
+      remove(timer);
+      expired->push_back(timer);
+    }
+    ++currentTick_;
+  }
+  if (currentTick_ <= nowTick)
+  {
+    // nothing left, skip idle ticks.
+    currentTick_ = nowTick + 1;
+  }
+}
+
+Timestamp TimerWheel::nextExpiration() const
+{
+  if (size_ == 0)
+  {
+    return Timestamp::invalid();
+  }
+  // slots of level 0 will be refilled when it wraps around.
+  if ((currentTick_ & kRootMask) == 0 && upperSize_ > 0)
+  {
+    return fromTick(currentTick_);
+  }
+  const int64_t wrap = (currentTick_ | kRootMask) + 1;
+  for (int64_t tick = currentTick_; tick < wrap; ++tick)
+  {
+    if (slots_[static_cast<size_t>(tick & kRootMask)])
+    {
+      return fromTick(tick);
+    }
+  }
+  return fromTick(wrap);
+}
+
+void TimerWheel::removeAll(std::vector<Timer*>* timers)
+{
+  for (Timer*& head : slots_)
+  {
+    while (head)
+    {
+      Timer* timer = head;
+      remove(timer);
+      timers->push_back(timer);
+    }
+  }
+  assert(size_ == 0);
+  assert(upperSize_ == 0);
+}
+
+int64_t TimerWheel::toTick(Timestamp when) const
+{
+  // round up, never fires early.
+  return (when.microSecondsSinceEpoch() + tickMicroSeconds_ - 1) / tickMicroSeconds_;
+}
+
+Timestamp TimerWheel::fromTick(int64_t tick) const
+{
+  return Timestamp(tick * tickMicroSeconds_);
+}
+
+Timer** TimerWheel::slot(int level, int64_t index)
+{
+  assert(0 <= level && level < kLevels);
+  size_t offset = level == 0 ? 0 : static_cast<size_t>(kRootSize + (level-1) * kLevelSize);
+  return &slots_[offset + static_cast<size_t>(index)];
+}
+
+void TimerWheel::link(Timer* timer, int level, int64_t index)
+{
+  Timer** head = slot(level, index);
+  timer->next_ = *head;
+  if (*head)
+  {
+    (*head)->pprev_ = &timer->next_;
+  }
+  timer->pprev_ = head;
+  timer->level_ = level;
+  *head = timer;
+}
+
+int64_t TimerWheel::cascade(int level)
+{
+  const int shift = kRootBits + (level-1) * kLevelBits;
+  const int64_t index = (currentTick_ >> shift) & kLevelMask;
+  Timer** head = slot(level, index);
+  Timer* timer = *head;
+  *head = NULL;
+  while (timer)
+  {
+    Timer* next = timer->next_;
+    timer->next_ = NULL;
+    timer->pprev_ = NULL;
+    timer->level_ = -1;
+    --upperSize_;
+    --size_;
+    insert(timer);
+    timer = next;
+  }
+  return index;
+}
@@ -0,0 +1,85 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_TIMERWHEEL_H
+#define MUDUO_NET_TIMERWHEEL_H
+
+#include "muduo/base/noncopyable.h"
+#include "muduo/base/Timestamp.h"
+
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+class Timer;
+
+///
+/// Hierarchical timing wheel, as in Linux kernel before 4.8.
+///
+/// Level 0 has 256 slots of one tick each, levels 1 to 4 have 64 slots,
+/// each slot of level n spans all slots of level n-1.
+/// Timers are linked into slots intrusively, so insert and remove are O(1),
+/// timers of a higher level cascade down when lower level wraps around.
+///
+/// Expirations are rounded up to the next tick, so a timer never fires early,
+/// but may fire up to one tick late.
+///
+/// Not thread safe, owned by TimerQueue in loop thread.
+class TimerWheel : noncopyable
+{
+ public:
+  TimerWheel(int64_t tickMicroSeconds, Timestamp now);
+  ~TimerWheel();
+
+  void insert(Timer* timer);
+  void remove(Timer* timer);
+  static bool linked(const Timer* timer);
+
+  /// Moves out all timers expired at now.
+  void expire(Timestamp now, std::vector<Timer*>* expired);
+
+  /// When TimerQueue should wake up next, invalid if no timer.
+  Timestamp nextExpiration() const;
+
+  /// Moves out all timers.
+  void removeAll(std::vector<Timer*>* timers);
+
+  size_t size() const { return size_; }
+
+ private:
+  static const int kLevels = 5;
+  static const int kRootBits = 8;
+  static const int kLevelBits = 6;
+  static const int64_t kRootSize = 1 << kRootBits;
+  static const int64_t kLevelSize = 1 << kLevelBits;
+  static const int64_t kRootMask = kRootSize - 1;
+  static const int64_t kLevelMask = kLevelSize - 1;
+  static const int64_t kMaxDelta = (int64_t(1) << (kRootBits + (kLevels-1) * kLevelBits)) - 1;
+
+  int64_t toTick(Timestamp when) const;
+  Timestamp fromTick(int64_t tick) const;
+  Timer** slot(int level, int64_t index);
+  void link(Timer* timer, int level, int64_t index);
+  // re-inserts timers of a higher level slot, returns the slot index.
+  int64_t cascade(int level);
+
+  const int64_t tickMicroSeconds_;
+  // next tick to be processed
+  int64_t currentTick_;
+  size_t size_;
+  // number of timers in levels above root
+  size_t upperSize_;
+  std::vector<Timer*> slots_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_TIMERWHEEL_H
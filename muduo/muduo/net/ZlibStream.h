@@ -2,6 +2,11 @@
 
 #include "muduo/base/noncopyable.h"
 #include "muduo/net/Buffer.h"
+#include "muduo/net/TcpConnection.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
 #pragma GCC diagnostic ignored "-Wold-style-cast"
 #include <zlib.h>
 
@@ -10,6 +15,13 @@ namespace muduo
 namespace net
 {
 
+enum ZlibFormat
+{
+  kZlibFormat,  // RFC 1950, Content-Encoding: deflate
+  kGzipFormat,  // RFC 1952, Content-Encoding: gzip
+  kRawDeflate,  // RFC 1951, without header nor checksum
+};
+
 // input is zlib compressed data, output uncompressed data
 // FIXME: finish this
 class ZlibInputStream : noncopyable
@@ -45,18 +57,39 @@ class ZlibInputStream : noncopyable
 class ZlibOutputStream : noncopyable
 {
  public:
-  explicit ZlibOutputStream(Buffer* output)
+  // zlib takes about (1 << (windowBits+2)) + (1 << (memLevel+9)) bytes,
+  // 256KiB by default, windowBits 12 and memLevel 5 take 32KiB,
+  // and compress a little worse.
+  explicit ZlibOutputStream(Buffer* output,
+                            ZlibFormat format = kZlibFormat,
+                            int level = Z_DEFAULT_COMPRESSION,
+                            int windowBits = 15,
+                            int memLevel = 8)
     : output_(output),
       zerror_(Z_OK),
-      bufferSize_(1024)
+      bufferSize_(1024),
+      ended_(false)
   {
     memZero(&zstream_, sizeof zstream_);
-    zerror_ = deflateInit(&zstream_, Z_DEFAULT_COMPRESSION);
+    if (format == kGzipFormat)
+      windowBits += 16;
+    else if (format == kRawDeflate)
+      windowBits = -windowBits;
+    zerror_ = deflateInit2(&zstream_, level, Z_DEFLATED, windowBits,
+                           memLevel, Z_DEFAULT_STRATEGY);
   }
 
   ~ZlibOutputStream()
   {
-    finish();
+    // idle in ZlibOutputStreamPool if NULL
+    if (output_)
+    {
+      finish();
+    }
+    if (!ended_)
+    {
+      deflateEnd(&zstream_);
+    }
   }
 
   // Return last error message or NULL if no error.
@@ -102,10 +135,30 @@ class ZlibOutputStream : noncopyable
       zerror_ = compress(Z_NO_FLUSH);
     }
     input->retrieve(input->readableBytes() - zstream_.avail_in);
+    zstream_.next_in = NULL;
+    zstream_.avail_in = 0;
     return zerror_ == Z_OK;
   }
 
-  bool finish()
+  // Outputs all data written so far, so that the peer could decompress
+  // them without waiting for more, costs 5 or so bytes each time.
+  bool flush()
+  {
+    if (zerror_ != Z_OK)
+      return false;
+
+    do
+    {
+      zerror_ = compress(Z_SYNC_FLUSH);
+    } while (zerror_ == Z_OK && zstream_.avail_out == 0);
+    // nothing to flush
+    if (zerror_ == Z_BUF_ERROR)
+      zerror_ = Z_OK;
+    return zerror_ == Z_OK;
+  }
+
+  // Outputs the rest and the trailer, keeps zlib state for reset().
+  bool finishStream()
   {
     if (zerror_ != Z_OK)
       return false;
@@ -114,12 +167,34 @@ class ZlibOutputStream : noncopyable
     {
       zerror_ = compress(Z_FINISH);
     }
+    return zerror_ == Z_STREAM_END;
+  }
+
+  bool finish()
+  {
+    if (zerror_ != Z_OK)
+      return false;
+
+    finishStream();
     zerror_ = deflateEnd(&zstream_);
+    ended_ = true;
     bool ok = zerror_ == Z_OK;
     zerror_ = Z_STREAM_END;
     return ok;
   }
 
+  // Starts a new stream to output, much cheaper than a new ZlibOutputStream,
+  // which allocates and initializes zlib state. Output could be NULL
+  // if nothing will be written before next reset().
+  bool reset(Buffer* output)
+  {
+    if (ended_)
+      return false;
+    output_ = output;
+    zerror_ = deflateReset(&zstream_);
+    return zerror_ == Z_OK;
+  }
+
  private:
   int compress(int flush)
   {
@@ -139,6 +214,158 @@ class ZlibOutputStream : noncopyable
   z_stream zstream_;
   int zerror_;
   int bufferSize_;
+  bool ended_;  // deflateEnd() called
+};
+
+// Idle ZlibOutputStreams of the same options, for reuse.
+// Not thread safe, keep one per loop, e.g. with ThreadLocalSingleton.
+class ZlibOutputStreamPool : noncopyable
+{
+ public:
+  explicit ZlibOutputStreamPool(ZlibFormat format = kGzipFormat,
+                                int level = Z_DEFAULT_COMPRESSION,
+                                int windowBits = 15,
+                                int memLevel = 8,
+                                size_t maxIdle = 16)
+    : format_(format),
+      level_(level),
+      windowBits_(windowBits),
+      memLevel_(memLevel),
+      maxIdle_(maxIdle)
+  {
+  }
+
+  ZlibFormat format() const { return format_; }
+  size_t idle() const { return idle_.size(); }
+
+  std::unique_ptr<ZlibOutputStream> get(Buffer* output)
+  {
+    std::unique_ptr<ZlibOutputStream> stream;
+    if (!idle_.empty())
+    {
+      stream = std::move(idle_.back());
+      idle_.pop_back();
+      stream->reset(output);
+    }
+    else
+    {
+      stream.reset(new ZlibOutputStream(output, format_, level_, windowBits_, memLevel_));
+    }
+    return stream;
+  }
+
+  // keeps at most maxIdle streams, destroys the rest.
+  void put(std::unique_ptr<ZlibOutputStream> stream)
+  {
+    if (idle_.size() < maxIdle_ && stream->reset(NULL))
+    {
+      idle_.push_back(std::move(stream));
+    }
+  }
+
+ private:
+  const ZlibFormat format_;
+  const int level_;
+  const int windowBits_;
+  const int memLevel_;
+  const size_t maxIdle_;
+  std::vector<std::unique_ptr<ZlibOutputStream>> idle_;
+};
+
+///
+/// Compresses a stream of data incrementally, and passes compressed
+/// data to a callback, or sends them to a TcpConnection.
+///
+/// Compressed data are passed on once there are highWaterMark bytes,
+/// or by flush(), so that memory is bounded no matter how long the stream.
+/// The ZlibOutputStream is taken from a pool and returned by finish(),
+/// without a pool, it's a new one of gzip format and default options.
+/// Not thread safe, one at a time.
+///
+class ZlibStreamWriter : noncopyable
+{
+ public:
+  // should consume data in the buffer
+  typedef std::function<void (Buffer*)> OutputCallback;
+
+  ZlibStreamWriter(const OutputCallback& cb,
+                   ZlibOutputStreamPool* pool,
+                   size_t highWaterMark = 16*1024)
+    : outputCallback_(cb),
+      pool_(pool),
+      highWaterMark_(highWaterMark)
+  {
+    if (pool_)
+      stream_ = pool_->get(&output_);
+    else
+      stream_.reset(new ZlibOutputStream(&output_, kGzipFormat));
+  }
+
+  ZlibStreamWriter(const TcpConnectionPtr& conn,
+                   ZlibOutputStreamPool* pool,
+                   size_t highWaterMark = 16*1024)
+    : ZlibStreamWriter(std::bind(&ZlibStreamWriter::sendTo, conn, std::placeholders::_1),
+                       pool, highWaterMark)
+  {
+  }
+
+  ~ZlibStreamWriter()
+  {
+    finish();
+  }
+
+  bool ok() const
+  { return stream_ && stream_->zlibErrorCode() == Z_OK; }
+
+  bool write(StringPiece data)
+  {
+    if (!stream_ || !stream_->write(data))
+      return false;
+    if (output_.readableBytes() >= highWaterMark_)
+      output();
+    return true;
+  }
+
+  bool flush()
+  {
+    if (!stream_ || !stream_->flush())
+      return false;
+    output();
+    return true;
+  }
+
+  bool finish()
+  {
+    if (!stream_)
+      return false;
+    bool ok = stream_->finishStream();
+    output();
+    if (pool_)
+      pool_->put(std::move(stream_));
+    stream_.reset();
+    return ok;
+  }
+
+ private:
+  static void sendTo(const TcpConnectionPtr& conn, Buffer* data)
+  {
+    conn->send(data);
+  }
+
+  void output()
+  {
+    if (output_.readableBytes() > 0)
+    {
+      outputCallback_(&output_);
+      output_.retrieveAll();
+    }
+  }
+
+  OutputCallback outputCallback_;
+  ZlibOutputStreamPool* pool_;
+  const size_t highWaterMark_;
+  Buffer output_;
+  std::unique_ptr<ZlibOutputStream> stream_;
 };
 
 }  // namespace net
@@ -8,23 +8,36 @@
 //
 
 #include "muduo/net/Buffer.h"
+#include "muduo/net/ByteScan.h"
 #include "muduo/net/http/HttpContext.h"
 
+#include <ctype.h>
+#include <strings.h>
+
 using namespace muduo;
 using namespace muduo::net;
 
+const size_t HttpContext::kDefaultMaxBodySize;
+const size_t HttpContext::kMaxLineLength;
+const size_t HttpContext::kDefaultMaxHeaders;
+
 bool HttpContext::processRequestLine(const char* begin, const char* end)
 {
   bool succeed = false;
   const char* start = begin;
-  const char* space = std::find(start, end, ' ');
+  const char* space = scan::findChar(start, end, ' ');
   if (space != end && request_.setMethod(start, space))
   {
     start = space+1;
-    space = std::find(start, end, ' ');
+    // one pass for both
+    const char* question = scan::findEither(start, end, ' ', '?');
+    space = question;
+    if (question != end && *question == '?')
+    {
+      space = scan::findChar(question, end, ' ');
+    }
     if (space != end)
     {
-      const char* question = std::find(start, space, '?');
       if (question != space)
       {
         request_.setPath(start, question);
@@ -56,6 +69,111 @@ bool HttpContext::processRequestLine(const char* begin, const char* end)
   return succeed;
 }
 
+namespace
+{
+
+// header names are case-insensitive
+const string* findHeader(const std::map<string, string>& headers, const char* field)
+{
+  for (const auto& header : headers)
+  {
+    if (strcasecmp(header.first.c_str(), field) == 0)
+    {
+      return &header.second;
+    }
+  }
+  return NULL;
+}
+
+}  // namespace
+
+bool HttpContext::processHeadersEnd()
+{
+  // Transfer-Encoding overrides Content-Length, RFC 7230 section 3.3.3
+  const string* encoding = findHeader(request_.headers(), "Transfer-Encoding");
+  if (encoding)
+  {
+    // chunked must be the final encoding
+    const char* chunked = "chunked";
+    size_t len = strlen(chunked);
+    if (encoding->size() < len ||
+        strcasecmp(encoding->c_str() + encoding->size() - len, chunked) != 0)
+    {
+      return false;
+    }
+    state_ = kExpectChunkSize;
+    return true;
+  }
+
+  const string* length = findHeader(request_.headers(), "Content-Length");
+  if (length)
+  {
+    if (length->empty() || length->size() > 19)
+    {
+      return false;
+    }
+    size_t n = 0;
+    for (char c : *length)
+    {
+      if (!isdigit(c))
+      {
+        return false;
+      }
+      n = n * 10 + static_cast<size_t>(c - '0');
+    }
+    if (n > maxBodySize_)
+    {
+      return false;
+    }
+    if (n > 0)
+    {
+      bodyRemaining_ = n;
+      state_ = kExpectBody;
+      return true;
+    }
+  }
+  state_ = kGotAll;
+  return true;
+}
+
+bool HttpContext::processChunkSize(const char* begin, const char* end)
+{
+  // chunk extensions are ignored
+  const char* semicolon = std::find(begin, end, ';');
+  while (semicolon > begin && isspace(*(semicolon-1)))
+  {
+    --semicolon;
+  }
+  if (begin == semicolon || semicolon - begin > 16)
+  {
+    return false;
+  }
+  size_t n = 0;
+  for (const char* p = begin; p < semicolon; ++p)
+  {
+    if (!isxdigit(*p))
+    {
+      return false;
+    }
+    n = n * 16 + static_cast<size_t>(isdigit(*p) ? *p - '0' : tolower(*p) - 'a' + 10);
+  }
+  if (n > maxBodySize_ - request_.body().size())
+  {
+    return false;
+  }
+  bodyRemaining_ = n;
+  state_ = n > 0 ? kExpectChunkData : kExpectTrailers;
+  return true;
+}
+
+void HttpContext::processBody(Buffer* buf)
+{
+  size_t n = std::min(buf->readableBytes(), bodyRemaining_);
+  request_.appendBody(buf->peek(), buf->peek() + n);
+  buf->retrieve(n);
+  bodyRemaining_ -= n;
+}
+
 // return false if any error
 bool HttpContext::parseRequest(Buffer* buf, Timestamp receiveTime)
 {
@@ -82,36 +200,105 @@ bool HttpContext::parseRequest(Buffer* buf, Timestamp receiveTime)
       }
       else
       {
+        ok = buf->readableBytes() <= kMaxLineLength;
         hasMore = false;
       }
     }
-    else if (state_ == kExpectHeaders)
+    else if (state_ == kExpectHeaders || state_ == kExpectTrailers)
     {
       const char* crlf = buf->findCRLF();
       if (crlf)
       {
-        const char* colon = std::find(buf->peek(), crlf, ':');
+        const char* colon = scan::findChar(buf->peek(), crlf, ':');
         if (colon != crlf)
         {
-          request_.addHeader(buf->peek(), colon, crlf);
+          if (++numHeaders_ <= maxHeaders_)
+          {
+            request_.addHeader(buf->peek(), colon, crlf);
+            buf->retrieveUntil(crlf + 2);
+          }
+          else
+          {
+            ok = false;
+            headersTooLarge_ = true;
+            hasMore = false;
+          }
         }
         else
         {
           // empty line, end of header
-          // FIXME:
-          state_ = kGotAll;
-          hasMore = false;
+          buf->retrieveUntil(crlf + 2);
+          if (state_ == kExpectHeaders)
+          {
+            ok = processHeadersEnd();
+          }
+          else
+          {
+            state_ = kGotAll;
+          }
+          hasMore = ok && state_ != kGotAll;
         }
-        buf->retrieveUntil(crlf + 2);
       }
       else
       {
+        ok = buf->readableBytes() <= kMaxLineLength;
+        headersTooLarge_ = !ok;
         hasMore = false;
       }
     }
     else if (state_ == kExpectBody)
     {
-      // FIXME:
+      processBody(buf);
+      if (bodyRemaining_ == 0)
+      {
+        state_ = kGotAll;
+      }
+      hasMore = false;
+    }
+    else if (state_ == kExpectChunkSize)
+    {
+      const char* crlf = buf->findCRLF();
+      if (crlf)
+      {
+        ok = processChunkSize(buf->peek(), crlf);
+        buf->retrieveUntil(crlf + 2);
+        hasMore = ok;
+      }
+      else
+      {
+        ok = buf->readableBytes() <= kMaxLineLength;
+        hasMore = false;
+      }
+    }
+    else if (state_ == kExpectChunkData)
+    {
+      processBody(buf);
+      if (bodyRemaining_ == 0)
+      {
+        state_ = kExpectChunkEnd;
+      }
+      else
+      {
+        hasMore = false;
+      }
+    }
+    else if (state_ == kExpectChunkEnd)
+    {
+      if (buf->readableBytes() >= 2)
+      {
+        ok = buf->peek()[0] == '\r' && buf->peek()[1] == '\n';
+        buf->retrieve(2);
+        state_ = kExpectChunkSize;
+        hasMore = ok;
+      }
+      else
+      {
+        hasMore = false;
+      }
+    }
+    else
+    {
+      hasMore = false;
     }
   }
   return ok;
@@ -30,25 +30,64 @@ class HttpContext : public muduo::copyable
     kExpectRequestLine,
     kExpectHeaders,
     kExpectBody,
+    kExpectChunkSize,
+    kExpectChunkData,
+    kExpectChunkEnd,
+    kExpectTrailers,
     kGotAll,
   };
 
+  static const size_t kDefaultMaxBodySize = 8*1024*1024;
+  static const size_t kMaxLineLength = 8*1024;
+  static const size_t kDefaultMaxHeaders = 100;
+
   HttpContext()
-    : state_(kExpectRequestLine)
+    : state_(kExpectRequestLine),
+      bodyRemaining_(0),
+      maxBodySize_(kDefaultMaxBodySize),
+      numHeaders_(0),
+      maxHeaders_(kDefaultMaxHeaders),
+      headersTooLarge_(false),
+      paused_(false)
   {
   }
 
   // default copy-ctor, dtor and assignment are fine
 
   // return false if any error
+  // stops after one request, the rest of buf is left for the next one.
   bool parseRequest(Buffer* buf, Timestamp receiveTime);
 
+  // requests with a larger body are rejected
+  void setMaxBodySize(size_t size)
+  { maxBodySize_ = size; }
+
+  // requests with more header and trailer fields are rejected
+  void setMaxHeaders(size_t count)
+  { maxHeaders_ = count; }
+
+  // parseRequest() failed on too many fields, or a field line longer
+  // than kMaxLineLength, to be answered with 431 rather than 400.
+  bool headersTooLarge() const
+  { return headersTooLarge_; }
+
+  // pipelined requests wait in input buffer while the response
+  // to previous one is being streamed, see HttpServer.
+  void setPaused(bool on)
+  { paused_ = on; }
+
+  bool paused() const
+  { return paused_; }
+
   bool gotAll() const
   { return state_ == kGotAll; }
 
   void reset()
   {
     state_ = kExpectRequestLine;
+    bodyRemaining_ = 0;
+    numHeaders_ = 0;
+    headersTooLarge_ = false;
     HttpRequest dummy;
     request_.swap(dummy);
   }
@@ -61,9 +100,19 @@ class HttpContext : public muduo::copyable
 
  private:
   bool processRequestLine(const char* begin, const char* end);
+  bool processHeadersEnd();
+  bool processChunkSize(const char* begin, const char* end);
+  void processBody(Buffer* buf);
 
   HttpRequestParseState state_;
   HttpRequest request_;
+  // of Content-Length body or current chunk
+  size_t bodyRemaining_;
+  size_t maxBodySize_;
+  size_t numHeaders_;
+  size_t maxHeaders_;
+  bool headersTooLarge_;
+  bool paused_;
 };
 
 }  // namespace net
@@ -16,21 +16,43 @@ using namespace muduo;
 using namespace muduo::net;
 
 void HttpResponse::appendToBuffer(Buffer* output) const
+{
+  appendStatusLine(output);
+  // always sent, so responses to pipelined requests can be told apart
+  char buf[32];
+  snprintf(buf, sizeof buf, "Content-Length: %zd\r\n", body_.size());
+  output->append(buf);
+  appendHeaders(output);
+  output->append(body_);
+}
+
+void HttpResponse::appendHeadersToBuffer(Buffer* output, bool chunked) const
+{
+  appendStatusLine(output);
+  if (chunked)
+  {
+    output->append("Transfer-Encoding: chunked\r\n");
+  }
+  appendHeaders(output);
+}
+
+void HttpResponse::appendStatusLine(Buffer* output) const
 {
   char buf[32];
   snprintf(buf, sizeof buf, "HTTP/1.1 %d ", statusCode_);
   output->append(buf);
   output->append(statusMessage_);
   output->append("\r\n");
+}
 
+void HttpResponse::appendHeaders(Buffer* output) const
+{
   if (closeConnection_)
   {
     output->append("Connection: close\r\n");
   }
   else
   {
-    snprintf(buf, sizeof buf, "Content-Length: %zd\r\n", body_.size());
-    output->append(buf);
     output->append("Connection: Keep-Alive\r\n");
   }
 
@@ -43,5 +65,4 @@ void HttpResponse::appendToBuffer(Buffer* output) const
   }
 
   output->append("\r\n");
-  output->append(body_);
 }
@@ -32,6 +32,7 @@ class HttpResponse : public muduo::copyable
     k301MovedPermanently = 301,
     k400BadRequest = 400,
     k404NotFound = 404,
+    k500InternalServerError = 500,
   };
 
   explicit HttpResponse(bool close)
@@ -64,7 +65,14 @@ class HttpResponse : public muduo::copyable
 
   void appendToBuffer(Buffer* output) const;
 
+  // status line and headers only, the body is sent in chunks,
+  // or till the connection closes if not chunked.
+  void appendHeadersToBuffer(Buffer* output, bool chunked) const;
+
  private:
+  void appendStatusLine(Buffer* output) const;
+  void appendHeaders(Buffer* output) const;
+
   std::map<string, string> headers_;
   HttpStatusCode statusCode_;
   // FIXME: add http version
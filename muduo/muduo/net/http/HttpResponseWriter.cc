@@ -0,0 +1,126 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+
+#include "muduo/net/http/HttpResponseWriter.h"
+
+#include "muduo/net/Buffer.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpConnection.h"
+#include "muduo/net/http/HttpResponse.h"
+
+#include <stdio.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+HttpResponseWriter::HttpResponseWriter(const TcpConnectionPtr& conn,
+                                       bool chunked,
+                                       bool close,
+                                       const DoneCallback& cb)
+  : conn_(conn),
+    chunked_(chunked),
+    closeConnection_(close),
+    started_(false),
+    finished_(false),
+    doneCallback_(cb)
+{
+}
+
+HttpResponseWriter::~HttpResponseWriter()
+{
+  finish();
+}
+
+void HttpResponseWriter::send(const HttpResponse& response)
+{
+  assert(!started_);
+  started_ = true;
+  finished_ = true;
+  closeConnection_ = response.closeConnection();
+  Buffer buf;
+  response.appendToBuffer(&buf);
+  conn_->send(&buf);
+  done();
+}
+
+void HttpResponseWriter::start(const HttpResponse& response)
+{
+  assert(!started_);
+  started_ = true;
+  Buffer buf;
+  if (!chunked_ && !response.closeConnection())
+  {
+    // the end of body is told by closing the connection
+    HttpResponse closing(response);
+    closing.setCloseConnection(true);
+    closing.appendHeadersToBuffer(&buf, false);
+  }
+  else
+  {
+    response.appendHeadersToBuffer(&buf, chunked_);
+  }
+  closeConnection_ = !chunked_ || response.closeConnection();
+  conn_->send(&buf);
+}
+
+void HttpResponseWriter::write(const StringPiece& data)
+{
+  assert(started_ && !finished_);
+  // an empty chunk ends the body
+  if (data.empty())
+  {
+    return;
+  }
+
+  if (chunked_)
+  {
+    char size[32];
+    snprintf(size, sizeof size, "%zx\r\n", static_cast<size_t>(data.size()));
+    Buffer buf;
+    buf.append(size);
+    buf.append(data);
+    buf.append("\r\n", 2);
+    conn_->send(&buf);
+  }
+  else
+  {
+    conn_->send(data);
+  }
+}
+
+void HttpResponseWriter::finish()
+{
+  if (finished_)
+  {
+    return;
+  }
+
+  if (!started_)
+  {
+    HttpResponse response(true);
+    response.setStatusCode(HttpResponse::k500InternalServerError);
+    response.setStatusMessage("Internal Server Error");
+    send(response);
+    return;
+  }
+
+  finished_ = true;
+  if (chunked_)
+  {
+    conn_->send("0\r\n\r\n");
+  }
+  done();
+}
+
+void HttpResponseWriter::done()
+{
+  if (closeConnection_)
+  {
+    conn_->shutdown();
+  }
+  // queued after the data sent from this thread
+  conn_->getLoop()->queueInLoop(doneCallback_);
+}
@@ -0,0 +1,73 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_HTTP_HTTPRESPONSEWRITER_H
+#define MUDUO_NET_HTTP_HTTPRESPONSEWRITER_H
+
+#include "muduo/base/noncopyable.h"
+#include "muduo/base/StringPiece.h"
+#include "muduo/net/Callbacks.h"
+
+namespace muduo
+{
+namespace net
+{
+
+class HttpResponse;
+
+///
+/// Sends the response to one request of HttpServer, possibly in pieces.
+///
+/// The body of unknown length is sent with chunked transfer encoding,
+/// or till the connection closes for HTTP/1.0 clients.
+/// Could be used in any thread, but one at a time.
+/// Next pipelined request of the connection is processed after finish(),
+/// which is called in destructor if not yet.
+///
+class HttpResponseWriter : noncopyable
+{
+ public:
+  typedef std::function<void()> DoneCallback;
+
+  HttpResponseWriter(const TcpConnectionPtr& conn,
+                     bool chunked,
+                     bool close,
+                     const DoneCallback& cb);
+  ~HttpResponseWriter();
+
+  /// Whether the client asked to close the connection,
+  /// to construct HttpResponse with.
+  bool closeConnection() const
+  { return closeConnection_; }
+
+  /// Sends a whole response, with Content-Length.
+  void send(const HttpResponse& response);
+
+  /// Sends status line and headers, the body of response is ignored.
+  void start(const HttpResponse& response);
+  /// Sends part of the body, after start().
+  void write(const StringPiece& data);
+  /// Ends the body, if start() is not called, sends 500 Internal Server Error.
+  void finish();
+
+ private:
+  void done();
+
+  TcpConnectionPtr conn_;
+  const bool chunked_;
+  bool closeConnection_;
+  bool started_;
+  bool finished_;
+  DoneCallback doneCallback_;
+};
+
+typedef std::shared_ptr<HttpResponseWriter> HttpResponseWriterPtr;
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_HTTP_HTTPRESPONSEWRITER_H
@@ -40,7 +40,8 @@ HttpServer::HttpServer(EventLoop* loop,
                        const string& name,
                        TcpServer::Option option)
   : server_(loop, listenAddr, name, option),
-    httpCallback_(detail::defaultHttpCallback)
+    httpCallback_(detail::defaultHttpCallback),
+    maxBodySize_(HttpContext::kDefaultMaxBodySize)
 {
   server_.setConnectionCallback(
       std::bind(&HttpServer::onConnection, this, _1));
@@ -59,7 +60,9 @@ void HttpServer::onConnection(const TcpConnectionPtr& conn)
 {
   if (conn->connected())
   {
-    conn->setContext(HttpContext());
+    HttpContext context;
+    context.setMaxBodySize(maxBodySize_);
+    conn->setContext(context);
   }
 }
 
@@ -68,33 +71,82 @@ void HttpServer::onMessage(const TcpConnectionPtr& conn,
                            Timestamp receiveTime)
 {
   HttpContext* context = boost::any_cast<HttpContext>(conn->getMutableContext());
-
-  if (!context->parseRequest(buf, receiveTime))
+  if (!context->paused())
   {
-    conn->send("HTTP/1.1 400 Bad Request\r\n\r\n");
-    conn->shutdown();
+    handleRequests(conn, context, buf, receiveTime);
   }
+}
 
-  if (context->gotAll())
+void HttpServer::handleRequests(const TcpConnectionPtr& conn,
+                                HttpContext* context,
+                                Buffer* buf,
+                                Timestamp receiveTime)
+{
+  Buffer output;
+  bool close = false;
+  while (!close && !context->paused())
   {
-    onRequest(conn, context->request());
+    if (!context->parseRequest(buf, receiveTime))
+    {
+      output.append(context->headersTooLarge()
+                    ? "HTTP/1.1 431 Request Header Fields Too Large\r\n\r\n"
+                    : "HTTP/1.1 400 Bad Request\r\n\r\n");
+      close = true;
+      break;
+    }
+    if (!context->gotAll())
+    {
+      break;
+    }
+
+    const HttpRequest& req = context->request();
+    const string& connection = req.getHeader("Connection");
+    bool closeRequested = connection == "close" ||
+      (req.getVersion() == HttpRequest::kHttp10 && connection != "Keep-Alive");
+    if (httpStreamCallback_)
+    {
+      // keeps responses in order
+      if (output.readableBytes() > 0)
+      {
+        conn->send(&output);
+      }
+      context->setPaused(true);
+      HttpResponseWriterPtr writer(new HttpResponseWriter(
+          conn,
+          req.getVersion() == HttpRequest::kHttp11,
+          closeRequested,
+          std::bind(&HttpServer::onResponseDone, this, conn)));
+      httpStreamCallback_(req, writer);
+    }
+    else
+    {
+      HttpResponse response(closeRequested);
+      httpCallback_(req, &response);
+      response.appendToBuffer(&output);
+      close = response.closeConnection();
+    }
     context->reset();
   }
-}
 
-void HttpServer::onRequest(const TcpConnectionPtr& conn, const HttpRequest& req)
-{
-  const string& connection = req.getHeader("Connection");
-  bool close = connection == "close" ||
-    (req.getVersion() == HttpRequest::kHttp10 && connection != "Keep-Alive");
-  HttpResponse response(close);
-  httpCallback_(req, &response);
-  Buffer buf;
-  response.appendToBuffer(&buf);
-  conn->send(&buf);
-  if (response.closeConnection())
+  if (output.readableBytes() > 0)
   {
+    conn->send(&output);
+  }
+  if (close)
+  {
+    // ignores anything after
+    context->setPaused(true);
     conn->shutdown();
   }
 }
 
+void HttpServer::onResponseDone(const TcpConnectionPtr& conn)
+{
+  // not connected if the response closed it
+  if (conn->connected())
+  {
+    HttpContext* context = boost::any_cast<HttpContext>(conn->getMutableContext());
+    context->setPaused(false);
+    handleRequests(conn, context, conn->inputBuffer(), Timestamp::now());
+  }
+}
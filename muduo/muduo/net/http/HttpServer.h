@@ -12,12 +12,14 @@
 #define MUDUO_NET_HTTP_HTTPSERVER_H
 
 #include "muduo/net/TcpServer.h"
+#include "muduo/net/http/HttpResponseWriter.h"
 
 namespace muduo
 {
 namespace net
 {
 
+class HttpContext;
 class HttpRequest;
 class HttpResponse;
 
@@ -25,11 +27,19 @@ class HttpResponse;
 /// It is not a fully HTTP 1.1 compliant server, but provides minimum features
 /// that can communicate with HttpClient and Web browser.
 /// It is synchronous, just like Java Servlet.
+///
+/// Requests pipelined on one connection are answered in order,
+/// responses to those arrived together are sent in one batch.
+/// A response could also be streamed with HttpResponseWriter.
 class HttpServer : noncopyable
 {
  public:
   typedef std::function<void (const HttpRequest&,
                               HttpResponse*)> HttpCallback;
+  /// HttpRequest is valid only during the callback,
+  /// the response is sent with writer, maybe later in another thread.
+  typedef std::function<void (const HttpRequest&,
+                              const HttpResponseWriterPtr&)> HttpStreamCallback;
 
   HttpServer(EventLoop* loop,
              const InetAddress& listenAddr,
@@ -44,6 +54,19 @@ class HttpServer : noncopyable
     httpCallback_ = cb;
   }
 
+  /// Not thread safe, callback be registered before calling start().
+  /// Takes all requests instead of HttpCallback.
+  void setHttpStreamCallback(const HttpStreamCallback& cb)
+  {
+    httpStreamCallback_ = cb;
+  }
+
+  /// Not thread safe, requests with larger body get 400 Bad Request.
+  void setMaxBodySize(size_t size)
+  {
+    maxBodySize_ = size;
+  }
+
   void setThreadNum(int numThreads)
   {
     server_.setThreadNum(numThreads);
@@ -56,10 +79,16 @@ class HttpServer : noncopyable
   void onMessage(const TcpConnectionPtr& conn,
                  Buffer* buf,
                  Timestamp receiveTime);
-  void onRequest(const TcpConnectionPtr&, const HttpRequest&);
+  void handleRequests(const TcpConnectionPtr& conn,
+                      HttpContext* context,
+                      Buffer* buf,
+                      Timestamp receiveTime);
+  void onResponseDone(const TcpConnectionPtr& conn);
 
   TcpServer server_;
   HttpCallback httpCallback_;
+  HttpStreamCallback httpStreamCallback_;
+  size_t maxBodySize_;
 };
 
 }  // namespace net
@@ -0,0 +1,97 @@
+// HttpServer with Content-Encoding: gzip.
+//
+// GET /log streams lines of text, compressed on the fly if the client
+// accepts gzip, e.g. curl --compressed http://127.0.0.1:8000/log
+
+#include "muduo/net/http/HttpServer.h"
+#include "muduo/net/http/HttpRequest.h"
+#include "muduo/net/http/HttpResponse.h"
+#include "muduo/net/http/HttpResponseWriter.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/ZlibStream.h"
+#include "muduo/base/Logging.h"
+#include "muduo/base/ThreadLocalSingleton.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+int g_lines = 10000;
+
+bool acceptGzip(const HttpRequest& req)
+{
+  // FIXME: q=0
+  return req.getHeader("Accept-Encoding").find("gzip") != string::npos;
+}
+
+void writeBody(const HttpResponseWriterPtr& writer, Buffer* data)
+{
+  writer->write(StringPiece(data->peek(), static_cast<int>(data->readableBytes())));
+}
+
+int formatLine(char* buf, size_t size, int i)
+{
+  return snprintf(buf, size, "line %d of %d, the quick brown fox jumps over the lazy dog\n",
+                  i, g_lines);
+}
+
+void onRequest(const HttpRequest& req, const HttpResponseWriterPtr& writer)
+{
+  HttpResponse resp(writer->closeConnection());
+  if (req.path() != "/log")
+  {
+    resp.setStatusCode(HttpResponse::k404NotFound);
+    resp.setStatusMessage("Not Found");
+    writer->send(resp);
+    return;
+  }
+
+  bool gzip = acceptGzip(req);
+  resp.setStatusCode(HttpResponse::k200Ok);
+  resp.setStatusMessage("OK");
+  resp.setContentType("text/plain");
+  resp.addHeader("Vary", "Accept-Encoding");
+  if (gzip)
+  {
+    resp.addHeader("Content-Encoding", "gzip");
+  }
+  writer->start(resp);
+
+  char line[128];
+  if (gzip)
+  {
+    // one pool per I/O thread
+    ZlibStreamWriter compressor(std::bind(writeBody, writer, _1),
+                                &ThreadLocalSingleton<ZlibOutputStreamPool>::instance());
+    for (int i = 0; i < g_lines; ++i)
+    {
+      compressor.write(StringPiece(line, formatLine(line, sizeof line, i)));
+    }
+    compressor.finish();
+  }
+  else
+  {
+    for (int i = 0; i < g_lines; ++i)
+    {
+      writer->write(StringPiece(line, formatLine(line, sizeof line, i)));
+    }
+  }
+  writer->finish();
+}
+
+int main(int argc, char* argv[])
+{
+  int numThreads = argc > 1 ? atoi(argv[1]) : 0;
+  if (argc > 2)
+  {
+    g_lines = atoi(argv[2]);
+  }
+  EventLoop loop;
+  HttpServer server(&loop, InetAddress(8000), "gzip");
+  server.setHttpStreamCallback(onRequest);
+  server.setThreadNum(numThreads);
+  server.start();
+  loop.loop();
+}
@@ -77,3 +77,170 @@ BOOST_AUTO_TEST_CASE(testParseRequestEmptyHeaderValue)
   BOOST_CHECK_EQUAL(request.getHeader("User-Agent"), string(""));
   BOOST_CHECK_EQUAL(request.getHeader("Accept-Encoding"), string(""));
 }
+
+BOOST_AUTO_TEST_CASE(testParseRequestContentLength)
+{
+  string all("POST /api HTTP/1.1\r\n"
+       "Host: www.chenshuo.com\r\n"
+       "content-length: 11\r\n"
+       "\r\n"
+       "hello world");
+
+  for (size_t sz1 = 0; sz1 < all.size(); ++sz1)
+  {
+    HttpContext context;
+    Buffer input;
+    input.append(all.c_str(), sz1);
+    BOOST_CHECK(context.parseRequest(&input, Timestamp::now()));
+    BOOST_CHECK(!context.gotAll());
+
+    input.append(all.c_str() + sz1, all.size() - sz1);
+    BOOST_CHECK(context.parseRequest(&input, Timestamp::now()));
+    BOOST_CHECK(context.gotAll());
+    BOOST_CHECK_EQUAL(context.request().method(), HttpRequest::kPost);
+    BOOST_CHECK_EQUAL(context.request().body(), string("hello world"));
+    BOOST_CHECK_EQUAL(input.readableBytes(), 0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testParseRequestChunked)
+{
+  string all("POST /api HTTP/1.1\r\n"
+       "Transfer-Encoding: chunked\r\n"
+       "\r\n"
+       "5\r\nhello\r\n"
+       "1;ext=1\r\n \r\n"
+       "A\r\n0123456789\r\n"
+       "0\r\n"
+       "Trailer: yes\r\n"
+       "\r\n");
+
+  for (size_t sz1 = 0; sz1 < all.size(); ++sz1)
+  {
+    HttpContext context;
+    Buffer input;
+    input.append(all.c_str(), sz1);
+    BOOST_CHECK(context.parseRequest(&input, Timestamp::now()));
+    BOOST_CHECK(!context.gotAll());
+
+    input.append(all.c_str() + sz1, all.size() - sz1);
+    BOOST_CHECK(context.parseRequest(&input, Timestamp::now()));
+    BOOST_CHECK(context.gotAll());
+    BOOST_CHECK_EQUAL(context.request().body(), string("hello 0123456789"));
+    BOOST_CHECK_EQUAL(context.request().getHeader("Trailer"), string("yes"));
+    BOOST_CHECK_EQUAL(input.readableBytes(), 0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testParseRequestPipelined)
+{
+  HttpContext context;
+  Buffer input;
+  input.append("POST /a HTTP/1.1\r\n"
+       "Content-Length: 3\r\n"
+       "\r\n"
+       "abc"
+       "GET /b HTTP/1.1\r\n"
+       "\r\n"
+       "GET /c HTTP/1.1\r\n");
+
+  BOOST_CHECK(context.parseRequest(&input, Timestamp::now()));
+  BOOST_CHECK(context.gotAll());
+  BOOST_CHECK_EQUAL(context.request().path(), string("/a"));
+  BOOST_CHECK_EQUAL(context.request().body(), string("abc"));
+  context.reset();
+
+  BOOST_CHECK(context.parseRequest(&input, Timestamp::now()));
+  BOOST_CHECK(context.gotAll());
+  BOOST_CHECK_EQUAL(context.request().path(), string("/b"));
+  BOOST_CHECK_EQUAL(context.request().body(), string(""));
+  context.reset();
+
+  BOOST_CHECK(context.parseRequest(&input, Timestamp::now()));
+  BOOST_CHECK(!context.gotAll());
+  input.append("\r\n");
+  BOOST_CHECK(context.parseRequest(&input, Timestamp::now()));
+  BOOST_CHECK(context.gotAll());
+  BOOST_CHECK_EQUAL(context.request().path(), string("/c"));
+}
+
+BOOST_AUTO_TEST_CASE(testParseRequestBadBody)
+{
+  const char* requests[] = {
+    "POST / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n",
+    "POST / HTTP/1.1\r\nContent-Length: 101\r\n\r\n",
+    "POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n",
+    "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nz\r\n",
+    "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n65\r\n",
+    "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n1\r\nab\r\n",
+  };
+
+  for (const char* req : requests)
+  {
+    HttpContext context;
+    context.setMaxBodySize(100);
+    Buffer input;
+    input.append(req);
+    BOOST_CHECK(!context.parseRequest(&input, Timestamp::now()));
+  }
+
+  HttpContext context;
+  Buffer input;
+  input.append(string(HttpContext::kMaxLineLength + 1, 'x'));
+  BOOST_CHECK(!context.parseRequest(&input, Timestamp::now()));
+}
+
+BOOST_AUTO_TEST_CASE(testParseRequestTooManyHeaders)
+{
+  string request("GET / HTTP/1.1\r\n");
+  for (size_t i = 0; i < HttpContext::kDefaultMaxHeaders; ++i)
+  {
+    request += "X-" + std::to_string(i) + ": x\r\n";
+  }
+
+  {
+  HttpContext context;
+  Buffer input;
+  input.append(request + "\r\n");
+  BOOST_CHECK(context.parseRequest(&input, Timestamp::now()));
+  BOOST_CHECK(context.gotAll());
+  BOOST_CHECK(!context.headersTooLarge());
+  }
+
+  {
+  HttpContext context;
+  Buffer input;
+  input.append(request + "X-More: x\r\n\r\n");
+  BOOST_CHECK(!context.parseRequest(&input, Timestamp::now()));
+  BOOST_CHECK(context.headersTooLarge());
+  }
+
+  // trailers count too
+  {
+  HttpContext context;
+  context.setMaxHeaders(2);
+  Buffer input;
+  input.append("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+               "0\r\nA: 1\r\nB: 2\r\n\r\n");
+  BOOST_CHECK(!context.parseRequest(&input, Timestamp::now()));
+  BOOST_CHECK(context.headersTooLarge());
+  }
+
+  // a long header line is the same error, a long request line is not
+  {
+  HttpContext context;
+  Buffer input;
+  input.append("GET / HTTP/1.1\r\nX-Long: ");
+  input.append(string(HttpContext::kMaxLineLength, 'x'));
+  BOOST_CHECK(!context.parseRequest(&input, Timestamp::now()));
+  BOOST_CHECK(context.headersTooLarge());
+  }
+
+  {
+  HttpContext context;
+  Buffer input;
+  input.append(string(HttpContext::kMaxLineLength + 1, 'x'));
+  BOOST_CHECK(!context.parseRequest(&input, Timestamp::now()));
+  BOOST_CHECK(!context.headersTooLarge());
+  }
+}
@@ -0,0 +1,255 @@
+// HTTP/1.1 load generator in the style of wrk, for benchmarking HttpServer.
+//
+// Each connection keeps 'pipeline' GET requests in flight, sends a new one
+// whenever a response is complete, reports requests/s and latency.
+// Responses must have Content-Length, as HttpResponse does.
+
+#include "muduo/base/Atomic.h"
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThreadPool.h"
+#include "muduo/net/InetAddress.h"
+#include "muduo/net/TcpClient.h"
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+class Session : noncopyable
+{
+ public:
+  Session(EventLoop* loop,
+          const InetAddress& serverAddr,
+          const string& name,
+          const string& request,
+          int pipeline)
+    : loop_(loop),
+      client_(loop, serverAddr, name),
+      request_(request),
+      pipeline_(pipeline),
+      running_(true),
+      requests_(0),
+      errors_(0),
+      bytesRead_(0)
+  {
+    client_.setConnectionCallback(
+        std::bind(&Session::onConnection, this, _1));
+    client_.setMessageCallback(
+        std::bind(&Session::onMessage, this, _1, _2, _3));
+  }
+
+  EventLoop* getLoop() const { return loop_; }
+
+  void start()
+  {
+    client_.connect();
+  }
+
+  // in loop thread
+  void stop()
+  {
+    running_ = false;
+    client_.disconnect();
+  }
+
+  int64_t requests() const { return requests_; }
+  int64_t errors() const { return errors_; }
+  int64_t bytesRead() const { return bytesRead_; }
+  const std::vector<int32_t>& latencies() const { return latencies_; }
+
+ private:
+  void onConnection(const TcpConnectionPtr& conn)
+  {
+    if (conn->connected() && running_)
+    {
+      conn->setTcpNoDelay(true);
+      Buffer output;
+      for (int i = 0; i < pipeline_; ++i)
+      {
+        sendRequest(&output);
+      }
+      conn->send(&output);
+    }
+  }
+
+  void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime)
+  {
+    Buffer output;
+    ssize_t n;
+    bool success = false;
+    while ((n = parseResponse(buf, &success)) > 0)
+    {
+      if (!success)
+      {
+        ++errors_;
+      }
+      bytesRead_ += n;
+      buf->retrieve(static_cast<size_t>(n));
+      ++requests_;
+      latencies_.push_back(static_cast<int32_t>(
+          receiveTime.microSecondsSinceEpoch() - sentTimes_.front().microSecondsSinceEpoch()));
+      sentTimes_.pop_front();
+      if (running_)
+      {
+        sendRequest(&output);
+      }
+    }
+
+    if (n < 0)
+    {
+      ++errors_;
+      conn->shutdown();
+    }
+    else if (output.readableBytes() > 0)
+    {
+      conn->send(&output);
+    }
+  }
+
+  void sendRequest(Buffer* output)
+  {
+    output->append(request_);
+    sentTimes_.push_back(Timestamp::now());
+  }
+
+  // returns length of the response, 0 if incomplete, -1 if error
+  ssize_t parseResponse(Buffer* buf, bool* success)
+  {
+    const char* begin = buf->peek();
+    const char* end = buf->beginWrite();
+    const char kEnd[] = "\r\n\r\n";
+    const char* headerEnd = std::search(begin, end, kEnd, kEnd + 4);
+    if (headerEnd == end)
+    {
+      return 0;
+    }
+    if (end - begin < 12 || memcmp(begin, "HTTP/1.", 7) != 0)
+    {
+      return -1;
+    }
+    *success = begin[9] == '2';
+
+    const char* line = buf->findCRLF();
+    while (line < headerEnd)
+    {
+      line += 2;
+      const char* lineEnd = buf->findCRLF(line);
+      const char kLength[] = "Content-Length:";
+      size_t len = sizeof kLength - 1;
+      if (static_cast<size_t>(lineEnd - line) > len && strncasecmp(line, kLength, len) == 0)
+      {
+        ssize_t total = headerEnd + 4 - begin + atol(line + len);
+        return total <= end - begin ? total : 0;
+      }
+      line = lineEnd;
+    }
+    return -1;
+  }
+
+  EventLoop* loop_;
+  TcpClient client_;
+  const string request_;
+  const int pipeline_;
+  bool running_;
+  int64_t requests_;
+  int64_t errors_;
+  int64_t bytesRead_;
+  std::deque<Timestamp> sentTimes_;
+  std::vector<int32_t> latencies_;
+};
+
+void stopSession(Session* session, CountDownLatch* latch)
+{
+  session->stop();
+  latch->countDown();
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 3)
+  {
+    fprintf(stderr, "Usage: httpserver_bench <host_ip> <port> "
+            "[connections] [threads] [seconds] [pipeline] [path]\n");
+    return 1;
+  }
+
+  Logger::setLogLevel(Logger::WARN);
+  const char* ip = argv[1];
+  uint16_t port = static_cast<uint16_t>(atoi(argv[2]));
+  int connections = argc > 3 ? atoi(argv[3]) : 10;
+  int threads = argc > 4 ? atoi(argv[4]) : 1;
+  double seconds = argc > 5 ? atof(argv[5]) : 10.0;
+  int pipeline = argc > 6 ? atoi(argv[6]) : 1;
+  string path = argc > 7 ? argv[7] : "/hello";
+
+  string request = "GET " + path + " HTTP/1.1\r\nHost: " + string(ip) + "\r\n\r\n";
+  InetAddress serverAddr(ip, port);
+  EventLoop loop;
+  EventLoopThreadPool threadPool(&loop, "bench");
+  threadPool.setThreadNum(threads);
+  threadPool.start();
+
+  std::vector<std::unique_ptr<Session>> sessions;
+  for (int i = 0; i < connections; ++i)
+  {
+    char name[32];
+    snprintf(name, sizeof name, "C%05d", i);
+    sessions.emplace_back(new Session(threadPool.getNextLoop(), serverAddr,
+                                      name, request, pipeline));
+    sessions.back()->start();
+  }
+
+  printf("Running %.1fs test @ http://%s:%d%s\n", seconds, ip, port, path.c_str());
+  printf("  %d threads and %d connections, pipeline %d\n", threads, connections, pipeline);
+  Timestamp start(Timestamp::now());
+  loop.runAfter(seconds, std::bind(&EventLoop::quit, &loop));
+  loop.loop();
+  double elapsed = timeDifference(Timestamp::now(), start);
+
+  CountDownLatch latch(connections);
+  for (auto& session : sessions)
+  {
+    session->getLoop()->runInLoop(std::bind(stopSession, session.get(), &latch));
+  }
+  latch.wait();
+
+  int64_t requests = 0;
+  int64_t errors = 0;
+  int64_t bytesRead = 0;
+  std::vector<int32_t> latencies;
+  for (const auto& session : sessions)
+  {
+    requests += session->requests();
+    errors += session->errors();
+    bytesRead += session->bytesRead();
+    latencies.insert(latencies.end(),
+                     session->latencies().begin(), session->latencies().end());
+  }
+  std::sort(latencies.begin(), latencies.end());
+
+  if (!latencies.empty())
+  {
+    double sum = 0;
+    for (int32_t us : latencies)
+    {
+      sum += us;
+    }
+    size_t n = latencies.size();
+    printf("  Latency avg %.0fus p50 %dus p90 %dus p99 %dus max %dus\n",
+           sum / static_cast<double>(n), latencies[n / 2], latencies[n * 9 / 10],
+           latencies[n * 99 / 100], latencies.back());
+  }
+  printf("  %lld requests in %.2fs, %.2f MiB read, %lld errors\n",
+         static_cast<long long>(requests), elapsed,
+         static_cast<double>(bytesRead) / (1024 * 1024),
+         static_cast<long long>(errors));
+  printf("Requests/sec: %.2f\n", static_cast<double>(requests) / elapsed);
+}
@@ -7,6 +7,8 @@
 #include <iostream>
 #include <map>
 
+#include <string.h>
+
 using namespace muduo;
 using namespace muduo::net;
 
@@ -59,6 +61,30 @@ void onRequest(const HttpRequest& req, HttpResponse* resp)
   }
 }
 
+// /stream sends the body in pieces, others are the same as onRequest()
+void onStreamRequest(const HttpRequest& req, const HttpResponseWriterPtr& writer)
+{
+  if (req.path() == "/stream")
+  {
+    HttpResponse resp(writer->closeConnection());
+    resp.setStatusCode(HttpResponse::k200Ok);
+    resp.setStatusMessage("OK");
+    resp.setContentType("text/plain");
+    writer->start(resp);
+    for (int i = 0; i < 10; ++i)
+    {
+      writer->write("line " + std::to_string(i) + "\n");
+    }
+    writer->finish();
+  }
+  else
+  {
+    HttpResponse resp(writer->closeConnection());
+    onRequest(req, &resp);
+    writer->send(resp);
+  }
+}
+
 int main(int argc, char* argv[])
 {
   int numThreads = 0;
@@ -71,6 +97,10 @@ int main(int argc, char* argv[])
   EventLoop loop;
   HttpServer server(&loop, InetAddress(8000), "dummy");
   server.setHttpCallback(onRequest);
+  if (argc > 2 && strcmp(argv[2], "stream") == 0)
+  {
+    server.setHttpStreamCallback(onStreamRequest);
+  }
   server.setThreadNum(numThreads);
   server.start();
   loop.loop();
@@ -14,6 +14,7 @@
 #include "muduo/net/EventLoop.h"
 #include "muduo/net/http/HttpRequest.h"
 #include "muduo/net/http/HttpResponse.h"
+#include "muduo/net/inspect/LoopInspector.h"
 #include "muduo/net/inspect/ProcessInspector.h"
 #include "muduo/net/inspect/PerformanceInspector.h"
 #include "muduo/net/inspect/SystemInspector.h"
@@ -64,7 +65,8 @@ Inspector::Inspector(EventLoop* loop,
                      const string& name)
     : server_(loop, httpAddr, "Inspector:"+name),
       processInspector_(new ProcessInspector),
-      systemInspector_(new SystemInspector)
+      systemInspector_(new SystemInspector),
+      loopInspector_(new LoopInspector)
 {
   assert(CurrentThread::isMainThread());
   assert(g_globalInspector == 0);
@@ -72,6 +74,7 @@ Inspector::Inspector(EventLoop* loop,
   server_.setHttpCallback(std::bind(&Inspector::onRequest, this, _1, _2));
   processInspector_->registerCommands(this);
   systemInspector_->registerCommands(this);
+  loopInspector_->registerCommands(this);
 #ifdef HAVE_TCMALLOC
   performanceInspector_.reset(new PerformanceInspector);
   performanceInspector_->registerCommands(this);
@@ -162,6 +165,15 @@ void Inspector::onRequest(const HttpRequest& req, HttpResponse* resp)
 
         ok = true;
       }
+      else if (module == "metrics")
+      {
+        // where Prometheus scrapes by default
+        resp->setStatusCode(HttpResponse::k200Ok);
+        resp->setStatusMessage("OK");
+        resp->setContentType("text/plain; version=0.0.4");
+        resp->setBody(LoopInspector::metrics(req.method(), ArgList()));
+        ok = true;
+      }
       else
       {
         LOG_ERROR << "Unimplemented " << module;
@@ -22,6 +22,7 @@ namespace muduo
 namespace net
 {
 
+class LoopInspector;
 class ProcessInspector;
 class PerformanceInspector;
 class SystemInspector;
@@ -56,6 +57,7 @@ class Inspector : noncopyable
   std::unique_ptr<ProcessInspector> processInspector_;
   std::unique_ptr<PerformanceInspector> performanceInspector_;
   std::unique_ptr<SystemInspector> systemInspector_;
+  std::unique_ptr<LoopInspector> loopInspector_;
   MutexLock mutex_;
   std::map<string, CommandList> modules_ GUARDED_BY(mutex_);
   std::map<string, HelpList> helps_ GUARDED_BY(mutex_);
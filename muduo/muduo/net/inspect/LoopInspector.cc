@@ -0,0 +1,111 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+
+#include "muduo/net/inspect/LoopInspector.h"
+
+#include "muduo/net/LoopMetrics.h"
+
+#include <inttypes.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace muduo
+{
+namespace inspect
+{
+int stringPrintf(string* out, const char* fmt, ...) __attribute__ ((format (printf, 2, 3)));
+}
+}
+
+using namespace muduo::inspect;
+
+namespace
+{
+
+typedef LoopMetrics::Snapshot Snapshot;
+typedef LoopMetrics::HistogramSnapshot HistogramSnapshot;
+
+void header(string* out, const char* name, const char* type, const char* help)
+{
+  stringPrintf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+string labels(const Snapshot& loop)
+{
+  string result;
+  stringPrintf(&result, "loop=\"%s\",tid=\"%d\"", loop.name.c_str(), loop.tid);
+  return result;
+}
+
+void histogram(string* out, const std::vector<Snapshot>& loops,
+               const char* name, const char* help,
+               HistogramSnapshot Snapshot::* member)
+{
+  header(out, name, "histogram", help);
+  for (const Snapshot& loop : loops)
+  {
+    const HistogramSnapshot& h = loop.*member;
+    const string label = labels(loop);
+    int64_t cumulative = 0;
+    for (int i = 0; i < LoopMetrics::Histogram::kBuckets; ++i)
+    {
+      cumulative += h.counts[i];
+      stringPrintf(out, "%s_bucket{%s,le=\"%g\"} %" PRId64 "\n", name, label.c_str(),
+                   static_cast<double>(int64_t(1) << i) * 1e-6, cumulative);
+    }
+    stringPrintf(out, "%s_bucket{%s,le=\"+Inf\"} %" PRId64 "\n", name, label.c_str(), h.count);
+    stringPrintf(out, "%s_sum{%s} %.6f\n", name, label.c_str(),
+                 static_cast<double>(h.sum) * 1e-6);
+    stringPrintf(out, "%s_count{%s} %" PRId64 "\n", name, label.c_str(), h.count);
+  }
+}
+
+void scalar(string* out, const std::vector<Snapshot>& loops,
+            const char* name, const char* type, const char* help,
+            int64_t Snapshot::* member)
+{
+  header(out, name, type, help);
+  for (const Snapshot& loop : loops)
+  {
+    stringPrintf(out, "%s{%s} %" PRId64 "\n", name, labels(loop).c_str(), loop.*member);
+  }
+}
+
+}  // namespace
+
+void LoopInspector::registerCommands(Inspector* ins)
+{
+  ins->add("loop", "metrics", LoopInspector::metrics,
+           "print metrics of event loops in Prometheus format");
+}
+
+string LoopInspector::metrics(HttpRequest::Method, const Inspector::ArgList&)
+{
+  std::vector<Snapshot> loops = LoopMetrics::snapshotAll();
+  string result;
+  histogram(&result, loops, "muduo_loop_poll_wait_seconds",
+            "Time blocked in poller per iteration.", &Snapshot::pollWait);
+  histogram(&result, loops, "muduo_loop_handling_seconds",
+            "Time running callbacks and functors per iteration.", &Snapshot::handling);
+  histogram(&result, loops, "muduo_loop_timer_lateness_seconds",
+            "Time from expiration of a timer to running it.", &Snapshot::timerLateness);
+  scalar(&result, loops, "muduo_loop_functors_total", "counter",
+         "Functors run by queueInLoop().", &Snapshot::functors);
+  scalar(&result, loops, "muduo_loop_pending_functors", "gauge",
+         "Functors pending in the last iteration.", &Snapshot::pendingFunctors);
+  scalar(&result, loops, "muduo_loop_pending_functors_max", "gauge",
+         "Most functors pending in one iteration.", &Snapshot::maxPendingFunctors);
+  scalar(&result, loops, "muduo_loop_read_bytes_total", "counter",
+         "Bytes read by TcpConnections.", &Snapshot::bytesRead);
+  scalar(&result, loops, "muduo_loop_written_bytes_total", "counter",
+         "Bytes written by TcpConnections.", &Snapshot::bytesWritten);
+  scalar(&result, loops, "muduo_loop_output_buffer_high_water_bytes", "gauge",
+         "Most bytes in output buffer of a TcpConnection.", &Snapshot::outputBufferHighWater);
+  scalar(&result, loops, "muduo_loop_connections", "gauge",
+         "TcpConnections owned by the loop.", &Snapshot::connections);
+  return result;
+}
@@ -0,0 +1,30 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_INSPECT_LOOPINSPECTOR_H
+#define MUDUO_NET_INSPECT_LOOPINSPECTOR_H
+
+#include "muduo/net/inspect/Inspector.h"
+
+namespace muduo
+{
+namespace net
+{
+
+// Exports LoopMetrics of all event loops in Prometheus text format.
+class LoopInspector : noncopyable
+{
+ public:
+  void registerCommands(Inspector* ins);
+
+  static string metrics(HttpRequest::Method, const Inspector::ArgList&);
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_INSPECT_LOOPINSPECTOR_H
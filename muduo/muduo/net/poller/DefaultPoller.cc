@@ -9,6 +9,13 @@
 #include "muduo/net/Poller.h"
 #include "muduo/net/poller/PollPoller.h"
 #include "muduo/net/poller/EPollPoller.h"
+#ifndef NO_IO_URING
+#include "muduo/net/poller/IOUringPollPoller.h"
+#endif
+
+#include "muduo/base/Logging.h"
+
+#include <memory>
 
 #include <stdlib.h>
 
@@ -20,6 +27,18 @@ Poller* Poller::newDefaultPoller(EventLoop* loop)
   {
     return new PollPoller(loop);
   }
+#ifndef NO_IO_URING
+  else if (::getenv("MUDUO_USE_IOURING"))
+  {
+    std::unique_ptr<IOUringPollPoller> poller(new IOUringPollPoller(loop));
+    if (poller->valid())
+    {
+      return poller.release();
+    }
+    LOG_WARN << "MUDUO_USE_IOURING: io_uring poll mode unavailable, falling back to epoll";
+    return new EPollPoller(loop);
+  }
+#endif
   else
   {
     return new EPollPoller(loop);
@@ -0,0 +1,394 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include "muduo/net/poller/IOUringPollPoller.h"
+
+#include "muduo/base/Logging.h"
+#include "muduo/net/Channel.h"
+
+#include <algorithm>
+
+#include <assert.h>
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+const int kNew = -1;
+const int kAdded = 1;
+
+// user_data of POLL_REMOVE requests, their completions are ignored.
+const uint64_t kRemoveTag = ~uint64_t(0);
+
+uint64_t makeUserData(int fd, uint32_t generation)
+{
+  return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+}
+
+int fdOf(uint64_t userData)
+{
+  return static_cast<int>(static_cast<uint32_t>(userData));
+}
+
+uint32_t generationOf(uint64_t userData)
+{
+  return static_cast<uint32_t>(userData >> 32);
+}
+
+template<typename T>
+T* ringPointer(void* ring, uint32_t offset)
+{
+  return static_cast<T*>(static_cast<void*>(static_cast<char*>(ring) + offset));
+}
+
+int ioUringSetup(unsigned entries, struct io_uring_params* params)
+{
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete,
+                 unsigned flags, void* arg, size_t argSize)
+{
+  return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit,
+                                    minComplete, flags, arg, argSize));
+}
+
+}  // namespace
+
+IOUringPollPoller::IOUringPollPoller(EventLoop* loop)
+  : Poller(loop),
+    ringfd_(-1),
+    ringEntries_(0),
+    sqRing_(MAP_FAILED),
+    sqRingSize_(0),
+    sqHead_(NULL),
+    sqTail_(NULL),
+    sqMask_(NULL),
+    sqArray_(NULL),
+    sqes_(NULL),
+    sqesSize_(0),
+    sqLocalTail_(0),
+    cqRing_(MAP_FAILED),
+    cqRingSize_(0),
+    cqHead_(NULL),
+    cqTail_(NULL),
+    cqMask_(NULL),
+    cqes_(NULL)
+{
+  setup();
+}
+
+void IOUringPollPoller::setup()
+{
+  struct io_uring_params params;
+  memZero(&params, sizeof params);
+  // one-shot polls of all channels may complete in the same round.
+  params.flags = IORING_SETUP_CLAMP | IORING_SETUP_CQSIZE;
+  params.cq_entries = kRingEntries * 16;
+  int fd = ioUringSetup(kRingEntries, &params);
+  if (fd < 0)
+  {
+    LOG_SYSERR << "IOUringPollPoller::setup - io_uring_setup";
+    return;
+  }
+  ringfd_ = fd;
+  if (!(params.features & IORING_FEAT_EXT_ARG))
+  {
+    LOG_ERROR << "IOUringPollPoller::setup - kernel lacks IORING_FEAT_EXT_ARG";
+    return;
+  }
+  ringEntries_ = params.sq_entries;
+
+  sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (singleMmap)
+  {
+    sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+  }
+  sqRing_ = ::mmap(NULL, sqRingSize_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ringfd_, IORING_OFF_SQ_RING);
+  if (sqRing_ == MAP_FAILED)
+  {
+    LOG_SYSERR << "IOUringPollPoller::setup - mmap sq ring";
+    return;
+  }
+  if (singleMmap)
+  {
+    cqRing_ = sqRing_;
+  }
+  else
+  {
+    cqRing_ = ::mmap(NULL, cqRingSize_, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ringfd_, IORING_OFF_CQ_RING);
+    if (cqRing_ == MAP_FAILED)
+    {
+      LOG_SYSERR << "IOUringPollPoller::setup - mmap cq ring";
+      return;
+    }
+  }
+  sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  void* sqes = ::mmap(NULL, sqesSize_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ringfd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED)
+  {
+    LOG_SYSERR << "IOUringPollPoller::setup - mmap sqes";
+    return;
+  }
+  sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+  sqHead_ = ringPointer<unsigned>(sqRing_, params.sq_off.head);
+  sqTail_ = ringPointer<unsigned>(sqRing_, params.sq_off.tail);
+  sqMask_ = ringPointer<unsigned>(sqRing_, params.sq_off.ring_mask);
+  sqArray_ = ringPointer<unsigned>(sqRing_, params.sq_off.array);
+  sqLocalTail_ = *sqTail_;
+
+  cqHead_ = ringPointer<unsigned>(cqRing_, params.cq_off.head);
+  cqTail_ = ringPointer<unsigned>(cqRing_, params.cq_off.tail);
+  cqMask_ = ringPointer<unsigned>(cqRing_, params.cq_off.ring_mask);
+  cqes_ = ringPointer<struct io_uring_cqe>(cqRing_, params.cq_off.cqes);
+}
+
+IOUringPollPoller::~IOUringPollPoller()
+{
+  if (sqes_)
+  {
+    ::munmap(sqes_, sqesSize_);
+  }
+  if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_)
+  {
+    ::munmap(cqRing_, cqRingSize_);
+  }
+  if (sqRing_ != MAP_FAILED)
+  {
+    ::munmap(sqRing_, sqRingSize_);
+  }
+  if (ringfd_ >= 0)
+  {
+    ::close(ringfd_);
+  }
+}
+
+Timestamp IOUringPollPoller::poll(int timeoutMs, ChannelList* activeChannels)
+{
+  LOG_TRACE << "fd total count " << channels_.size();
+  // re-arm one-shot polls fired in last round, after their callbacks ran.
+  for (int fd : firedFds_)
+  {
+    ChannelMap::const_iterator it = channels_.find(fd);
+    if (it != channels_.end())
+    {
+      Channel* channel = it->second;
+      PollEntry& entry = entryOf(fd);
+      if (!entry.armed && !channel->isNoneEvent())
+      {
+        arm(channel, &entry);
+      }
+    }
+  }
+  firedFds_.clear();
+
+  int ret = submitAndWait(timeoutMs);
+  int savedErrno = errno;
+  Timestamp now(Timestamp::now());
+  size_t numEvents = activeChannels->size();
+  fillActiveChannels(activeChannels);
+  numEvents = activeChannels->size() - numEvents;
+  if (numEvents > 0)
+  {
+    LOG_TRACE << numEvents << " events happened";
+  }
+  else if (ret >= 0 || savedErrno == ETIME)
+  {
+    LOG_TRACE << "nothing happened";
+  }
+  else if (savedErrno != EINTR)
+  {
+    errno = savedErrno;
+    LOG_SYSERR << "IOUringPollPoller::poll()";
+  }
+  return now;
+}
+
+int IOUringPollPoller::submitAndWait(int timeoutMs)
+{
+  struct __kernel_timespec ts;
+  struct io_uring_getevents_arg arg;
+  memZero(&arg, sizeof arg);
+  if (timeoutMs >= 0)
+  {
+    ts.tv_sec = timeoutMs / 1000;
+    ts.tv_nsec = static_cast<long long>(timeoutMs % 1000) * 1000 * 1000;
+    arg.ts = reinterpret_cast<uint64_t>(&ts);
+  }
+
+  __atomic_store_n(sqTail_, sqLocalTail_, __ATOMIC_RELEASE);
+  unsigned toSubmit = sqLocalTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+  unsigned minComplete = timeoutMs == 0 ? 0 : 1;
+  int ret = ioUringEnter(ringfd_, toSubmit, minComplete,
+                         IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                         &arg, sizeof arg);
+  if (ret < 0 && errno == EBUSY)
+  {
+    // completion ring overflowed, reap what we have and retry next round.
+    ret = 0;
+  }
+  return ret;
+}
+
+void IOUringPollPoller::fillActiveChannels(ChannelList* activeChannels)
+{
+  unsigned head = *cqHead_;
+  const unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+  for (; head != tail; ++head)
+  {
+    const struct io_uring_cqe& cqe = cqes_[head & *cqMask_];
+    if (cqe.user_data == kRemoveTag)
+    {
+      continue;
+    }
+    int fd = fdOf(cqe.user_data);
+    PollEntry& entry = entryOf(fd);
+    if (!entry.armed || entry.generation != generationOf(cqe.user_data))
+    {
+      // completion of a poll that has been removed or replaced.
+      continue;
+    }
+    entry.armed = false;
+    if (cqe.res < 0)
+    {
+      if (cqe.res != -ECANCELED)
+      {
+        errno = -cqe.res;
+        LOG_SYSERR << "IOUringPollPoller::fillActiveChannels fd = " << fd;
+      }
+      continue;
+    }
+    ChannelMap::const_iterator it = channels_.find(fd);
+    assert(it != channels_.end());
+    Channel* channel = it->second;
+    channel->set_revents(cqe.res);
+    activeChannels->push_back(channel);
+    firedFds_.push_back(fd);
+  }
+  __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+}
+
+void IOUringPollPoller::updateChannel(Channel* channel)
+{
+  Poller::assertInLoopThread();
+  const int index = channel->index();
+  const int fd = channel->fd();
+  LOG_TRACE << "fd = " << fd
+    << " events = " << channel->events() << " index = " << index;
+  if (index == kNew)
+  {
+    assert(channels_.find(fd) == channels_.end());
+    channels_[fd] = channel;
+    channel->set_index(kAdded);
+  }
+  else
+  {
+    assert(channels_.find(fd) != channels_.end());
+    assert(channels_[fd] == channel);
+    assert(index == kAdded);
+  }
+
+  PollEntry& entry = entryOf(fd);
+  if (entry.armed && entry.armedEvents == channel->events())
+  {
+    return;
+  }
+  if (entry.armed)
+  {
+    disarm(fd, &entry);
+  }
+  if (!channel->isNoneEvent())
+  {
+    arm(channel, &entry);
+  }
+}
+
+void IOUringPollPoller::removeChannel(Channel* channel)
+{
+  Poller::assertInLoopThread();
+  int fd = channel->fd();
+  LOG_TRACE << "fd = " << fd;
+  assert(channels_.find(fd) != channels_.end());
+  assert(channels_[fd] == channel);
+  assert(channel->isNoneEvent());
+  assert(channel->index() == kAdded);
+  size_t n = channels_.erase(fd);
+  (void)n;
+  assert(n == 1);
+
+  PollEntry& entry = entryOf(fd);
+  if (entry.armed)
+  {
+    disarm(fd, &entry);
+  }
+  // invalidates in-flight completions of this fd.
+  ++entry.generation;
+  channel->set_index(kNew);
+}
+
+IOUringPollPoller::PollEntry& IOUringPollPoller::entryOf(int fd)
+{
+  assert(fd >= 0);
+  size_t idx = static_cast<size_t>(fd);
+  if (idx >= entries_.size())
+  {
+    entries_.resize(std::max(idx + 1, entries_.size() * 2));
+  }
+  return entries_[idx];
+}
+
+void IOUringPollPoller::arm(Channel* channel, PollEntry* entry)
+{
+  struct io_uring_sqe* sqe = getSqe();
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = channel->fd();
+  sqe->poll32_events = static_cast<uint32_t>(channel->events());
+  sqe->user_data = makeUserData(channel->fd(), entry->generation);
+  entry->armed = true;
+  entry->armedEvents = channel->events();
+}
+
+void IOUringPollPoller::disarm(int fd, PollEntry* entry)
+{
+  struct io_uring_sqe* sqe = getSqe();
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = makeUserData(fd, entry->generation);
+  sqe->user_data = kRemoveTag;
+  entry->armed = false;
+  ++entry->generation;
+}
+
+struct io_uring_sqe* IOUringPollPoller::getSqe()
+{
+  if (sqLocalTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= ringEntries_)
+  {
+    // submission ring is full, flush it without waiting.
+    __atomic_store_n(sqTail_, sqLocalTail_, __ATOMIC_RELEASE);
+    if (ioUringEnter(ringfd_, ringEntries_, 0, 0, NULL, 0) < 0)
+    {
+      LOG_SYSFATAL << "IOUringPollPoller::getSqe - io_uring_enter";
+    }
+  }
+  unsigned idx = sqLocalTail_ & *sqMask_;
+  struct io_uring_sqe* sqe = &sqes_[idx];
+  memZero(sqe, sizeof *sqe);
+  sqArray_[idx] = idx;
+  ++sqLocalTail_;
+  return sqe;
+}
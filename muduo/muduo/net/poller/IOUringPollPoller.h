@@ -0,0 +1,102 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_POLLER_IOURINGPOLLPOLLER_H
+#define MUDUO_NET_POLLER_IOURINGPOLLPOLLER_H
+
+#include "muduo/net/Poller.h"
+
+#include <vector>
+
+#include <stdint.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// IO Multiplexing with io_uring(7) in poll mode, a drop-in for EPollPoller.
+///
+/// Interests are registered as one-shot IORING_OP_POLL_ADD requests,
+/// queued in the submission ring without any syscall, and re-armed after
+/// they fire, which keeps level-triggered semantics of EPollPoller.
+/// All pending submissions are flushed and completions are reaped
+/// by a single io_uring_enter(2) per poll().
+///
+/// This is not completion-based I/O: callbacks still read, write and
+/// accept with plain syscalls, no IORING_OP_READ, WRITE or ACCEPT is
+/// submitted, and every fired event costs one more SQE to re-arm.
+/// Multishot polls would save that, but are edge-triggered.
+/// Expect it to be no faster than epoll, it's there to compare with.
+///
+/// Requires Linux 5.11 or later (IORING_FEAT_EXT_ARG), built only if
+/// <linux/io_uring.h> has it.
+class IOUringPollPoller : public Poller
+{
+ public:
+  IOUringPollPoller(EventLoop* loop);
+  ~IOUringPollPoller() override;
+
+  /// false if the ring couldn't be set up, e.g. on an older kernel
+  /// or where io_uring is disabled, then the poller must not be used.
+  bool valid() const { return cqes_ != NULL; }
+
+  Timestamp poll(int timeoutMs, ChannelList* activeChannels) override;
+  void updateChannel(Channel* channel) override;
+  void removeChannel(Channel* channel) override;
+
+ private:
+  static const unsigned kRingEntries = 1024;
+
+  struct PollEntry
+  {
+    uint32_t generation = 0;
+    int armedEvents = 0;
+    bool armed = false;
+  };
+
+  void setup();
+  PollEntry& entryOf(int fd);
+  void arm(Channel* channel, PollEntry* entry);
+  void disarm(int fd, PollEntry* entry);
+  io_uring_sqe* getSqe();
+  int submitAndWait(int timeoutMs);
+  void fillActiveChannels(ChannelList* activeChannels);
+
+  int ringfd_;
+  unsigned ringEntries_;
+
+  // mmap'ed submission queue
+  void* sqRing_;
+  size_t sqRingSize_;
+  unsigned* sqHead_;
+  unsigned* sqTail_;
+  unsigned* sqMask_;
+  unsigned* sqArray_;
+  io_uring_sqe* sqes_;
+  size_t sqesSize_;
+  unsigned sqLocalTail_;
+
+  // mmap'ed completion queue, may share mapping with sqRing_
+  void* cqRing_;
+  size_t cqRingSize_;
+  unsigned* cqHead_;
+  unsigned* cqTail_;
+  unsigned* cqMask_;
+  io_uring_cqe* cqes_;
+
+  std::vector<PollEntry> entries_;  // indexed by fd
+  std::vector<int> firedFds_;  // to be re-armed in next poll()
+};
+
+}  // namespace net
+}  // namespace muduo
+#endif  // MUDUO_NET_POLLER_IOURINGPOLLPOLLER_H
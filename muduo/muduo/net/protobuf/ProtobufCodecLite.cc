@@ -10,7 +10,9 @@
 // #include <muduo/net/protobuf/BufferStream.h>
 
 #include "muduo/base/Logging.h"
+#include "muduo/base/ThreadLocalSingleton.h"
 #include "muduo/net/Endian.h"
+#include "muduo/net/EventLoop.h"
 #include "muduo/net/TcpConnection.h"
 #include "muduo/net/protorpc/google-inl.h"
 
@@ -28,15 +30,45 @@ namespace
     return 0;
   }
   int __attribute__ ((unused)) dummy = ProtobufVersionCheck();
+
+  // of the last message sent in the loop thread of its connection,
+  // it's usually written to the socket right away, and reused for next one.
+  struct SendBuffer
+  {
+    static const size_t kMaxCapacity = 64*1024;
+    Buffer buffer;
+  };
+
+  // messages of last frames parsed in this thread, by prototype.
+  struct MessageCache
+  {
+    std::vector<std::pair<const google::protobuf::Message*, MessagePtr>> messages;
+  };
 }
 
 void ProtobufCodecLite::send(const TcpConnectionPtr& conn,
                              const ::google::protobuf::Message& message)
 {
   // FIXME: serialize to TcpConnection::outputBuffer()
-  muduo::net::Buffer buf;
-  fillEmptyBuffer(&buf, message);
-  conn->send(&buf);
+  if (conn->getLoop()->isInLoopThread())
+  {
+    Buffer& buf = ThreadLocalSingleton<SendBuffer>::instance().buffer;
+    buf.retrieveAll();
+    fillEmptyBuffer(&buf, message);
+    conn->send(&buf);
+    // don't hold a large message forever
+    if (buf.internalCapacity() > SendBuffer::kMaxCapacity)
+    {
+      buf.shrink(0);
+    }
+  }
+  else
+  {
+    // handed over to the loop of conn, nothing to reuse
+    Buffer buf;
+    fillEmptyBuffer(&buf, message);
+    conn->send(std::move(buf));
+  }
 }
 
 void ProtobufCodecLite::fillEmptyBuffer(muduo::net::Buffer* buf,
@@ -74,7 +106,7 @@ void ProtobufCodecLite::onMessage(const TcpConnectionPtr& conn,
         buf->retrieve(kHeaderLen+len);
         continue;
       }
-      MessagePtr message(prototype_->New());
+      MessagePtr message(newMessage());
       // FIXME: can we move deserialization & callback to other thread?
       ErrorCode errorCode = parse(buf->peek()+kHeaderLen, len, message.get());
       if (errorCode == kNoError)
@@ -96,6 +128,31 @@ void ProtobufCodecLite::onMessage(const TcpConnectionPtr& conn,
   }
 }
 
+MessagePtr ProtobufCodecLite::newMessage()
+{
+  if (!reuseMessage_)
+  {
+    return MessagePtr(prototype_->New());
+  }
+
+  auto& messages = ThreadLocalSingleton<MessageCache>::instance().messages;
+  for (auto& item : messages)
+  {
+    if (item.first == prototype_)
+    {
+      // the callback kept the last one
+      if (item.second.use_count() > 1)
+      {
+        item.second.reset(prototype_->New());
+      }
+      // parseFromBuffer() should clear it, as ParseFromArray() does
+      return item.second;
+    }
+  }
+  messages.push_back(std::make_pair(prototype_, MessagePtr(prototype_->New())));
+  return messages.back().second;
+}
+
 bool ProtobufCodecLite::parseFromBuffer(StringPiece buf, google::protobuf::Message* message)
 {
   return message->ParseFromArray(buf.data(), buf.size());
@@ -88,7 +88,8 @@ class ProtobufCodecLite : noncopyable
       messageCallback_(messageCb),
       rawCb_(rawCb),
       errorCallback_(errorCb),
-      kMinMessageLen(tagArg.size() + kChecksumLen)
+      kMinMessageLen(tagArg.size() + kChecksumLen),
+      reuseMessage_(false)
   {
   }
 
@@ -96,6 +97,12 @@ class ProtobufCodecLite : noncopyable
 
   const string& tag() const { return tag_; }
 
+  // Off by default. If on, a message is parsed into the one of last frame
+  // in this thread, if the callback didn't keep a MessagePtr to it,
+  // so that memory of its strings and repeated fields is reused.
+  // The callback must not keep pointers into a message it doesn't own.
+  void setReuseMessage(bool on) { reuseMessage_ = on; }
+
   void send(const TcpConnectionPtr& conn,
             const ::google::protobuf::Message& message);
 
@@ -109,6 +116,7 @@ class ProtobufCodecLite : noncopyable
   static const string& errorCodeToString(ErrorCode errorCode);
 
   // public for unit tests
+  MessagePtr newMessage();
   ErrorCode parse(const char* buf, int len, ::google::protobuf::Message* message);
   void fillEmptyBuffer(muduo::net::Buffer* buf, const google::protobuf::Message& message);
 
@@ -127,6 +135,7 @@ class ProtobufCodecLite : noncopyable
   RawMessageCallback rawCb_;
   ErrorCallback errorCallback_;
   const int kMinMessageLen;
+  bool reuseMessage_;
 };
 
 template<typename MSG, const char* TAG, typename CODEC=ProtobufCodecLite>  // TAG must be a variable with external linkage, not a string literal
@@ -155,6 +164,8 @@ class ProtobufCodecLiteT
 
   const string& tag() const { return codec_.tag(); }
 
+  void setReuseMessage(bool on) { codec_.setReuseMessage(on); }
+
   void send(const TcpConnectionPtr& conn,
             const MSG& message)
   {
@@ -8,24 +8,215 @@
 
 #include "muduo/net/protorpc/RpcChannel.h"
 
+#include "muduo/base/Atomic.h"
 #include "muduo/base/Logging.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/TcpConnection.h"
+#include "muduo/net/protorpc/RpcController.h"
 #include "muduo/net/protorpc/rpc.pb.h"
 
+#include <google/protobuf/arena.h>
 #include <google/protobuf/descriptor.h>
 
 using namespace muduo;
 using namespace muduo::net;
 
+namespace
+{
+
+const size_t kMaxFreeCalls = 64;
+const size_t kArenaBlockSize = 1024;
+
+::google::protobuf::ArenaOptions arenaOptions(char* block, size_t size)
+{
+  ::google::protobuf::ArenaOptions options;
+  options.initial_block = block;
+  options.initial_block_size = size;
+  return options;
+}
+
+}  // namespace
+
+///
+/// Outstanding calls keyed by id, in shards of slot arrays.
+///
+/// Shard and slot index are encoded in the id, so lookup doesn't hash,
+/// and slots are reused without allocation. Consecutive calls go to
+/// different shards, callers in different threads rarely contend.
+///
+class RpcChannel::CallTable : noncopyable
+{
+ public:
+  struct Call
+  {
+    ::google::protobuf::Message* response;
+    ::google::protobuf::Closure* done;
+    RpcController* controller;
+    TimerId timer;
+    bool hasTimer;
+  };
+
+  int64_t add(const Call& call)
+  {
+    int64_t seq = sequence_.incrementAndGet();
+    Shard& shard = shards_[seq & (kShards-1)];
+    MutexLockGuard lock(shard.mutex);
+    uint32_t index;
+    if (!shard.freeSlots.empty())
+    {
+      index = shard.freeSlots.back();
+      shard.freeSlots.pop_back();
+    }
+    else
+    {
+      if (shard.slots.size() > kIndexMask)
+      {
+        LOG_FATAL << "RpcChannel - too many outstanding calls";
+      }
+      index = static_cast<uint32_t>(shard.slots.size());
+      shard.slots.push_back(Slot());
+    }
+    int64_t id = (seq << kIndexBits) | index;
+    shard.slots[index].id = id;
+    shard.slots[index].call = call;
+    return id;
+  }
+
+  bool remove(int64_t id, Call* call)
+  {
+    Shard& shard = shardOf(id);
+    uint32_t index = static_cast<uint32_t>(id & kIndexMask);
+    MutexLockGuard lock(shard.mutex);
+    if (index < shard.slots.size() && shard.slots[index].id == id)
+    {
+      *call = shard.slots[index].call;
+      shard.slots[index].id = 0;
+      shard.freeSlots.push_back(index);
+      return true;
+    }
+    return false;
+  }
+
+  // returns false if the call is gone
+  bool setTimer(int64_t id, TimerId timer)
+  {
+    Shard& shard = shardOf(id);
+    uint32_t index = static_cast<uint32_t>(id & kIndexMask);
+    MutexLockGuard lock(shard.mutex);
+    if (index < shard.slots.size() && shard.slots[index].id == id)
+    {
+      shard.slots[index].call.timer = timer;
+      shard.slots[index].call.hasTimer = true;
+      return true;
+    }
+    return false;
+  }
+
+  void takeAll(std::vector<Call>* calls)
+  {
+    for (Shard& shard : shards_)
+    {
+      MutexLockGuard lock(shard.mutex);
+      for (Slot& slot : shard.slots)
+      {
+        if (slot.id != 0)
+        {
+          calls->push_back(slot.call);
+        }
+      }
+      shard.slots.clear();
+      shard.freeSlots.clear();
+    }
+  }
+
+ private:
+  static const int kShards = 16;
+  static const int kIndexBits = 20;
+  static const int64_t kIndexMask = (1 << kIndexBits) - 1;
+
+  struct Slot
+  {
+    Slot() : id(0) { }
+    int64_t id;  // 0 if free
+    Call call;
+  };
+
+  struct Shard
+  {
+    MutexLock mutex;
+    std::vector<Slot> slots GUARDED_BY(mutex);
+    std::vector<uint32_t> freeSlots GUARDED_BY(mutex);
+  };
+
+  Shard& shardOf(int64_t id)
+  {
+    return shards_[(id >> kIndexBits) & (kShards-1)];
+  }
+
+  AtomicInt64 sequence_;
+  Shard shards_[kShards];
+};
+
+/// A request being served, with an arena for request and response,
+/// pooled by the channel.
+struct RpcChannel::ServerCall : public ::google::protobuf::Closure
+{
+  explicit ServerCall(RpcChannel* ch)
+    : channel(ch),
+      arena(arenaOptions(block, sizeof block)),
+      id(0),
+      response(NULL)
+  {
+  }
+
+  void Run() override
+  {
+    channel->doneCallback(this);
+  }
+
+  RpcChannel* channel;
+  char block[kArenaBlockSize];
+  ::google::protobuf::Arena arena;
+  int64_t id;
+  ::google::protobuf::Message* response;
+};
+
+/// Messages waiting to be written in loop thread.
+struct RpcChannel::Batch
+{
+  Batch()
+    : flushQueued(false)
+  {
+  }
+
+  MutexLock mutex;
+  Buffer output GUARDED_BY(mutex);
+  Buffer scratch GUARDED_BY(mutex);
+  bool flushQueued GUARDED_BY(mutex);
+  // loop thread only
+  Buffer sending;
+};
+
 RpcChannel::RpcChannel()
-  : codec_(std::bind(&RpcChannel::onRpcMessage, this, _1, _2, _3)),
+  : codec_(std::bind(&RpcChannel::onRpcMessage, this, _1, _2, _3),
+           std::bind(&RpcChannel::onRawMessage, this, _1, _2, _3)),
+    defaultTimeout_(0),
+    outstandings_(new CallTable),
+    batch_(new Batch),
+    message_(new RpcMessage),
     services_(NULL)
 {
   LOG_INFO << "RpcChannel::ctor - " << this;
 }
 
 RpcChannel::RpcChannel(const TcpConnectionPtr& conn)
-  : codec_(std::bind(&RpcChannel::onRpcMessage, this, _1, _2, _3)),
+  : codec_(std::bind(&RpcChannel::onRpcMessage, this, _1, _2, _3),
+           std::bind(&RpcChannel::onRawMessage, this, _1, _2, _3)),
     conn_(conn),
+    defaultTimeout_(0),
+    outstandings_(new CallTable),
+    batch_(new Batch),
+    message_(new RpcMessage),
     services_(NULL)
 {
   LOG_INFO << "RpcChannel::ctor - " << this;
@@ -34,11 +225,17 @@ RpcChannel::RpcChannel(const TcpConnectionPtr& conn)
 RpcChannel::~RpcChannel()
 {
   LOG_INFO << "RpcChannel::dtor - " << this;
-  for (const auto& outstanding : outstandings_)
+  std::vector<CallTable::Call> calls;
+  outstandings_->takeAll(&calls);
+  for (const CallTable::Call& call : calls)
+  {
+    delete call.response;
+    delete call.done;
+  }
+  MutexLockGuard lock(mutex_);
+  for (ServerCall* call : freeCalls_)
   {
-    OutstandingCall out = outstanding.second;
-    delete out.response;
-    delete out.done;
+    delete call;
   }
 }
 
@@ -53,20 +250,36 @@ void RpcChannel::CallMethod(const ::google::protobuf::MethodDescriptor* method,
                             ::google::protobuf::Message* response,
                             ::google::protobuf::Closure* done)
 {
-  RpcMessage message;
-  message.set_type(REQUEST);
-  int64_t id = id_.incrementAndGet();
-  message.set_id(id);
-  message.set_service(method->service()->full_name());
-  message.set_method(method->name());
-  message.set_request(request->SerializeAsString()); // FIXME: error check
+  RpcController* rpcController = dynamic_cast<RpcController*>(controller);
+  CallTable::Call call = { response, done, rpcController, TimerId(), false };
+  int64_t id = outstandings_->add(call);
+
+  char block[kArenaBlockSize];
+  ::google::protobuf::Arena arena(arenaOptions(block, sizeof block));
+  RpcMessage* message = ::google::protobuf::Arena::CreateMessage<RpcMessage>(&arena);
+  message->set_type(REQUEST);
+  message->set_id(id);
+  message->set_service(method->service()->full_name());
+  message->set_method(method->name());
+  request->SerializeToString(message->mutable_request()); // FIXME: error check
+  send(*message);
 
-  OutstandingCall out = { response, done };
+  double timeout = defaultTimeout_;
+  if (rpcController && rpcController->timeout() > 0)
   {
-  MutexLockGuard lock(mutex_);
-  outstandings_[id] = out;
+    timeout = rpcController->timeout();
+  }
+  if (timeout > 0)
+  {
+    EventLoop* loop = conn_->getLoop();
+    TimerId timer = loop->runAfter(
+        timeout,
+        std::bind(&RpcChannel::onTimeout, std::weak_ptr<CallTable>(outstandings_), id));
+    if (!outstandings_->setTimer(id, timer))
+    {
+      loop->cancel(timer);
+    }
   }
-  codec_.send(conn_, message);
 }
 
 void RpcChannel::onMessage(const TcpConnectionPtr& conn,
@@ -76,109 +289,217 @@ void RpcChannel::onMessage(const TcpConnectionPtr& conn,
   codec_.onMessage(conn, buf, receiveTime);
 }
 
+bool RpcChannel::onRawMessage(const TcpConnectionPtr& conn,
+                              StringPiece raw,
+                              Timestamp receiveTime)
+{
+  // parses into message_ instead of a new RpcMessage,
+  // leaves malformed ones to codec, which reports the error.
+  const char* data = raw.data() + ProtobufCodecLite::kHeaderLen;
+  int len = raw.size() - ProtobufCodecLite::kHeaderLen;
+  int tagLen = static_cast<int>(strlen(rpctag));
+  if (ProtobufCodecLite::validateChecksum(data, len) &&
+      memcmp(data, rpctag, tagLen) == 0 &&
+      message_->ParseFromArray(data + tagLen, len - tagLen - ProtobufCodecLite::kChecksumLen))
+  {
+    handleMessage(conn, *message_);
+    return false;
+  }
+  return true;
+}
+
 void RpcChannel::onRpcMessage(const TcpConnectionPtr& conn,
                               const RpcMessagePtr& messagePtr,
                               Timestamp receiveTime)
+{
+  handleMessage(conn, *messagePtr);
+}
+
+void RpcChannel::handleMessage(const TcpConnectionPtr& conn, const RpcMessage& message)
 {
   assert(conn == conn_);
   //printf("%s\n", message.DebugString().c_str());
-  RpcMessage& message = *messagePtr;
   if (message.type() == RESPONSE)
   {
-    int64_t id = message.id();
-    assert(message.has_response() || message.has_error());
-
-    OutstandingCall out = { NULL, NULL };
+    handleResponse(message);
+  }
+  else if (message.type() == REQUEST)
+  {
+    handleRequest(message);
+  }
+  else if (message.type() == ERROR)
+  {
+  }
+}
 
+void RpcChannel::handleResponse(const RpcMessage& message)
+{
+  assert(message.has_response() || message.has_error());
+  CallTable::Call call;
+  if (outstandings_->remove(message.id(), &call))
+  {
+    if (call.hasTimer)
     {
-      MutexLockGuard lock(mutex_);
-      std::map<int64_t, OutstandingCall>::iterator it = outstandings_.find(id);
-      if (it != outstandings_.end())
-      {
-        out = it->second;
-        outstandings_.erase(it);
-      }
+      conn_->getLoop()->cancel(call.timer);
     }
-
-    if (out.response)
+    std::unique_ptr<google::protobuf::Message> d(call.response);
+    if (message.has_response())
     {
-      std::unique_ptr<google::protobuf::Message> d(out.response);
-      if (message.has_response())
-      {
-        out.response->ParseFromString(message.response());
-      }
-      if (out.done)
+      if (!call.response->ParseFromString(message.response()) && call.controller)
       {
-        out.done->Run();
+        call.controller->SetFailed(ErrorCode_Name(INVALID_RESPONSE));
       }
     }
+    else if (call.controller)
+    {
+      call.controller->SetFailed(ErrorCode_Name(message.error()));
+    }
+    if (call.done)
+    {
+      call.done->Run();
+    }
   }
-  else if (message.type() == REQUEST)
+}
+
+void RpcChannel::handleRequest(const RpcMessage& message)
+{
+  // FIXME: extract to a function
+  ErrorCode error = WRONG_PROTO;
+  if (services_)
   {
-    // FIXME: extract to a function
-    ErrorCode error = WRONG_PROTO;
-    if (services_)
+    std::map<std::string, google::protobuf::Service*>::const_iterator it = services_->find(message.service());
+    if (it != services_->end())
     {
-      std::map<std::string, google::protobuf::Service*>::const_iterator it = services_->find(message.service());
-      if (it != services_->end())
+      google::protobuf::Service* service = it->second;
+      assert(service != NULL);
+      const google::protobuf::ServiceDescriptor* desc = service->GetDescriptor();
+      const google::protobuf::MethodDescriptor* method
+        = desc->FindMethodByName(message.method());
+      if (method)
       {
-        google::protobuf::Service* service = it->second;
-        assert(service != NULL);
-        const google::protobuf::ServiceDescriptor* desc = service->GetDescriptor();
-        const google::protobuf::MethodDescriptor* method
-          = desc->FindMethodByName(message.method());
-        if (method)
+        // request and response live in call's arena, till doneCallback
+        ServerCall* call = acquireCall();
+        google::protobuf::Message* request = service->GetRequestPrototype(method).New(&call->arena);
+        if (request->ParseFromString(message.request()))
         {
-          std::unique_ptr<google::protobuf::Message> request(service->GetRequestPrototype(method).New());
-          if (request->ParseFromString(message.request()))
-          {
-            google::protobuf::Message* response = service->GetResponsePrototype(method).New();
-            // response is deleted in doneCallback
-            int64_t id = message.id();
-            service->CallMethod(method, NULL, get_pointer(request), response,
-                                NewCallback(this, &RpcChannel::doneCallback, response, id));
-            error = NO_ERROR;
-          }
-          else
-          {
-            error = INVALID_REQUEST;
-          }
+          call->id = message.id();
+          call->response = service->GetResponsePrototype(method).New(&call->arena);
+          service->CallMethod(method, NULL, request, call->response, call);
+          error = NO_ERROR;
         }
         else
         {
-          error = NO_METHOD;
+          releaseCall(call);
+          error = INVALID_REQUEST;
         }
       }
       else
       {
-        error = NO_SERVICE;
+        error = NO_METHOD;
       }
     }
     else
     {
       error = NO_SERVICE;
     }
-    if (error != NO_ERROR)
-    {
-      RpcMessage response;
-      response.set_type(RESPONSE);
-      response.set_id(message.id());
-      response.set_error(error);
-      codec_.send(conn_, response);
-    }
   }
-  else if (message.type() == ERROR)
+  else
+  {
+    error = NO_SERVICE;
+  }
+  if (error != NO_ERROR)
   {
+    RpcMessage response;
+    response.set_type(RESPONSE);
+    response.set_id(message.id());
+    response.set_error(error);
+    send(response);
   }
 }
 
-void RpcChannel::doneCallback(::google::protobuf::Message* response, int64_t id)
+void RpcChannel::doneCallback(ServerCall* call)
 {
-  std::unique_ptr<google::protobuf::Message> d(response);
-  RpcMessage message;
-  message.set_type(RESPONSE);
-  message.set_id(id);
-  message.set_response(response->SerializeAsString()); // FIXME: error check
-  codec_.send(conn_, message);
+  RpcMessage* message = ::google::protobuf::Arena::CreateMessage<RpcMessage>(&call->arena);
+  message->set_type(RESPONSE);
+  message->set_id(call->id);
+  call->response->SerializeToString(message->mutable_response()); // FIXME: error check
+  send(*message);
+  releaseCall(call);
 }
 
+RpcChannel::ServerCall* RpcChannel::acquireCall()
+{
+  {
+  MutexLockGuard lock(mutex_);
+  if (!freeCalls_.empty())
+  {
+    ServerCall* call = freeCalls_.back();
+    freeCalls_.pop_back();
+    return call;
+  }
+  }
+  return new ServerCall(this);
+}
+
+void RpcChannel::releaseCall(ServerCall* call)
+{
+  call->arena.Reset();
+  call->response = NULL;
+  MutexLockGuard lock(mutex_);
+  if (freeCalls_.size() < kMaxFreeCalls)
+  {
+    freeCalls_.push_back(call);
+  }
+  else
+  {
+    delete call;
+  }
+}
+
+void RpcChannel::send(const RpcMessage& message)
+{
+  bool queue = false;
+  {
+  MutexLockGuard lock(batch_->mutex);
+  codec_.fillEmptyBuffer(&batch_->scratch, message);
+  batch_->output.append(batch_->scratch.peek(), batch_->scratch.readableBytes());
+  batch_->scratch.retrieveAll();
+  queue = !batch_->flushQueued;
+  batch_->flushQueued = true;
+  }
+  // written after the current event is handled,
+  // along with other messages sent before that.
+  if (queue)
+  {
+    conn_->getLoop()->queueInLoop(std::bind(&RpcChannel::flush, batch_, conn_));
+  }
+}
+
+void RpcChannel::flush(const std::shared_ptr<Batch>& batch, const TcpConnectionPtr& conn)
+{
+  {
+  MutexLockGuard lock(batch->mutex);
+  batch->sending.swap(batch->output);
+  batch->flushQueued = false;
+  }
+  conn->send(&batch->sending);
+  batch->sending.retrieveAll();
+}
+
+void RpcChannel::onTimeout(const std::weak_ptr<CallTable>& table, int64_t id)
+{
+  std::shared_ptr<CallTable> outstandings(table.lock());
+  CallTable::Call call;
+  if (outstandings && outstandings->remove(id, &call))
+  {
+    std::unique_ptr<google::protobuf::Message> d(call.response);
+    if (call.controller)
+    {
+      call.controller->SetFailed(ErrorCode_Name(TIMEOUT));
+    }
+    if (call.done)
+    {
+      call.done->Run();
+    }
+  }
+}
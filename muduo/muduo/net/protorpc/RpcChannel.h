@@ -11,13 +11,13 @@
 #ifndef MUDUO_NET_PROTORPC_RPCCHANNEL_H
 #define MUDUO_NET_PROTORPC_RPCCHANNEL_H
 
-#include "muduo/base/Atomic.h"
 #include "muduo/base/Mutex.h"
 #include "muduo/net/protorpc/RpcCodec.h"
 
 #include <google/protobuf/service.h>
 
 #include <map>
+#include <vector>
 
 // Service and RpcChannel classes are incorporated from
 // google/protobuf/service.h
@@ -88,6 +88,11 @@ namespace net
 //   RpcChannel* channel = new MyRpcChannel("remotehost.example.com:1234");
 //   MyService* service = new MyService::Stub(channel);
 //   service->MyMethod(request, &response, callback);
+//
+// Outstanding calls are kept in a sharded table, messages sent in one
+// event loop iteration are written together, and a call fails with
+// "timeout" if the response doesn't arrive before its deadline.
+// Pass a muduo::net::RpcController to set deadline and check result.
 class RpcChannel : public ::google::protobuf::RpcChannel
 {
  public:
@@ -107,6 +112,13 @@ class RpcChannel : public ::google::protobuf::RpcChannel
     services_ = services;
   }
 
+  /// In seconds, for calls without RpcController::setTimeout(), 0 for none.
+  /// Not thread safe, set it before calling any method.
+  void setDefaultTimeout(double seconds)
+  {
+    defaultTimeout_ = seconds;
+  }
+
   // Call the given method of the remote service.  The signature of this
   // procedure looks the same as Service::CallMethod(), but the requirements
   // are less strict in one important way:  the request and response objects
@@ -123,24 +135,39 @@ class RpcChannel : public ::google::protobuf::RpcChannel
                  Timestamp receiveTime);
 
  private:
+  class CallTable;
+  struct ServerCall;
+  struct Batch;
+
+  bool onRawMessage(const TcpConnectionPtr& conn,
+                    StringPiece raw,
+                    Timestamp receiveTime);
   void onRpcMessage(const TcpConnectionPtr& conn,
                     const RpcMessagePtr& messagePtr,
                     Timestamp receiveTime);
+  void handleMessage(const TcpConnectionPtr& conn, const RpcMessage& message);
+  void handleResponse(const RpcMessage& message);
+  void handleRequest(const RpcMessage& message);
 
-  void doneCallback(::google::protobuf::Message* response, int64_t id);
+  void doneCallback(ServerCall* call);
+  ServerCall* acquireCall();
+  void releaseCall(ServerCall* call);
 
-  struct OutstandingCall
-  {
-    ::google::protobuf::Message* response;
-    ::google::protobuf::Closure* done;
-  };
+  void send(const RpcMessage& message);
+  static void flush(const std::shared_ptr<Batch>& batch, const TcpConnectionPtr& conn);
+  static void onTimeout(const std::weak_ptr<CallTable>& table, int64_t id);
 
   RpcCodec codec_;
   TcpConnectionPtr conn_;
-  AtomicInt64 id_;
+  double defaultTimeout_;
+  // shared with timers, which may outlive the channel
+  std::shared_ptr<CallTable> outstandings_;
+  std::shared_ptr<Batch> batch_;
+  // reused for every incoming message, in loop thread
+  std::unique_ptr<RpcMessage> message_;
 
   MutexLock mutex_;
-  std::map<int64_t, OutstandingCall> outstandings_ GUARDED_BY(mutex_);
+  std::vector<ServerCall*> freeCalls_ GUARDED_BY(mutex_);
 
   const std::map<std::string, ::google::protobuf::Service*>* services_;
 };
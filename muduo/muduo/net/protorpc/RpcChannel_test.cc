@@ -0,0 +1,263 @@
+#undef NDEBUG
+#include "muduo/net/protorpc/RpcChannel.h"
+#include "muduo/net/protorpc/RpcController.h"
+#include "muduo/net/protorpc/rpc.pb.h"
+#include "muduo/net/protorpc/rpcservice.pb.h"
+
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/Mutex.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThread.h"
+#include "muduo/net/InetAddress.h"
+#include "muduo/net/TcpConnection.h"
+
+#include <set>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// call id is sequence and slot index, shard is the low bits of sequence,
+// as RpcChannel.cc
+const int kIndexBits = 20;
+const int kShards = 16;
+const int kCalls = 100;
+
+MutexLock g_mutex;
+std::vector<RpcMessage> g_requests GUARDED_BY(g_mutex);
+int g_completed GUARDED_BY(g_mutex) = 0;
+
+// the server side, records requests and answers them by hand
+void onRequest(const TcpConnectionPtr&, const RpcMessagePtr& message, Timestamp)
+{
+  assert(message->type() == REQUEST);
+  MutexLockGuard lock(g_mutex);
+  g_requests.push_back(*message);
+}
+
+int requests()
+{
+  MutexLockGuard lock(g_mutex);
+  return static_cast<int>(g_requests.size());
+}
+
+int completed()
+{
+  MutexLockGuard lock(g_mutex);
+  return g_completed;
+}
+
+void waitFor(int (*count)(), int n)
+{
+  for (int i = 0; i < 1000 && count() < n; ++i)
+  {
+    usleep(1000);
+  }
+  assert(count() == n);
+}
+
+bool sameSlot(int64_t id1, int64_t id2)
+{
+  int64_t indexMask = (1 << kIndexBits) - 1;
+  return (id1 & indexMask) == (id2 & indexMask) &&
+         ((id1 >> kIndexBits) & (kShards-1)) == ((id2 >> kIndexBits) & (kShards-1));
+}
+
+void respond(RpcCodec* codec, const TcpConnectionPtr& conn,
+             int64_t id, const string& serviceName)
+{
+  ListRpcResponse response;
+  response.set_error(NO_ERROR);
+  response.add_service_name(serviceName);
+  RpcMessage message;
+  message.set_type(RESPONSE);
+  message.set_id(id);
+  response.SerializeToString(message.mutable_response());
+  codec->send(conn, message);
+}
+
+struct Call : public ::google::protobuf::Closure
+{
+  Call()
+    : response(new ListRpcResponse),
+      runs(0)
+  {
+  }
+
+  // in loop thread, the channel deletes response after this
+  void Run() override
+  {
+    if (response->service_name_size() > 0)
+    {
+      result = response->service_name(0);
+    }
+    MutexLockGuard lock(g_mutex);
+    ++runs;
+    ++g_completed;
+  }
+
+  ListRpcResponse* response;
+  RpcController controller;
+  string result;
+  int runs;
+};
+
+void call(RpcService_Stub* stub, Call* c, const string& serviceName)
+{
+  ListRpcRequest request;
+  request.set_service_name(serviceName);
+  stub->listRpc(&c->controller, &request, c->response, c);
+}
+
+struct Closure : public ::google::protobuf::Closure
+{
+  Closure() : runs(0) { }
+  void Run() override { ++runs; }
+  int runs;
+};
+
+void testCancel()
+{
+  RpcController controller;
+  Closure callback;
+  controller.NotifyOnCancel(&callback);
+  assert(!controller.IsCanceled());
+  assert(callback.runs == 0);
+  controller.StartCancel();
+  assert(controller.IsCanceled());
+  assert(callback.runs == 1);
+  controller.StartCancel();
+  assert(callback.runs == 1);
+
+  Closure late;
+  controller.NotifyOnCancel(&late);
+  assert(late.runs == 1);
+
+  controller.Reset();
+  assert(!controller.IsCanceled());
+}
+
+int main()
+{
+  testCancel();
+
+  EventLoopThread loopThread;
+  EventLoop* loop = loopThread.startLoop();
+
+  int fds[2];
+  int ret = ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds);
+  assert(ret == 0); (void) ret;
+  InetAddress addr;
+  TcpConnectionPtr clientConn(new TcpConnection(loop, "client", fds[0], addr, addr));
+  TcpConnectionPtr serverConn(new TcpConnection(loop, "server", fds[1], addr, addr));
+  clientConn->setConnectionCallback(defaultConnectionCallback);
+  serverConn->setConnectionCallback(defaultConnectionCallback);
+  RpcCodec codec(onRequest);
+  serverConn->setMessageCallback(
+      std::bind(&RpcCodec::onMessage, &codec, _1, _2, _3));
+
+  {
+  RpcChannel channel(clientConn);
+  clientConn->setMessageCallback(
+      std::bind(&RpcChannel::onMessage, &channel, _1, _2, _3));
+  loop->runInLoop(std::bind(&TcpConnection::connectEstablished, clientConn));
+  loop->runInLoop(std::bind(&TcpConnection::connectEstablished, serverConn));
+  RpcService_Stub stub(&channel);
+  std::set<int64_t> ids;
+
+  // calls spread over shards, answered in reverse order
+  std::vector<Call> calls(kCalls);
+  for (int i = 0; i < kCalls; ++i)
+  {
+    call(&stub, &calls[i], std::to_string(i));
+  }
+  waitFor(requests, kCalls);
+  {
+  MutexLockGuard lock(g_mutex);
+  for (int i = kCalls-1; i >= 0; --i)
+  {
+    const RpcMessage& request = g_requests[i];
+    ListRpcRequest args;
+    assert(args.ParseFromString(request.request()));
+    assert(ids.insert(request.id()).second);
+    respond(&codec, serverConn, request.id(), args.service_name());
+  }
+  }
+  waitFor(completed, kCalls);
+  for (int i = 0; i < kCalls; ++i)
+  {
+    assert(calls[i].runs == 1);
+    assert(!calls[i].controller.Failed());
+    assert(calls[i].result == std::to_string(i));
+  }
+
+  // deadline expires without a response
+  Call expired;
+  expired.controller.setTimeout(0.05);
+  call(&stub, &expired, "expired");
+  waitFor(requests, kCalls+1);
+  waitFor(completed, kCalls+1);
+  assert(expired.runs == 1);
+  assert(expired.controller.Failed());
+  assert(expired.controller.ErrorText() == ErrorCode_Name(TIMEOUT));
+  int64_t expiredId = 0;
+  {
+  MutexLockGuard lock(g_mutex);
+  expiredId = g_requests.back().id();
+  assert(ids.insert(expiredId).second);
+  }
+
+  // one call per shard, one of them reuses the slot of the expired call,
+  // the late response to the expired call must not complete it.
+  std::vector<Call> reusing(kShards);
+  for (int i = 0; i < kShards; ++i)
+  {
+    call(&stub, &reusing[i], "reusing" + std::to_string(i));
+  }
+  waitFor(requests, kCalls+1+kShards);
+  int reused = -1;
+  {
+  MutexLockGuard lock(g_mutex);
+  for (int i = 0; i < kShards; ++i)
+  {
+    int64_t id = g_requests[kCalls+1+i].id();
+    assert(ids.insert(id).second);
+    if (sameSlot(id, expiredId))
+    {
+      reused = i;
+    }
+  }
+  }
+  assert(reused >= 0);
+  respond(&codec, serverConn, expiredId, "late");
+  usleep(50*1000);
+  assert(completed() == kCalls+1);
+  assert(expired.runs == 1);
+  assert(reusing[reused].runs == 0);
+
+  {
+  MutexLockGuard lock(g_mutex);
+  for (int i = 0; i < kShards; ++i)
+  {
+    respond(&codec, serverConn, g_requests[kCalls+1+i].id(), "reusing" + std::to_string(i));
+  }
+  }
+  waitFor(completed, kCalls+1+kShards);
+  for (int i = 0; i < kShards; ++i)
+  {
+    assert(reusing[i].runs == 1);
+    assert(!reusing[i].controller.Failed());
+    assert(reusing[i].result == "reusing" + std::to_string(i));
+  }
+
+  CountDownLatch latch(1);
+  loop->runInLoop(std::bind(&TcpConnection::connectDestroyed, clientConn));
+  loop->runInLoop(std::bind(&TcpConnection::connectDestroyed, serverConn));
+  loop->runInLoop(std::bind(&CountDownLatch::countDown, &latch));
+  latch.wait();
+  }
+  printf("PASS\n");
+  google::protobuf::ShutdownProtobufLibrary();
+}
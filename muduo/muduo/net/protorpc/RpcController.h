@@ -0,0 +1,103 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_PROTORPC_RPCCONTROLLER_H
+#define MUDUO_NET_PROTORPC_RPCCONTROLLER_H
+
+#include "muduo/base/Types.h"
+
+#include <google/protobuf/service.h>
+
+namespace muduo
+{
+namespace net
+{
+
+/// Per-call options and result of RpcChannel::CallMethod().
+/// Check Failed() in the done callback, the response is empty if failed.
+///
+/// StartCancel() only marks the controller canceled and runs the callback
+/// given to NotifyOnCancel(), the call itself still completes or times out.
+class RpcController : public ::google::protobuf::RpcController
+{
+ public:
+  RpcController()
+    : timeout_(0),
+      failed_(false),
+      canceled_(false),
+      cancelCallback_(NULL)
+  {
+  }
+
+  /// In seconds, overrides RpcChannel::setDefaultTimeout(), 0 for none.
+  void setTimeout(double seconds)
+  { timeout_ = seconds; }
+
+  double timeout() const
+  { return timeout_; }
+
+  void Reset() override
+  {
+    failed_ = false;
+    canceled_ = false;
+    cancelCallback_ = NULL;
+    errorText_.clear();
+  }
+
+  bool Failed() const override
+  { return failed_; }
+
+  std::string ErrorText() const override
+  { return errorText_; }
+
+  void StartCancel() override
+  {
+    canceled_ = true;
+    runCancelCallback();
+  }
+
+  void SetFailed(const std::string& reason) override
+  {
+    failed_ = true;
+    errorText_ = reason;
+  }
+
+  bool IsCanceled() const override
+  { return canceled_; }
+
+  /// Runs callback once, on StartCancel() or now if already canceled.
+  void NotifyOnCancel(::google::protobuf::Closure* callback) override
+  {
+    cancelCallback_ = callback;
+    if (canceled_)
+    {
+      runCancelCallback();
+    }
+  }
+
+ private:
+  void runCancelCallback()
+  {
+    ::google::protobuf::Closure* callback = cancelCallback_;
+    cancelCallback_ = NULL;
+    if (callback)
+    {
+      callback->Run();
+    }
+  }
+
+  double timeout_;
+  bool failed_;
+  bool canceled_;
+  ::google::protobuf::Closure* cancelCallback_;
+  std::string errorText_;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_PROTORPC_RPCCONTROLLER_H
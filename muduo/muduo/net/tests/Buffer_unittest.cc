@@ -1,4 +1,7 @@
 #include "muduo/net/Buffer.h"
+#include "muduo/net/ByteScan.h"
+
+#include <algorithm>
 
 //#define BOOST_TEST_MODULE BufferTest
 #define BOOST_TEST_MAIN
@@ -160,6 +163,55 @@ void output(Buffer&& buf, const void* inner)
 }
 
 // NOTE: This test fails in g++ 4.4, passes in g++ 4.6.
+BOOST_AUTO_TEST_CASE(testBufferFindCRLF)
+{
+  Buffer buf;
+  buf.append(string(100, 'x'));
+  BOOST_CHECK(buf.findCRLF() == NULL);
+  buf.append("\r\r\n");
+  BOOST_CHECK_EQUAL(buf.findCRLF(), buf.peek() + 101);
+  BOOST_CHECK(buf.findCRLF(buf.peek() + 103) == NULL);
+}
+
+// every implementation agrees with std algorithms, at all offsets and lengths
+BOOST_AUTO_TEST_CASE(testByteScan)
+{
+  using namespace muduo::net;
+  const char kCRLF[] = "\r\n";
+  const char alphabet[] = "ab\r\n ?:";
+  string data;
+  unsigned seed = 1;
+  for (int i = 0; i < 200; ++i)
+  {
+    seed = seed * 1103515245 + 12345;
+    // mostly 'a', so matches are sparse
+    size_t idx = (seed >> 16) % 32;
+    data.push_back(idx < sizeof alphabet - 1 ? alphabet[idx] : 'a');
+  }
+
+  scan::Impl best = scan::bestImpl();
+  for (int impl = scan::kScalar; impl <= scan::kAvx2; ++impl)
+  {
+    if (!scan::setImpl(static_cast<scan::Impl>(impl)))
+    {
+      continue;
+    }
+    for (size_t begin = 0; begin < 40; ++begin)
+    {
+      for (size_t end = begin; end <= data.size(); ++end)
+      {
+        const char* b = data.data() + begin;
+        const char* e = data.data() + end;
+        BOOST_REQUIRE_EQUAL(scan::findCRLF(b, e) - b, std::search(b, e, kCRLF, kCRLF+2) - b);
+        BOOST_REQUIRE_EQUAL(scan::findChar(b, e, ':') - b, std::find(b, e, ':') - b);
+        BOOST_REQUIRE_EQUAL(scan::findEither(b, e, ' ', '?') - b,
+                            std::find_first_of(b, e, " ?", " ?" + 2) - b);
+      }
+    }
+  }
+  scan::setImpl(best);
+}
+
 BOOST_AUTO_TEST_CASE(testMove)
 {
   Buffer buf;
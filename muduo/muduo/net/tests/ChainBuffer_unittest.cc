@@ -0,0 +1,217 @@
+#include "muduo/net/ChainBuffer.h"
+
+//#define BOOST_TEST_MODULE ChainBufferTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+using muduo::string;
+using muduo::net::Buffer;
+using muduo::net::ChainBuffer;
+
+BOOST_AUTO_TEST_CASE(testChainBufferAppendCoalesce)
+{
+  ChainBuffer chain;
+  BOOST_CHECK(chain.empty());
+  chain.append("hello", 5);
+  chain.append(string(" world"));
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 11);
+  BOOST_CHECK_EQUAL(chain.numSlices(), 1);
+
+  chain.append(string(ChainBuffer::kSliceSize, 'x'));
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 11 + ChainBuffer::kSliceSize);
+  BOOST_CHECK_EQUAL(chain.numSlices(), 2);
+
+  const string str = chain.retrieveAllAsString();
+  BOOST_CHECK_EQUAL(str, "hello world" + string(ChainBuffer::kSliceSize, 'x'));
+  BOOST_CHECK(chain.empty());
+  BOOST_CHECK_EQUAL(chain.numSlices(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testChainBufferMoveBuffer)
+{
+  Buffer buf;
+  buf.append(string(2000, 'y'));
+  const char* data = buf.peek();
+
+  ChainBuffer chain;
+  chain.append("abc", 3);
+  chain.append(std::move(buf));
+  BOOST_CHECK_EQUAL(buf.readableBytes(), 0);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 2003);
+  BOOST_CHECK_EQUAL(chain.numSlices(), 2);
+
+  // not copied
+  struct iovec vec[ChainBuffer::kMaxIovec];
+  BOOST_CHECK_EQUAL(chain.fillIovec(vec, ChainBuffer::kMaxIovec), 2);
+  BOOST_CHECK_EQUAL(vec[1].iov_base, data);
+  BOOST_CHECK_EQUAL(vec[1].iov_len, 2000);
+
+  // appending by copy after a moved buffer must not grow it
+  chain.append("z", 1);
+  BOOST_CHECK_EQUAL(chain.numSlices(), 3);
+  BOOST_CHECK_EQUAL(chain.retrieveAllAsString(), "abc" + string(2000, 'y') + "z");
+}
+
+BOOST_AUTO_TEST_CASE(testChainBufferSharedString)
+{
+  std::shared_ptr<const string> payload(new string("shared payload"));
+  ChainBuffer chain1, chain2;
+  chain1.append(payload);
+  chain2.append(payload);
+  BOOST_CHECK_EQUAL(payload.use_count(), 3);
+
+  chain1.retrieve(7);
+  BOOST_CHECK_EQUAL(chain1.readableBytes(), 7);
+  BOOST_CHECK_EQUAL(chain1.retrieveAllAsString(), "payload");
+  BOOST_CHECK_EQUAL(payload.use_count(), 2);
+
+  ChainBuffer chain3;
+  chain3.append("head ", 5);
+  chain3.append(std::move(chain2));
+  BOOST_CHECK(chain2.empty());
+  BOOST_CHECK_EQUAL(chain3.retrieveAllAsString(), "head shared payload");
+  BOOST_CHECK_EQUAL(payload.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(testChainBufferRetrieveAcrossSlices)
+{
+  ChainBuffer chain;
+  for (int i = 0; i < 10; ++i)
+  {
+    Buffer buf;
+    buf.append(string(100, static_cast<char>('0' + i)));
+    chain.append(std::move(buf));
+  }
+  BOOST_CHECK_EQUAL(chain.numSlices(), 10);
+  chain.retrieve(250);
+  BOOST_CHECK_EQUAL(chain.numSlices(), 8);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 750);
+  const string str = chain.retrieveAllAsString();
+  BOOST_CHECK_EQUAL(str.substr(0, 50), string(50, '2'));
+}
+
+BOOST_AUTO_TEST_CASE(testChainBufferWriteFd)
+{
+  int fds[2];
+  BOOST_REQUIRE_EQUAL(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  ChainBuffer chain;
+  std::shared_ptr<const string> payload(new string(1000, 'p'));
+  for (int i = 0; i < 2 * ChainBuffer::kMaxIovec; ++i)
+  {
+    chain.append(payload);
+  }
+  int savedErrno = 0;
+  ssize_t n = chain.writeFd(fds[0], &savedErrno);
+  // at most kMaxIovec slices per writev
+  BOOST_CHECK_EQUAL(n, ChainBuffer::kMaxIovec * 1000);
+  BOOST_CHECK_EQUAL(chain.numSlices(), ChainBuffer::kMaxIovec);
+
+  char buf[1000];
+  BOOST_CHECK_EQUAL(::read(fds[1], buf, sizeof buf), 1000);
+  BOOST_CHECK_EQUAL(string(buf, sizeof buf), *payload);
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+BOOST_AUTO_TEST_CASE(testChainBufferFile)
+{
+  char name[] = "/tmp/chainbuffer_unittestXXXXXX";
+  int filefd = ::mkstemp(name);
+  BOOST_REQUIRE(filefd >= 0);
+  ::unlink(name);
+  const string content = "0123456789abcdefghij";
+  BOOST_REQUIRE_EQUAL(::write(filefd, content.data(), content.size()),
+                      static_cast<ssize_t>(content.size()));
+
+  int fds[2];
+  BOOST_REQUIRE_EQUAL(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  ChainBuffer chain;
+  chain.append("head", 4);
+  chain.appendFile(filefd, 10, 5);
+  chain.append("tail", 4);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 13);
+
+  // writev stops at the file region, which goes by sendfile
+  int savedErrno = 0;
+  BOOST_CHECK_EQUAL(chain.writeFd(fds[0], &savedErrno), 4);
+  BOOST_CHECK_EQUAL(chain.writeFd(fds[0], &savedErrno), 5);
+  BOOST_CHECK_EQUAL(chain.writeFd(fds[0], &savedErrno), 4);
+  BOOST_CHECK(chain.empty());
+
+  char buf[64];
+  BOOST_CHECK_EQUAL(::read(fds[1], buf, sizeof buf), 13);
+  BOOST_CHECK_EQUAL(string(buf, 13), "headabcdetail");
+  // filefd was closed by chain
+  BOOST_CHECK_EQUAL(::close(filefd), -1);
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+BOOST_AUTO_TEST_CASE(testChainBufferPipe)
+{
+  int pipefd[2];
+  BOOST_REQUIRE_EQUAL(::pipe(pipefd), 0);
+  BOOST_REQUIRE_EQUAL(::write(pipefd[1], "abcdef", 6), 6);
+  std::shared_ptr<const void> holder(new int(0));
+
+  int fds[2];
+  BOOST_REQUIRE_EQUAL(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  ChainBuffer chain;
+  chain.append("head", 4);
+  chain.appendPipe(pipefd[0], 2, holder);
+  // merged with the region before
+  chain.appendPipe(pipefd[0], 4, holder);
+  BOOST_CHECK_EQUAL(chain.numSlices(), 2);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 10);
+
+  int savedErrno = 0;
+  BOOST_CHECK_EQUAL(chain.writeFd(fds[0], &savedErrno), 4);
+  BOOST_CHECK_EQUAL(chain.writeFd(fds[0], &savedErrno), 6);
+  BOOST_CHECK(chain.empty());
+
+  char buf[64];
+  BOOST_CHECK_EQUAL(::read(fds[1], buf, sizeof buf), 10);
+  BOOST_CHECK_EQUAL(string(buf, 10), "headabcdef");
+  // not owned by chain
+  BOOST_CHECK_EQUAL(::close(pipefd[0]), 0);
+  ::close(pipefd[1]);
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+BOOST_AUTO_TEST_CASE(testChainBufferEmptyPipe)
+{
+  int pipefd[2];
+  BOOST_REQUIRE_EQUAL(::pipe(pipefd), 0);
+  std::shared_ptr<const void> holder(new int(0));
+
+  int fds[2];
+  BOOST_REQUIRE_EQUAL(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  ChainBuffer chain;
+  BOOST_CHECK_EQUAL(chain.frontPipe(), -1);
+  chain.appendPipe(pipefd[0], 3, holder);
+  BOOST_CHECK_EQUAL(chain.frontPipe(), pipefd[0]);
+
+  // nothing in the pipe yet, no progress
+  int savedErrno = 0;
+  BOOST_CHECK_EQUAL(chain.writeFd(fds[0], &savedErrno), -1);
+  BOOST_CHECK_EQUAL(savedErrno, EAGAIN);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 3);
+
+  BOOST_REQUIRE_EQUAL(::write(pipefd[1], "abc", 3), 3);
+  BOOST_CHECK_EQUAL(chain.writeFd(fds[0], &savedErrno), 3);
+  BOOST_CHECK(chain.empty());
+  BOOST_CHECK_EQUAL(chain.frontPipe(), -1);
+
+  ::close(pipefd[0]);
+  ::close(pipefd[1]);
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
@@ -0,0 +1,116 @@
+// Benchmark of cross-thread EventLoop::queueInLoop(),
+// a few producer threads fan out small functors to many IO loops.
+// The functors are a plain function, or a bound function and a string
+// as TcpConnection::send() queues.
+
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/Thread.h"
+#include "muduo/base/Timestamp.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThreadPool.h"
+
+#include <atomic>
+#include <vector>
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+std::atomic<int64_t> g_remaining;
+CountDownLatch* g_done;
+
+void onFunctor()
+{
+  if (g_remaining.fetch_sub(1, std::memory_order_relaxed) == 1)
+  {
+    g_done->countDown();
+  }
+}
+
+void onMessage(const string& message)
+{
+  assert(!message.empty()); (void) message;
+  onFunctor();
+}
+
+void produce(const std::vector<EventLoop*>& loops, int count, bool bound,
+             CountDownLatch* start)
+{
+  start->wait();
+  size_t n = loops.size();
+  string message("hello");
+  for (int i = 0; i < count; ++i)
+  {
+    if (bound)
+    {
+      loops[static_cast<size_t>(i) % n]->queueInLoop(std::bind(onMessage, message));
+    }
+    else
+    {
+      loops[static_cast<size_t>(i) % n]->queueInLoop(onFunctor);
+    }
+  }
+}
+
+void bench(int numProducers, int numLoops, int count, bool bound)
+{
+  EventLoop baseLoop;
+  EventLoopThreadPool pool(&baseLoop, "bench");
+  pool.setThreadNum(numLoops);
+  pool.start();
+  std::vector<EventLoop*> loops = pool.getAllLoops();
+  std::vector<int64_t> iterations;
+  for (EventLoop* loop : loops)
+  {
+    iterations.push_back(loop->iteration());
+  }
+
+  CountDownLatch start(1);
+  CountDownLatch done(1);
+  g_done = &done;
+  g_remaining = static_cast<int64_t>(numProducers) * count;
+  std::vector<std::unique_ptr<Thread>> producers;
+  for (int i = 0; i < numProducers; ++i)
+  {
+    producers.emplace_back(new Thread(
+        std::bind(produce, loops, count, bound, &start), "producer"));
+    producers.back()->start();
+  }
+
+  Timestamp begin(Timestamp::now());
+  start.countDown();
+  done.wait();
+  double seconds = timeDifference(Timestamp::now(), begin);
+  for (auto& thr : producers)
+  {
+    thr->join();
+  }
+
+  int64_t polls = 0;
+  for (size_t i = 0; i < loops.size(); ++i)
+  {
+    polls += loops[i]->iteration() - iterations[i];
+  }
+  double total = static_cast<double>(numProducers) * count;
+  printf("%d producers -> %d loops, %s: %.0f functors in %.3fs, %.0f /s, "
+         "%.1f functors per poll\n",
+         numProducers, numLoops, bound ? "bound" : "plain",
+         total, seconds, total / seconds,
+         total / static_cast<double>(polls > 0 ? polls : 1));
+}
+
+int main(int argc, char* argv[])
+{
+  int count = argc > 1 ? atoi(argv[1]) : 1000*1000;
+  for (int bound = 0; bound < 2; ++bound)
+  {
+    bench(1, 1, count, bound);
+    bench(1, 4, count, bound);
+    bench(1, 8, count, bound);
+    bench(4, 4, count, bound);
+    bench(4, 1, count, bound);
+  }
+}
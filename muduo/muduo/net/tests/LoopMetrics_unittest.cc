@@ -0,0 +1,57 @@
+#include "muduo/net/LoopMetrics.h"
+#include "muduo/net/EventLoop.h"
+
+//#define BOOST_TEST_MODULE LoopMetricsTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using muduo::net::EventLoop;
+using muduo::net::LoopMetrics;
+
+BOOST_AUTO_TEST_CASE(testHistogramBuckets)
+{
+  BOOST_CHECK_EQUAL(LoopMetrics::Histogram::bucketOf(0), 0);
+  BOOST_CHECK_EQUAL(LoopMetrics::Histogram::bucketOf(1), 0);
+  BOOST_CHECK_EQUAL(LoopMetrics::Histogram::bucketOf(2), 1);
+  BOOST_CHECK_EQUAL(LoopMetrics::Histogram::bucketOf(3), 2);
+  BOOST_CHECK_EQUAL(LoopMetrics::Histogram::bucketOf(4), 2);
+  BOOST_CHECK_EQUAL(LoopMetrics::Histogram::bucketOf(5), 3);
+  BOOST_CHECK_EQUAL(LoopMetrics::Histogram::bucketOf(1000*1000), 20);
+  BOOST_CHECK_EQUAL(LoopMetrics::Histogram::bucketOf(int64_t(1) << 23), 23);
+  BOOST_CHECK_EQUAL(LoopMetrics::Histogram::bucketOf((int64_t(1) << 23) + 1),
+                    LoopMetrics::Histogram::kBuckets);
+  BOOST_CHECK_EQUAL(LoopMetrics::Histogram::bucketOf(-1), 0);
+}
+
+void noop()
+{
+}
+
+BOOST_AUTO_TEST_CASE(testLoopMetrics)
+{
+  size_t before = LoopMetrics::snapshotAll().size();
+  {
+  EventLoop loop;
+  BOOST_CHECK_EQUAL(LoopMetrics::snapshotAll().size(), before + 1);
+  for (int i = 0; i < 100; ++i)
+  {
+    loop.queueInLoop(noop);
+  }
+  loop.runAfter(0.01, noop);
+  loop.runAfter(0.02, std::bind(&EventLoop::quit, &loop));
+  loop.loop();
+
+  LoopMetrics::Snapshot s = loop.metrics()->snapshot();
+  BOOST_CHECK_EQUAL(s.tid, muduo::CurrentThread::tid());
+  BOOST_CHECK_EQUAL(s.functors, 100);
+  BOOST_CHECK_EQUAL(s.maxPendingFunctors, 100);
+  BOOST_CHECK_EQUAL(s.timerLateness.count, 2);
+  BOOST_CHECK(s.pollWait.count >= 2);
+  BOOST_CHECK_EQUAL(s.pollWait.count, s.handling.count);
+  // about 20ms in poll
+  BOOST_CHECK(s.pollWait.sum >= 15*1000);
+  BOOST_CHECK_EQUAL(s.bytesRead, 0);
+  }
+  BOOST_CHECK_EQUAL(LoopMetrics::snapshotAll().size(), before);
+}
@@ -0,0 +1,269 @@
+// Benchmark of choosing I/O loops for new connections under skewed load.
+//
+// A few heavy clients pipeline requests which cost the server 500us each,
+// making their loops busy. Then many light clients connect and ping-pong,
+// their round-trip times are reported. A light client sharing a loop with
+// a heavy one waits for it.
+//
+// "migrate" assigns connections round-robin, then moves light connections
+// off the loops of heavy ones with TcpConnection::migrateTo().
+
+#include "muduo/base/Logging.h"
+#include "muduo/base/Mutex.h"
+#include "muduo/base/Thread.h"
+#include "muduo/base/Timestamp.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/EventLoopThreadPool.h"
+#include "muduo/net/InetAddress.h"
+#include "muduo/net/TcpServer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const size_t kMessageLen = 8;
+const int kHeavyCost = 500;  // microseconds
+const int kPipeline = 16;
+
+std::atomic<bool> g_stop;
+
+MutexLock g_mutex;
+std::map<string, TcpConnectionPtr> g_connections GUARDED_BY(g_mutex);
+
+void onConnection(const TcpConnectionPtr& conn)
+{
+  MutexLockGuard lock(g_mutex);
+  if (conn->connected())
+  {
+    g_connections[conn->name()] = conn;
+  }
+  else
+  {
+    g_connections.erase(conn->name());
+  }
+}
+
+void spin(int microseconds)
+{
+  Timestamp start(Timestamp::now());
+  while (timeDifference(Timestamp::now(), start) * 1e6 < microseconds)
+  {
+  }
+}
+
+void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+  while (buf->readableBytes() >= kMessageLen)
+  {
+    if (*buf->peek() == 'H')
+    {
+      conn->setContext(true);
+      spin(kHeavyCost);
+    }
+    conn->send(buf->peek(), kMessageLen);
+    buf->retrieve(kMessageLen);
+  }
+}
+
+int connectTo(const InetAddress& serverAddr)
+{
+  int sockfd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+  if (::connect(sockfd, serverAddr.getSockAddr(),
+                static_cast<socklen_t>(sizeof(struct sockaddr_in))) < 0)
+  {
+    LOG_SYSFATAL << "connect";
+  }
+  int one = 1;
+  ::setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+  return sockfd;
+}
+
+bool readn(int sockfd, char* buf, size_t len)
+{
+  size_t got = 0;
+  while (got < len)
+  {
+    ssize_t n = ::read(sockfd, buf + got, len - got);
+    if (n <= 0)
+    {
+      return false;
+    }
+    got += n;
+  }
+  return true;
+}
+
+void heavyClient(const InetAddress& serverAddr)
+{
+  int sockfd = connectTo(serverAddr);
+  char message[kMessageLen];
+  memset(message, 'H', sizeof message);
+  for (int i = 0; i < kPipeline; ++i)
+  {
+    ::write(sockfd, message, sizeof message);
+  }
+  while (!g_stop.load(std::memory_order_relaxed)
+         && readn(sockfd, message, sizeof message))
+  {
+    ::write(sockfd, message, sizeof message);
+  }
+  // drains replies of requests in flight
+  ::shutdown(sockfd, SHUT_WR);
+  while (::read(sockfd, message, sizeof message) > 0)
+  {
+  }
+  ::close(sockfd);
+}
+
+void lightClient(const InetAddress& serverAddr, std::vector<int64_t>* rtts)
+{
+  int sockfd = connectTo(serverAddr);
+  char message[kMessageLen];
+  memset(message, 'L', sizeof message);
+  while (!g_stop.load(std::memory_order_relaxed))
+  {
+    Timestamp start(Timestamp::now());
+    ::write(sockfd, message, sizeof message);
+    if (!readn(sockfd, message, sizeof message))
+    {
+      break;
+    }
+    rtts->push_back(Timestamp::now().microSecondsSinceEpoch()
+                    - start.microSecondsSinceEpoch());
+    ::usleep(1000);
+  }
+  ::close(sockfd);
+}
+
+void startLightClients(std::vector<std::unique_ptr<Thread>>* clients,
+                       const InetAddress& serverAddr,
+                       std::vector<std::vector<int64_t>>* rtts)
+{
+  for (auto& r : *rtts)
+  {
+    clients->emplace_back(new Thread(std::bind(lightClient, serverAddr, &r), "light"));
+    clients->back()->start();
+  }
+}
+
+// moves light connections away from loops of heavy ones, in base loop.
+void rebalance(TcpServer* server)
+{
+  std::set<EventLoop*> heavyLoops;
+  std::vector<TcpConnectionPtr> lights;
+  {
+  MutexLockGuard lock(g_mutex);
+  for (const auto& item : g_connections)
+  {
+    const TcpConnectionPtr& conn = item.second;
+    if (conn->getContext().empty())
+      lights.push_back(conn);
+    else
+      heavyLoops.insert(conn->getLoop());
+  }
+  }
+  std::vector<EventLoop*> targets;
+  for (EventLoop* loop : server->threadPool()->getAllLoops())
+  {
+    if (heavyLoops.count(loop) == 0)
+      targets.push_back(loop);
+  }
+  if (targets.empty())
+    return;
+  int moved = 0;
+  for (const TcpConnectionPtr& conn : lights)
+  {
+    if (heavyLoops.count(conn->getLoop()) > 0)
+    {
+      conn->migrateTo(targets[moved % targets.size()]);
+      ++moved;
+    }
+  }
+  printf("migrated %d connections\n", moved);
+}
+
+void stop()
+{
+  g_stop = true;
+}
+
+void bench(const char* name, TcpServer::LoopSelection selection, bool migrate,
+           int numThreads, int numHeavy, int numLight, double seconds)
+{
+  EventLoop loop;
+  InetAddress listenAddr("127.0.0.1", 2020);
+  TcpServer server(&loop, listenAddr, "LoopSelectBench");
+  server.setConnectionCallback(onConnection);
+  server.setMessageCallback(onMessage);
+  server.setThreadNum(numThreads);
+  server.setLoopSelection(selection);
+  server.start();
+
+  g_stop = false;
+  std::vector<std::unique_ptr<Thread>> clients;
+  for (int i = 0; i < numHeavy; ++i)
+  {
+    clients.emplace_back(new Thread(std::bind(heavyClient, listenAddr), "heavy"));
+    clients.back()->start();
+  }
+  // lets busy time of loops show up
+  std::vector<std::vector<int64_t>> rtts(numLight);
+  loop.runAfter(0.5, std::bind(startLightClients, &clients, listenAddr, &rtts));
+  if (migrate)
+  {
+    loop.runAfter(1.0, std::bind(rebalance, &server));
+  }
+  loop.runAfter(seconds, stop);
+  // the server closes connections of clients in its loop
+  loop.runAfter(seconds + 0.2, std::bind(&EventLoop::quit, &loop));
+  loop.loop();
+  for (auto& thr : clients)
+  {
+    thr->join();
+  }
+
+  std::vector<int64_t> all;
+  for (const auto& r : rtts)
+  {
+    all.insert(all.end(), r.begin(), r.end());
+  }
+  std::sort(all.begin(), all.end());
+  if (all.empty())
+  {
+    printf("%-14s no samples\n", name);
+    return;
+  }
+  printf("%-14s pings %7zu  p50 %6ld us  p99 %6ld us  p99.9 %6ld us  max %6ld us\n",
+         name, all.size(),
+         all[all.size() / 2],
+         all[all.size() * 99 / 100],
+         all[all.size() * 999 / 1000],
+         all.back());
+}
+
+int main(int argc, char* argv[])
+{
+  int numThreads = argc > 1 ? atoi(argv[1]) : 4;
+  int numHeavy = argc > 2 ? atoi(argv[2]) : 1;
+  int numLight = argc > 3 ? atoi(argv[3]) : 16;
+  double seconds = argc > 4 ? atof(argv[4]) : 5.0;
+  Logger::setLogLevel(Logger::WARN);
+  printf("threads %d heavy %d light %d, %d us per heavy request\n",
+         numThreads, numHeavy, numLight, kHeavyCost);
+
+  bench("round-robin", TcpServer::kRoundRobin, false, numThreads, numHeavy, numLight, seconds);
+  bench("least-conns", TcpServer::kLeastConnections, false, numThreads, numHeavy, numLight, seconds);
+  bench("least-busy", TcpServer::kLeastBusy, false, numThreads, numHeavy, numLight, seconds);
+  bench("rr+migrate", TcpServer::kRoundRobin, true, numThreads, numHeavy, numLight, seconds);
+}
@@ -0,0 +1,140 @@
+#include "muduo/net/EventLoopThreadPool.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/LoopMetrics.h"
+#include "muduo/net/TcpServer.h"
+#include "muduo/base/CountDownLatch.h"
+#include "muduo/base/Mutex.h"
+#include "muduo/base/Thread.h"
+
+#include <vector>
+
+#include <unistd.h>
+
+//#define BOOST_TEST_MODULE LoopSelectTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+BOOST_AUTO_TEST_CASE(testLeastConnections)
+{
+  EventLoop loop;
+  EventLoopThreadPool pool(&loop, "least");
+  pool.setThreadNum(3);
+  pool.setSelectPolicy(EventLoopThreadPool::kLeastConnections);
+  pool.start();
+  std::vector<EventLoop*> loops = pool.getAllLoops();
+  BOOST_REQUIRE_EQUAL(loops.size(), 3);
+
+  // round-robin among equals
+  BOOST_CHECK_EQUAL(pool.getNextLoop(), loops[0]);
+  BOOST_CHECK_EQUAL(pool.getNextLoop(), loops[1]);
+  BOOST_CHECK_EQUAL(pool.getNextLoop(), loops[2]);
+
+  loops[0]->metrics()->addConnection();
+  loops[0]->metrics()->addConnection();
+  loops[2]->metrics()->addConnection();
+  BOOST_CHECK_EQUAL(pool.getNextLoop(), loops[1]);
+  BOOST_CHECK_EQUAL(pool.getNextLoop(), loops[1]);
+  loops[1]->metrics()->addConnection();
+  // ties go round-robin
+  BOOST_CHECK_EQUAL(pool.getNextLoop(), loops[2]);
+  loops[1]->metrics()->addConnection();
+  BOOST_CHECK_EQUAL(pool.getNextLoop(), loops[2]);
+  loops[0]->metrics()->removeConnection();
+  loops[0]->metrics()->removeConnection();
+  BOOST_CHECK_EQUAL(pool.getNextLoop(), loops[0]);
+}
+
+MutexLock g_mutex;
+TcpConnectionPtr g_conn GUARDED_BY(g_mutex);
+std::vector<EventLoop*> g_messageLoops GUARDED_BY(g_mutex);
+
+void onConnection(const TcpConnectionPtr& conn)
+{
+  MutexLockGuard lock(g_mutex);
+  if (conn->connected())
+    g_conn = conn;
+  else
+    g_conn.reset();
+}
+
+void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+  {
+  MutexLockGuard lock(g_mutex);
+  g_messageLoops.push_back(EventLoop::getEventLoopOfCurrentThread());
+  }
+  conn->send(buf);
+}
+
+void migrate(TcpServer* server, CountDownLatch* latch)
+{
+  MutexLockGuard lock(g_mutex);
+  std::vector<EventLoop*> loops = server->threadPool()->getAllLoops();
+  EventLoop* target = g_conn->getLoop() == loops[0] ? loops[1] : loops[0];
+  g_conn->migrateTo(target, std::bind(&CountDownLatch::countDown, latch));
+}
+
+void echo(int sockfd, char c)
+{
+  BOOST_CHECK_EQUAL(::write(sockfd, &c, 1), 1);
+  char reply = 0;
+  BOOST_CHECK_EQUAL(::read(sockfd, &reply, 1), 1);
+  BOOST_CHECK_EQUAL(reply, c);
+}
+
+void client(const InetAddress& serverAddr, TcpServer* server)
+{
+  int sockfd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+  BOOST_REQUIRE(::connect(sockfd, serverAddr.getSockAddr(),
+                          static_cast<socklen_t>(sizeof(struct sockaddr_in))) == 0);
+  echo(sockfd, 'a');
+  CountDownLatch latch(1);
+  server->getLoop()->runInLoop(std::bind(migrate, server, &latch));
+  latch.wait();
+  echo(sockfd, 'b');
+  ::close(sockfd);
+  server->getLoop()->runAfter(0.1, std::bind(&EventLoop::quit, server->getLoop()));
+}
+
+void testMigrate(TcpServer::Option option, uint16_t port)
+{
+  {
+  MutexLockGuard lock(g_mutex);
+  g_messageLoops.clear();
+  }
+  EventLoop loop;
+  InetAddress listenAddr("127.0.0.1", port);
+  TcpServer server(&loop, listenAddr, "MigrateTest", option);
+  server.setConnectionCallback(onConnection);
+  server.setMessageCallback(onMessage);
+  server.setThreadNum(2);
+  server.start();
+
+  Thread thr(std::bind(client, listenAddr, &server), "client");
+  thr.start();
+  loop.loop();
+  thr.join();
+
+  std::vector<EventLoop*> loops = server.threadPool()->getAllLoops();
+  MutexLockGuard lock(g_mutex);
+  BOOST_REQUIRE_EQUAL(g_messageLoops.size(), 2);
+  BOOST_CHECK(g_messageLoops[0] != g_messageLoops[1]);
+  BOOST_CHECK(!g_conn);
+  BOOST_CHECK_EQUAL(loops[0]->metrics()->connections(), 0);
+  BOOST_CHECK_EQUAL(loops[1]->metrics()->connections(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testMigrateTo)
+{
+  testMigrate(TcpServer::kNoReusePort, 2021);
+}
+
+// the connection closes in a loop other than that of its acceptor
+BOOST_AUTO_TEST_CASE(testMigrateToPerLoop)
+{
+  testMigrate(TcpServer::kReusePortPerLoop, 2022);
+}
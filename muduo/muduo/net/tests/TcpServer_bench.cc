@@ -0,0 +1,92 @@
+// Benchmark of TcpServer accept rate, single acceptor vs. SO_REUSEPORT per loop.
+//
+// Client threads connect() and close the connection right away,
+// the server counts connections established in its callback.
+
+#include "muduo/base/Atomic.h"
+#include "muduo/base/Logging.h"
+#include "muduo/base/Thread.h"
+#include "muduo/base/Timestamp.h"
+#include "muduo/net/EventLoop.h"
+#include "muduo/net/InetAddress.h"
+#include "muduo/net/TcpServer.h"
+
+#include <atomic>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+AtomicInt64 g_accepted;
+std::atomic<bool> g_stop;
+
+void onConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    g_accepted.increment();
+  }
+}
+
+void client(const InetAddress& serverAddr)
+{
+  while (!g_stop.load(std::memory_order_relaxed))
+  {
+    int sockfd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    // TIME_WAIT ports are reused on loopback, see tcp_tw_reuse
+    ::connect(sockfd, serverAddr.getSockAddr(),
+              static_cast<socklen_t>(sizeof(struct sockaddr_in)));
+    ::close(sockfd);
+  }
+}
+
+void bench(TcpServer::Option option, int numThreads, int numClients, int acceptBatch, double seconds)
+{
+  EventLoop loop;
+  InetAddress listenAddr("127.0.0.1", 2019);
+  TcpServer server(&loop, listenAddr, "AcceptBench", option);
+  server.setConnectionCallback(onConnection);
+  server.setThreadNum(numThreads);
+  server.setAcceptBatch(acceptBatch);
+  server.start();
+
+  g_stop = false;
+  g_accepted.getAndSet(0);
+  std::vector<std::unique_ptr<Thread>> clients;
+  for (int i = 0; i < numClients; ++i)
+  {
+    clients.emplace_back(new Thread(std::bind(client, listenAddr), "client"));
+    clients.back()->start();
+  }
+
+  Timestamp start(Timestamp::now());
+  loop.runAfter(seconds, std::bind(&EventLoop::quit, &loop));
+  loop.loop();
+  int64_t accepted = g_accepted.get();
+  double elapsed = timeDifference(Timestamp::now(), start);
+  g_stop = true;
+  for (auto& thr : clients)
+  {
+    thr->join();
+  }
+  printf("%-18s threads %d clients %d batch %2d: %8.0f accepts/s\n",
+         option == TcpServer::kReusePortPerLoop ? "reuseport-per-loop" : "single-acceptor",
+         numThreads, numClients, acceptBatch,
+         static_cast<double>(accepted) / elapsed);
+}
+
+int main(int argc, char* argv[])
+{
+  Logger::setLogLevel(Logger::WARN);
+  int numThreads = argc > 1 ? atoi(argv[1]) : 4;
+  int numClients = argc > 2 ? atoi(argv[2]) : 8;
+  double seconds = argc > 3 ? atof(argv[3]) : 3.0;
+  bench(TcpServer::kNoReusePort, numThreads, numClients, 1, seconds);
+  bench(TcpServer::kNoReusePort, numThreads, numClients, 16, seconds);
+  bench(TcpServer::kReusePortPerLoop, numThreads, numClients, 1, seconds);
+  bench(TcpServer::kReusePortPerLoop, numThreads, numClients, 16, seconds);
+}
@@ -0,0 +1,94 @@
+// Benchmark of TimerQueue, with and without timing wheel.
+//
+// Keeps N timers pending, like idle timeouts of N connections,
+// then cancels and re-adds a random one repeatedly,
+// at last lets a batch of short timers expire.
+
+#include "muduo/net/EventLoop.h"
+#include "muduo/base/Timestamp.h"
+
+#include <random>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+int g_fired = 0;
+int g_expected = 0;
+EventLoop* g_loop;
+
+void noop()
+{
+}
+
+void onFire()
+{
+  if (++g_fired == g_expected)
+  {
+    g_loop->quit();
+  }
+}
+
+void bench(double tick, int numTimers, int numChurns)
+{
+  EventLoop loop;
+  g_loop = &loop;
+  if (tick > 0.0)
+  {
+    loop.setTimingWheel(tick);
+  }
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> delay(60.0, 120.0);
+  std::uniform_int_distribution<int> which(0, numTimers - 1);
+
+  std::vector<TimerId> timers;
+  timers.reserve(numTimers);
+  Timestamp start(Timestamp::now());
+  for (int i = 0; i < numTimers; ++i)
+  {
+    timers.push_back(loop.runAfter(delay(rng), noop));
+  }
+  Timestamp added(Timestamp::now());
+
+  for (int i = 0; i < numChurns; ++i)
+  {
+    int idx = which(rng);
+    loop.cancel(timers[idx]);
+    timers[idx] = loop.runAfter(delay(rng), noop);
+  }
+  Timestamp churned(Timestamp::now());
+
+  const int kShort = 10000;
+  g_fired = 0;
+  g_expected = kShort;
+  std::uniform_real_distribution<double> shortDelay(0.0, 0.2);
+  for (int i = 0; i < kShort; ++i)
+  {
+    loop.runAfter(shortDelay(rng), onFire);
+  }
+  Timestamp fireStart(Timestamp::now());
+  loop.loop();
+  Timestamp fired(Timestamp::now());
+
+  double addSec = timeDifference(added, start);
+  double churnSec = timeDifference(churned, added);
+  printf("%-6s tick %.3f: add %d in %.3fs, %.0f ops/s; "
+         "cancel+add %d in %.3fs, %.0f ops/s; "
+         "fire %d in %.3fs (expect ~0.2s)\n",
+         tick > 0.0 ? "wheel" : "set", tick,
+         numTimers, addSec, numTimers / addSec,
+         numChurns, churnSec, numChurns / churnSec,
+         kShort, timeDifference(fired, fireStart));
+}
+
+int main(int argc, char* argv[])
+{
+  int numTimers = argc > 1 ? atoi(argv[1]) : 100*1000;
+  int numChurns = argc > 2 ? atoi(argv[2]) : 1000*1000;
+  bench(0.0, numTimers, numChurns);
+  bench(0.001, numTimers, numChurns);
+  bench(0.01, numTimers, numChurns);
+}
@@ -3,8 +3,11 @@
 #include "muduo/base/Thread.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 
+#include <vector>
+
 using namespace muduo;
 using namespace muduo::net;
 
@@ -32,13 +35,19 @@ void cancel(TimerId timer)
   printf("cancelled at %s\n", Timestamp::now().toString().c_str());
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+  // timerqueue_unittest [tick_seconds], runs with a timing wheel if tick given
+  double tick = argc > 1 ? atof(argv[1]) : 0.0;
   printTid();
   sleep(1);
   {
     EventLoop loop;
     g_loop = &loop;
+    if (tick > 0.0)
+    {
+      loop.setTimingWheel(tick);
+    }
 
     print("main");
     loop.runAfter(1, std::bind(print, "once1"));
@@ -59,8 +68,34 @@ int main()
   {
     EventLoopThread loopThread;
     EventLoop* loop = loopThread.startLoop();
+    if (tick > 0.0)
+    {
+      loop->runInLoop(std::bind(&EventLoop::setTimingWheel, loop, tick));
+    }
     loop->runAfter(2, printTid);
     sleep(3);
     print("thread loop exits");
   }
+  {
+    // a burst of timers, then cancel them after they fired and were released
+    EventLoop loop;
+    if (tick > 0.0)
+    {
+      loop.setTimingWheel(tick);
+    }
+    std::vector<TimerId> timers;
+    for (int i = 0; i < 10000; ++i)
+    {
+      timers.push_back(loop.runAfter(0.01, [] {}));
+    }
+    loop.runAfter(0.5, [&] {
+      for (const TimerId& timer : timers)
+      {
+        loop.cancel(timer);
+      }
+      loop.quit();
+    });
+    loop.loop();
+    printf("burst of %zu timers\n", timers.size());
+  }
 }
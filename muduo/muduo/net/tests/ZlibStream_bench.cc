@@ -0,0 +1,138 @@
+// Benchmark of ZlibOutputStream, CPU cost per MB of input.
+//
+// Streams: a long stream written in 4KiB pieces, with or without flush()
+// after each piece, as a chatty connection does.
+// Responses: many small responses compressed separately, with a new
+// ZlibOutputStream each vs. one from ZlibOutputStreamPool.
+
+#include "muduo/net/ZlibStream.h"
+
+#include <functional>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+double cpuTime()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) * 1e-9;
+}
+
+string makeText(size_t size)
+{
+  const char* methods[] = { "GET", "POST", "PUT" };
+  const char* paths[] = { "/index.html", "/api/v1/users", "/static/app.js", "/favicon.ico" };
+  string text;
+  char line[256];
+  for (int i = 0; text.size() < size; ++i)
+  {
+    snprintf(line, sizeof line,
+             "20190415 10:%02d:%02d.%06d 1234 INFO  %s %s from 10.0.%d.%d status %d bytes %d\n",
+             i / 60 % 60, i % 60, rand() % 1000000,
+             methods[rand() % 3], paths[rand() % 4],
+             rand() % 256, rand() % 256, rand() % 10 ? 200 : 404, rand() % 100000);
+    text += line;
+  }
+  text.resize(size);
+  return text;
+}
+
+string makeRandom(size_t size)
+{
+  string data(size, '\0');
+  for (auto& c : data)
+  {
+    c = static_cast<char>(rand());
+  }
+  return data;
+}
+
+void report(const char* name, size_t inputBytes, size_t outputBytes, double seconds)
+{
+  double mb = static_cast<double>(inputBytes) / (1024 * 1024);
+  printf("%-36s ratio %5.1f%%  %7.2f ms CPU per MB  %7.1f MB/s\n",
+         name,
+         100.0 * static_cast<double>(outputBytes) / static_cast<double>(inputBytes),
+         seconds * 1000 / mb, mb / seconds);
+}
+
+void benchStream(const char* name, const string& input, bool flush,
+                 ZlibFormat format, int level, int windowBits = 15, int memLevel = 8)
+{
+  const size_t kPiece = 4096;
+  Buffer output;
+  size_t outputBytes = 0;
+  double start = cpuTime();
+  ZlibOutputStream stream(&output, format, level, windowBits, memLevel);
+  for (size_t i = 0; i < input.size(); i += kPiece)
+  {
+    size_t len = std::min(kPiece, input.size() - i);
+    stream.write(StringPiece(input.data() + i, static_cast<int>(len)));
+    if (flush)
+    {
+      stream.flush();
+    }
+    // as if sent to a TcpConnection
+    outputBytes += output.readableBytes();
+    output.retrieveAll();
+  }
+  stream.finishStream();
+  outputBytes += output.readableBytes();
+  report(name, input.size(), outputBytes, cpuTime() - start);
+}
+
+void benchResponses(const char* name, const string& input, size_t responseSize, bool pooled)
+{
+  ZlibOutputStreamPool pool(kGzipFormat);
+  Buffer output;
+  size_t outputBytes = 0;
+  double start = cpuTime();
+  for (size_t i = 0; i + responseSize <= input.size(); i += responseSize)
+  {
+    StringPiece body(input.data() + i, static_cast<int>(responseSize));
+    if (pooled)
+    {
+      std::unique_ptr<ZlibOutputStream> stream(pool.get(&output));
+      stream->write(body);
+      stream->finishStream();
+      pool.put(std::move(stream));
+    }
+    else
+    {
+      ZlibOutputStream stream(&output, kGzipFormat);
+      stream.write(body);
+      stream.finish();
+    }
+    outputBytes += output.readableBytes();
+    output.retrieveAll();
+  }
+  report(name, input.size() / responseSize * responseSize, outputBytes, cpuTime() - start);
+}
+
+int main(int argc, char* argv[])
+{
+  size_t size = (argc > 1 ? atoi(argv[1]) : 64) * 1024 * 1024;
+  string text = makeText(size);
+  string random = makeRandom(size / 4);
+  printf("input %zd MiB of log lines\n", size / 1024 / 1024);
+
+  benchStream("gzip level 1", text, false, kGzipFormat, 1);
+  benchStream("gzip level 6", text, false, kGzipFormat, 6);
+  benchStream("gzip level 9", text, false, kGzipFormat, 9);
+  benchStream("gzip level 6, 32KiB state", text, false, kGzipFormat, 6, 12, 5);
+  benchStream("gzip level 1, flush every 4KiB", text, true, kGzipFormat, 1);
+  benchStream("gzip level 6, flush every 4KiB", text, true, kGzipFormat, 6);
+  benchStream("raw deflate level 6", text, false, kRawDeflate, 6);
+  benchStream("gzip level 6, random bytes", random, false, kGzipFormat, 6);
+
+  benchResponses("2KiB responses, new stream", text, 2048, false);
+  benchResponses("2KiB responses, pooled stream", text, 2048, true);
+  benchResponses("16KiB responses, new stream", text, 16384, false);
+  benchResponses("16KiB responses, pooled stream", text, 16384, true);
+}
@@ -89,3 +89,126 @@ BOOST_AUTO_TEST_CASE(testZlibOutputStream5)
   printf("total %zd\n", output.readableBytes());
   BOOST_CHECK_EQUAL(stream.zlibErrorCode(), Z_STREAM_END);
 }
+
+// inflates zlib or gzip format
+muduo::string decompress(const muduo::net::Buffer& input, int windowBits = 15 + 32)
+{
+  z_stream zs;
+  muduo::memZero(&zs, sizeof zs);
+  BOOST_REQUIRE_EQUAL(inflateInit2(&zs, windowBits), Z_OK);
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.peek()));
+  zs.avail_in = static_cast<uInt>(input.readableBytes());
+  muduo::string output;
+  char buf[4096];
+  int err = Z_OK;
+  while (err == Z_OK)
+  {
+    zs.next_out = reinterpret_cast<Bytef*>(buf);
+    zs.avail_out = sizeof buf;
+    err = inflate(&zs, Z_SYNC_FLUSH);
+    output.append(buf, sizeof buf - zs.avail_out);
+    if (zs.avail_in == 0 && zs.avail_out > 0)
+      break;
+  }
+  inflateEnd(&zs);
+  return output;
+}
+
+BOOST_AUTO_TEST_CASE(testZlibOutputStreamFlush)
+{
+  muduo::net::Buffer output;
+  muduo::net::ZlibOutputStream stream(&output, muduo::net::kGzipFormat);
+  BOOST_CHECK(stream.write("hello "));
+  BOOST_CHECK(stream.flush());
+  // the peer could decompress all data so far
+  BOOST_CHECK_EQUAL(decompress(output), "hello ");
+  BOOST_CHECK(stream.flush());
+  BOOST_CHECK(stream.write("world"));
+  BOOST_CHECK(stream.finishStream());
+  BOOST_CHECK_EQUAL(stream.zlibErrorCode(), Z_STREAM_END);
+  BOOST_CHECK_EQUAL(decompress(output), "hello world");
+  // gzip magic
+  BOOST_CHECK_EQUAL(output.peek()[0], '\x1f');
+  BOOST_CHECK_EQUAL(output.peek()[1], '\x8b');
+}
+
+BOOST_AUTO_TEST_CASE(testZlibOutputStreamRawDeflate)
+{
+  muduo::net::Buffer output;
+  muduo::net::ZlibOutputStream stream(&output, muduo::net::kRawDeflate,
+                                      Z_BEST_SPEED, 12, 5);
+  muduo::string input;
+  for (int i = 0; i < 10000; ++i)
+  {
+    input += std::to_string(i);
+  }
+  BOOST_CHECK(stream.write(input));
+  BOOST_CHECK(stream.finishStream());
+  BOOST_CHECK(output.readableBytes() < input.size());
+  BOOST_CHECK_EQUAL(decompress(output, -15), input);
+}
+
+BOOST_AUTO_TEST_CASE(testZlibOutputStreamPool)
+{
+  muduo::net::ZlibOutputStreamPool pool(muduo::net::kZlibFormat, Z_DEFAULT_COMPRESSION, 15, 8, 1);
+  muduo::net::Buffer output1;
+  std::unique_ptr<muduo::net::ZlibOutputStream> stream1(pool.get(&output1));
+  BOOST_CHECK(stream1->write("first stream"));
+  BOOST_CHECK(stream1->finishStream());
+  muduo::net::ZlibOutputStream* p = stream1.get();
+  pool.put(std::move(stream1));
+  BOOST_CHECK_EQUAL(pool.idle(), 1);
+
+  muduo::net::Buffer output2;
+  std::unique_ptr<muduo::net::ZlibOutputStream> stream2(pool.get(&output2));
+  std::unique_ptr<muduo::net::ZlibOutputStream> stream3(pool.get(&output2));
+  BOOST_CHECK_EQUAL(stream2.get(), p);
+  BOOST_CHECK_EQUAL(pool.idle(), 0);
+  BOOST_CHECK(stream2->write("second stream"));
+  BOOST_CHECK(stream2->finishStream());
+  BOOST_CHECK_EQUAL(decompress(output1), "first stream");
+  BOOST_CHECK_EQUAL(decompress(output2), "second stream");
+  BOOST_CHECK_EQUAL(stream2->inputBytes(), 13);
+
+  pool.put(std::move(stream2));
+  pool.put(std::move(stream3));
+  BOOST_CHECK_EQUAL(pool.idle(), 1);
+}
+
+void append(muduo::net::Buffer* to, int* calls, muduo::net::Buffer* data)
+{
+  to->append(data->peek(), data->readableBytes());
+  ++*calls;
+}
+
+BOOST_AUTO_TEST_CASE(testZlibStreamWriter)
+{
+  muduo::net::ZlibOutputStreamPool pool;
+  muduo::net::Buffer output;
+  int calls = 0;
+  muduo::string input;
+  {
+  muduo::net::ZlibStreamWriter writer(std::bind(append, &output, &calls, std::placeholders::_1),
+                                      &pool, 1024);
+  for (int i = 0; i < 1000; ++i)
+  {
+    muduo::string line(100, static_cast<char>('A' + rand() % 26));
+    for (auto& c : line)
+    {
+      c = static_cast<char>(c + rand() % 4);
+    }
+    line += '\n';
+    input += line;
+    BOOST_CHECK(writer.write(line));
+  }
+  // compressed data leave before the end
+  BOOST_CHECK(calls > 0);
+  BOOST_CHECK(writer.flush());
+  BOOST_CHECK_EQUAL(decompress(output), input);
+  BOOST_CHECK(writer.write("end"));
+  BOOST_CHECK(writer.finish());
+  BOOST_CHECK(!writer.write("more"));
+  }
+  BOOST_CHECK_EQUAL(decompress(output), input + "end");
+  BOOST_CHECK_EQUAL(pool.idle(), 1);
+}